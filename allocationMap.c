@@ -0,0 +1,421 @@
+/*
+ * allocationMap.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Unallocated space of a disk image
+ * Builds extent lists of unallocated space from the partition list,
+ * the in-memory FAT index and the NTFS $Bitmap, scanning both a word
+ * at a time, and of the file slack after the end of allocated files.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "allocationMap.h"
+#include "fatVolume.h"
+#include "ntfsVolume.h"
+#include "diskLayout.h"
+
+#define BITMAP_READ_BYTES 65536 //BYTES OF THE $Bitmap READ AT A TIME
+
+struct SlackWalk{
+	struct DiskImage *image;
+	struct FatVolume *fat; //VOLUME BEING WALKED (ONE OF fat AND ntfs IS NULL)
+	struct NtfsVolume *ntfs;
+	struct ExtentList *list; //LIST THE SLACK RANGES ARE APPENDED TO
+	int status; //-1 ONCE AN APPEND FAILED
+};
+
+static int appendFatSlack(const struct FatDirEntry *entry, void *context);
+static int appendNtfsSlack(const struct MftRecord *record, void *context);
+static int compareExtents(const void *a, const void *b);
+
+
+/*
+ * Function:  fetchUnallocatedExtents 
+ * --------------------
+ * Collects all unallocated space of the image in offset order:
+ * space outside the partitions plus the free clusters of the
+ * FAT and NTFS volumes of the model
+ * 
+ * model: The volume model of the open disk image
+ * list: Extent list the unallocated ranges are appended to (zero initialised)
+ * int: 0 on success, -1 on failure
+ */
+int fetchUnallocatedExtents(struct VolumeModel *model, struct ExtentList *list){
+	return fetchFreeSpaceExtents(model, FREE_UNALLOCATED, list);
+}
+
+
+/*
+ * Function:  fetchFreeSpaceExtents 
+ * --------------------
+ * Collects the unallocated space and/or the file slack of the image in offset order
+ * Each source is built on its own, then they are sorted and merged so
+ * touching ranges from different sources become one extent
+ * 
+ * model: The volume model of the open disk image
+ * kinds: FREE_UNALLOCATED, FREE_SLACK or both
+ * list: Extent list the ranges are appended to (zero initialised)
+ * int: 0 on success, -1 on failure
+ */
+int fetchFreeSpaceExtents(struct VolumeModel *model, int kinds, struct ExtentList *list){
+	//DATA DECLARATION
+	struct ExtentList pieces = {NULL, 0, 0, 0};
+	size_t i;
+	int status = 0;
+	//DATA MANIPULATION
+	if(kinds & FREE_UNALLOCATED){
+		status |= fetchUnpartitionedExtents(model, &pieces);
+		if(model->fat.present){
+			status |= fetchFatFreeExtents(model->image, &model->fat, &pieces);
+		}
+		if(model->ntfs.present){
+			status |= fetchNtfsFreeExtents(model->image, &model->ntfs, &pieces);
+		}
+	}
+	if(kinds & FREE_SLACK){
+		if(model->fat.present){
+			status |= fetchFatSlackExtents(model->image, &model->fat, &pieces);
+		}
+		if(model->ntfs.present){
+			status |= fetchNtfsSlackExtents(model->image, &model->ntfs, &pieces);
+		}
+	}
+	qsort(pieces.extents, pieces.count, sizeof(struct ImageExtent), compareExtents); //EACH SOURCE IS IN ORDER, MERGE THEM
+	for(i=0;i<pieces.count && status == 0;i++){
+		status = appendImageExtent(list, pieces.extents[i].offset, pieces.extents[i].length);
+	}
+	freeExtentList(&pieces);
+	return status ? -1 : 0;
+}
+
+
+/*
+ * Function:  fetchUnpartitionedExtents 
+ * --------------------
+ * Finds the space of the image that no partition covers (after the
+ * partition table in sector 0, between partitions and after the last one)
+ * Extended partition containers only hold EBRs and do not count as covering
+ * 
+ * model: The volume model of the open disk image
+ * list: Extent list the ranges are appended to
+ * int: 0 on success, -1 when out of memory
+ */
+int fetchUnpartitionedExtents(struct VolumeModel *model, struct ExtentList *list){
+	//DATA DECLARATION
+	struct ExtentList covered = {NULL, 0, 0, 0};
+	const struct Partition *partition;
+	uint64_t position = SECTOR_SIZE, start, end;
+	size_t i;
+	int status = 0;
+	//DATA MANIPULATION
+	for(i=0;i<model->partitionCount && status == 0;i++){
+		partition = &model->partitions[i];
+		if(partition->sectorCount == 0 || (partition->scheme != PARTITION_GPT && (partition->type == 0 || isExtendedPartitionType(partition->type) || (unsigned char)partition->type == 0xEE))){
+			continue;
+		}
+		status = appendImageExtent(&covered, partition->sectorStart*SECTOR_SIZE, partition->sectorCount*SECTOR_SIZE);
+	}
+	qsort(covered.extents, covered.count, sizeof(struct ImageExtent), compareExtents);
+	for(i=0;i<=covered.count && status == 0;i++){ //GAP BEFORE EACH PARTITION, THEN AFTER THE LAST
+		start = (i < covered.count) ? covered.extents[i].offset : model->image->size;
+		end = (i < covered.count) ? covered.extents[i].offset + covered.extents[i].length : model->image->size;
+		if(start > model->image->size){
+			start = model->image->size;
+		}
+		if(start > position){
+			status = appendImageExtent(list, position, start - position);
+		}
+		if(end > position){
+			position = end;
+		}
+	}
+	freeExtentList(&covered);
+	return status;
+}
+
+
+/*
+ * Function:  fetchFatFreeExtents 
+ * --------------------
+ * Appends every run of free clusters (FAT entry 0) of a FAT volume
+ * The in-memory FAT index is scanned 8 bytes (4 FAT16 or 2 FAT32 entries)
+ * at a time, read as little endian words like the entries themselves:
+ * words that are all free or hold no free entry at all are passed over
+ * whole, only mixed words are looked at entry by entry
+ * 
+ * image: The open disk image
+ * fat: The FAT volume of the volume model
+ * list: Extent list the free runs are appended to
+ * int: 0 on success, -1 if the FAT could not be loaded or when out of memory
+ */
+int fetchFatFreeExtents(struct DiskImage *image, struct FatVolume *fat, struct ExtentList *list){
+	//DATA DECLARATION
+	uint64_t clusterBytes = (uint64_t)fat->bytesPerSector*fat->sectorsPerCluster;
+	size_t entryBytes = (fat->fatBits == 32) ? 4 : 2, perWord = 8/entryBytes;
+	uint64_t laneLow = (entryBytes == 4) ? 0x0000000100000001ull : 0x0001000100010001ull;
+	uint64_t laneHigh = laneLow << (8*entryBytes - 1);
+	uint64_t entryMask = (entryBytes == 4) ? 0x0FFFFFFF0FFFFFFFull : UINT64_MAX; //TOP 4 BITS OF A FAT32 ENTRY ARE RESERVED
+	const unsigned char *table;
+	uint64_t word;
+	unsigned int cluster, end, runStart = 0;
+	int inRun = 0, isFree;
+	//DATA MANIPULATION
+	if(fat->table == NULL && loadFatTable(image, fat) != 0){
+		return -1;
+	}
+	table = fat->table;
+	end = (fat->clusterCount + 2 < fat->tableEntries) ? fat->clusterCount + 2 : fat->tableEntries;
+	for(cluster=2;cluster<end;){
+		if(cluster + perWord <= end){
+			word = readLe64(table + (size_t)cluster*entryBytes) & entryMask;
+			if(word == 0){ //EVERY ENTRY FREE, THE RUN CARRIES ON
+				if(!inRun){
+					runStart = cluster;
+					inRun = 1;
+				}
+				cluster += (unsigned int)perWord;
+				continue;
+			}
+			if(!inRun && ((word - laneLow) & ~word & laneHigh) == 0){ //NO ENTRY IS ZERO, NOTHING STARTS HERE
+				cluster += (unsigned int)perWord;
+				continue;
+			}
+		}
+		if(entryBytes == 4){
+			isFree = (readLe32(table + (size_t)cluster*4) & 0x0FFFFFFF) == 0;
+		}else{
+			isFree = (readLe16(table + (size_t)cluster*2) == 0);
+		}
+		if(isFree && !inRun){
+			runStart = cluster;
+			inRun = 1;
+		}else if(!isFree && inRun){
+			if(appendImageExtent(list, fetchClusterOffset(fat, runStart), (uint64_t)(cluster - runStart)*clusterBytes) != 0){
+				return -1;
+			}
+			inRun = 0;
+		}
+		cluster++;
+	}
+	if(inRun && appendImageExtent(list, fetchClusterOffset(fat, runStart), (uint64_t)(end - runStart)*clusterBytes) != 0){
+		return -1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  fetchNtfsFreeExtents 
+ * --------------------
+ * Appends every run of clusters marked free in the NTFS $Bitmap (MFT record 6)
+ * The bitmap holds one bit per cluster, bit 0 of byte 0 is cluster 0
+ * It is scanned a 64 bit little endian word at a time, so bit n of a word
+ * is cluster n of it; inside a mixed word the ends of free runs are found
+ * with count trailing zeros instead of bit by bit
+ * 
+ * image: The open disk image
+ * ntfs: The NTFS volume of the volume model
+ * list: Extent list the free runs are appended to
+ * int: 0 on success, -1 if the $Bitmap could not be read or when out of memory
+ */
+int fetchNtfsFreeExtents(struct DiskImage *image, struct NtfsVolume *ntfs, struct ExtentList *list){
+	//DATA DECLARATION
+	const struct NtfsExtentMap *map;
+	unsigned char *bitmap;
+	uint64_t clusterCount, volumeOffset = (uint64_t)ntfs->sectorStart*SECTOR_SIZE, position, word, rest, base, runStart = 0, runEnd;
+	long long int got;
+	size_t i;
+	int status = 0, inRun = 0;
+	unsigned int bit;
+	//DATA MANIPULATION
+	map = fetchExtentMap(image, ntfs, 6); //$Bitmap
+	if(map == NULL){
+		return -1;
+	}
+	clusterCount = (uint64_t)ntfs->totalSectors*ntfs->bytesPerSector/ntfs->clusterSize;
+	bitmap = malloc(BITMAP_READ_BYTES + 8);
+	if(bitmap == NULL){
+		return -1;
+	}
+	for(position = 0;position*8 < clusterCount && status == 0;position += (uint64_t)got){
+		got = readNtfsData(image, ntfs, map, position, bitmap, BITMAP_READ_BYTES);
+		if(got <= 0){
+			status = (got < 0) ? -1 : 0;
+			break;
+		}
+		memset(bitmap + got, 0xFF, 8); //A PARTIAL LAST WORD READS AS ALLOCATED
+		for(i=0;i<(size_t)got && status == 0;i+=8){
+			word = readLe64(bitmap + i);
+			base = (position + i)*8;
+			if(word == (inRun ? 0 : UINT64_MAX)){ //NO CHANGE FROM FREE TO ALLOCATED OR BACK IN THIS WORD
+				continue;
+			}
+			for(bit=0;bit<64;){
+				rest = inRun ? (word >> bit) : (~word >> bit);
+				if(rest == 0){ //NO FURTHER CHANGE IN THIS WORD
+					break;
+				}
+				bit += (unsigned int)__builtin_ctzll(rest);
+				if(inRun){ //FIRST ALLOCATED CLUSTER ENDS THE FREE RUN
+					runEnd = (base + bit < clusterCount) ? base + bit : clusterCount;
+					if(runEnd > runStart){
+						status = appendImageExtent(list, volumeOffset + runStart*ntfs->clusterSize, (runEnd - runStart)*ntfs->clusterSize);
+					}
+					inRun = 0;
+				}else{
+					runStart = base + bit;
+					inRun = 1;
+				}
+			}
+		}
+	}
+	if(inRun && status == 0 && runStart < clusterCount){
+		status = appendImageExtent(list, volumeOffset + runStart*ntfs->clusterSize, (clusterCount - runStart)*ntfs->clusterSize);
+	}
+	free(bitmap);
+	return status;
+}
+
+
+/*
+ * Function:  fetchFatSlackExtents 
+ * --------------------
+ * Appends the file slack of every live FAT file: the bytes between
+ * the end of the file and the end of its last cluster
+ * Extents are appended in directory walk order, not offset order
+ * 
+ * image: The open disk image
+ * fat: The FAT volume of the volume model
+ * list: Extent list the slack ranges are appended to
+ * int: 0 on success, -1 if a directory could not be read or when out of memory
+ */
+int fetchFatSlackExtents(struct DiskImage *image, struct FatVolume *fat, struct ExtentList *list){
+	struct SlackWalk walk = {image, fat, NULL, list, 0};
+	if(walkFatDirectories(image, fat, appendFatSlack, &walk) < 0){
+		return -1;
+	}
+	return walk.status;
+}
+
+
+/*
+ * Function:  appendFatSlack 
+ * --------------------
+ * Directory walk visitor appending the slack of one file
+ * Files ending exactly on a cluster boundary, deleted files and files
+ * whose chain is shorter than their size have no slack to add
+ * 
+ * entry: The directory entry being visited
+ * context: The SlackWalk
+ * int: 0 to continue the walk, -1 when out of memory
+ */
+static int appendFatSlack(const struct FatDirEntry *entry, void *context){
+	//DATA DECLARATION
+	struct SlackWalk *walk = context;
+	uint64_t clusterBytes = (uint64_t)walk->fat->bytesPerSector*walk->fat->sectorsPerCluster;
+	const struct ImageExtent *last;
+	struct FileExtents extents;
+	//DATA MANIPULATION
+	if(entry->deleted || entry->parentDeleted || (entry->attributes & 0x18) || entry->fileSize % clusterBytes == 0){ //DIRECTORIES AND VOLUME LABELS HAVE NO SIZE
+		return 0;
+	}
+	if(fetchFileExtents(walk->image, walk->fat, entry, &extents) != 0){
+		walk->status = -1;
+		return -1;
+	}
+	if(extents.count > 0 && !extents.truncated){
+		last = &extents.extents[extents.count-1];
+		walk->status = appendImageExtent(walk->list, last->offset + last->length, clusterBytes - entry->fileSize % clusterBytes);
+	}
+	freeFileExtents(&extents);
+	return walk->status;
+}
+
+
+/*
+ * Function:  fetchNtfsSlackExtents 
+ * --------------------
+ * Appends the slack of every non-resident unnamed $DATA stream in use:
+ * the clusters between the real size and the allocated size of the stream
+ * (the tail of the last cluster plus any clusters allocated ahead)
+ * Compressed streams are skipped as their allocation does not follow the real size
+ * 
+ * image: The open disk image
+ * ntfs: The NTFS volume of the volume model
+ * list: Extent list the slack ranges are appended to
+ * int: 0 on success, -1 if the $MFT could not be read or when out of memory
+ */
+int fetchNtfsSlackExtents(struct DiskImage *image, struct NtfsVolume *ntfs, struct ExtentList *list){
+	struct SlackWalk walk = {image, NULL, ntfs, list, 0};
+	if(scanMftRecords(image, ntfs, 0, appendNtfsSlack, &walk) < 0){
+		return -1;
+	}
+	return walk.status;
+}
+
+
+/*
+ * Function:  appendNtfsSlack 
+ * --------------------
+ * MFT scan visitor appending the slack of one record's $DATA stream
+ * The slack byte range of the stream is mapped through its runs to the volume
+ * 
+ * record: The decoded MFT record
+ * context: The SlackWalk
+ * int: 0 to continue the scan, -1 when out of memory
+ */
+static int appendNtfsSlack(const struct MftRecord *record, void *context){
+	//DATA DECLARATION
+	struct SlackWalk *walk = context;
+	struct NtfsVolume *ntfs = walk->ntfs;
+	const struct MftAttribute *data = NULL;
+	struct NtfsExtentMap map;
+	uint64_t clusterSize = (uint64_t)ntfs->clusterSize, volumeOffset = (uint64_t)ntfs->sectorStart*SECTOR_SIZE;
+	uint64_t runFirst, runLast, start, end;
+	size_t i;
+	int a;
+	//DATA MANIPULATION
+	if(!record->inUse || record->baseRecord != 0){
+		return 0;
+	}
+	for(a=0;a<record->attributeCount;a++){
+		if(record->attributes[a].type == 0x80 && record->attributes[a].nameLength == 0 && record->attributes[a].nonResident && record->attributes[a].startVcn == 0){
+			data = &record->attributes[a];
+			break;
+		}
+	}
+	if(data == NULL || (data->flags & 0x0001) || data->allocatedSize <= data->realSize || buildExtentMap(record, &map) != 0){
+		return 0;
+	}
+	for(i=0;i<map.count && walk->status == 0;i++){ //PART OF EACH RUN INSIDE [realSize, allocatedSize)
+		if(map.runs[i].lcn == NTFS_SPARSE_LCN){
+			continue;
+		}
+		runFirst = map.runs[i].vcn*clusterSize;
+		runLast = (map.runs[i].vcn + map.runs[i].length)*clusterSize;
+		start = (runFirst > data->realSize) ? runFirst : data->realSize;
+		end = (runLast < data->allocatedSize) ? runLast : data->allocatedSize;
+		if(start < end){
+			walk->status = appendImageExtent(walk->list, volumeOffset + map.runs[i].lcn*clusterSize + (start - runFirst), end - start);
+		}
+	}
+	freeExtentMap(&map);
+	return walk->status;
+}
+
+
+/*
+ * Function:  compareExtents 
+ * --------------------
+ * qsort comparison ordering extents by image offset
+ */
+static int compareExtents(const void *a, const void *b){
+	uint64_t first = ((const struct ImageExtent*)a)->offset, second = ((const struct ImageExtent*)b)->offset;
+	return (first > second) - (first < second);
+}
@@ -0,0 +1,34 @@
+/*
+ * allocationMap.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Unallocated space of a disk image
+ * Finds the byte ranges of an image no file system is using:
+ * space outside every partition, free FAT clusters and clusters
+ * marked free in the NTFS $Bitmap, and the slack after the end
+ * of each allocated file.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef ALLOCATIONMAP_H
+#define ALLOCATIONMAP_H
+
+//IMPORTED LIBRARIES
+#include "diskImage.h"
+#include "volumeModel.h"
+
+#define FREE_UNALLOCATED 1 //fetchFreeSpaceExtents KINDS
+#define FREE_SLACK 2
+
+//FUNCTION & STRUCT DECLARATIONS:
+int fetchUnallocatedExtents(struct VolumeModel *model, struct ExtentList *list);
+int fetchFreeSpaceExtents(struct VolumeModel *model, int kinds, struct ExtentList *list);
+int fetchUnpartitionedExtents(struct VolumeModel *model, struct ExtentList *list);
+int fetchFatFreeExtents(struct DiskImage *image, struct FatVolume *fat, struct ExtentList *list);
+int fetchNtfsFreeExtents(struct DiskImage *image, struct NtfsVolume *ntfs, struct ExtentList *list);
+int fetchFatSlackExtents(struct DiskImage *image, struct FatVolume *fat, struct ExtentList *list);
+int fetchNtfsSlackExtents(struct DiskImage *image, struct NtfsVolume *ntfs, struct ExtentList *list);
+
+#endif
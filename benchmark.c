@@ -0,0 +1,310 @@
+/*
+ * benchmark.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Per-stage benchmark
+ * Times each stage of the tool on one image: partition table parsing,
+ * the FAT directory sweep, $MFT parsing and the full image scans used
+ * by carving and hashing. Each stage is run several times and the best
+ * run is kept, so the first (cold cache) run does not skew the result.
+ * One "benchmark" record per stage is written to stdout with records/s
+ * and MB/s so results can be compared across releases.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "diskImage.h"
+#include "volumeModel.h"
+#include "fatVolume.h"
+#include "ntfsVolume.h"
+#include "jsonOutput.h"
+#include "fileCarver.h"
+#include "imageHash.h"
+
+#define BENCH_REPEATS 3 //RUNS OF EACH STAGE, THE FASTEST IS REPORTED
+#define BENCH_PARTITION_LOOPS 10000 //PARTITION TABLE PARSES PER RUN (ONE PARSE IS TOO QUICK TO TIME)
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct BenchStage{
+	const char *name; //STAGE NAME IN THE OUTPUT
+	int (*run)(struct VolumeModel *model, int threadCount, uint64_t *records, uint64_t *bytes); //1 IF THE IMAGE HAS NOTHING FOR THE STAGE
+};
+
+static int benchPartitionTable(struct VolumeModel *model, int threadCount, uint64_t *records, uint64_t *bytes);
+static int benchFatSweep(struct VolumeModel *model, int threadCount, uint64_t *records, uint64_t *bytes);
+static int countFatEntry(const struct FatDirEntry *entry, void *context);
+static int benchMftParse(struct VolumeModel *model, int threadCount, uint64_t *records, uint64_t *bytes);
+static int countMftRecord(const struct MftRecord *record, void *context);
+static int benchCarveScan(struct VolumeModel *model, int threadCount, uint64_t *records, uint64_t *bytes);
+static int countCarveHit(const struct CarveHit *hit, void *context);
+static int benchHashScan(struct VolumeModel *model, int threadCount, uint64_t *records, uint64_t *bytes);
+static double fetchSeconds(void);
+
+static const struct BenchStage benchStages[] = {
+	{"partitionTable", benchPartitionTable},
+	{"fatDirectorySweep", benchFatSweep},
+	{"mftParse", benchMftParse},
+	{"carveScan", benchCarveScan},
+	{"hashScan", benchHashScan},
+};
+
+
+/*
+ * Main: 
+ * --------------------
+ * Opens the image once, builds the volume model and times every stage
+ * 
+ * Parameters: argc, char *argv[] The image, then optionally the repeats and the thread count
+ * int: 0 on success, 1 if a stage failed, 2 on a usage error
+ */
+int main(int argc, char *argv[]){
+	//DATA DECLARATION
+	struct DiskImage image;
+	struct VolumeModel model;
+	struct JsonRecord record;
+	uint64_t records, bytes;
+	double start, seconds, best;
+	int repeats = BENCH_REPEATS, threadCount = 0, status = 0, skipped, failed, r;
+	size_t s;
+	//DATA MANIPULATION
+	if(argc < 2 || argc > 4){
+		fprintf(stderr, "Usage: %s <image> [repeats] [threads]\n", argv[0]);
+		return 2;
+	}
+	if(argc > 2){
+		repeats = atoi(argv[2]);
+	}
+	if(argc > 3){
+		threadCount = atoi(argv[3]);
+	}
+	if(repeats < 1){
+		repeats = 1;
+	}
+	if(openDiskImage(argv[1], &image) != 0){
+		perror(argv[1]);
+		return 1;
+	}
+	buildVolumeModel(&image, &model);
+	for(s=0;s<sizeof(benchStages)/sizeof(benchStages[0]);s++){
+		best = 0;
+		records = bytes = 0;
+		skipped = failed = 0;
+		for(r=0;r<repeats && !skipped && !failed;r++){
+			start = fetchSeconds();
+			switch(benchStages[s].run(&model, threadCount, &records, &bytes)){
+				case 0: break;
+				case 1: skipped = 1; break;
+				default: failed = 1; break;
+			}
+			seconds = fetchSeconds() - start;
+			if(r == 0 || seconds < best){
+				best = seconds;
+			}
+		}
+		beginJsonRecord(&record, stdout, "benchmark");
+		addJsonString(&record, "image", image.name);
+		addJsonString(&record, "stage", benchStages[s].name);
+		if(skipped || failed){
+			addJsonBool(&record, "skipped", skipped);
+			addJsonBool(&record, "failed", failed);
+		}else{
+			addJsonInt(&record, "repeats", repeats);
+			addJsonDouble(&record, "seconds", best);
+			addJsonInt(&record, "records", (long long int)records);
+			addJsonInt(&record, "bytes", (long long int)bytes);
+			addJsonDouble(&record, "recordsPerSecond", (best > 0) ? (double)records/best : 0);
+			addJsonDouble(&record, "megabytesPerSecond", (best > 0) ? (double)bytes/(1024.0*1024.0)/best : 0);
+		}
+		endJsonRecord(&record);
+		fflush(stdout);
+		status |= failed;
+	}
+	freeVolumeModel(&model);
+	closeDiskImage(&image);
+	return status;
+}
+
+
+/*
+ * Function:  benchPartitionTable 
+ * --------------------
+ * Parses the partition table (MBR, EBR chain or GPT) BENCH_PARTITION_LOOPS times
+ * 
+ * model: The volume model
+ * threadCount: Unused, parsing is single threaded
+ * records: Set to the number of partition entries returned
+ * bytes: Set to the number of table sectors read (512 per partition entry and loop)
+ * int: 0
+ */
+static int benchPartitionTable(struct VolumeModel *model, int threadCount, uint64_t *records, uint64_t *bytes){
+	struct PartitionScan scan;
+	struct Partition partition;
+	int loop;
+	*records = 0;
+	for(loop=0;loop<BENCH_PARTITION_LOOPS;loop++){
+		beginPartitionScan(model->image, &scan);
+		while(nextPartition(&scan, &partition) == 1){
+			(*records)++;
+		}
+	}
+	*bytes = *records*SECTOR_SIZE;
+	return 0;
+}
+
+
+/*
+ * Function:  benchFatSweep 
+ * --------------------
+ * Walks every directory of the FAT volume, live and deleted
+ * 
+ * model: The volume model
+ * threadCount: Unused, the walk is single threaded
+ * records: Set to the number of directory entries visited
+ * bytes: Set to the bytes of 32 byte entries visited
+ * int: 0 on success, 1 without a FAT volume, -1 on failure
+ */
+static int benchFatSweep(struct VolumeModel *model, int threadCount, uint64_t *records, uint64_t *bytes){
+	if(!model->fat.present){
+		return 1;
+	}
+	*records = 0;
+	if(walkFatDirectories(model->image, &model->fat, countFatEntry, records) != 0){
+		return -1;
+	}
+	*bytes = *records*32;
+	return 0;
+}
+
+
+/*
+ * Function:  countFatEntry 
+ * --------------------
+ * Directory walk visitor counting entries
+ * 
+ * entry: The directory entry
+ * context: The uint64_t counter
+ * int: 0 to continue the walk
+ */
+static int countFatEntry(const struct FatDirEntry *entry, void *context){
+	(*(uint64_t*)context)++;
+	return 0;
+}
+
+
+/*
+ * Function:  benchMftParse 
+ * --------------------
+ * Reads and parses every record of the $MFT on the work pool
+ * 
+ * model: The volume model
+ * threadCount: Parsing threads, 0 for one per processor
+ * records: Set to the number of records parsed
+ * bytes: Set to the bytes of $MFT read
+ * int: 0 on success, 1 without an NTFS volume, -1 on failure
+ */
+static int benchMftParse(struct VolumeModel *model, int threadCount, uint64_t *records, uint64_t *bytes){
+	if(!model->ntfs.present){
+		return 1;
+	}
+	*records = 0;
+	if(scanMftRecords(model->image, &model->ntfs, threadCount, countMftRecord, records) != 0){
+		return -1;
+	}
+	*bytes = *records*(uint64_t)model->ntfs.mftRecordSize;
+	return 0;
+}
+
+
+/*
+ * Function:  countMftRecord 
+ * --------------------
+ * MFT scan visitor counting records
+ * 
+ * record: The parsed record
+ * context: The uint64_t counter
+ * int: 0 to continue the scan
+ */
+static int countMftRecord(const struct MftRecord *record, void *context){
+	(*(uint64_t*)context)++;
+	return 0;
+}
+
+
+/*
+ * Function:  benchCarveScan 
+ * --------------------
+ * Carves the whole image for every known signature
+ * 
+ * model: The volume model
+ * threadCount: Carving threads, 0 for one per processor
+ * records: Set to the number of files carved
+ * bytes: Set to the size of the image
+ * int: 0 on success, -1 on failure
+ */
+static int benchCarveScan(struct VolumeModel *model, int threadCount, uint64_t *records, uint64_t *bytes){
+	struct ImageExtent whole = {0, model->image->size};
+	*records = 0;
+	if(carveImage(model->image, &whole, 1, threadCount, countCarveHit, records) != 0){
+		return -1;
+	}
+	*bytes = model->image->size;
+	return 0;
+}
+
+
+/*
+ * Function:  countCarveHit 
+ * --------------------
+ * Carver visitor counting hits
+ * 
+ * hit: The carved file
+ * context: The uint64_t counter
+ * int: 0 to continue carving
+ */
+static int countCarveHit(const struct CarveHit *hit, void *context){
+	(*(uint64_t*)context)++;
+	return 0;
+}
+
+
+/*
+ * Function:  benchHashScan 
+ * --------------------
+ * Hashes the whole image (MD5, SHA-1 and SHA-256) without per-block hashes
+ * 
+ * model: The volume model
+ * threadCount: Hashing threads, 0 for one per processor
+ * records: Set to the number of 1 MiB blocks hashed
+ * bytes: Set to the size of the image
+ * int: 0 on success, -1 on failure
+ */
+static int benchHashScan(struct VolumeModel *model, int threadCount, uint64_t *records, uint64_t *bytes){
+	struct ImageDigest digest;
+	if(hashImage(model->image, NULL, 0, 0, threadCount, NULL, NULL, &digest, NULL) != 0){
+		return -1;
+	}
+	*records = (model->image->size + 1024*1024 - 1)/(1024*1024);
+	*bytes = model->image->size;
+	return 0;
+}
+
+
+/*
+ * Function:  fetchSeconds 
+ * --------------------
+ * Reads the monotonic clock
+ * 
+ * double: Seconds since an arbitrary starting point
+ */
+static double fetchSeconds(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec + (double)now.tv_nsec/1e9;
+}
@@ -0,0 +1,430 @@
+/*
+ * diskImage.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Shared disk image access layer
+ * Opens the disk image a single time and memory maps it.
+ * Parsers request views of byte ranges instead of opening,
+ * seeking and reading the image themselves.
+ * The raw backend lives here; split raw and EWF images are
+ * handled by splitImage.c and ewfImage.c behind the same interface.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#define _GNU_SOURCE //copy_file_range
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include "diskImage.h"
+#include "splitImage.h"
+#include "ewfImage.h"
+#include "scanStats.h"
+
+#define IMAGE_PROBE_BYTES 16 //BYTES OF THE FILE HANDED TO EACH BACKEND TO IDENTIFY ITS FORMAT
+
+static int probeRawImage(const char *fileName, const unsigned char *header, size_t length);
+static int openRawImage(const char *fileName, struct DiskImage *image);
+static int readRawImage(struct DiskImage *image, uint64_t offset, unsigned char *buffer, size_t length);
+static void adviseRawImage(struct DiskImage *image, uint64_t offset, uint64_t length);
+static void closeRawImage(struct DiskImage *image);
+
+static const struct ImageBackend rawImageBackend = {"raw", probeRawImage, openRawImage, readRawImage, adviseRawImage, closeRawImage};
+
+
+/*
+ * Function:  openDiskImage 
+ * --------------------
+ * Opens the disk image for reading with the first backend that recognises it
+ * EWF images are detected by their signature, split raw images by a .001
+ * extension, and anything else is opened as a single raw file
+ * 
+ * fileName: The fileName of the disk image (the first segment of a split or EWF image)
+ * image: Pointer to the image struct to be filled in
+ * int: 0 on success, -1 if the image could not be opened (errno is set)
+ */
+int openDiskImage(const char *fileName, struct DiskImage *image){
+	//DATA DECLARATION
+	static const struct ImageBackend *const backends[] = {&ewfImageBackend, &splitImageBackend, &rawImageBackend};
+	unsigned char header[IMAGE_PROBE_BYTES];
+	ssize_t length;
+	size_t i;
+	int fd;
+	//DATA MANIPULATION
+	memset(image, 0, sizeof(*image));
+	strncpy(image->name, fileName, sizeof(image->name) - 1);
+	image->fd = -1;
+	fd = open(fileName, O_RDONLY); //READ THE START OF THE FILE TO IDENTIFY ITS FORMAT
+	if(fd < 0){
+		return -1;
+	}
+	length = pread(fd, header, sizeof(header), 0);
+	close(fd);
+	if(length < 0){
+		return -1;
+	}
+	for(i=0;i<sizeof(backends)/sizeof(backends[0]);i++){
+		if(backends[i]->probe(fileName, header, (size_t)length)){
+			image->backend = backends[i];
+			return backends[i]->open(fileName, image);
+		}
+	}
+	errno = EINVAL;
+	return -1;
+}
+
+
+/*
+ * Function:  closeDiskImage 
+ * --------------------
+ * Closes a disk image opened with openDiskImage and releases its backend state
+ * 
+ * image: Pointer to the image struct to be closed
+ */
+void closeDiskImage(struct DiskImage *image){
+	if(image->backend != NULL){
+		image->backend->close(image);
+		image->backend = NULL;
+	}
+}
+
+
+/*
+ * Function:  readImage 
+ * --------------------
+ * Copies length bytes of the image starting at offset into buffer
+ * Safe to call from several threads at once
+ * 
+ * image: The open disk image
+ * offset: Byte offset into the image
+ * buffer: Buffer of at least length bytes
+ * length: Number of bytes to read
+ * int: 0 on success, -1 if the range is outside the image or could not be read
+ */
+int readImage(struct DiskImage *image, uint64_t offset, unsigned char *buffer, size_t length){
+	if(offset > image->size || length > image->size - offset){ //RANGE MUST LIE INSIDE THE IMAGE
+		errno = EINVAL;
+		return -1;
+	}
+	countImageRead(offset, length);
+	if(image->map != NULL){
+		memcpy(buffer, image->map + offset, length);
+		return 0;
+	}
+	return image->backend->read(image, offset, buffer, length);
+}
+
+
+/*
+ * Function:  fetchImageView 
+ * --------------------
+ * Returns a pointer to length bytes of the image starting at offset
+ * When the image is mapped the pointer is straight into the mapping (zero-copy)
+ * Otherwise the backend reads the bytes into the caller supplied scratch buffer
+ * 
+ * image: The open disk image
+ * offset: Byte offset into the image
+ * length: Number of bytes requested
+ * scratch: Buffer of at least length bytes used when the image is not mapped
+ * const unsigned char*: Pointer to the requested bytes, NULL if the range is outside the image
+ */
+const unsigned char *fetchImageView(struct DiskImage *image, uint64_t offset, size_t length, unsigned char *scratch){
+	if(offset > image->size || length > image->size - offset){ //RANGE MUST LIE INSIDE THE IMAGE
+		return NULL;
+	}
+	countImageRead(offset, length);
+	if(image->map != NULL){
+		return image->map + offset;
+	}
+	return (image->backend->read(image, offset, scratch, length) == 0) ? scratch : NULL;
+}
+
+
+/*
+ * Function:  adviseImageRange 
+ * --------------------
+ * Tells the backend a range of the image is about to be read from start to end
+ * so it reads ahead in large blocks (the mapping defaults to random access)
+ * 
+ * image: The open disk image
+ * offset: Byte offset of the range
+ * length: Length of the range in bytes
+ */
+void adviseImageRange(struct DiskImage *image, uint64_t offset, uint64_t length){
+	if(offset >= image->size || image->backend->advise == NULL){
+		return;
+	}
+	if(length > image->size - offset){
+		length = image->size - offset;
+	}
+	image->backend->advise(image, offset, length);
+}
+
+
+/*
+ * Function:  copyImageExtents 
+ * --------------------
+ * Writes a list of image extents one after the other to an open file
+ * The copy is done in the kernel with copy_file_range, falling back to
+ * sendfile and finally to write from the mapped image, so file content
+ * does not have to pass through a user space buffer
+ * Split and EWF images always take the write path
+ * 
+ * image: The open disk image
+ * extents: Extents of the image to copy, in file order
+ * count: Number of extents
+ * outFd: Descriptor of the output file (written at its current position)
+ * int: 0 on success, -1 on failure (errno is set)
+ */
+int copyImageExtents(struct DiskImage *image, const struct ImageExtent *extents, size_t count, int outFd){
+	//DATA DECLARATION
+	size_t i;
+	uint64_t remaining;
+	off_t inOffset;
+	ssize_t copied;
+	int useCopyRange = (image->fd >= 0), useSendfile = (image->fd >= 0); //ONLY A SINGLE RAW FILE CAN BE COPIED IN THE KERNEL
+	unsigned char buffer[65536];
+	const unsigned char *view;
+	size_t chunk;
+	//DATA MANIPULATION
+	for(i=0;i<count;i++){
+		if(extents[i].offset > image->size || extents[i].length > image->size - extents[i].offset){
+			errno = EINVAL;
+			return -1;
+		}
+		inOffset = (off_t)extents[i].offset;
+		remaining = extents[i].length;
+		while(remaining > 0){
+			copied = -1;
+			if(useCopyRange){
+				copied = copy_file_range(image->fd, &inOffset, outFd, NULL, remaining, 0);
+				if(copied > 0){
+					countImageRead((uint64_t)inOffset - (uint64_t)copied, (uint64_t)copied);
+					countStat(&statsCounters.readCalls, 1);
+				}
+				if(copied < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP || errno == EBADF)){
+					useCopyRange = 0; //NOT SUPPORTED BETWEEN THESE FILES, TRY THE NEXT METHOD
+					continue;
+				}
+			}else if(useSendfile){
+				copied = sendfile(outFd, image->fd, &inOffset, remaining);
+				if(copied > 0){
+					countImageRead((uint64_t)inOffset - (uint64_t)copied, (uint64_t)copied);
+					countStat(&statsCounters.readCalls, 1);
+				}
+				if(copied < 0 && (errno == ENOSYS || errno == EINVAL)){
+					useSendfile = 0;
+					continue;
+				}
+			}else{ //PLAIN WRITE OF THE MAPPED (OR BACKEND READ) BYTES
+				chunk = remaining < sizeof(buffer) ? (size_t)remaining : sizeof(buffer);
+				view = fetchImageView(image, (uint64_t)inOffset, chunk, buffer);
+				copied = (view == NULL) ? -1 : write(outFd, view, chunk);
+				if(copied > 0){
+					inOffset += copied;
+				}
+			}
+			if(copied < 0 && errno == EINTR){
+				continue;
+			}
+			if(copied <= 0){
+				if(copied == 0){
+					errno = EIO;
+				}
+				return -1;
+			}
+			remaining -= (uint64_t)copied;
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  appendImageExtent 
+ * --------------------
+ * Appends an extent to a list, merging it into the last extent
+ * when it follows straight on from it
+ * 
+ * list: The extent list (zero initialised before first use)
+ * offset: Byte offset of the extent in the image
+ * length: Length of the extent in bytes
+ * int: 0 on success, -1 when out of memory
+ */
+int appendImageExtent(struct ExtentList *list, uint64_t offset, uint64_t length){
+	struct ImageExtent *grown;
+	size_t capacity;
+	if(length == 0){
+		return 0;
+	}
+	if(list->count > 0 && list->extents[list->count-1].offset + list->extents[list->count-1].length == offset){
+		list->extents[list->count-1].length += length; //FOLLOWS ON FROM THE LAST EXTENT
+	}else{
+		if(list->count == list->capacity){
+			capacity = list->capacity ? list->capacity*2 : 16;
+			grown = realloc(list->extents, capacity*sizeof(*grown));
+			if(grown == NULL){
+				return -1;
+			}
+			list->extents = grown;
+			list->capacity = capacity;
+		}
+		list->extents[list->count].offset = offset;
+		list->extents[list->count].length = length;
+		list->count++;
+	}
+	list->length += length;
+	return 0;
+}
+
+
+/*
+ * Function:  freeExtentList 
+ * --------------------
+ * Releases the extents held by a list
+ * 
+ * list: The extent list
+ */
+void freeExtentList(struct ExtentList *list){
+	free(list->extents);
+	list->extents = NULL;
+	list->count = list->capacity = 0;
+	list->length = 0;
+}
+
+
+/*
+ * Function:  probeRawImage 
+ * --------------------
+ * Any file can be read as a raw image, so this backend is tried last
+ * 
+ * fileName: The fileName of the disk image
+ * header: The first bytes of the file
+ * length: Number of bytes in header
+ * int: Always 1
+ */
+static int probeRawImage(const char *fileName, const unsigned char *header, size_t length){
+	return 1;
+}
+
+
+/*
+ * Function:  openRawImage 
+ * --------------------
+ * Opens a single file raw image and memory maps the whole file
+ * If the file cannot be mapped (pipes, special files, exhausted address space)
+ * the descriptor is kept open and views are served with pread instead
+ * Block devices (/dev/sdX) have no st_size and are sized by seeking to their end
+ * 
+ * fileName: The fileName of the disk image
+ * image: Pointer to the image struct to be filled in
+ * int: 0 on success, -1 if the image could not be opened (errno is set)
+ */
+static int openRawImage(const char *fileName, struct DiskImage *image){
+	struct stat imageStat;
+	off_t offset;
+	void *map;
+	image->fd = open(fileName, O_RDONLY); //OPEN FILE FOR READING ONLY
+	if(image->fd < 0){
+		return -1;
+	}
+	if(fstat(image->fd, &imageStat) != 0){
+		close(image->fd);
+		image->fd = -1;
+		return -1;
+	}
+	image->size = (uint64_t)imageStat.st_size;
+	if(!S_ISREG(imageStat.st_mode)){ //BLOCK DEVICES REPORT A ZERO st_size, THEIR END IS FOUND BY SEEKING
+		offset = lseek(image->fd, 0, SEEK_END);
+		image->size = (offset > 0) ? (uint64_t)offset : 0;
+	}
+	if(image->size > 0){
+		map = mmap(NULL, image->size, PROT_READ, MAP_PRIVATE, image->fd, 0); //MAPS THE WHOLE IMAGE READ ONLY
+		if(map != MAP_FAILED){
+			image->map = (const unsigned char*)map;
+			madvise(map, image->size, MADV_RANDOM); //METADATA ACCESS JUMPS AROUND THE IMAGE
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  readRawImage 
+ * --------------------
+ * Fills a buffer from an unmapped raw image with pread, retrying short reads
+ * 
+ * image: The open disk image
+ * offset: Byte offset into the image
+ * buffer: Buffer to read into
+ * length: Number of bytes to read
+ * int: 0 on success, -1 on a read error (errno is set)
+ */
+static int readRawImage(struct DiskImage *image, uint64_t offset, unsigned char *buffer, size_t length){
+	size_t done = 0;
+	ssize_t got;
+	while(done < length){ //PREAD CAN RETURN SHORT COUNTS SO LOOP UNTIL THE BUFFER IS FILLED
+		got = pread(image->fd, buffer + done, length - done, (off_t)(offset + done));
+		countStat(&statsCounters.readCalls, 1);
+		if(got < 0 && errno == EINTR){
+			continue;
+		}
+		if(got <= 0){
+			if(got == 0){
+				errno = EIO;
+			}
+			return -1;
+		}
+		done += (size_t)got;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  adviseRawImage 
+ * --------------------
+ * Switches a range of the mapping (or the file) to sequential read ahead
+ * 
+ * image: The open disk image
+ * offset: Byte offset of the range
+ * length: Length of the range in bytes (inside the image)
+ */
+static void adviseRawImage(struct DiskImage *image, uint64_t offset, uint64_t length){
+	uint64_t pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+	uint64_t start = offset - offset % pageSize; //MADVISE NEEDS A PAGE ALIGNED START
+	if(image->map != NULL){
+		madvise((void*)(image->map + start), (size_t)(offset + length - start), MADV_SEQUENTIAL);
+		madvise((void*)(image->map + start), (size_t)(offset + length - start), MADV_WILLNEED);
+	}else{
+		posix_fadvise(image->fd, (off_t)offset, (off_t)length, POSIX_FADV_SEQUENTIAL);
+		posix_fadvise(image->fd, (off_t)offset, (off_t)length, POSIX_FADV_WILLNEED);
+	}
+}
+
+
+/*
+ * Function:  closeRawImage 
+ * --------------------
+ * Unmaps and closes a raw image
+ * 
+ * image: Pointer to the image struct to be closed
+ */
+static void closeRawImage(struct DiskImage *image){
+	if(image->map != NULL){
+		munmap((void*)image->map, image->size);
+		image->map = NULL;
+	}
+	if(image->fd >= 0){
+		close(image->fd);
+		image->fd = -1;
+	}
+}
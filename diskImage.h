@@ -0,0 +1,66 @@
+/*
+ * diskImage.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Shared disk image access layer
+ * Opens a disk image once and memory maps it so every parser
+ * can take zero-copy views of its sectors.
+ * Falls back to pread for images that cannot be mapped.
+ * Split raw (.001, .002...) and EWF (.E01) images are read through
+ * pluggable backends that serve the same views from a scratch buffer.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef DISKIMAGE_H
+#define DISKIMAGE_H
+
+//IMPORTED LIBRARIES
+#include <stddef.h>
+#include <stdint.h>
+
+#define SECTOR_SIZE 512 //DEFAULT SECTOR SIZE USED FOR LBA ADDRESSING
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct ImageExtent{
+	uint64_t offset; //BYTE OFFSET OF THE EXTENT IN THE IMAGE
+	uint64_t length; //LENGTH OF THE EXTENT IN BYTES
+};
+
+struct ExtentList{
+	struct ImageExtent *extents; //EXTENTS IN THE ORDER THEY WERE APPENDED
+	size_t count, capacity;
+	uint64_t length; //TOTAL BYTES COVERED BY THE EXTENTS
+};
+
+struct DiskImage;
+
+struct ImageBackend{
+	const char *name; //FORMAT NAME ("raw", "split", "ewf")
+	int (*probe)(const char *fileName, const unsigned char *header, size_t length); //1 IF THE FILE IS IN THIS FORMAT
+	int (*open)(const char *fileName, struct DiskImage *image); //SETS size AND state, 0 ON SUCCESS
+	int (*read)(struct DiskImage *image, uint64_t offset, unsigned char *buffer, size_t length); //READS EXACTLY length BYTES, 0 ON SUCCESS
+	void (*advise)(struct DiskImage *image, uint64_t offset, uint64_t length); //SEQUENTIAL READ HINT (MAY BE NULL)
+	void (*close)(struct DiskImage *image);
+};
+
+struct DiskImage{
+	int fd; //FILE DESCRIPTOR OF A SINGLE FILE RAW IMAGE (-1 FOR SPLIT AND EWF IMAGES)
+	const unsigned char *map; //START OF THE MAPPED IMAGE (NULL WHEN USING THE PREAD FALLBACK OR ANOTHER BACKEND)
+	uint64_t size; //SIZE OF THE IMAGE IN BYTES
+	char name[128]; //FILE NAME OF THE IMAGE
+	const struct ImageBackend *backend; //READER FOR THE IMAGE FORMAT
+	void *state; //PRIVATE STATE OF THE BACKEND
+};
+
+int openDiskImage(const char *fileName, struct DiskImage *image);
+void closeDiskImage(struct DiskImage *image);
+int readImage(struct DiskImage *image, uint64_t offset, unsigned char *buffer, size_t length);
+const unsigned char *fetchImageView(struct DiskImage *image, uint64_t offset, size_t length, unsigned char *scratch);
+void adviseImageRange(struct DiskImage *image, uint64_t offset, uint64_t length);
+int copyImageExtents(struct DiskImage *image, const struct ImageExtent *extents, size_t count, int outFd);
+int appendImageExtent(struct ExtentList *list, uint64_t offset, uint64_t length);
+void freeExtentList(struct ExtentList *list);
+
+#endif
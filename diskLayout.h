@@ -0,0 +1,207 @@
+/*
+ * diskLayout.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: On-disk structure layouts
+ * Field offsets of the MBR and GPT partition tables, the FAT boot sector
+ * (BPB) and directory entries, the NTFS boot sector, MFT file records,
+ * attribute headers and index entries, with fixed width little endian
+ * readers. The readers are inline and compile to single unaligned loads
+ * on little endian machines, so decoding a field costs no more than the
+ * pointer casts they replace while staying correct on any alignment and
+ * byte order.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef DISKLAYOUT_H
+#define DISKLAYOUT_H
+
+//IMPORTED LIBRARIES
+#include <stdint.h>
+#include <string.h>
+
+//MBR PARTITION TABLE: FOUR 16 BYTE ENTRIES AT 0x1BE OF THE MBR AND OF EVERY EBR
+#define MBR_TABLE_OFFSET 0x1BE
+#define MBR_ENTRY_SIZE 16
+#define MBR_ENTRY_TYPE 0x04 //PARTITION TYPE BYTE
+#define MBR_ENTRY_LBA 0x08 //32 BIT FIRST SECTOR
+#define MBR_ENTRY_SECTORS 0x0C //32 BIT SECTOR COUNT
+#define MBR_SIGNATURE 0x1FE //0x55 0xAA
+
+//GPT HEADER (LBA 1) AND PARTITION ENTRIES
+#define GPT_HEADER_MIN 92 //BYTES OF THE HEADER READ
+#define GPT_HEADER_ENTRY_LBA 0x48 //64 BIT LBA OF THE PARTITION ENTRY ARRAY
+#define GPT_HEADER_ENTRY_COUNT 0x50 //32 BIT NUMBER OF ENTRIES
+#define GPT_HEADER_ENTRY_SIZE 0x54 //32 BIT SIZE OF EACH ENTRY
+#define GPT_ENTRY_TYPE_GUID 0x00 //16 BYTE TYPE GUID
+#define GPT_ENTRY_FIRST_LBA 0x20 //64 BIT
+#define GPT_ENTRY_LAST_LBA 0x28 //64 BIT, INCLUSIVE
+#define GPT_ENTRY_NAME 0x38 //36 UTF-16LE CHARACTERS
+#define GPT_ENTRY_NAME_UNITS 36
+
+//FAT BOOT SECTOR (BIOS PARAMETER BLOCK)
+#define FAT_BPB_BYTES_PER_SECTOR 0x0B //16 BIT
+#define FAT_BPB_SECTORS_PER_CLUSTER 0x0D //8 BIT
+#define FAT_BPB_RESERVED_SECTORS 0x0E //16 BIT
+#define FAT_BPB_FAT_COUNT 0x10 //8 BIT
+#define FAT_BPB_ROOT_ENTRIES 0x11 //16 BIT, 0 ON FAT32
+#define FAT_BPB_TOTAL_SECTORS16 0x13 //16 BIT, 0 IF THE 32 BIT COUNT IS USED
+#define FAT_BPB_MEDIA 0x15 //8 BIT MEDIA DESCRIPTOR (0xF0 OR ABOVE)
+#define FAT_BPB_FAT_SIZE16 0x16 //16 BIT SECTORS PER FAT, 0 ON FAT32
+#define FAT_BPB_TOTAL_SECTORS32 0x20 //32 BIT
+#define FAT_BPB_FAT_SIZE32 0x24 //32 BIT SECTORS PER FAT (FAT32)
+#define FAT_BPB_ROOT_CLUSTER 0x2C //32 BIT FIRST CLUSTER OF THE ROOT DIRECTORY (FAT32)
+#define FAT_BPB_BYTES 64 //BYTES OF THE BOOT SECTOR HOLDING THE FIELDS ABOVE
+
+//FAT DIRECTORY ENTRY (32 BYTES, LONG FILE NAME ENTRIES SHARE THE SIZE)
+#define FAT_DIRENT_SIZE 32
+#define FAT_DIRENT_ATTRIBUTES 0x0B //8 BIT (0x0F MARKS A LONG FILE NAME ENTRY)
+#define FAT_DIRENT_CREATED_TENTHS 0x0D //8 BIT, 10 ms UNITS (LONG NAME ENTRIES KEEP THEIR CHECKSUM HERE)
+#define FAT_DIRENT_CREATED_TIME 0x0E //16 BIT DOS TIME
+#define FAT_DIRENT_CREATED_DATE 0x10 //16 BIT DOS DATE
+#define FAT_DIRENT_ACCESSED_DATE 0x12 //16 BIT DOS DATE
+#define FAT_DIRENT_CLUSTER_HIGH 0x14 //16 BIT HIGH HALF OF THE FIRST CLUSTER (FAT32)
+#define FAT_DIRENT_MODIFIED_TIME 0x16 //16 BIT DOS TIME
+#define FAT_DIRENT_MODIFIED_DATE 0x18 //16 BIT DOS DATE
+#define FAT_DIRENT_CLUSTER_LOW 0x1A //16 BIT LOW HALF OF THE FIRST CLUSTER
+#define FAT_DIRENT_FILE_SIZE 0x1C //32 BIT
+#define FAT_LFN_CHECKSUM 0x0D //8 BIT CHECKSUM OF THE SHORT NAME
+
+//NTFS BOOT SECTOR
+#define NTFS_BOOT_OEM_ID 0x03 //"NTFS    "
+#define NTFS_BOOT_BYTES_PER_SECTOR 0x0B //16 BIT
+#define NTFS_BOOT_SECTORS_PER_CLUSTER 0x0D //8 BIT, ABOVE 0x80 MEANS 2^(256-VALUE)
+#define NTFS_BOOT_TOTAL_SECTORS 0x28 //64 BIT
+#define NTFS_BOOT_MFT_CLUSTER 0x30 //64 BIT LCN OF THE $MFT
+#define NTFS_BOOT_RECORD_SIZE 0x40 //SIGNED 8 BIT: CLUSTERS PER FILE RECORD, NEGATIVE MEANS 2^(-VALUE) BYTES
+
+//MFT FILE RECORD HEADER
+#define MFT_RECORD_USA_OFFSET 0x04 //16 BIT OFFSET OF THE UPDATE SEQUENCE ARRAY
+#define MFT_RECORD_USA_COUNT 0x06 //16 BIT ENTRIES IN IT (SEQUENCE NUMBER + 1 PER SECTOR)
+#define MFT_RECORD_SEQUENCE 0x10 //16 BIT
+#define MFT_RECORD_LINK_COUNT 0x12 //16 BIT
+#define MFT_RECORD_ATTRIBUTE_OFFSET 0x14 //16 BIT OFFSET OF THE FIRST ATTRIBUTE
+#define MFT_RECORD_FLAGS 0x16 //16 BIT: IN USE 0x01, DIRECTORY 0x02
+#define MFT_RECORD_USED_SIZE 0x18 //32 BIT
+#define MFT_RECORD_BASE_RECORD 0x20 //64 BIT FILE REFERENCE OF THE BASE RECORD
+#define MFT_RECORD_HEADER_MIN 32 //BYTES OF THE HEADER READ TO FIND THE FIRST ATTRIBUTE
+
+//MFT ATTRIBUTE HEADER (COMMON PART, THEN RESIDENT OR NON-RESIDENT)
+#define MFT_ATTR_TYPE 0x00 //32 BIT TYPE CODE (0xFFFFFFFF ENDS THE ATTRIBUTES)
+#define MFT_ATTR_LENGTH 0x04 //32 BIT
+#define MFT_ATTR_NON_RESIDENT 0x08 //8 BIT
+#define MFT_ATTR_NAME_LENGTH 0x09 //8 BIT, UTF-16 CHARACTERS
+#define MFT_ATTR_NAME_OFFSET 0x0A //16 BIT
+#define MFT_ATTR_FLAGS 0x0C //16 BIT
+#define MFT_ATTR_ID 0x0E //16 BIT
+#define MFT_ATTR_CONTENT_LENGTH 0x10 //RESIDENT: 32 BIT
+#define MFT_ATTR_CONTENT_OFFSET 0x14 //RESIDENT: 16 BIT
+#define MFT_ATTR_START_VCN 0x10 //NON-RESIDENT: 64 BIT
+#define MFT_ATTR_LAST_VCN 0x18 //NON-RESIDENT: 64 BIT
+#define MFT_ATTR_RUNLIST_OFFSET 0x20 //NON-RESIDENT: 16 BIT
+#define MFT_ATTR_ALLOCATED_SIZE 0x28 //NON-RESIDENT: 64 BIT
+#define MFT_ATTR_REAL_SIZE 0x30 //NON-RESIDENT: 64 BIT
+#define MFT_ATTR_INITIALIZED_SIZE 0x38 //NON-RESIDENT: 64 BIT
+#define MFT_ATTR_NON_RESIDENT_MIN 0x40 //SHORTEST NON-RESIDENT HEADER
+
+//$STANDARD_INFORMATION CONTENT
+#define STDINFO_CREATED 0x00 //64 BIT FILETIMES
+#define STDINFO_MODIFIED 0x08
+#define STDINFO_MFT_MODIFIED 0x10
+#define STDINFO_ACCESSED 0x18
+#define STDINFO_FILE_ATTRIBUTES 0x20 //32 BIT
+#define STDINFO_MIN 0x24
+
+//$FILE_NAME CONTENT (ALSO THE KEY OF A $I30 INDEX ENTRY)
+#define FILENAME_PARENT 0x00 //64 BIT FILE REFERENCE
+#define FILENAME_CREATED 0x08 //64 BIT FILETIMES
+#define FILENAME_MODIFIED 0x10
+#define FILENAME_MFT_MODIFIED 0x18
+#define FILENAME_ACCESSED 0x20
+#define FILENAME_ALLOCATED_SIZE 0x28 //64 BIT
+#define FILENAME_REAL_SIZE 0x30 //64 BIT
+#define FILENAME_FLAGS 0x38 //32 BIT
+#define FILENAME_NAME_LENGTH 0x40 //8 BIT, UTF-16 CHARACTERS
+#define FILENAME_NAME_SPACE 0x41 //8 BIT
+#define FILENAME_NAME 0x42 //UTF-16LE NAME
+
+//$INDEX_ROOT, INDEX NODE HEADER AND INDEX ENTRY
+#define NTFS_INDEX_ROOT_BLOCK_SIZE 0x08 //32 BIT BYTES PER INDEX BLOCK
+#define NTFS_INDEX_ROOT_NODE 0x10 //THE NODE HEADER FOLLOWS THE 16 BYTE ROOT HEADER
+#define NTFS_INDEX_NODE_ENTRIES_OFFSET 0x00 //32 BIT, FROM THE NODE HEADER
+#define NTFS_INDEX_NODE_ENTRIES_END 0x04 //32 BIT
+#define NTFS_INDEX_ENTRY_REFERENCE 0x00 //64 BIT FILE REFERENCE
+#define NTFS_INDEX_ENTRY_LENGTH 0x08 //16 BIT
+#define NTFS_INDEX_ENTRY_KEY_LENGTH 0x0A //16 BIT
+#define NTFS_INDEX_ENTRY_FLAGS 0x0C //16 BIT: 1 SUB-NODE, 2 LAST ENTRY
+#define NTFS_INDEX_ENTRY_KEY 0x10
+
+//$ATTRIBUTE_LIST ENTRY: ONE PER ATTRIBUTE OF A RECORD WHOSE ATTRIBUTES SPILL INTO EXTENSION RECORDS
+#define ATTRLIST_TYPE 0x00 //32 BIT TYPE CODE
+#define ATTRLIST_LENGTH 0x04 //16 BIT LENGTH OF THE ENTRY
+#define ATTRLIST_NAME_LENGTH 0x06 //8 BIT, UTF-16 CHARACTERS
+#define ATTRLIST_NAME_OFFSET 0x07 //8 BIT
+#define ATTRLIST_START_VCN 0x08 //64 BIT FIRST VCN OF THE FRAGMENT
+#define ATTRLIST_REFERENCE 0x10 //64 BIT FILE REFERENCE OF THE RECORD HOLDING THE ATTRIBUTE
+#define ATTRLIST_MIN 0x1A
+
+#define NTFS_REFERENCE_RECORD(reference) ((reference) & 0x0000FFFFFFFFFFFFULL) //FILE REFERENCE: 48 BIT RECORD NUMBER
+#define NTFS_REFERENCE_SEQUENCE(reference) ((unsigned short)((reference) >> 48)) //AND 16 BIT SEQUENCE NUMBER
+
+
+/*
+ * Function:  readLe16 
+ * --------------------
+ * Reads an unaligned 16 bit little endian field
+ * 
+ * field: First byte of the field
+ * uint16_t: The value
+ */
+static inline uint16_t readLe16(const unsigned char *field){
+	uint16_t value;
+	memcpy(&value, field, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	value = __builtin_bswap16(value);
+#endif
+	return value;
+}
+
+
+/*
+ * Function:  readLe32 
+ * --------------------
+ * Reads an unaligned 32 bit little endian field
+ * 
+ * field: First byte of the field
+ * uint32_t: The value
+ */
+static inline uint32_t readLe32(const unsigned char *field){
+	uint32_t value;
+	memcpy(&value, field, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	value = __builtin_bswap32(value);
+#endif
+	return value;
+}
+
+
+/*
+ * Function:  readLe64 
+ * --------------------
+ * Reads an unaligned 64 bit little endian field
+ * 
+ * field: First byte of the field
+ * uint64_t: The value
+ */
+static inline uint64_t readLe64(const unsigned char *field){
+	uint64_t value;
+	memcpy(&value, field, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	value = __builtin_bswap64(value);
+#endif
+	return value;
+}
+
+#endif
@@ -0,0 +1,599 @@
+/*
+ * ewfImage.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Expert Witness Format (E01) image backend
+ * Walks the section chain of every segment file to build one table of
+ * chunk locations, then serves reads by inflating chunks with zlib.
+ * Inflated chunks are kept in a bounded LRU cache (a hash of chunk
+ * numbers over a doubly linked recency list) shared by all threads.
+ * When a reader moves on to the next chunk a background thread starts
+ * inflating the chunks after it, so sequential scans rarely wait on zlib.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <zlib.h>
+#include "ewfImage.h"
+#include "scanStats.h"
+#include "diskLayout.h"
+
+#define EWF_SIGNATURE "EVF\x09\x0d\x0a\xff\x00" //START OF EVERY E01 SEGMENT FILE
+#define EWF_FILE_HEADER 13 //SIGNATURE, FIELDS START, SEGMENT NUMBER, FIELDS END
+#define EWF_SECTION_HEADER 76 //TYPE, NEXT OFFSET, SIZE, PADDING, CHECKSUM
+#define EWF_TABLE_HEADER 24 //ENTRY COUNT, PADDING, BASE OFFSET, PADDING, CHECKSUM
+#define EWF_COMPRESSED 0x80000000U //TABLE ENTRY FLAG FOR A ZLIB COMPRESSED CHUNK
+#define EWF_CACHE_BUCKETS (2*EWF_CACHE_CHUNKS) //HASH BUCKETS (A POWER OF TWO)
+#define EWF_NONE -1 //END OF A SLOT LIST
+
+struct EwfChunk{
+	uint64_t offset; //OFFSET OF THE STORED CHUNK IN ITS SEGMENT FILE
+	uint32_t size; //STORED SIZE (INCLUDING THE CHECKSUM OF AN UNCOMPRESSED CHUNK)
+	uint16_t segment; //INDEX OF THE SEGMENT FILE
+	uint8_t compressed;
+};
+
+struct EwfSlot{
+	uint64_t chunk; //CHUNK NUMBER HELD IN THE SLOT
+	int newer, older; //RECENCY LIST
+	int next; //NEXT SLOT IN THE SAME HASH BUCKET
+	unsigned char *data; //INFLATED CHUNK
+};
+
+struct EwfImage{
+	int *fds; //SEGMENT FILE DESCRIPTORS (.E01 FIRST)
+	size_t segmentCount;
+	struct EwfChunk *chunks; //EVERY CHUNK OF THE IMAGE IN ORDER
+	uint64_t chunkCount, chunkCapacity;
+	uint32_t chunkSize; //BYTES PER INFLATED CHUNK (SECTORS PER CHUNK * BYTES PER SECTOR)
+	pthread_mutex_t lock; //GUARDS THE CACHE AND THE READ AHEAD WINDOW
+	pthread_cond_t wake;
+	struct EwfSlot slots[EWF_CACHE_CHUNKS];
+	int buckets[EWF_CACHE_BUCKETS];
+	int usedSlots; //SLOTS HOLDING A CHUNK
+	int newest, oldest; //ENDS OF THE RECENCY LIST
+	uint64_t lastChunk; //LAST CHUNK A READER ASKED FOR
+	uint64_t aheadNext, aheadEnd; //CHUNKS STILL TO BE INFLATED AHEAD OF THE READER
+	pthread_t aheadThread;
+	int threadStarted, stopping;
+};
+
+static int probeEwfImage(const char *fileName, const unsigned char *header, size_t length);
+static int openEwfImage(const char *fileName, struct DiskImage *image);
+static int readEwfImage(struct DiskImage *image, uint64_t offset, unsigned char *buffer, size_t length);
+static void closeEwfImage(struct DiskImage *image);
+static int openEwfSegments(const char *fileName, struct EwfImage *ewf);
+static int parseEwfSegment(struct DiskImage *image, struct EwfImage *ewf, uint16_t segment);
+static int parseEwfTable(struct EwfImage *ewf, uint16_t segment, uint64_t sectionOffset, uint64_t sectorsEnd);
+static int inflateEwfChunk(struct EwfImage *ewf, uint64_t chunk, unsigned char *output, unsigned char *input);
+static int fetchCachedChunk(struct EwfImage *ewf, uint64_t chunk);
+static int storeCachedChunk(struct EwfImage *ewf, uint64_t chunk, const unsigned char *data);
+static void unlinkCacheSlot(struct EwfImage *ewf, int slot);
+static void *readAheadEwf(void *arg);
+
+const struct ImageBackend ewfImageBackend = {"ewf", probeEwfImage, openEwfImage, readEwfImage, NULL, closeEwfImage};
+
+
+/*
+ * Function:  probeEwfImage 
+ * --------------------
+ * Recognises an E01 segment by its signature
+ * 
+ * fileName: The fileName of the disk image
+ * header: The first bytes of the file
+ * length: Number of bytes in header
+ * int: 1 if the file is an EWF segment, 0 otherwise
+ */
+static int probeEwfImage(const char *fileName, const unsigned char *header, size_t length){
+	return length >= EWF_FILE_HEADER && memcmp(header, EWF_SIGNATURE, 8) == 0;
+}
+
+
+/*
+ * Function:  openEwfImage 
+ * --------------------
+ * Opens every segment, builds the chunk table and starts the read ahead thread
+ * 
+ * fileName: The fileName of the .E01 segment
+ * image: Pointer to the image struct to be filled in
+ * int: 0 on success, -1 on failure (errno is set)
+ */
+static int openEwfImage(const char *fileName, struct DiskImage *image){
+	//DATA DECLARATION
+	struct EwfImage *ewf;
+	size_t s;
+	int i;
+	//DATA MANIPULATION
+	ewf = calloc(1, sizeof(*ewf));
+	if(ewf == NULL){
+		return -1;
+	}
+	image->state = ewf;
+	pthread_mutex_init(&ewf->lock, NULL);
+	pthread_cond_init(&ewf->wake, NULL);
+	ewf->newest = ewf->oldest = EWF_NONE;
+	ewf->lastChunk = UINT64_MAX;
+	for(i=0;i<EWF_CACHE_BUCKETS;i++){
+		ewf->buckets[i] = EWF_NONE;
+	}
+	if(openEwfSegments(fileName, ewf) != 0){
+		closeEwfImage(image);
+		return -1;
+	}
+	for(s=0;s<ewf->segmentCount;s++){
+		if(parseEwfSegment(image, ewf, (uint16_t)s) != 0){
+			closeEwfImage(image);
+			return -1;
+		}
+	}
+	if(ewf->chunkSize == 0 || ewf->chunkCount < (image->size + ewf->chunkSize - 1)/ewf->chunkSize){ //NO VOLUME SECTION OR MISSING TABLES
+		closeEwfImage(image);
+		errno = EINVAL;
+		return -1;
+	}
+	for(i=0;i<EWF_CACHE_CHUNKS;i++){
+		ewf->slots[i].data = malloc(ewf->chunkSize);
+		if(ewf->slots[i].data == NULL){
+			closeEwfImage(image);
+			return -1;
+		}
+	}
+	if(pthread_create(&ewf->aheadThread, NULL, readAheadEwf, ewf) == 0){ //WITHOUT IT READS STILL WORK, JUST WITHOUT READ AHEAD
+		ewf->threadStarted = 1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  readEwfImage 
+ * --------------------
+ * Copies a range of the image out of the chunk cache, inflating missing chunks
+ * Moving on to the chunk after the previous one widens the read ahead window
+ * 
+ * image: The open disk image
+ * offset: Byte offset into the image
+ * buffer: Buffer to read into
+ * length: Number of bytes to read (inside the image)
+ * int: 0 on success, -1 if a chunk could not be read or inflated (errno is set)
+ */
+static int readEwfImage(struct DiskImage *image, uint64_t offset, unsigned char *buffer, size_t length){
+	//DATA DECLARATION
+	struct EwfImage *ewf = image->state;
+	unsigned char *inflated = NULL, *stored = NULL;
+	uint64_t chunk;
+	size_t within, part;
+	int slot, status = 0;
+	//DATA MANIPULATION
+	while(length > 0 && status == 0){
+		chunk = offset/ewf->chunkSize;
+		within = (size_t)(offset % ewf->chunkSize);
+		part = (length < ewf->chunkSize - within) ? length : ewf->chunkSize - within;
+		pthread_mutex_lock(&ewf->lock);
+		if(chunk == ewf->lastChunk + 1){ //SEQUENTIAL, KEEP THE READ AHEAD WINDOW IN FRONT OF THE READER
+			if(ewf->aheadNext <= chunk || ewf->aheadNext > chunk + 1 + EWF_READ_AHEAD){ //THE READER JUMPED SINCE THE WINDOW WAS SET
+				ewf->aheadNext = chunk + 1;
+			}
+			ewf->aheadEnd = (chunk + 1 + EWF_READ_AHEAD < ewf->chunkCount) ? chunk + 1 + EWF_READ_AHEAD : ewf->chunkCount;
+			pthread_cond_signal(&ewf->wake);
+		}
+		ewf->lastChunk = chunk;
+		slot = fetchCachedChunk(ewf, chunk);
+		if(slot != EWF_NONE){
+			memcpy(buffer, ewf->slots[slot].data + within, part);
+		}
+		pthread_mutex_unlock(&ewf->lock);
+		countStat((slot != EWF_NONE) ? &statsCounters.cacheHits : &statsCounters.cacheMisses, 1);
+		if(slot == EWF_NONE){ //MISS, INFLATE WITHOUT HOLDING THE LOCK SO OTHER READERS CAN CONTINUE
+			if(inflated == NULL){
+				inflated = malloc(ewf->chunkSize);
+				stored = malloc(2*(size_t)ewf->chunkSize + 64);
+			}
+			if(inflated == NULL || stored == NULL || inflateEwfChunk(ewf, chunk, inflated, stored) != 0){
+				status = -1;
+				break;
+			}
+			memcpy(buffer, inflated + within, part);
+			pthread_mutex_lock(&ewf->lock);
+			storeCachedChunk(ewf, chunk, inflated);
+			pthread_mutex_unlock(&ewf->lock);
+		}
+		buffer += part;
+		offset += part;
+		length -= part;
+	}
+	free(inflated);
+	free(stored);
+	return status;
+}
+
+
+/*
+ * Function:  closeEwfImage 
+ * --------------------
+ * Stops the read ahead thread, closes the segments and frees the cache
+ * 
+ * image: Pointer to the image struct to be closed
+ */
+static void closeEwfImage(struct DiskImage *image){
+	struct EwfImage *ewf = image->state;
+	size_t s;
+	int i;
+	if(ewf == NULL){
+		return;
+	}
+	if(ewf->threadStarted){
+		pthread_mutex_lock(&ewf->lock);
+		ewf->stopping = 1;
+		pthread_cond_signal(&ewf->wake);
+		pthread_mutex_unlock(&ewf->lock);
+		pthread_join(ewf->aheadThread, NULL);
+	}
+	for(s=0;s<ewf->segmentCount;s++){
+		close(ewf->fds[s]);
+	}
+	for(i=0;i<EWF_CACHE_CHUNKS;i++){
+		free(ewf->slots[i].data);
+	}
+	pthread_mutex_destroy(&ewf->lock);
+	pthread_cond_destroy(&ewf->wake);
+	free(ewf->fds);
+	free(ewf->chunks);
+	free(ewf);
+	image->state = NULL;
+}
+
+
+/*
+ * Function:  openEwfSegments 
+ * --------------------
+ * Opens the .E01 file and each following segment (.E02 to .E99, then .EAA to .EZZ)
+ * 
+ * fileName: The fileName of the .E01 segment
+ * ewf: The EWF state to add the descriptors to
+ * int: 0 on success, -1 if a segment could not be opened (errno is set)
+ */
+static int openEwfSegments(const char *fileName, struct EwfImage *ewf){
+	//DATA DECLARATION
+	size_t nameLength = strlen(fileName);
+	char *segmentName;
+	unsigned int number;
+	int fd;
+	//DATA MANIPULATION
+	ewf->fds = malloc(EWF_MAX_SEGMENTS*sizeof(int));
+	segmentName = malloc(nameLength + 1);
+	if(ewf->fds == NULL || segmentName == NULL){
+		free(segmentName);
+		return -1;
+	}
+	memcpy(segmentName, fileName, nameLength + 1);
+	for(number=1;number<=EWF_MAX_SEGMENTS;number++){
+		if(number > 1){ //THE FIRST SEGMENT IS OPENED BY THE NAME GIVEN, WHATEVER ITS EXTENSION
+			if(nameLength < 2){
+				break;
+			}
+			if(number <= 99){
+				segmentName[nameLength-2] = (char)('0' + number/10);
+				segmentName[nameLength-1] = (char)('0' + number%10);
+			}else{
+				segmentName[nameLength-2] = (char)('A' + (number - 100)/26);
+				segmentName[nameLength-1] = (char)('A' + (number - 100)%26);
+			}
+		}
+		fd = open(segmentName, O_RDONLY);
+		if(fd < 0){
+			if(number > 1 && errno == ENOENT){ //NO MORE SEGMENTS
+				break;
+			}
+			free(segmentName);
+			return -1;
+		}
+		ewf->fds[ewf->segmentCount++] = fd;
+	}
+	free(segmentName);
+	return 0;
+}
+
+
+/*
+ * Function:  parseEwfSegment 
+ * --------------------
+ * Follows the section chain of one segment file
+ * The volume (or disk) section gives the chunk and image size, and each table
+ * section appends the chunks stored in the sectors section before it
+ * 
+ * image: The image, whose size is set from the volume section
+ * ewf: The EWF state
+ * segment: Index of the segment file
+ * int: 0 on success, -1 if the segment is not a valid EWF segment (errno is set)
+ */
+static int parseEwfSegment(struct DiskImage *image, struct EwfImage *ewf, uint16_t segment){
+	//DATA DECLARATION
+	unsigned char header[EWF_SECTION_HEADER], volume[24];
+	uint64_t offset = EWF_FILE_HEADER, next, size, sectorsEnd = 0;
+	char type[17];
+	//DATA MANIPULATION
+	if(pread(ewf->fds[segment], header, EWF_FILE_HEADER, 0) != EWF_FILE_HEADER || memcmp(header, EWF_SIGNATURE, 8) != 0){
+		errno = EINVAL;
+		return -1;
+	}
+	for(;;){
+		if(pread(ewf->fds[segment], header, EWF_SECTION_HEADER, (off_t)offset) != EWF_SECTION_HEADER){
+			errno = EINVAL;
+			return -1;
+		}
+		memcpy(type, header, 16);
+		type[16] = '\0';
+		next = readLe64(header + 16); //OFFSET OF THE NEXT SECTION IN THIS SEGMENT
+		size = readLe64(header + 24); //SIZE OF THE SECTION INCLUDING THIS HEADER
+		if(strcmp(type, "volume") == 0 || strcmp(type, "disk") == 0){
+			if(pread(ewf->fds[segment], volume, sizeof(volume), (off_t)(offset + EWF_SECTION_HEADER)) != sizeof(volume)){
+				errno = EINVAL;
+				return -1;
+			}
+			ewf->chunkSize = readLe32(volume + 8) * readLe32(volume + 12); //SECTORS PER CHUNK * BYTES PER SECTOR
+			image->size = readLe64(volume + 16) * readLe32(volume + 12); //SECTOR COUNT * BYTES PER SECTOR
+		}else if(strcmp(type, "sectors") == 0){
+			sectorsEnd = offset + size; //THE LAST CHUNK OF THE NEXT TABLE ENDS HERE
+		}else if(strcmp(type, "table") == 0){ //"table2" IS A BACKUP COPY AND IS SKIPPED
+			if(ewf->chunkSize == 0 || parseEwfTable(ewf, segment, offset, sectorsEnd) != 0){
+				errno = EINVAL;
+				return -1;
+			}
+		}
+		if(strcmp(type, "next") == 0 || strcmp(type, "done") == 0 || next <= offset){ //LAST SECTION OF THE SEGMENT
+			break;
+		}
+		offset = next;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  parseEwfTable 
+ * --------------------
+ * Appends the chunks listed by a table section to the chunk table
+ * Entry offsets are relative to the table's base offset and the stored size
+ * of a chunk runs to the next entry (or to the end of the sectors section)
+ * 
+ * ewf: The EWF state
+ * segment: Index of the segment file
+ * sectionOffset: Offset of the table section header in the segment
+ * sectorsEnd: End of the sectors section holding the chunks (0 if not seen)
+ * int: 0 on success, -1 on a malformed table or when out of memory
+ */
+static int parseEwfTable(struct EwfImage *ewf, uint16_t segment, uint64_t sectionOffset, uint64_t sectorsEnd){
+	//DATA DECLARATION
+	unsigned char header[EWF_TABLE_HEADER];
+	uint32_t *entries, entryCount, i;
+	uint64_t base, start, end;
+	struct EwfChunk *grown;
+	uint64_t capacity;
+	//DATA MANIPULATION
+	if(pread(ewf->fds[segment], header, EWF_TABLE_HEADER, (off_t)(sectionOffset + EWF_SECTION_HEADER)) != EWF_TABLE_HEADER){
+		return -1;
+	}
+	entryCount = readLe32(header);
+	base = readLe64(header + 8);
+	if(entryCount == 0){
+		return 0;
+	}
+	entries = malloc((size_t)entryCount*sizeof(uint32_t));
+	if(entries == NULL){
+		return -1;
+	}
+	if(pread(ewf->fds[segment], entries, (size_t)entryCount*sizeof(uint32_t), (off_t)(sectionOffset + EWF_SECTION_HEADER + EWF_TABLE_HEADER)) != (ssize_t)(entryCount*sizeof(uint32_t))){
+		free(entries);
+		return -1;
+	}
+	for(i=0;i<entryCount;i++){ //ENTRIES ARE LITTLE ENDIAN ON DISK
+		entries[i] = readLe32((const unsigned char*)&entries[i]);
+	}
+	if(ewf->chunkCount + entryCount > ewf->chunkCapacity){
+		capacity = ewf->chunkCapacity ? ewf->chunkCapacity : 1024;
+		while(capacity < ewf->chunkCount + entryCount){
+			capacity *= 2;
+		}
+		grown = realloc(ewf->chunks, (size_t)capacity*sizeof(*grown));
+		if(grown == NULL){
+			free(entries);
+			return -1;
+		}
+		ewf->chunks = grown;
+		ewf->chunkCapacity = capacity;
+	}
+	for(i=0;i<entryCount;i++){
+		start = base + (entries[i] & ~EWF_COMPRESSED);
+		if(i + 1 < entryCount){
+			end = base + (entries[i+1] & ~EWF_COMPRESSED);
+		}else{
+			end = (sectorsEnd > start) ? sectorsEnd : sectionOffset; //THE TABLE FOLLOWS ITS SECTORS SECTION
+		}
+		if(end <= start || end - start > 2*(uint64_t)ewf->chunkSize + 64){ //CORRUPT OR OUT OF ORDER ENTRY
+			free(entries);
+			return -1;
+		}
+		ewf->chunks[ewf->chunkCount].offset = start;
+		ewf->chunks[ewf->chunkCount].size = (uint32_t)(end - start);
+		ewf->chunks[ewf->chunkCount].segment = segment;
+		ewf->chunks[ewf->chunkCount].compressed = (entries[i] & EWF_COMPRESSED) != 0;
+		ewf->chunkCount++;
+	}
+	free(entries);
+	return 0;
+}
+
+
+/*
+ * Function:  inflateEwfChunk 
+ * --------------------
+ * Reads one stored chunk and inflates it (or copies it when stored uncompressed)
+ * 
+ * ewf: The EWF state
+ * chunk: Chunk number
+ * output: Buffer of chunkSize bytes for the inflated chunk
+ * input: Buffer of at least 2*chunkSize+64 bytes for the stored chunk
+ * int: 0 on success, -1 on a read or zlib error (errno is set)
+ */
+static int inflateEwfChunk(struct EwfImage *ewf, uint64_t chunk, unsigned char *output, unsigned char *input){
+	const struct EwfChunk *stored;
+	uLongf outputLength = ewf->chunkSize;
+	size_t wanted;
+	if(chunk >= ewf->chunkCount){
+		errno = EIO;
+		return -1;
+	}
+	stored = &ewf->chunks[chunk];
+	wanted = stored->compressed ? stored->size : ((stored->size < ewf->chunkSize) ? stored->size : ewf->chunkSize); //SKIP THE CHECKSUM AFTER RAW DATA
+	countStat(&statsCounters.readCalls, 1);
+	if(pread(ewf->fds[stored->segment], stored->compressed ? input : output, wanted, (off_t)stored->offset) != (ssize_t)wanted){
+		errno = EIO;
+		return -1;
+	}
+	if(stored->compressed && uncompress(output, &outputLength, input, stored->size) != Z_OK){
+		errno = EIO;
+		return -1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  fetchCachedChunk 
+ * --------------------
+ * Looks a chunk up in the cache and marks it most recently used
+ * Called with the lock held
+ * 
+ * ewf: The EWF state
+ * chunk: Chunk number
+ * int: Slot holding the chunk, EWF_NONE if it is not cached
+ */
+static int fetchCachedChunk(struct EwfImage *ewf, uint64_t chunk){
+	int slot = ewf->buckets[chunk & (EWF_CACHE_BUCKETS - 1)];
+	while(slot != EWF_NONE && ewf->slots[slot].chunk != chunk){
+		slot = ewf->slots[slot].next;
+	}
+	if(slot != EWF_NONE && slot != ewf->newest){ //MOVE TO THE FRONT OF THE RECENCY LIST
+		unlinkCacheSlot(ewf, slot);
+		ewf->slots[slot].older = ewf->newest;
+		ewf->slots[slot].newer = EWF_NONE;
+		ewf->slots[ewf->newest].newer = slot;
+		ewf->newest = slot;
+	}
+	return slot;
+}
+
+
+/*
+ * Function:  storeCachedChunk 
+ * --------------------
+ * Copies an inflated chunk into a free slot, or the least recently used one
+ * Called with the lock held
+ * 
+ * ewf: The EWF state
+ * chunk: Chunk number
+ * data: The inflated chunk
+ * int: Slot now holding the chunk
+ */
+static int storeCachedChunk(struct EwfImage *ewf, uint64_t chunk, const unsigned char *data){
+	int slot = fetchCachedChunk(ewf, chunk), *link;
+	if(slot != EWF_NONE){ //ANOTHER THREAD GOT THERE FIRST
+		return slot;
+	}
+	if(ewf->usedSlots < EWF_CACHE_CHUNKS){ //SLOTS ARE FILLED IN ORDER UNTIL THE CACHE IS FULL
+		slot = ewf->usedSlots++;
+	}else{ //EVICT THE LEAST RECENTLY USED CHUNK
+		slot = ewf->oldest;
+		unlinkCacheSlot(ewf, slot);
+		link = &ewf->buckets[ewf->slots[slot].chunk & (EWF_CACHE_BUCKETS - 1)];
+		while(*link != slot){
+			link = &ewf->slots[*link].next;
+		}
+		*link = ewf->slots[slot].next;
+	}
+	memcpy(ewf->slots[slot].data, data, ewf->chunkSize);
+	ewf->slots[slot].chunk = chunk;
+	ewf->slots[slot].next = ewf->buckets[chunk & (EWF_CACHE_BUCKETS - 1)];
+	ewf->buckets[chunk & (EWF_CACHE_BUCKETS - 1)] = slot;
+	ewf->slots[slot].newer = EWF_NONE;
+	ewf->slots[slot].older = ewf->newest;
+	if(ewf->newest != EWF_NONE){
+		ewf->slots[ewf->newest].newer = slot;
+	}
+	ewf->newest = slot;
+	if(ewf->oldest == EWF_NONE){
+		ewf->oldest = slot;
+	}
+	return slot;
+}
+
+
+/*
+ * Function:  unlinkCacheSlot 
+ * --------------------
+ * Removes a slot from the recency list
+ * 
+ * ewf: The EWF state
+ * slot: The slot to remove
+ */
+static void unlinkCacheSlot(struct EwfImage *ewf, int slot){
+	struct EwfSlot *entry = &ewf->slots[slot];
+	if(entry->newer != EWF_NONE){
+		ewf->slots[entry->newer].older = entry->older;
+	}else{
+		ewf->newest = entry->older;
+	}
+	if(entry->older != EWF_NONE){
+		ewf->slots[entry->older].newer = entry->newer;
+	}else{
+		ewf->oldest = entry->newer;
+	}
+	entry->newer = entry->older = EWF_NONE;
+}
+
+
+/*
+ * Function:  readAheadEwf 
+ * --------------------
+ * Background thread inflating the chunks in the read ahead window
+ * so they are cached before a sequential reader reaches them
+ * 
+ * arg: The EWF state
+ * void*: Always NULL
+ */
+static void *readAheadEwf(void *arg){
+	struct EwfImage *ewf = arg;
+	unsigned char *inflated = malloc(ewf->chunkSize), *stored = malloc(2*(size_t)ewf->chunkSize + 64);
+	uint64_t chunk;
+	int cached;
+	pthread_mutex_lock(&ewf->lock);
+	while(!ewf->stopping && inflated != NULL && stored != NULL){
+		if(ewf->aheadNext >= ewf->aheadEnd){
+			pthread_cond_wait(&ewf->wake, &ewf->lock);
+			continue;
+		}
+		chunk = ewf->aheadNext++;
+		cached = (fetchCachedChunk(ewf, chunk) != EWF_NONE);
+		pthread_mutex_unlock(&ewf->lock);
+		if(!cached && inflateEwfChunk(ewf, chunk, inflated, stored) == 0){
+			pthread_mutex_lock(&ewf->lock);
+			storeCachedChunk(ewf, chunk, inflated);
+		}else{
+			pthread_mutex_lock(&ewf->lock);
+		}
+	}
+	pthread_mutex_unlock(&ewf->lock);
+	free(inflated);
+	free(stored);
+	return NULL;
+}
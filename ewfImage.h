@@ -0,0 +1,26 @@
+/*
+ * ewfImage.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Expert Witness Format (E01) image backend
+ * Reads EnCase EWF-E01 images split over .E01, .E02... segment files.
+ * Chunks are inflated on demand into a bounded LRU cache, and a
+ * background thread inflates the chunks ahead of a sequential reader.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef EWFIMAGE_H
+#define EWFIMAGE_H
+
+//IMPORTED LIBRARIES
+#include "diskImage.h"
+
+#define EWF_CACHE_CHUNKS 256 //INFLATED CHUNKS KEPT IN MEMORY (8 MiB WITH THE USUAL 32 KiB CHUNKS)
+#define EWF_READ_AHEAD 16 //CHUNKS INFLATED AHEAD OF A SEQUENTIAL READER
+#define EWF_MAX_SEGMENTS 775 //.E01 TO .E99 THEN .EAA TO .EZZ
+
+extern const struct ImageBackend ewfImageBackend;
+
+#endif
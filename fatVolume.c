@@ -0,0 +1,648 @@
+/*
+ * fatVolume.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: FAT directory and deleted file parsing
+ * Walks the root directory and every subdirectory of the FAT volume
+ * held in the volume model. Directories are read a whole run of
+ * contiguous clusters at a time rather than one entry at a time.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "fatVolume.h"
+#include "nameConvert.h"
+#include "diskLayout.h"
+
+#define DIRECTORY_BATCH_BYTES (256*1024) //LARGEST RUN OF DIRECTORY CLUSTERS READ IN ONE VIEW
+#define LFN_MAX_PARTS 20 //A LONG FILE NAME USES AT MOST 20 ENTRIES OF 13 CHARACTERS
+
+struct DirectoryTask{
+	unsigned int cluster; //FIRST CLUSTER OF THE DIRECTORY (0 FOR THE FAT12/16 ROOT DIRECTORY)
+	int deleted; //1 IF THE DIRECTORY ITSELF WAS DELETED
+	char *path; //PATH OF THE DIRECTORY
+};
+
+struct FatWalker{
+	struct DiskImage *image;
+	struct FatVolume *fat;
+	int (*visit)(const struct FatDirEntry *entry, void *context);
+	void *context;
+	struct DirectoryTask *tasks; //QUEUE OF DIRECTORIES STILL TO BE READ
+	size_t taskCount, taskCapacity, taskHead;
+	unsigned char *visited; //ONE BIT PER CLUSTER, STOPS DIRECTORY LOOPS
+	unsigned char *scratch; //BUFFER FOR THE PREAD FALLBACK
+	unsigned char lfnParts[LFN_MAX_PARTS][26]; //UTF-16LE CHARACTERS OF THE LONG FILE NAME ENTRIES IN THE ORDER THEY WERE READ
+	int lfnCount;
+	unsigned char lfnChecksum;
+	struct FatDirEntry entry;
+};
+
+static int readDirectory(struct FatWalker *walker, struct DirectoryTask *task);
+static int parseDirectoryBlock(struct FatWalker *walker, const unsigned char *block, size_t length, uint64_t offset, struct DirectoryTask *task);
+static int handleShortEntry(struct FatWalker *walker, const unsigned char *raw, uint64_t offset, struct DirectoryTask *task);
+static int queueDirectory(struct FatWalker *walker, unsigned int cluster, int deleted, const char *path);
+static int isDirectoryCluster(struct FatWalker *walker, unsigned int cluster);
+static unsigned char fetchShortNameChecksum(const unsigned char *shortName);
+static void assembleLongName(struct FatWalker *walker, char *longName);
+
+
+/*
+ * Function:  walkFatDirectories
+ * --------------------
+ * Visits every entry (live and deleted) of the root directory and all subdirectories
+ * Directories are read breadth first from a queue so a view of one directory
+ * is never still in use while the next is read
+ * Deleted subdirectories are followed when their first cluster still holds
+ * a "." entry, their cluster chain is gone so only that cluster is read
+ *
+ * image: The open disk image
+ * fat: The FAT volume of the volume model
+ * visit: Called for each entry, a non zero return stops the walk
+ * context: Passed through to visit
+ * int: 0 when the walk finished, the non zero value returned by visit, -1 on allocation failure
+ */
+int walkFatDirectories(struct DiskImage *image, struct FatVolume *fat, int (*visit)(const struct FatDirEntry *entry, void *context), void *context){
+	//DATA DECLARATION
+	struct FatWalker *walker;
+	struct DirectoryTask task;
+	size_t scratchSize;
+	int status = 0;
+	//DATA MANIPULATION
+	if(!fat->present){
+		return 0;
+	}
+	walker = calloc(1, sizeof(*walker));
+	if(walker == NULL){
+		return -1;
+	}
+	walker->image = image;
+	walker->fat = fat;
+	walker->visit = visit;
+	walker->context = context;
+	walker->visited = calloc(((size_t)fat->clusterCount + 2)/8 + 1, 1);
+	scratchSize = (size_t)fat->rootDirSize*fat->bytesPerSector;
+	if(scratchSize < DIRECTORY_BATCH_BYTES){
+		scratchSize = DIRECTORY_BATCH_BYTES;
+	}
+	if((size_t)fat->sectorsPerCluster*fat->bytesPerSector > scratchSize){
+		scratchSize = (size_t)fat->sectorsPerCluster*fat->bytesPerSector;
+	}
+	walker->scratch = (image->map == NULL) ? malloc(scratchSize) : NULL; //ONLY NEEDED WHEN THE IMAGE IS NOT MAPPED
+	if(walker->visited == NULL || (image->map == NULL && walker->scratch == NULL)){
+		status = -1;
+	}else if(queueDirectory(walker, fat->fatBits == 32 ? fat->rootCluster : 0, 0, "") != 0){
+		status = -1;
+	}
+	while(status == 0 && walker->taskHead < walker->taskCount){ //READ DIRECTORIES IN THE ORDER THEY WERE FOUND
+		task = walker->tasks[walker->taskHead]; //COPIED BECAUSE QUEUEING SUBDIRECTORIES MAY MOVE THE QUEUE
+		walker->tasks[walker->taskHead++].path = NULL;
+		status = readDirectory(walker, &task);
+		free(task.path);
+	}
+	while(walker->taskHead < walker->taskCount){ //FREE ANY DIRECTORIES LEFT WHEN THE WALK WAS STOPPED
+		free(walker->tasks[walker->taskHead++].path);
+	}
+	free(walker->tasks);
+	free(walker->visited);
+	free(walker->scratch);
+	free(walker);
+	return status;
+}
+
+
+/*
+ * Function:  fetchFatEntry
+ * --------------------
+ * Looks up the entry for a cluster in the in-memory FAT index
+ * The index is loaded from the first FAT on first use so following
+ * a chain costs one array lookup per cluster
+ *
+ * image: The open disk image
+ * fat: The FAT volume of the volume model
+ * cluster: Cluster number whose FAT entry is read
+ * unsigned int: Next cluster in the chain, 0 for a free cluster,
+ *               FAT_CHAIN_END for end of chain, bad or unreadable clusters
+ */
+unsigned int fetchFatEntry(struct DiskImage *image, struct FatVolume *fat, unsigned int cluster){
+	unsigned int value;
+	if(fat->table == NULL && loadFatTable(image, fat) != 0){
+		return FAT_CHAIN_END;
+	}
+	if(cluster < 2 || cluster >= fat->tableEntries){
+		return FAT_CHAIN_END;
+	}
+	if(fat->fatBits == 32){
+		value = readLe32((const unsigned char*)fat->table + (size_t)cluster*4) & 0x0FFFFFFF; //TOP 4 BITS OF A FAT32 ENTRY ARE RESERVED
+		return (value >= 0x0FFFFFF7) ? FAT_CHAIN_END : value;
+	}
+	value = readLe16((const unsigned char*)fat->table + (size_t)cluster*2); //FAT12 ENTRIES WERE WIDENED TO 16 BITS WHEN LOADED
+	return (value >= 0xFFF7) ? FAT_CHAIN_END : value;
+}
+
+
+/*
+ * Function:  loadFatTable
+ * --------------------
+ * Loads the first FAT into a compact in-memory array indexed by cluster
+ * FAT16 and FAT32 tables are used in place as a view of the mapped image
+ * (only copied when the image is read with pread)
+ * FAT12 entries are packed 2 per 3 bytes so they are widened to 16 bit
+ * little endian entries like FAT16, with the FAT12 end of chain values
+ * moved up to the FAT16 range, so the index always reads in disk byte order
+ *
+ * image: The open disk image
+ * fat: The FAT volume of the volume model
+ * int: 0 on success, -1 if the FAT could not be read
+ */
+int loadFatTable(struct DiskImage *image, struct FatVolume *fat){
+	//DATA DECLARATION
+	uint64_t fatStart = fetchVolumeOffset(fat, fat->reserved);
+	size_t fatBytes = (size_t)fat->sizeOfFat*fat->bytesPerSector;
+	size_t entryBits = (size_t)fat->fatBits, capacity;
+	unsigned int entries = fat->clusterCount + 2, cluster, value;
+	const unsigned char *view;
+	unsigned char *buffer = NULL;
+	unsigned char *widened;
+	//DATA MANIPULATION
+	if(fat->table != NULL){
+		return 0;
+	}
+	capacity = fatBytes*8/entryBits; //NUMBER OF ENTRIES THE FAT CAN HOLD
+	if(entries > capacity){
+		entries = (unsigned int)capacity;
+	}
+	if(image->map == NULL){
+		buffer = malloc(fatBytes);
+		if(buffer == NULL){
+			return -1;
+		}
+	}
+	view = fetchImageView(image, fatStart, fatBytes, buffer);
+	if(view == NULL){
+		free(buffer);
+		return -1;
+	}
+	if(fat->fatBits == 12){
+		widened = malloc((size_t)entries*2);
+		if(widened == NULL){
+			free(buffer);
+			return -1;
+		}
+		for(cluster=0;cluster<entries;cluster++){
+			value = readLe16(view + cluster + cluster/2);
+			value = (cluster & 1) ? (value >> 4) : (value & 0x0FFF);
+			value = (value >= 0x0FF7) ? (value | 0xF000) : value;
+			widened[(size_t)cluster*2] = (unsigned char)(value & 0xFF); //STORED LITTLE ENDIAN LIKE A FAT16 ENTRY
+			widened[(size_t)cluster*2 + 1] = (unsigned char)(value >> 8);
+		}
+		free(buffer);
+		fat->tableBuffer = widened;
+		fat->table = widened;
+	}else{
+		fat->tableBuffer = buffer;
+		fat->table = view;
+	}
+	fat->tableEntries = entries;
+	return 0;
+}
+
+
+/*
+ * Function:  fetchFileExtents
+ * --------------------
+ * Builds the list of byte extents holding a file's content
+ * Contiguous clusters are joined into a single extent
+ * Live files follow their cluster chain in the FAT index
+ * Deleted files have no chain left so their clusters are taken from the start
+ * cluster onwards, skipping clusters that are allocated to other files
+ * The last extent is cut to the file size (directories keep their whole chain)
+ *
+ * image: The open disk image
+ * fat: The FAT volume of the volume model
+ * entry: Directory entry of the file
+ * extents: Extent list to fill in (free with freeFileExtents)
+ * int: 0 on success, -1 on allocation failure
+ */
+int fetchFileExtents(struct DiskImage *image, struct FatVolume *fat, const struct FatDirEntry *entry, struct FileExtents *extents){
+	//DATA DECLARATION
+	uint64_t clusterBytes = (uint64_t)fat->sectorsPerCluster*fat->bytesPerSector;
+	uint64_t wanted, offset;
+	unsigned int cluster, steps = 0;
+	int isDirectory = (entry->attributes & 0x10) != 0;
+	int deleted = entry->deleted || entry->parentDeleted;
+	struct ImageExtent *grown;
+	//DATA MANIPULATION
+	memset(extents, 0, sizeof(*extents));
+	if(entry->startCluster < 2 || entry->startCluster >= fat->clusterCount + 2){
+		extents->truncated = (entry->fileSize > 0);
+		return 0;
+	}
+	wanted = isDirectory ? (deleted ? clusterBytes : UINT64_MAX) : entry->fileSize;
+	cluster = entry->startCluster;
+	if(deleted && fetchFatEntry(image, fat, cluster) != 0){ //FIRST CLUSTER IN USE AGAIN
+		extents->overwritten = 1;
+	}
+	while(extents->length < wanted && steps++ <= fat->clusterCount){ //STEP LIMIT STOPS A LOOPING CHAIN
+		offset = fetchClusterOffset(fat, cluster);
+		if(extents->count > 0 && extents->extents[extents->count-1].offset + extents->extents[extents->count-1].length == offset){
+			extents->extents[extents->count-1].length += clusterBytes; //CLUSTER FOLLOWS ON FROM THE LAST EXTENT
+		}else{
+			if(extents->count == extents->capacity){
+				extents->capacity = extents->capacity ? extents->capacity*2 : 8;
+				grown = realloc(extents->extents, extents->capacity*sizeof(*grown));
+				if(grown == NULL){
+					freeFileExtents(extents);
+					return -1;
+				}
+				extents->extents = grown;
+			}
+			extents->extents[extents->count].offset = offset;
+			extents->extents[extents->count].length = clusterBytes;
+			extents->count++;
+		}
+		extents->length += clusterBytes;
+		if(deleted){ //NEXT CLUSTER NOT IN USE BY A LIVE FILE (OR SIMPLY THE NEXT ONE IF THE FILE WAS OVERWRITTEN)
+			do{
+				cluster++;
+			}while(!extents->overwritten && cluster < fat->clusterCount + 2 && fetchFatEntry(image, fat, cluster) != 0);
+		}else{
+			cluster = fetchFatEntry(image, fat, cluster);
+		}
+		if(cluster < 2 || cluster >= fat->clusterCount + 2){ //END OF CHAIN (OR END OF VOLUME)
+			break;
+		}
+	}
+	if(extents->length > wanted){ //CUT THE SLACK OFF THE LAST EXTENT
+		extents->extents[extents->count-1].length -= extents->length - wanted;
+		extents->length = wanted;
+	}else if(!isDirectory && extents->length < wanted){
+		extents->truncated = 1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  freeFileExtents
+ * --------------------
+ * Releases an extent list filled in by fetchFileExtents
+ *
+ * extents: The extent list
+ */
+void freeFileExtents(struct FileExtents *extents){
+	free(extents->extents);
+	memset(extents, 0, sizeof(*extents));
+}
+
+
+/*
+ * Function:  fetchVolumeOffset
+ * --------------------
+ * Converts a sector of the volume (counted from its boot sector, in BPB
+ * bytesPerSector units) to its byte offset in the image. The partition start
+ * is a 512 byte LBA and is kept apart so 1K/2K/4K sector volumes line up
+ * BYTE OFFSET = (PARTITION LBA * 512) + (VOLUME SECTOR * BYTES PER SECTOR)
+ *
+ * fat: The FAT volume of the volume model
+ * sector: Sector number relative to the start of the volume
+ * uint64_t: Byte offset of the first byte of the sector
+ */
+uint64_t fetchVolumeOffset(const struct FatVolume *fat, uint64_t sector){
+	return fat->sectorStart*SECTOR_SIZE + sector*(uint64_t)fat->bytesPerSector;
+}
+
+
+/*
+ * Function:  fetchClusterOffset
+ * --------------------
+ * Converts a cluster number to its byte offset in the image
+ * CLUSTER SECTOR = RESERVED + FAT AREA + ROOT DIR + ((CLUSTER-2)*SECTORS PER CLUSTER)
+ *
+ * fat: The FAT volume of the volume model
+ * cluster: Cluster number (2 or higher)
+ * uint64_t: Byte offset of the first byte of the cluster
+ */
+uint64_t fetchClusterOffset(struct FatVolume *fat, unsigned int cluster){
+	return fetchVolumeOffset(fat, (uint64_t)fat->reserved + fat->fatSize + fat->rootDirSize + (uint64_t)(cluster - 2)*fat->sectorsPerCluster);
+}
+
+
+/*
+ * Function:  fetchFilePreview
+ * --------------------
+ * Copies the first bytes of a file's first cluster
+ * Used to show the first 16 characters of a (deleted) text file
+ *
+ * image: The open disk image
+ * fat: The FAT volume of the volume model
+ * entry: Directory entry of the file
+ * buffer: Buffer of at least length bytes
+ * length: Number of bytes wanted (at most one cluster)
+ * size_t: Number of bytes copied (limited by the file size)
+ */
+size_t fetchFilePreview(struct DiskImage *image, struct FatVolume *fat, const struct FatDirEntry *entry, char *buffer, size_t length){
+	const unsigned char *content;
+	if(entry->startCluster < 2 || entry->startCluster >= fat->clusterCount + 2){
+		return 0;
+	}
+	if(!(entry->attributes & 0x10) && entry->fileSize < length){
+		length = entry->fileSize;
+	}
+	content = fetchImageView(image, fetchClusterOffset(fat, entry->startCluster), length, (unsigned char*)buffer);
+	if(content == NULL){
+		return 0;
+	}
+	if(content != (const unsigned char*)buffer){
+		memcpy(buffer, content, length);
+	}
+	return length;
+}
+
+
+/*
+ * Function:  readDirectory
+ * --------------------
+ * Reads one directory in batches
+ * The FAT12/16 root directory is one fixed area and is taken as a single view
+ * Other directories follow their cluster chain, grouping contiguous clusters
+ * into runs of up to DIRECTORY_BATCH_BYTES that are each taken as a single view
+ *
+ * walker: State of the directory walk
+ * task: The directory to read
+ * int: 0 to continue the walk, otherwise the value returned by visit
+ */
+static int readDirectory(struct FatWalker *walker, struct DirectoryTask *task){
+	//DATA DECLARATION
+	struct FatVolume *fat = walker->fat;
+	size_t clusterBytes = (size_t)fat->sectorsPerCluster*fat->bytesPerSector;
+	size_t maxRun = DIRECTORY_BATCH_BYTES/clusterBytes;
+	unsigned int cluster, next, runStart, runLength, clustersRead = 0;
+	uint64_t offset;
+	const unsigned char *block;
+	int status;
+	//DATA MANIPULATION
+	walker->lfnCount = 0;
+	if(task->cluster == 0){ //FIXED FAT12/16 ROOT DIRECTORY BETWEEN THE FAT AREA AND CLUSTER #2
+		offset = fetchVolumeOffset(fat, (uint64_t)fat->reserved + fat->fatSize);
+		block = fetchImageView(walker->image, offset, (size_t)fat->rootDirSize*fat->bytesPerSector, walker->scratch);
+		if(block == NULL){
+			return 0;
+		}
+		status = parseDirectoryBlock(walker, block, (size_t)fat->rootDirSize*fat->bytesPerSector, offset, task);
+		return (status > 0) ? 0 : status;
+	}
+	if(maxRun == 0){
+		maxRun = 1;
+	}
+	cluster = task->cluster;
+	while(cluster >= 2 && cluster < fat->clusterCount + 2 && clustersRead < fat->clusterCount){ //CLUSTERS READ LIMIT STOPS A LOOPING CHAIN
+		runStart = cluster;
+		runLength = 1;
+		next = task->deleted ? FAT_CHAIN_END : fetchFatEntry(walker->image, fat, cluster); //A DELETED DIRECTORY HAS NO CHAIN LEFT
+		while(next == cluster + 1 && runLength < maxRun){ //EXTEND THE RUN WHILE THE CHAIN IS CONTIGUOUS
+			cluster = next;
+			runLength++;
+			next = fetchFatEntry(walker->image, fat, cluster);
+		}
+		clustersRead += runLength;
+		offset = fetchClusterOffset(fat, runStart);
+		block = fetchImageView(walker->image, offset, (size_t)runLength*clusterBytes, walker->scratch);
+		if(block == NULL){
+			return 0;
+		}
+		status = parseDirectoryBlock(walker, block, (size_t)runLength*clusterBytes, offset, task);
+		if(status != 0){
+			return (status > 0) ? 0 : status;
+		}
+		cluster = next;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  parseDirectoryBlock
+ * --------------------
+ * Parses the 32 byte entries of a block of directory data
+ * Long file name entries (attribute 0x0F) are collected until
+ * the short entry they belong to is reached
+ *
+ * walker: State of the directory walk
+ * block: Directory data
+ * length: Length of the block in bytes
+ * offset: Byte offset of the block in the image
+ * task: The directory the block belongs to
+ * int: 0 to continue, 1 at the end of directory marker, otherwise the value returned by visit
+ */
+static int parseDirectoryBlock(struct FatWalker *walker, const unsigned char *block, size_t length, uint64_t offset, struct DirectoryTask *task){
+	//DATA DECLARATION
+	size_t position;
+	int i, status;
+	const unsigned char *raw;
+	static const int lfnOffsets[13] = {1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30}; //POSITIONS OF THE 13 UTF-16 CHARACTERS
+	//DATA MANIPULATION
+	for(position = 0;position + FAT_DIRENT_SIZE <= length;position += FAT_DIRENT_SIZE){
+		raw = block + position;
+		if(raw[0] == 0x00){ //0x00 MARKS THE END OF THE DIRECTORY
+			return 1;
+		}
+		if(raw[FAT_DIRENT_ATTRIBUTES] == 0x0F){ //LONG FILE NAME ENTRY
+			if((raw[0] != 0xE5 && (raw[0] & 0x40)) || walker->lfnCount == 0 || raw[FAT_LFN_CHECKSUM] != walker->lfnChecksum){ //START OF A NEW LONG NAME
+				walker->lfnCount = 0;
+				walker->lfnChecksum = raw[FAT_LFN_CHECKSUM];
+			}
+			if(walker->lfnCount < LFN_MAX_PARTS){
+				for(i=0;i<13;i++){
+					memcpy(walker->lfnParts[walker->lfnCount] + i*2, raw + lfnOffsets[i], 2); //KEPT IN DISK BYTE ORDER
+				}
+				walker->lfnCount++;
+			}
+			continue;
+		}
+		status = handleShortEntry(walker, raw, offset + position, task);
+		walker->lfnCount = 0;
+		if(status != 0){
+			return status;
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  handleShortEntry
+ * --------------------
+ * Decodes a short (8.3) directory entry, attaches any long file name
+ * collected before it and passes it to the visitor
+ * For deleted entries the long name checksum is used to try and recover
+ * the first character of the short name that 0xE5 overwrote
+ * Subdirectories are queued to be read later
+ *
+ * walker: State of the directory walk
+ * raw: The 32 byte entry
+ * offset: Byte offset of the entry in the image
+ * task: The directory the entry belongs to
+ * int: 0 to continue, otherwise the value returned by visit
+ */
+static int handleShortEntry(struct FatWalker *walker, const unsigned char *raw, uint64_t offset, struct DirectoryTask *task){
+	//DATA DECLARATION
+	struct FatDirEntry *entry = &walker->entry;
+	struct FatVolume *fat = walker->fat;
+	unsigned char shortName[11];
+	int i, nameLength = 0, firstKnown = 1;
+	//DATA MANIPULATION
+	if(raw[FAT_DIRENT_ATTRIBUTES] & 0x08){ //VOLUME LABEL
+		return 0;
+	}
+	if(raw[0] == '.' && (raw[1] == ' ' || (raw[1] == '.' && raw[2] == ' '))){ //"." AND ".." ENTRIES
+		return 0;
+	}
+	memcpy(shortName, raw, 11);
+	entry->deleted = (raw[0] == 0xE5); //IF THE FIRST BYTE MATCHES 0xE5 (229) IT IS A DELETED FILE
+	entry->longName[0] = '\0';
+	if(raw[0] == 0x05){ //0x05 STANDS IN FOR A REAL 0xE5 FIRST CHARACTER
+		shortName[0] = 0xE5;
+	}
+	if(walker->lfnCount > 0){
+		assembleLongName(walker, entry->longName);
+		if(entry->deleted){
+			firstKnown = 0;
+			shortName[0] = (unsigned char)toupper((unsigned char)entry->longName[0]); //MOST SHORT NAMES START WITH THE LONG NAME'S FIRST LETTER
+			if(fetchShortNameChecksum(shortName) == walker->lfnChecksum){
+				firstKnown = 1;
+			}
+		}else if(fetchShortNameChecksum(shortName) != walker->lfnChecksum){ //LONG NAME BELONGS TO A DIFFERENT ENTRY
+			entry->longName[0] = '\0';
+		}
+	}else if(entry->deleted){
+		firstKnown = 0;
+	}
+	for(i=0;i<11;i++){ //FILE NAME (FIRST 11 BYTES) AS NAME.EXT
+		if(i == 8 && shortName[8] != ' '){
+			entry->shortName[nameLength++] = '.';
+		}
+		if(shortName[i] != ' '){
+			entry->shortName[nameLength++] = (i == 0 && !firstKnown) ? '_' : (char)shortName[i];
+		}
+	}
+	entry->shortName[nameLength] = '\0';
+	entry->attributes = raw[FAT_DIRENT_ATTRIBUTES];
+	entry->parentDeleted = task->deleted;
+	entry->startCluster = readLe16(raw + FAT_DIRENT_CLUSTER_LOW); //STARTING CLUSTER ADDRESS (0x1A)(0 IF EMPTY)
+	if(fat->fatBits == 32){ //FAT32 KEEPS THE HIGH 16 BITS OF THE CLUSTER AT 0x14
+		entry->startCluster |= (unsigned int)readLe16(raw + FAT_DIRENT_CLUSTER_HIGH) << 16;
+	}
+	entry->fileSize = readLe32(raw + FAT_DIRENT_FILE_SIZE); //FILE SIZE (0x1C)
+	entry->entryOffset = offset;
+	entry->raw = raw;
+	snprintf(entry->path, sizeof(entry->path), "%s/%s", task->path, entry->longName[0] ? entry->longName : entry->shortName);
+	if((entry->attributes & 0x10) && (!entry->deleted || isDirectoryCluster(walker, entry->startCluster))){
+		if(queueDirectory(walker, entry->startCluster, entry->deleted || task->deleted, entry->path) != 0){
+			return -1;
+		}
+	}
+	return walker->visit(entry, walker->context);
+}
+
+
+/*
+ * Function:  queueDirectory
+ * --------------------
+ * Adds a directory to the walk queue unless its first cluster was already queued
+ *
+ * walker: State of the directory walk
+ * cluster: First cluster of the directory (0 for the FAT12/16 root directory)
+ * deleted: 1 if the directory was deleted
+ * path: Path of the directory
+ * int: 0 on success, -1 on allocation failure
+ */
+static int queueDirectory(struct FatWalker *walker, unsigned int cluster, int deleted, const char *path){
+	struct DirectoryTask *tasks;
+	if(cluster != 0){
+		if(cluster < 2 || cluster >= walker->fat->clusterCount + 2 || (walker->visited[cluster/8] & (1 << (cluster%8)))){
+			return 0;
+		}
+		walker->visited[cluster/8] |= (unsigned char)(1 << (cluster%8));
+	}
+	if(walker->taskCount == walker->taskCapacity){ //GROW THE QUEUE
+		walker->taskCapacity = walker->taskCapacity ? walker->taskCapacity*2 : 64;
+		tasks = realloc(walker->tasks, walker->taskCapacity*sizeof(*tasks));
+		if(tasks == NULL){
+			return -1;
+		}
+		walker->tasks = tasks;
+	}
+	walker->tasks[walker->taskCount].cluster = cluster;
+	walker->tasks[walker->taskCount].deleted = deleted;
+	walker->tasks[walker->taskCount].path = strdup(path);
+	if(walker->tasks[walker->taskCount].path == NULL){
+		return -1;
+	}
+	walker->taskCount++;
+	return 0;
+}
+
+
+/*
+ * Function:  isDirectoryCluster
+ * --------------------
+ * Checks if a cluster still starts with a "." directory entry
+ * Used before following a deleted directory whose cluster may have been reused
+ *
+ * walker: State of the directory walk
+ * cluster: Cluster number to check
+ * int: 1 if the cluster looks like the start of a directory
+ */
+static int isDirectoryCluster(struct FatWalker *walker, unsigned int cluster){
+	const unsigned char *raw;
+	unsigned char scratch[FAT_DIRENT_SIZE];
+	if(cluster < 2 || cluster >= walker->fat->clusterCount + 2){
+		return 0;
+	}
+	raw = fetchImageView(walker->image, fetchClusterOffset(walker->fat, cluster), FAT_DIRENT_SIZE, scratch);
+	return raw != NULL && memcmp(raw, ".          ", 11) == 0 && (raw[FAT_DIRENT_ATTRIBUTES] & 0x10);
+}
+
+
+/*
+ * Function:  fetchShortNameChecksum
+ * --------------------
+ * Calculates the checksum of an 8.3 name stored in every long file name entry
+ *
+ * shortName: The 11 byte short name
+ * unsigned char: The checksum
+ */
+static unsigned char fetchShortNameChecksum(const unsigned char *shortName){
+	int i;
+	unsigned char sum = 0;
+	for(i=0;i<11;i++){
+		sum = (unsigned char)(((sum & 1) << 7) + (sum >> 1) + shortName[i]);
+	}
+	return sum;
+}
+
+
+/*
+ * Function:  assembleLongName
+ * --------------------
+ * Joins the collected long file name entries into a UTF-8 name
+ * Entries are stored on disk last part first, so they are joined in reverse
+ *
+ * walker: State of the directory walk
+ * longName: Buffer of FAT_NAME_MAX bytes for the name
+ */
+static void assembleLongName(struct FatWalker *walker, char *longName){
+	unsigned char units[LFN_MAX_PARTS*26];
+	int part;
+	for(part = 0;part < walker->lfnCount;part++){
+		memcpy(units + part*26, walker->lfnParts[walker->lfnCount - 1 - part], sizeof(walker->lfnParts[0]));
+	}
+	convertUtf16Name(units, (size_t)walker->lfnCount*13, longName, FAT_NAME_MAX);
+}
@@ -0,0 +1,57 @@
+/*
+ * fatVolume.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: FAT directory and deleted file parsing
+ * Walks every directory of the FAT volume found in the volume model,
+ * reassembling long file names and reporting deleted entries.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef FATVOLUME_H
+#define FATVOLUME_H
+
+//IMPORTED LIBRARIES
+#include <stddef.h>
+#include <stdint.h>
+#include "diskImage.h"
+#include "volumeModel.h"
+
+#define FAT_NAME_MAX 768 //255 UTF-16 CHARACTERS AS UTF-8
+#define FAT_PATH_MAX 4096
+#define FAT_CHAIN_END 0x0FFFFFFF //RETURNED BY fetchFatEntry FOR END OF CHAIN AND BAD CLUSTERS
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct FatDirEntry{
+	char path[FAT_PATH_MAX]; //FULL PATH OF THE ENTRY FROM THE ROOT DIRECTORY
+	char shortName[13]; //8.3 FILE NAME, AN UNRECOVERABLE DELETED MARKER IS SHOWN AS '_'
+	char longName[FAT_NAME_MAX]; //REASSEMBLED LONG FILE NAME (EMPTY IF THERE IS NONE)
+	unsigned char attributes; //ATTRIBUTE BYTE (0x10 DIRECTORY, 0x20 ARCHIVE...)
+	int deleted; //1 IF THE ENTRY STARTS WITH 0xE5
+	int parentDeleted; //1 IF THE ENTRY WAS FOUND INSIDE A DELETED DIRECTORY
+	unsigned int startCluster; //NUMBER OF THE FIRST CLUSTER
+	unsigned int fileSize; //FILE SIZE IN BYTES
+	uint64_t entryOffset; //BYTE OFFSET OF THE 32 BYTE ENTRY IN THE IMAGE
+	const unsigned char *raw; //THE RAW 32 BYTE ENTRY (ONLY VALID DURING THE VISIT)
+};
+
+struct FileExtents{
+	struct ImageExtent *extents; //RUNS OF CONTIGUOUS CLUSTERS IN FILE ORDER
+	size_t count, capacity;
+	uint64_t length; //TOTAL BYTES COVERED BY THE EXTENTS
+	int truncated; //1 IF THE CHAIN ENDED BEFORE THE FILE SIZE WAS REACHED
+	int overwritten; //1 IF A DELETED FILE'S FIRST CLUSTER HAS SINCE BEEN REALLOCATED
+};
+
+int walkFatDirectories(struct DiskImage *image, struct FatVolume *fat, int (*visit)(const struct FatDirEntry *entry, void *context), void *context);
+unsigned int fetchFatEntry(struct DiskImage *image, struct FatVolume *fat, unsigned int cluster);
+int loadFatTable(struct DiskImage *image, struct FatVolume *fat);
+int fetchFileExtents(struct DiskImage *image, struct FatVolume *fat, const struct FatDirEntry *entry, struct FileExtents *extents);
+void freeFileExtents(struct FileExtents *extents);
+uint64_t fetchVolumeOffset(const struct FatVolume *fat, uint64_t sector);
+uint64_t fetchClusterOffset(struct FatVolume *fat, unsigned int cluster);
+size_t fetchFilePreview(struct DiskImage *image, struct FatVolume *fat, const struct FatDirEntry *entry, char *buffer, size_t length);
+
+#endif
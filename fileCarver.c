@@ -0,0 +1,410 @@
+/*
+ * fileCarver.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Header/footer signature carving
+ * Regions of the image are split into CARVE_CHUNK_BYTES chunks that are
+ * scanned in parallel on the work pool. Each chunk is read with a small
+ * overlap so headers crossing a chunk boundary are still matched.
+ * Candidate offsets are found 16 bytes at a time by comparing the first
+ * two bytes of every signature with SSE2, only candidates are compared
+ * with the full header. Hits are handed to the visitor as each chunk
+ * finishes, in offset order within the chunk.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#define _GNU_SOURCE //memmem
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "fileCarver.h"
+#include "workPool.h"
+
+#define CARVE_MEASURE_BYTES 128 //HEADER BYTES AVAILABLE TO A measure FUNCTION (ALSO THE CHUNK OVERLAP)
+#define CARVE_FOOTER_WINDOW (1024*1024) //BYTES SEARCHED FOR A FOOTER PER VIEW
+#define CARVE_MAX_PAIRS 16 //DISTINCT FIRST TWO BYTE PAIRS OF THE SIGNATURES
+
+struct CarveJob{
+	struct DiskImage *image;
+	const struct CarveSignature *signatures;
+	size_t signatureCount;
+	unsigned char pairFirst[CARVE_MAX_PAIRS], pairSecond[CARVE_MAX_PAIRS]; //PREFILTER: FIRST TWO BYTES OF EACH SIGNATURE
+	int pairCount;
+	int (*visit)(const struct CarveHit *hit, void *context);
+	void *context;
+	int status; //NON ZERO ONCE THE VISITOR STOPPED THE SCAN
+	pthread_mutex_t lock; //SERIALISES THE VISITOR AND GUARDS THE FREE SLOTS
+	pthread_cond_t slotFree;
+	int freeSlots;
+};
+
+struct CarveSlot{
+	struct CarveJob *job;
+	int busy;
+	uint64_t base; //IMAGE OFFSET OF THE CHUNK
+	size_t length; //BYTES OF THE CHUNK WHERE A HEADER MAY START
+	size_t available; //BYTES READABLE FROM base (length PLUS THE OVERLAP)
+	unsigned char *chunkBuffer; //PREAD FALLBACK BUFFER FOR THE CHUNK (NULL WHEN THE IMAGE IS MAPPED)
+	unsigned char *footerBuffer; //PREAD FALLBACK BUFFER FOR FOOTER SEARCHES
+	struct CarveHit *hits; //HITS OF THE CHUNK, IN OFFSET ORDER
+	size_t hitCount, hitCapacity;
+};
+
+static int measureJpeg(const unsigned char *header, size_t available, uint64_t *size);
+static int measureGif(const unsigned char *header, size_t available, uint64_t *size);
+static int measureSqlite(const unsigned char *header, size_t available, uint64_t *size);
+static void carveChunkTask(void *arg);
+static void checkCarveCandidate(struct CarveSlot *slot, const unsigned char *data, size_t position);
+static int findCarveFooter(struct CarveSlot *slot, const struct CarveSignature *signature, uint64_t start, uint64_t limit, uint64_t *found);
+
+static const struct CarveSignature carveSignatures[] = {
+	{"jpeg", "jpg", {0xFF, 0xD8, 0xFF}, 3, {0xFF, 0xD9}, 2, 0, 20ULL*1024*1024, measureJpeg},
+	{"png", "png", {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A}, 8, {'I', 'E', 'N', 'D', 0xAE, 0x42, 0x60, 0x82}, 8, 0, 50ULL*1024*1024, NULL},
+	{"gif", "gif", {'G', 'I', 'F', '8'}, 4, {0x00, 0x3B}, 2, 0, 20ULL*1024*1024, measureGif},
+	{"pdf", "pdf", {'%', 'P', 'D', 'F', '-'}, 5, {'%', '%', 'E', 'O', 'F'}, 5, 0, 100ULL*1024*1024, NULL},
+	{"zip", "zip", {'P', 'K', 0x03, 0x04}, 4, {'P', 'K', 0x05, 0x06}, 4, 18, 500ULL*1024*1024, NULL}, //END OF CENTRAL DIRECTORY RECORD IS 22 BYTES
+	{"sqlite", "sqlite", "SQLite format 3", 16, {0}, 0, 0, 1024ULL*1024*1024, measureSqlite},
+};
+
+
+/*
+ * Function:  fetchCarveSignatures 
+ * --------------------
+ * Returns the table of file signatures the carver looks for
+ * 
+ * count: Set to the number of signatures
+ * const struct CarveSignature*: The signature table
+ */
+const struct CarveSignature *fetchCarveSignatures(size_t *count){
+	*count = sizeof(carveSignatures)/sizeof(carveSignatures[0]);
+	return carveSignatures;
+}
+
+
+/*
+ * Function:  carveImage 
+ * --------------------
+ * Carves files out of a set of image regions (the whole image, or
+ * only its unallocated space) on a work pool
+ * A hit starts inside a region, its footer is searched forward from
+ * the header regardless of region boundaries
+ * 
+ * image: The open disk image
+ * regions: Byte ranges of the image to scan for headers
+ * regionCount: Number of regions
+ * threadCount: Number of scanning threads, 0 for one per processor
+ * visit: Called for each hit (one call at a time), a non zero return stops the scan
+ * context: Passed through to visit
+ * int: 0 when the scan finished, the non zero value returned by visit, -1 on failure
+ */
+int carveImage(struct DiskImage *image, const struct ImageExtent *regions, size_t regionCount, int threadCount, int (*visit)(const struct CarveHit *hit, void *context), void *context){
+	//DATA DECLARATION
+	struct CarveJob job;
+	struct CarveSlot *slots;
+	struct WorkPool *pool;
+	uint64_t offset, end;
+	size_t r, s, k, slotCount;
+	int status = 0;
+	//DATA MANIPULATION
+	memset(&job, 0, sizeof(job));
+	job.image = image;
+	job.signatures = fetchCarveSignatures(&job.signatureCount);
+	job.visit = visit;
+	job.context = context;
+	for(s=0;s<job.signatureCount;s++){ //DISTINCT FIRST TWO BYTES OF THE SIGNATURES FOR THE PREFILTER
+		for(k=0;k<(size_t)job.pairCount;k++){
+			if(job.pairFirst[k] == job.signatures[s].header[0] && job.pairSecond[k] == job.signatures[s].header[1]){
+				break;
+			}
+		}
+		if(k == (size_t)job.pairCount && job.pairCount < CARVE_MAX_PAIRS){
+			job.pairFirst[job.pairCount] = job.signatures[s].header[0];
+			job.pairSecond[job.pairCount++] = job.signatures[s].header[1];
+		}
+	}
+	pool = createWorkPool(threadCount);
+	if(pool == NULL){
+		return -1;
+	}
+	slotCount = (size_t)fetchWorkPoolSize(pool)*2; //ENOUGH CHUNKS IN FLIGHT TO KEEP EVERY THREAD BUSY
+	slots = calloc(slotCount, sizeof(struct CarveSlot));
+	if(slots == NULL){
+		destroyWorkPool(pool);
+		return -1;
+	}
+	pthread_mutex_init(&job.lock, NULL);
+	pthread_cond_init(&job.slotFree, NULL);
+	job.freeSlots = (int)slotCount;
+	for(s=0;s<slotCount;s++){
+		slots[s].job = &job;
+		slots[s].footerBuffer = malloc(CARVE_FOOTER_WINDOW + sizeof(slots[s].job->signatures[0].footer));
+		if(image->map == NULL){
+			slots[s].chunkBuffer = malloc(CARVE_CHUNK_BYTES + CARVE_MEASURE_BYTES);
+		}
+		if(slots[s].footerBuffer == NULL || (image->map == NULL && slots[s].chunkBuffer == NULL)){
+			status = -1;
+		}
+	}
+	for(r=0;r<regionCount && status == 0;r++){
+		end = regions[r].offset + regions[r].length;
+		if(end > image->size){
+			end = image->size;
+		}
+		for(offset=regions[r].offset;offset < end;offset += CARVE_CHUNK_BYTES){
+			pthread_mutex_lock(&job.lock);
+			while(job.freeSlots == 0){ //BOUNDS THE MEMORY USED ON A MULTI TERABYTE IMAGE
+				pthread_cond_wait(&job.slotFree, &job.lock);
+			}
+			status = job.status;
+			for(s=0;slots[s].busy;s++);
+			slots[s].busy = 1;
+			job.freeSlots--;
+			pthread_mutex_unlock(&job.lock);
+			if(status != 0){
+				pthread_mutex_lock(&job.lock);
+				slots[s].busy = 0;
+				job.freeSlots++;
+				pthread_mutex_unlock(&job.lock);
+				break;
+			}
+			slots[s].base = offset;
+			slots[s].length = (end - offset < CARVE_CHUNK_BYTES) ? (size_t)(end - offset) : CARVE_CHUNK_BYTES;
+			slots[s].available = (image->size - offset < slots[s].length + CARVE_MEASURE_BYTES) ? (size_t)(image->size - offset) : slots[s].length + CARVE_MEASURE_BYTES;
+			adviseImageRange(image, offset, slots[s].available);
+			if(submitWork(pool, carveChunkTask, &slots[s]) != 0){
+				status = -1;
+				break;
+			}
+		}
+	}
+	waitWorkPool(pool);
+	destroyWorkPool(pool);
+	if(status == 0){
+		status = job.status;
+	}
+	for(s=0;s<slotCount;s++){
+		free(slots[s].chunkBuffer);
+		free(slots[s].footerBuffer);
+		free(slots[s].hits);
+	}
+	free(slots);
+	pthread_mutex_destroy(&job.lock);
+	pthread_cond_destroy(&job.slotFree);
+	return status;
+}
+
+
+/*
+ * Function:  carveChunkTask 
+ * --------------------
+ * Pool task scanning one chunk for headers and reporting its hits
+ * 
+ * arg: The CarveSlot describing the chunk
+ */
+static void carveChunkTask(void *arg){
+	//DATA DECLARATION
+	struct CarveSlot *slot = arg;
+	struct CarveJob *job = slot->job;
+	const unsigned char *data;
+	size_t i = 0, h;
+	int k, mask, bit;
+#ifdef __SSE2__
+	__m128i first[CARVE_MAX_PAIRS], second[CARVE_MAX_PAIRS], current, next, match;
+#endif
+	//DATA MANIPULATION
+	slot->hitCount = 0;
+	data = (__atomic_load_n(&job->status, __ATOMIC_RELAXED) != 0) ? NULL : fetchImageView(job->image, slot->base, slot->available, slot->chunkBuffer);
+	if(data != NULL){
+#ifdef __SSE2__
+		for(k=0;k<job->pairCount;k++){
+			first[k] = _mm_set1_epi8((char)job->pairFirst[k]);
+			second[k] = _mm_set1_epi8((char)job->pairSecond[k]);
+		}
+		for(i=0;i + 17 <= slot->available && i < slot->length;i += 16){ //16 CANDIDATE OFFSETS PER STEP
+			current = _mm_loadu_si128((const __m128i*)(data + i));
+			next = _mm_loadu_si128((const __m128i*)(data + i + 1));
+			match = _mm_setzero_si128();
+			for(k=0;k<job->pairCount;k++){
+				match = _mm_or_si128(match, _mm_and_si128(_mm_cmpeq_epi8(current, first[k]), _mm_cmpeq_epi8(next, second[k])));
+			}
+			mask = _mm_movemask_epi8(match);
+			while(mask != 0){ //ONLY OFFSETS WHOSE FIRST TWO BYTES MATCH A SIGNATURE ARE CHECKED IN FULL
+				bit = __builtin_ctz((unsigned int)mask);
+				mask &= mask - 1;
+				if(i + (size_t)bit < slot->length){
+					checkCarveCandidate(slot, data, i + (size_t)bit);
+				}
+			}
+		}
+#endif
+		for(;i < slot->length;i++){ //REMAINING OFFSETS (OR ALL OF THEM WITHOUT SSE2)
+			for(k=0;k<job->pairCount;k++){
+				if(data[i] == job->pairFirst[k] && i + 1 < slot->available && data[i+1] == job->pairSecond[k]){
+					checkCarveCandidate(slot, data, i);
+					break;
+				}
+			}
+		}
+	}
+	pthread_mutex_lock(&job->lock);
+	for(h=0;h<slot->hitCount && job->status == 0;h++){ //STREAM THE HITS OF THIS CHUNK
+		__atomic_store_n(&job->status, job->visit(&slot->hits[h], job->context), __ATOMIC_RELAXED);
+	}
+	slot->busy = 0;
+	job->freeSlots++;
+	pthread_cond_signal(&job->slotFree);
+	pthread_mutex_unlock(&job->lock);
+}
+
+
+/*
+ * Function:  checkCarveCandidate 
+ * --------------------
+ * Compares a prefilter candidate with the full headers and sizes a hit
+ * The size comes from the signature's measure function, its footer,
+ * or maxSize when neither ends the file
+ * 
+ * slot: The chunk being scanned
+ * data: The bytes of the chunk
+ * position: Offset of the candidate within the chunk
+ */
+static void checkCarveCandidate(struct CarveSlot *slot, const unsigned char *data, size_t position){
+	//DATA DECLARATION
+	struct CarveJob *job = slot->job;
+	const struct CarveSignature *signature;
+	struct CarveHit *hit, *grown;
+	uint64_t offset = slot->base + position, size, footer, limit;
+	size_t s, available = slot->available - position;
+	//DATA MANIPULATION
+	for(s=0;s<job->signatureCount;s++){
+		signature = &job->signatures[s];
+		size = 0;
+		if(signature->headerLength > available || memcmp(data + position, signature->header, signature->headerLength) != 0){
+			continue;
+		}
+		if(signature->measure != NULL && signature->measure(data + position, available < CARVE_MEASURE_BYTES ? available : CARVE_MEASURE_BYTES, &size) != 0){
+			continue; //MAGIC BYTES MATCHED BY CHANCE
+		}
+		if(slot->hitCount == slot->hitCapacity){
+			grown = realloc(slot->hits, (slot->hitCapacity ? slot->hitCapacity*2 : 16)*sizeof(struct CarveHit));
+			if(grown == NULL){
+				return;
+			}
+			slot->hits = grown;
+			slot->hitCapacity = slot->hitCapacity ? slot->hitCapacity*2 : 16;
+		}
+		hit = &slot->hits[slot->hitCount++];
+		hit->signature = signature;
+		hit->offset = offset;
+		limit = (job->image->size - offset < signature->maxSize) ? job->image->size - offset : signature->maxSize;
+		if(size > 0){ //SIZE FIELD IN THE HEADER
+			hit->length = (size < limit) ? size : limit;
+			hit->complete = (size <= limit);
+		}else if(signature->footerLength > 0 && findCarveFooter(slot, signature, offset + signature->headerLength, offset + limit, &footer) == 0){
+			hit->length = footer + signature->footerLength + signature->footerTrailer - offset;
+			hit->complete = (hit->length <= job->image->size - offset);
+			if(!hit->complete){
+				hit->length = job->image->size - offset;
+			}
+		}else{
+			hit->length = limit;
+			hit->complete = 0;
+		}
+		return;
+	}
+}
+
+
+/*
+ * Function:  findCarveFooter 
+ * --------------------
+ * Searches forward for the first footer of a signature
+ * The range is viewed CARVE_FOOTER_WINDOW bytes at a time, windows
+ * overlap by the footer length so a footer across two windows is found
+ * 
+ * slot: The chunk being scanned (for its footer buffer)
+ * signature: The signature whose footer is searched for
+ * start: Image offset the search starts at
+ * limit: Image offset the footer must start before
+ * found: Set to the image offset of the footer
+ * int: 0 if the footer was found, -1 otherwise
+ */
+static int findCarveFooter(struct CarveSlot *slot, const struct CarveSignature *signature, uint64_t start, uint64_t limit, uint64_t *found){
+	const unsigned char *view, *match;
+	size_t length;
+	while(start < limit){
+		length = (limit - start < CARVE_FOOTER_WINDOW) ? (size_t)(limit - start) : CARVE_FOOTER_WINDOW;
+		if(length + signature->footerLength - 1 <= slot->job->image->size - start){ //LET THE LAST FOOTER START AT THE END OF THE WINDOW
+			length += signature->footerLength - 1;
+		}
+		view = fetchImageView(slot->job->image, start, length, slot->footerBuffer);
+		if(view == NULL){
+			return -1;
+		}
+		match = memmem(view, length, signature->footer, signature->footerLength);
+		if(match != NULL && start + (uint64_t)(match - view) < limit){
+			*found = start + (uint64_t)(match - view);
+			return 0;
+		}
+		start += CARVE_FOOTER_WINDOW;
+	}
+	return -1;
+}
+
+
+/*
+ * Function:  measureJpeg 
+ * --------------------
+ * Checks the byte after FF D8 FF starts a real JPEG marker segment
+ * (APPn E0-EF, quantisation table DB, comment FE or start of frame C0-CF)
+ */
+static int measureJpeg(const unsigned char *header, size_t available, uint64_t *size){
+	if(available < 4){
+		return -1;
+	}
+	return ((header[3] >= 0xE0 && header[3] <= 0xEF) || header[3] == 0xDB || header[3] == 0xFE || (header[3] >= 0xC0 && header[3] <= 0xCF)) ? 0 : -1;
+}
+
+
+/*
+ * Function:  measureGif 
+ * --------------------
+ * Checks for the full GIF87a or GIF89a version string
+ */
+static int measureGif(const unsigned char *header, size_t available, uint64_t *size){
+	if(available < 6){
+		return -1;
+	}
+	return ((header[4] == '7' || header[4] == '9') && header[5] == 'a') ? 0 : -1;
+}
+
+
+/*
+ * Function:  measureSqlite 
+ * --------------------
+ * Sizes an SQLite database from its header: big endian page size at
+ * offset 16 (1 means 65536) times the page count at offset 28
+ */
+static int measureSqlite(const unsigned char *header, size_t available, uint64_t *size){
+	unsigned int pageSize, pageCount;
+	if(available < 32){
+		return -1;
+	}
+	pageSize = (header[16] << 8) | header[17];
+	if(pageSize == 1){
+		pageSize = 65536;
+	}
+	if(pageSize < 512 || (pageSize & (pageSize - 1)) != 0){ //PAGE SIZE IS A POWER OF TWO FROM 512
+		return -1;
+	}
+	pageCount = ((unsigned int)header[28] << 24) | (header[29] << 16) | (header[30] << 8) | header[31];
+	*size = (uint64_t)pageSize*pageCount; //0 FOR OLD FILES WITHOUT A VALID COUNT, THE HIT IS CUT AT maxSize
+	return 0;
+}
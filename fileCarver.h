@@ -0,0 +1,47 @@
+/*
+ * fileCarver.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Header/footer signature carving
+ * Scans byte ranges of an image for known file headers on every core
+ * and sizes each hit by its footer or by a size field in its header.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef FILECARVER_H
+#define FILECARVER_H
+
+//IMPORTED LIBRARIES
+#include <stddef.h>
+#include <stdint.h>
+#include "diskImage.h"
+
+#define CARVE_HEADER_MAX 16 //LONGEST HEADER SIGNATURE IN BYTES
+#define CARVE_CHUNK_BYTES (8*1024*1024) //BYTES OF A REGION SCANNED PER POOL TASK
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct CarveSignature{
+	const char *name; //FILE TYPE ("jpeg", "png"...)
+	const char *extension; //EXTENSION USED FOR CARVED FILES
+	unsigned char header[CARVE_HEADER_MAX]; //MAGIC BYTES AT THE START OF THE FILE
+	size_t headerLength;
+	unsigned char footer[8]; //BYTES ENDING THE FILE (footerLength 0 IF THE FILE HAS NONE)
+	size_t footerLength;
+	size_t footerTrailer; //BYTES AFTER THE FOOTER THAT STILL BELONG TO THE FILE
+	uint64_t maxSize; //LARGEST FILE CARVED, A HIT WITHOUT A FOOTER IS CUT HERE
+	int (*measure)(const unsigned char *header, size_t available, uint64_t *size); //OPTIONAL HEADER CHECK, MAY SET THE SIZE (0 KEEPS THE HIT)
+};
+
+struct CarveHit{
+	const struct CarveSignature *signature; //TYPE OF FILE FOUND
+	uint64_t offset; //BYTE OFFSET OF THE HEADER IN THE IMAGE
+	uint64_t length; //LENGTH OF THE CARVED FILE IN BYTES
+	int complete; //1 IF A FOOTER OR SIZE FIELD ENDED THE FILE, 0 IF IT WAS CUT AT maxSize OR THE IMAGE END
+};
+
+const struct CarveSignature *fetchCarveSignatures(size_t *count);
+int carveImage(struct DiskImage *image, const struct ImageExtent *regions, size_t regionCount, int threadCount, int (*visit)(const struct CarveHit *hit, void *context), void *context);
+
+#endif
@@ -0,0 +1,751 @@
+/*
+ * fileMap.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Cluster to file reverse map
+ * Collects the extents of every file of every FAT and NTFS partition
+ * (live and deleted) into one array sorted by image offset. The array is
+ * read as an implicit interval tree (the node at index i has level equal to
+ * its trailing one bits, children i -/+ 2^(level-1)) with the furthest end
+ * of each subtree kept alongside, so only the subtrees that can still
+ * overlap an offset are visited.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fileMap.h"
+#include "allocationMap.h"
+#include "fatVolume.h"
+#include "ntfsVolume.h"
+
+#define FILE_MAP_TREE_LEVELS 64 //LEVELS AN IMPLICIT TREE OVER A size_t INDEXED ARRAY CAN HAVE
+
+struct FileMapWalk{
+	struct FileMap *map;
+	struct DiskImage *image;
+	struct FatVolume *fat; //VOLUME BEING WALKED (ONE OF fat AND ntfs IS NULL)
+	struct NtfsVolume *ntfs;
+	uint32_t volume; //INDEX OF THE VOLUME IN THE MAP
+	uint64_t volumeStart, volumeEnd; //IMAGE BYTES OF THE VOLUME, RUNS ARE CLIPPED TO THEM
+	uint32_t *recordFiles; //NTFS: FILE INDEX + 1 OF THE $DATA STREAM OF EACH BASE RECORD (0 UNTIL SEEN)
+	uint64_t recordCount;
+	int status; //-1 ONCE AN ALLOCATION FAILED
+};
+
+static int mapFatVolume(struct FileMap *map, struct DiskImage *image, struct FatVolume *fat, uint32_t volume);
+static int mapFatEntry(const struct FatDirEntry *entry, void *context);
+static int mapFatExtents(struct FileMapWalk *walk, const struct FatDirEntry *entry, const char *path, unsigned char flags);
+static int mapNtfsVolume(struct FileMap *map, struct VolumeModel *model, struct FileMapVolume *volume, uint32_t index);
+static int mapMftRecord(const struct MftRecord *record, void *context);
+static int mapNtfsStream(struct FileMapWalk *walk, const struct NtfsExtentMap *stream, uint32_t file);
+static int addFileMapFile(struct FileMap *map, uint32_t volume, uint64_t owner, uint64_t size, unsigned char flags, uint32_t *file);
+static int addFileMapExtent(struct FileMap *map, uint64_t offset, uint64_t length, uint64_t fileOffset, uint32_t file);
+static void indexFileMapExtents(struct FileMap *map);
+static int isPreferredExtent(const struct FileMap *map, size_t candidate, size_t best);
+static int isInExtentList(const struct ExtentList *list, uint64_t offset);
+static int compareFileMapExtents(const void *a, const void *b);
+static int compareImageExtents(const void *a, const void *b);
+
+
+/*
+ * Function:  buildFileMap 
+ * --------------------
+ * Builds the reverse map of every FAT and NTFS partition of the model
+ * Each partition is opened on its own so the model's volumes are left
+ * untouched
+ * 
+ * model: The volume model of the open disk image
+ * map: Filled in (released with freeFileMap)
+ * int: 0 on success, -1 if a volume could not be read or when out of memory
+ */
+int buildFileMap(struct VolumeModel *model, struct FileMap *map){
+	//DATA DECLARATION
+	struct ExtentList pieces = {NULL, 0, 0, 0};
+	struct VolumeModel partitionModel;
+	struct FileMapVolume *volume;
+	struct FatVolume fat;
+	const struct Partition *partition;
+	size_t i;
+	int fileSystem, status = 0;
+	//DATA MANIPULATION
+	memset(map, 0, sizeof(*map));
+	map->volumes = calloc(model->partitionCount ? model->partitionCount : 1, sizeof(*map->volumes));
+	if(map->volumes == NULL){
+		return -1;
+	}
+	status = fetchUnpartitionedExtents(model, &map->unpartitioned);
+	for(i=0;i<map->unpartitioned.count && status == 0;i++){
+		status = appendImageExtent(&pieces, map->unpartitioned.extents[i].offset, map->unpartitioned.extents[i].length);
+	}
+	for(i=0;i<model->partitionCount && status == 0;i++){
+		partition = &model->partitions[i];
+		fileSystem = fetchPartitionFileSystem(model->image, partition);
+		if(fileSystem != FILESYSTEM_FAT && fileSystem != FILESYSTEM_NTFS){
+			continue;
+		}
+		volume = &map->volumes[map->volumeCount];
+		volume->partition = partition->index;
+		volume->fileSystem = fileSystem;
+		volume->start = partition->sectorStart*SECTOR_SIZE;
+		volume->end = volume->start + partition->sectorCount*SECTOR_SIZE;
+		if(fileSystem == FILESYSTEM_FAT){
+			memset(&fat, 0, sizeof(fat));
+			fat.sectorStart = partition->sectorStart;
+			fetchFatVolumeInfo(model->image, &fat);
+			if(fat.present){
+				status = mapFatVolume(map, model->image, &fat, (uint32_t)map->volumeCount);
+				if(status == 0){
+					status = fetchFatFreeExtents(model->image, &fat, &pieces);
+				}
+			}
+			freeFatVolume(&fat);
+		}else{
+			partitionModel = *model; //THE TREE IS BUILT THROUGH A MODEL HOLDING ONLY THIS VOLUME
+			memset(&partitionModel.fat, 0, sizeof(partitionModel.fat));
+			memset(&partitionModel.ntfs, 0, sizeof(partitionModel.ntfs));
+			partitionModel.index = NULL;
+			partitionModel.ntfs.sectorStart = (long long int)partition->sectorStart;
+			fetchNTFSVolumeInfo(model->image, &partitionModel.ntfs);
+			if(partitionModel.ntfs.present){
+				status = mapNtfsVolume(map, &partitionModel, volume, (uint32_t)map->volumeCount);
+				if(status == 0){
+					status = fetchNtfsFreeExtents(model->image, &partitionModel.ntfs, &pieces);
+				}
+			}
+			freeNtfsVolume(&partitionModel.ntfs);
+		}
+		map->volumeCount++;
+	}
+	qsort(pieces.extents, pieces.count, sizeof(struct ImageExtent), compareImageExtents); //EACH SOURCE IS IN ORDER, MERGE THEM
+	for(i=0;i<pieces.count && status == 0;i++){
+		status = appendImageExtent(&map->unallocated, pieces.extents[i].offset, pieces.extents[i].length);
+	}
+	freeExtentList(&pieces);
+	if(status == 0 && map->count > 0){
+		qsort(map->extents, map->count, sizeof(struct FileMapExtent), compareFileMapExtents);
+		map->maxEnd = malloc(map->count*sizeof(uint64_t));
+		if(map->maxEnd == NULL){
+			status = -1;
+		}else{
+			indexFileMapExtents(map);
+		}
+	}
+	if(status != 0){
+		freeFileMap(map);
+		return -1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  locateImageOffset 
+ * --------------------
+ * Finds the partition and file holding a byte of the image
+ * A live file is preferred over deleted files that once used the same cluster
+ * 
+ * map: The reverse map
+ * offset: Byte offset in the image
+ * location: Filled in with what holds the offset
+ */
+void locateImageOffset(const struct FileMap *map, uint64_t offset, struct FileLocation *location){
+	//DATA DECLARATION
+	struct{
+		size_t node;
+		int level, leftDone;
+	} stack[2*FILE_MAP_TREE_LEVELS], cell;
+	const struct FileMapExtent *extent;
+	size_t top = 0, first, last, i, best = SIZE_MAX;
+	//DATA MANIPULATION
+	memset(location, 0, sizeof(*location));
+	for(i=0;i<map->volumeCount;i++){
+		if(offset >= map->volumes[i].start && offset < map->volumes[i].end){
+			location->volume = &map->volumes[i];
+			break;
+		}
+	}
+	location->allocated = !isInExtentList(&map->unallocated, offset);
+	if(map->count > 0){
+		stack[top].node = ((size_t)1 << map->treeLevel) - 1;
+		stack[top].level = map->treeLevel;
+		stack[top].leftDone = 0;
+		top++;
+	}
+	while(top > 0){ //EVERY EXTENT STARTING AT OR BEFORE THE OFFSET WHOSE SUBTREE STILL REACHES PAST IT
+		cell = stack[--top];
+		if(cell.level <= 3){ //SMALL SUBTREE, SCAN ITS EXTENTS IN ORDER
+			first = cell.node >> cell.level << cell.level;
+			last = first + ((size_t)1 << (cell.level + 1)) - 1;
+			if(last > map->count){
+				last = map->count;
+			}
+			for(i=first;i<last && map->extents[i].offset <= offset;i++){
+				if(map->extents[i].offset + map->extents[i].length > offset && isPreferredExtent(map, i, best)){
+					best = i;
+				}
+			}
+		}else if(!cell.leftDone){
+			stack[top] = cell;
+			stack[top++].leftDone = 1;
+			i = cell.node - ((size_t)1 << (cell.level - 1));
+			if(i >= map->count || map->maxEnd[i] > offset){
+				stack[top].node = i;
+				stack[top].level = cell.level - 1;
+				stack[top++].leftDone = 0;
+			}
+		}else if(cell.node < map->count && map->extents[cell.node].offset <= offset){
+			if(map->extents[cell.node].offset + map->extents[cell.node].length > offset && isPreferredExtent(map, cell.node, best)){
+				best = cell.node;
+			}
+			stack[top].node = cell.node + ((size_t)1 << (cell.level - 1));
+			stack[top].level = cell.level - 1;
+			stack[top++].leftDone = 0;
+		}
+	}
+	if(best != SIZE_MAX){
+		extent = &map->extents[best];
+		location->file = &map->files[extent->file];
+		location->fileOffset = extent->fileOffset + (offset - extent->offset);
+	}
+	if(location->file != NULL){
+		location->kind = (location->file->size != FILE_MAP_UNSIZED && location->fileOffset >= location->file->size) ? LOCATION_SLACK : LOCATION_FILE;
+	}else if(!location->allocated){
+		location->kind = isInExtentList(&map->unpartitioned, offset) ? LOCATION_UNPARTITIONED : LOCATION_UNALLOCATED;
+	}else{
+		location->kind = LOCATION_METADATA;
+	}
+}
+
+
+/*
+ * Function:  fetchFileMapPath 
+ * --------------------
+ * Gives the full path of a file of the map
+ * 
+ * map: The reverse map
+ * file: A file of the map
+ * buffer: Buffer an NTFS path is written into (NTFS_PATH_MAX holds any path)
+ * size: Size of the buffer
+ * const char*: The path, NULL if the file has no name
+ */
+const char *fetchFileMapPath(struct FileMap *map, const struct FileMapFile *file, char *buffer, size_t size){
+	//DATA DECLARATION
+	struct FileMapVolume *volume = &map->volumes[file->volume];
+	int orphan;
+	//DATA MANIPULATION
+	if(volume->fileSystem == FILESYSTEM_FAT){
+		return fetchInternedString(&map->names, file->path);
+	}
+	if(!volume->hasTree){
+		return NULL;
+	}
+	return resolveNtfsPath(&volume->tree, file->owner, buffer, size, &orphan);
+}
+
+
+/*
+ * Function:  freeFileMap 
+ * --------------------
+ * Releases everything held by a reverse map
+ * 
+ * map: The reverse map
+ */
+void freeFileMap(struct FileMap *map){
+	//DATA DECLARATION
+	size_t i;
+	//DATA MANIPULATION
+	for(i=0;i<map->volumeCount;i++){
+		if(map->volumes[i].hasTree){
+			freeNtfsTree(&map->volumes[i].tree);
+		}
+	}
+	free(map->volumes);
+	free(map->extents);
+	free(map->maxEnd);
+	free(map->files);
+	freeExtentList(&map->unallocated);
+	freeExtentList(&map->unpartitioned);
+	freeStringTable(&map->names);
+	memset(map, 0, sizeof(*map));
+}
+
+
+/*
+ * Function:  mapFatVolume 
+ * --------------------
+ * Adds the root directory and every entry of a FAT volume to the map
+ * 
+ * map: The reverse map
+ * image: The open disk image
+ * fat: The FAT volume
+ * volume: Index of the volume in the map
+ * int: 0 on success, -1 on failure
+ */
+static int mapFatVolume(struct FileMap *map, struct DiskImage *image, struct FatVolume *fat, uint32_t volume){
+	//DATA DECLARATION
+	struct FileMapWalk walk;
+	struct FatDirEntry root;
+	uint64_t path, length;
+	uint32_t file;
+	int status;
+	//DATA MANIPULATION
+	memset(&walk, 0, sizeof(walk));
+	walk.map = map;
+	walk.image = image;
+	walk.fat = fat;
+	walk.volume = volume;
+	if(fat->fatBits == 32){ //THE FAT32 ROOT DIRECTORY IS A CLUSTER CHAIN LIKE ANY OTHER DIRECTORY
+		memset(&root, 0, sizeof(root));
+		root.attributes = 0x10;
+		root.startCluster = fat->rootCluster;
+		status = mapFatExtents(&walk, &root, "/", FILE_MAP_DIRECTORY);
+	}else{
+		length = (uint64_t)fat->rootDirSize*fat->bytesPerSector;
+		status = internString(&map->names, "/", 1, &path);
+		if(status == 0){
+			status = addFileMapFile(map, volume, 0, length, FILE_MAP_DIRECTORY, &file);
+		}
+		if(status == 0){
+			map->files[file].path = path;
+			status = addFileMapExtent(map, fetchVolumeOffset(fat, (uint64_t)fat->reserved + fat->fatSize), length, 0, file);
+		}
+	}
+	if(status == 0){
+		status = walkFatDirectories(image, fat, mapFatEntry, &walk);
+	}
+	return (status != 0 || walk.status != 0) ? -1 : 0;
+}
+
+
+/*
+ * Function:  mapFatEntry 
+ * --------------------
+ * Directory walk visitor adding a FAT entry to the map
+ * 
+ * entry: The directory entry
+ * context: The FileMapWalk
+ * int: 0 to keep walking, -1 to stop
+ */
+static int mapFatEntry(const struct FatDirEntry *entry, void *context){
+	//DATA DECLARATION
+	struct FileMapWalk *walk = context;
+	unsigned char flags = 0;
+	//DATA MANIPULATION
+	if(entry->deleted || entry->parentDeleted){
+		flags |= FILE_MAP_DELETED;
+	}
+	if(entry->attributes & 0x10){
+		flags |= FILE_MAP_DIRECTORY;
+	}
+	walk->status = mapFatExtents(walk, entry, entry->path, flags);
+	return walk->status;
+}
+
+
+/*
+ * Function:  mapFatExtents 
+ * --------------------
+ * Adds a FAT file and the clusters of its chain to the map
+ * The last extent is rounded up to a whole cluster so hits in the slack
+ * are found as well
+ * 
+ * walk: The FileMapWalk
+ * entry: The directory entry of the file
+ * path: Full path of the file
+ * flags: FILE_MAP_ flags of the file
+ * int: 0 on success, -1 when out of memory
+ */
+static int mapFatExtents(struct FileMapWalk *walk, const struct FatDirEntry *entry, const char *path, unsigned char flags){
+	//DATA DECLARATION
+	struct FileExtents extents;
+	uint64_t clusterBytes = (uint64_t)walk->fat->bytesPerSector*walk->fat->sectorsPerCluster;
+	uint64_t fileOffset = 0, length, pathOffset;
+	uint32_t file;
+	size_t i;
+	int status = 0;
+	//DATA MANIPULATION
+	if(fetchFileExtents(walk->image, walk->fat, entry, &extents) != 0){
+		return 0; //NO CHAIN TO MAP (A BAD START CLUSTER)
+	}
+	if(extents.count > 0){
+		status = internString(&walk->map->names, path, strlen(path), &pathOffset);
+		if(status == 0){
+			status = addFileMapFile(walk->map, walk->volume, entry->entryOffset, (flags & FILE_MAP_DIRECTORY) ? extents.length : entry->fileSize, flags, &file);
+		}
+		if(status == 0){
+			walk->map->files[file].path = pathOffset;
+		}
+		for(i=0;i<extents.count && status == 0;i++){
+			length = extents.extents[i].length;
+			if(i == extents.count - 1 && clusterBytes > 0 && length % clusterBytes != 0){
+				length += clusterBytes - length % clusterBytes; //THE SLACK OF THE LAST CLUSTER
+			}
+			status = addFileMapExtent(walk->map, extents.extents[i].offset, length, fileOffset, file);
+			fileOffset += extents.extents[i].length;
+		}
+	}
+	freeFileExtents(&extents);
+	return status;
+}
+
+
+/*
+ * Function:  mapNtfsVolume 
+ * --------------------
+ * Builds the directory tree of an NTFS volume, then adds the non-resident
+ * $DATA streams and $I30 indexes of its records to the map
+ * 
+ * map: The reverse map
+ * model: Model holding only this volume
+ * volume: The volume of the map
+ * index: Index of the volume in the map
+ * int: 0 on success, -1 on failure
+ */
+static int mapNtfsVolume(struct FileMap *map, struct VolumeModel *model, struct FileMapVolume *volume, uint32_t index){
+	//DATA DECLARATION
+	struct FileMapWalk walk;
+	int status;
+	//DATA MANIPULATION
+	volume->mftRecordSize = model->ntfs.mftRecordSize;
+	if(buildNtfsTree(model, &volume->tree) == 0){ //PATHS ARE STILL LEFT OUT IF IT FAILS
+		volume->hasTree = 1;
+	}
+	memset(&walk, 0, sizeof(walk));
+	walk.map = map;
+	walk.image = model->image;
+	walk.ntfs = &model->ntfs;
+	walk.volume = index;
+	walk.volumeStart = volume->start;
+	walk.volumeEnd = volume->start + (uint64_t)model->ntfs.totalSectors*model->ntfs.bytesPerSector;
+	if(loadMftExtentMap(model->image, &model->ntfs) == 0 && model->ntfs.mftRecordSize > 0){
+		walk.recordCount = model->ntfs.mftMap.dataSize/(uint64_t)model->ntfs.mftRecordSize;
+		walk.recordFiles = calloc(walk.recordCount ? walk.recordCount : 1, sizeof(uint32_t));
+		if(walk.recordFiles == NULL){
+			return -1;
+		}
+	}
+	status = scanMftRecords(model->image, &model->ntfs, 0, mapMftRecord, &walk);
+	free(walk.recordFiles);
+	return (status != 0 || walk.status != 0) ? -1 : 0;
+}
+
+
+/*
+ * Function:  mapMftRecord 
+ * --------------------
+ * Record scan visitor adding the clusters of a record's unnamed $DATA
+ * stream and $I30 index to the map
+ * The runs of an extension record are added to the file of its base record
+ * 
+ * record: The MFT record
+ * context: The FileMapWalk
+ * int: 0 to keep scanning, -1 to stop
+ */
+static int mapMftRecord(const struct MftRecord *record, void *context){
+	//DATA DECLARATION
+	struct FileMapWalk *walk = context;
+	struct NtfsExtentMap stream;
+	const struct MftAttribute *attribute;
+	uint64_t base = record->baseRecord ? record->baseRecord : record->number, size = FILE_MAP_UNSIZED;
+	unsigned char flags = record->inUse ? 0 : FILE_MAP_DELETED;
+	uint32_t file;
+	int i, hasData = 0;
+	//DATA MANIPULATION
+	if(record->baseRecord != 0 && !record->inUse){
+		return 0; //A FREED EXTENSION RECORD CANNOT BE TIED TO ITS FILE ANY MORE
+	}
+	for(i=0;i<record->attributeCount;i++){
+		attribute = &record->attributes[i];
+		if(attribute->type == 0x80 && attribute->nameLength == 0 && attribute->nonResident){
+			hasData = 1;
+			if(attribute->startVcn == 0){
+				size = attribute->realSize; //ONLY THE FIRST PIECE OF THE STREAM HOLDS ITS SIZE
+			}
+		}
+	}
+	if(hasData){
+		if(base < walk->recordCount && walk->recordFiles[base] != 0){
+			file = walk->recordFiles[base] - 1;
+		}else{
+			walk->status = addFileMapFile(walk->map, walk->volume, base, FILE_MAP_UNSIZED, 0, &file);
+			if(walk->status != 0){
+				return -1;
+			}
+			if(base < walk->recordCount){
+				walk->recordFiles[base] = file + 1;
+			}
+		}
+		if(size != FILE_MAP_UNSIZED){
+			walk->map->files[file].size = size;
+		}
+		if(record->baseRecord == 0){
+			walk->map->files[file].flags = flags;
+		}
+		if(buildExtentMap(record, &stream) == 0){
+			walk->status = mapNtfsStream(walk, &stream, file);
+			freeExtentMap(&stream);
+		}
+	}
+	if(walk->status == 0 && record->baseRecord == 0 && record->isDirectory && findMftAttribute(record, 0xA0, "$I30") != NULL && buildStreamExtentMap(record, 0xA0, "$I30", &stream) == 0){
+		walk->status = addFileMapFile(walk->map, walk->volume, record->number, stream.dataSize, flags | FILE_MAP_DIRECTORY, &file);
+		if(walk->status == 0){
+			walk->status = mapNtfsStream(walk, &stream, file);
+		}
+		freeExtentMap(&stream);
+	}
+	return walk->status;
+}
+
+
+/*
+ * Function:  mapNtfsStream 
+ * --------------------
+ * Adds the allocated runs of a non-resident stream to the map
+ * Sparse runs and runs past the end of the volume are left out
+ * 
+ * walk: The FileMapWalk
+ * stream: Extent map of the stream
+ * file: Index of the file the runs belong to
+ * int: 0 on success, -1 when out of memory
+ */
+static int mapNtfsStream(struct FileMapWalk *walk, const struct NtfsExtentMap *stream, uint32_t file){
+	//DATA DECLARATION
+	uint64_t clusterSize = (uint64_t)walk->ntfs->clusterSize, offset, length;
+	size_t i;
+	int status = 0;
+	//DATA MANIPULATION
+	for(i=0;i<stream->count && status == 0;i++){
+		if(stream->runs[i].lcn == NTFS_SPARSE_LCN){
+			continue;
+		}
+		offset = walk->volumeStart + stream->runs[i].lcn*clusterSize;
+		length = stream->runs[i].length*clusterSize;
+		if(offset >= walk->volumeEnd){
+			continue;
+		}
+		if(length > walk->volumeEnd - offset){
+			length = walk->volumeEnd - offset;
+		}
+		status = addFileMapExtent(walk->map, offset, length, stream->runs[i].vcn*clusterSize, file);
+	}
+	return status;
+}
+
+
+/*
+ * Function:  addFileMapFile 
+ * --------------------
+ * Appends a file to the map's file table
+ * 
+ * map: The reverse map
+ * volume: Index of the volume holding the file
+ * owner: MFT record number or image offset of the FAT directory entry
+ * size: Size of the file's content in bytes
+ * flags: FILE_MAP_ flags
+ * file: Set to the index of the new file
+ * int: 0 on success, -1 when out of memory
+ */
+static int addFileMapFile(struct FileMap *map, uint32_t volume, uint64_t owner, uint64_t size, unsigned char flags, uint32_t *file){
+	//DATA DECLARATION
+	struct FileMapFile *grown;
+	size_t capacity;
+	//DATA MANIPULATION
+	if(map->fileCount == map->fileCapacity){
+		capacity = map->fileCapacity ? map->fileCapacity*2 : 256;
+		if(capacity > UINT32_MAX){
+			return -1;
+		}
+		grown = realloc(map->files, capacity*sizeof(*grown));
+		if(grown == NULL){
+			return -1;
+		}
+		map->files = grown;
+		map->fileCapacity = capacity;
+	}
+	memset(&map->files[map->fileCount], 0, sizeof(*grown));
+	map->files[map->fileCount].size = size;
+	map->files[map->fileCount].owner = owner;
+	map->files[map->fileCount].volume = volume;
+	map->files[map->fileCount].flags = flags;
+	*file = (uint32_t)map->fileCount++;
+	return 0;
+}
+
+
+/*
+ * Function:  addFileMapExtent 
+ * --------------------
+ * Appends an extent of a file to the map (sorted once the map is complete)
+ * 
+ * map: The reverse map
+ * offset: Image offset of the extent
+ * length: Length of the extent in bytes
+ * fileOffset: Offset of the extent within the file
+ * file: Index of the file
+ * int: 0 on success, -1 when out of memory
+ */
+static int addFileMapExtent(struct FileMap *map, uint64_t offset, uint64_t length, uint64_t fileOffset, uint32_t file){
+	//DATA DECLARATION
+	struct FileMapExtent *grown;
+	size_t capacity;
+	//DATA MANIPULATION
+	if(length == 0){
+		return 0;
+	}
+	if(map->count == map->capacity){
+		capacity = map->capacity ? map->capacity*2 : 1024;
+		grown = realloc(map->extents, capacity*sizeof(*grown));
+		if(grown == NULL){
+			return -1;
+		}
+		map->extents = grown;
+		map->capacity = capacity;
+	}
+	map->extents[map->count].offset = offset;
+	map->extents[map->count].length = length;
+	map->extents[map->count].fileOffset = fileOffset;
+	map->extents[map->count].file = file;
+	map->count++;
+	return 0;
+}
+
+
+/*
+ * Function:  indexFileMapExtents 
+ * --------------------
+ * Fills in the furthest end of every subtree of the implicit interval tree
+ * laid over the sorted extents, level by level from the leaves (even
+ * indexes) up. A right child past the end of the array stands for the
+ * extents of the last node of the level below.
+ * 
+ * map: The reverse map, extents sorted and maxEnd allocated
+ */
+static void indexFileMapExtents(struct FileMap *map){
+	//DATA DECLARATION
+	size_t i, half, lastNode = 0;
+	uint64_t lastEnd = 0, end, right;
+	int level;
+	//DATA MANIPULATION
+	for(i=0;i<map->count;i+=2){
+		lastNode = i;
+		lastEnd = map->maxEnd[i] = map->extents[i].offset + map->extents[i].length;
+	}
+	for(level=1;((size_t)1 << level) <= map->count;level++){
+		half = (size_t)1 << (level - 1);
+		for(i=(half << 1) - 1;i<map->count;i+=half << 2){
+			end = map->extents[i].offset + map->extents[i].length;
+			if(map->maxEnd[i - half] > end){
+				end = map->maxEnd[i - half];
+			}
+			right = (i + half < map->count) ? map->maxEnd[i + half] : lastEnd;
+			if(right > end){
+				end = right;
+			}
+			map->maxEnd[i] = end;
+		}
+		lastNode = ((lastNode >> level) & 1) ? lastNode - half : lastNode + half;
+		if(lastNode < map->count && map->maxEnd[lastNode] > lastEnd){
+			lastEnd = map->maxEnd[lastNode];
+		}
+	}
+	map->treeLevel = level - 1;
+}
+
+
+/*
+ * Function:  isPreferredExtent 
+ * --------------------
+ * Decides between two extents holding the same offset: a live file wins
+ * over a deleted one, then the extent starting later
+ * 
+ * map: The reverse map
+ * candidate: Index of the extent just found
+ * best: Index of the extent kept so far, SIZE_MAX if none
+ * int: 1 if the candidate should be kept instead
+ */
+static int isPreferredExtent(const struct FileMap *map, size_t candidate, size_t best){
+	//DATA DECLARATION
+	int candidateLive, bestLive;
+	//DATA MANIPULATION
+	if(best == SIZE_MAX){
+		return 1;
+	}
+	candidateLive = !(map->files[map->extents[candidate].file].flags & FILE_MAP_DELETED);
+	bestLive = !(map->files[map->extents[best].file].flags & FILE_MAP_DELETED);
+	if(candidateLive != bestLive){
+		return candidateLive;
+	}
+	return candidate > best;
+}
+
+
+/*
+ * Function:  isInExtentList 
+ * --------------------
+ * Checks whether an offset falls in a sorted, merged extent list
+ * 
+ * list: The extent list
+ * offset: Byte offset in the image
+ * int: 1 if an extent holds the offset, 0 otherwise
+ */
+static int isInExtentList(const struct ExtentList *list, uint64_t offset){
+	//DATA DECLARATION
+	size_t low = 0, high = list->count, middle;
+	//DATA MANIPULATION
+	while(low < high){
+		middle = low + (high - low)/2;
+		if(offset < list->extents[middle].offset){
+			high = middle;
+		}else if(offset >= list->extents[middle].offset + list->extents[middle].length){
+			low = middle + 1;
+		}else{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  compareFileMapExtents 
+ * --------------------
+ * qsort comparator ordering extents by offset, then by file
+ * 
+ * a: First extent
+ * b: Second extent
+ * int: Negative, zero or positive like strcmp
+ */
+static int compareFileMapExtents(const void *a, const void *b){
+	//DATA DECLARATION
+	const struct FileMapExtent *first = a, *second = b;
+	//DATA MANIPULATION
+	if(first->offset != second->offset){
+		return (first->offset < second->offset) ? -1 : 1;
+	}
+	return (first->file < second->file) ? -1 : (first->file > second->file);
+}
+
+
+/*
+ * Function:  compareImageExtents 
+ * --------------------
+ * qsort comparator ordering image extents by offset
+ * 
+ * a: First extent
+ * b: Second extent
+ * int: Negative, zero or positive like strcmp
+ */
+static int compareImageExtents(const void *a, const void *b){
+	//DATA DECLARATION
+	const struct ImageExtent *first = a, *second = b;
+	//DATA MANIPULATION
+	if(first->offset != second->offset){
+		return (first->offset < second->offset) ? -1 : 1;
+	}
+	return 0;
+}
@@ -0,0 +1,90 @@
+/*
+ * fileMap.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Cluster to file reverse map
+ * Maps any byte offset of the image back to the file holding it, from
+ * the FAT cluster chains and NTFS runlists of every FAT and NTFS
+ * partition, and tells allocated space from free clusters and space
+ * outside the partitions. The map is built once as a sorted array of
+ * extents laid out as an implicit interval tree, so each lookup takes
+ * logarithmic time plus the extents that actually hold the offset.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef FILEMAP_H
+#define FILEMAP_H
+
+//IMPORTED LIBRARIES
+#include <stddef.h>
+#include <stdint.h>
+#include "diskImage.h"
+#include "volumeModel.h"
+#include "stringTable.h"
+#include "ntfsTree.h"
+
+#define FILE_MAP_DELETED 0x01 //FileMapFile FLAGS
+#define FILE_MAP_DIRECTORY 0x02
+#define FILE_MAP_UNSIZED UINT64_MAX //SIZE OF A FILE ONLY SEEN THROUGH AN EXTENSION RECORD
+
+#define LOCATION_FILE 0 //FileLocation KINDS: INSIDE A FILE'S CONTENT
+#define LOCATION_SLACK 1 //IN THE LAST CLUSTER OF A FILE, PAST ITS END
+#define LOCATION_UNALLOCATED 2 //IN A FREE CLUSTER NO FILE RECORD POINTS AT
+#define LOCATION_METADATA 3 //ALLOCATED BUT IN NO FILE (BOOT SECTOR, FAT, UNMAPPED RECORDS...)
+#define LOCATION_UNPARTITIONED 4 //OUTSIDE EVERY PARTITION
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct FileMapExtent{
+	uint64_t offset; //IMAGE OFFSET OF THE FIRST BYTE
+	uint64_t length; //WHOLE CLUSTERS, THE SLACK OF THE LAST ONE INCLUDED
+	uint64_t fileOffset; //OFFSET OF THE FIRST BYTE WITHIN THE FILE
+	uint32_t file; //INDEX IN THE MAP'S FILE TABLE
+};
+
+struct FileMapFile{
+	uint64_t size; //BYTES OF CONTENT, SLACK STARTS HERE
+	uint64_t owner; //MFT RECORD NUMBER, OR IMAGE OFFSET OF THE FAT DIRECTORY ENTRY
+	uint64_t path; //OFFSET OF THE FAT PATH IN THE MAP'S STRING TABLE (NTFS PATHS COME FROM THE VOLUME'S TREE)
+	uint32_t volume; //INDEX IN THE MAP'S VOLUMES
+	unsigned char flags; //FILE_MAP_ FLAGS
+};
+
+struct FileMapVolume{
+	int partition; //INDEX OF THE PARTITION IN THE MODEL'S ENUMERATION
+	int fileSystem; //FILESYSTEM_FAT OR FILESYSTEM_NTFS
+	uint64_t start, end; //IMAGE BYTES OF THE PARTITION
+	int mftRecordSize; //NTFS: SIZE OF A FILE RECORD, TO NAME THE RECORD A HIT IN THE $MFT FALLS IN
+	int hasTree;
+	struct NtfsTree tree; //NTFS: PARENT LINKS TO REBUILD PATHS FROM
+};
+
+struct FileMap{
+	struct FileMapExtent *extents; //SORTED BY OFFSET
+	uint64_t *maxEnd; //IMPLICIT INTERVAL TREE OVER extents: maxEnd[i] IS THE FURTHEST END IN THE SUBTREE ROOTED AT i
+	int treeLevel; //LEVEL OF THE TREE'S ROOT, extents[2^treeLevel-1]
+	size_t count, capacity;
+	struct FileMapFile *files;
+	size_t fileCount, fileCapacity;
+	struct FileMapVolume *volumes;
+	size_t volumeCount;
+	struct ExtentList unallocated; //FREE CLUSTERS AND UNPARTITIONED SPACE, SORTED
+	struct ExtentList unpartitioned; //SPACE OUTSIDE EVERY PARTITION, SORTED
+	struct StringTable names; //FAT PATHS
+};
+
+struct FileLocation{
+	int kind; //LOCATION_ VALUE
+	int allocated; //0 IN A FREE CLUSTER OR OUTSIDE THE PARTITIONS
+	const struct FileMapVolume *volume; //PARTITION HOLDING THE OFFSET, NULL OUTSIDE THEM
+	const struct FileMapFile *file; //FILE HOLDING THE OFFSET, NULL IF NONE
+	uint64_t fileOffset; //OFFSET WITHIN THE FILE
+};
+
+int buildFileMap(struct VolumeModel *model, struct FileMap *map);
+void locateImageOffset(const struct FileMap *map, uint64_t offset, struct FileLocation *location);
+const char *fetchFileMapPath(struct FileMap *map, const struct FileMapFile *file, char *buffer, size_t size);
+void freeFileMap(struct FileMap *map);
+
+#endif
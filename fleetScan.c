@@ -0,0 +1,625 @@
+/*
+ * fleetScan.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Fleet mode
+ * Every image is one task on a work-stealing pool. The image task opens the
+ * image, writes its partition table and submits one task per FAT or NTFS
+ * partition, which idle workers steal, so a large image is spread over the
+ * pool instead of holding up one thread. The images are submitted largest
+ * first. Tasks reading an image take one of a fixed number of I/O slots so
+ * slow storage is not thrashed by every worker seeking at once.
+ * Each partition's records go to a temporary file, and the image's last
+ * task to finish appends them to <outdir>/<image>.json in partition order.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "fleetScan.h"
+#include "scanCommands.h"
+#include "diskImage.h"
+#include "volumeModel.h"
+#include "jsonOutput.h"
+#include "scanStats.h"
+#include "workPool.h"
+
+struct FleetScan;
+struct FleetImage;
+
+struct FleetPartition{
+	struct FleetImage *owner;
+	const struct Partition *partition; //ENTRY OF THE OWNER'S PARTITION TABLE
+	int fileSystem; //FILESYSTEM_FAT OR FILESYSTEM_NTFS
+	FILE *records; //TEMPORARY FILE HOLDING THE PARTITION'S RECORDS UNTIL THE IMAGE IS FINISHED
+	int status;
+};
+
+struct FleetImage{
+	struct FleetScan *fleet;
+	char path[PATH_MAX];
+	char output[PATH_MAX]; //FILE THE IMAGE'S RECORDS ARE WRITTEN TO
+	uint64_t fileSize; //SIZE OF THE (FIRST SEGMENT) FILE, ORDERS THE SUBMISSIONS
+	struct DiskImage image;
+	struct VolumeModel model;
+	int imageOpen;
+	FILE *out;
+	struct FleetPartition *partitions; //FAT AND NTFS PARTITIONS, IN TABLE ORDER
+	size_t partitionCount;
+	int pending; //TASKS OF THE IMAGE NOT YET FINISHED, THE LAST ONE WRITES THE FILE OUT
+	int status;
+	uint64_t started;
+	char error[128]; //WHY THE IMAGE COULD NOT BE SCANNED (EMPTY IF IT WAS)
+};
+
+struct FleetScan{
+	const char *outDir;
+	struct FleetImage *images;
+	size_t count, capacity;
+	struct WorkPool *pool;
+	pthread_mutex_t lock; //PROTECTS THE I/O SLOTS, failed, pending OF EVERY IMAGE AND STDOUT
+	pthread_cond_t ioReady; //SIGNALLED WHEN AN I/O SLOT IS RELEASED
+	int ioLimit, ioBusy;
+	size_t failed;
+};
+
+static const char *const fleetImageCommands[] = {"partitions"};
+static const char *const fleetFatCommands[] = {"fat", "deleted"};
+static const char *const fleetNtfsCommands[] = {"ntfs", "paths"};
+
+static int listFleetDirectory(struct FleetScan *fleet, const char *directory);
+static int readFleetManifest(struct FleetScan *fleet, const char *manifest);
+static int addFleetImage(struct FleetScan *fleet, const char *path, uint64_t fileSize);
+static int isFleetImageName(const char *name);
+static int compareFleetImages(const void *a, const void *b);
+static int nameFleetOutput(struct FleetScan *fleet, size_t index);
+static void scanFleetImage(void *arg);
+static void scanFleetPartition(void *arg);
+static int runFleetCommands(struct VolumeModel *model, const char *const names[], size_t count, FILE *out);
+static void finishFleetTask(struct FleetImage *image);
+static void finishFleetImage(struct FleetImage *image);
+static void acquireFleetIo(struct FleetScan *fleet);
+static void releaseFleetIo(struct FleetScan *fleet);
+
+
+/*
+ * Function:  runFleetScan 
+ * --------------------
+ * Scans every image of a directory or manifest and writes one
+ * "fleetImage" record per image to stdout as it finishes,
+ * then a "fleet" record once all are done
+ * A directory is scanned for regular files other than later segments of
+ * split and EWF images, indexes and fleet output; a manifest lists one
+ * image path per line (relative to the manifest, # starts a comment)
+ * 
+ * source: Directory of images or manifest file
+ * outDir: Directory the <image>.json files are written to (created if missing)
+ * threadCount: Worker threads, 0 for one per processor
+ * ioLimit: Tasks reading images at once, 0 for one per worker thread
+ * int: Process exit status (0 if every image was scanned, 1 otherwise)
+ */
+int runFleetScan(const char *source, const char *outDir, int threadCount, int ioLimit){
+	//DATA DECLARATION
+	struct FleetScan fleet;
+	struct JsonRecord record;
+	struct stat info;
+	uint64_t started = fetchStatsClock();
+	size_t i;
+	int status;
+	//DATA MANIPULATION
+	statsMode = STATS_OFF; //COUNTERS WOULD MIX THE IMAGES SCANNED AT ONCE
+	memset(&fleet, 0, sizeof(fleet));
+	fleet.outDir = outDir;
+	if(stat(source, &info) != 0){
+		perror(source);
+		return 1;
+	}
+	status = S_ISDIR(info.st_mode) ? listFleetDirectory(&fleet, source) : readFleetManifest(&fleet, source);
+	if(status == 0 && fleet.count == 0){
+		fprintf(stderr, "No images found in %s\n", source);
+		status = -1;
+	}
+	if(status == 0 && mkdir(outDir, 0755) != 0 && errno != EEXIST){
+		perror(outDir);
+		status = -1;
+	}
+	if(status == 0){
+		qsort(fleet.images, fleet.count, sizeof(*fleet.images), compareFleetImages); //LARGEST FIRST, SO THE BIGGEST IMAGE IS NOT THE LAST ONE STARTED
+		for(i=0;i<fleet.count && status == 0;i++){
+			status = nameFleetOutput(&fleet, i);
+		}
+	}
+	if(status == 0 && (fleet.pool = createWorkPool(threadCount)) == NULL){
+		fprintf(stderr, "Unable to start the scan threads\n");
+		status = -1;
+	}
+	if(status != 0){
+		free(fleet.images);
+		return 1;
+	}
+	fleet.ioLimit = (ioLimit > 0) ? ioLimit : fetchWorkPoolSize(fleet.pool);
+	pthread_mutex_init(&fleet.lock, NULL);
+	pthread_cond_init(&fleet.ioReady, NULL);
+	fprintf(stderr, "Scanning %zu images with %d threads, %d reading at once\n", fleet.count, fetchWorkPoolSize(fleet.pool), fleet.ioLimit);
+	for(i=fleet.count;i>0;i--){ //SMALLEST FIRST: WORKERS RUN THEIR NEWEST TASK FIRST, SO THE LARGEST IMAGES START FIRST
+		fleet.images[i - 1].fleet = &fleet;
+		if(submitWork(fleet.pool, scanFleetImage, &fleet.images[i - 1]) != 0){
+			scanFleetImage(&fleet.images[i - 1]); //RUN IT HERE RATHER THAN DROP IT
+		}
+	}
+	threadCount = fetchWorkPoolSize(fleet.pool);
+	destroyWorkPool(fleet.pool); //WAITS FOR EVERY IMAGE AND PARTITION TASK
+	beginJsonRecord(&record, stdout, "fleet");
+	addJsonInt(&record, "threads", threadCount);
+	addJsonInt(&record, "ioLimit", fleet.ioLimit);
+	addJsonInt(&record, "images", (long long int)fleet.count);
+	addJsonInt(&record, "failed", (long long int)fleet.failed);
+	addJsonDouble(&record, "seconds", (double)(fetchStatsClock() - started)/1e9);
+	endJsonRecord(&record);
+	fflush(stdout);
+	pthread_cond_destroy(&fleet.ioReady);
+	pthread_mutex_destroy(&fleet.lock);
+	free(fleet.images);
+	return (fleet.failed != 0) ? 1 : 0;
+}
+
+
+/*
+ * Function:  listFleetDirectory 
+ * --------------------
+ * Adds the image files of a directory (subdirectories are not entered)
+ * 
+ * fleet: The fleet scan
+ * directory: The directory
+ * int: 0 on success, -1 on failure
+ */
+static int listFleetDirectory(struct FleetScan *fleet, const char *directory){
+	//DATA DECLARATION
+	DIR *listing;
+	struct dirent *entry;
+	struct stat info;
+	char path[PATH_MAX];
+	int status = 0;
+	//DATA MANIPULATION
+	listing = opendir(directory);
+	if(listing == NULL){
+		perror(directory);
+		return -1;
+	}
+	while(status == 0 && (entry = readdir(listing)) != NULL){
+		if(entry->d_name[0] == '.' || !isFleetImageName(entry->d_name)){
+			continue;
+		}
+		if(snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name) >= (int)sizeof(path) || stat(path, &info) != 0 || !S_ISREG(info.st_mode)){
+			continue;
+		}
+		status = addFleetImage(fleet, path, (uint64_t)info.st_size);
+	}
+	closedir(listing);
+	return status;
+}
+
+
+/*
+ * Function:  readFleetManifest 
+ * --------------------
+ * Adds the images listed in a manifest, one path per line
+ * Listed images that do not exist are kept so they are reported as failed
+ * 
+ * fleet: The fleet scan
+ * manifest: The manifest file
+ * int: 0 on success, -1 on failure
+ */
+static int readFleetManifest(struct FleetScan *fleet, const char *manifest){
+	//DATA DECLARATION
+	FILE *in;
+	struct stat info;
+	char path[PATH_MAX], *line = NULL;
+	const char *slash = strrchr(manifest, '/');
+	int baseLength = (slash != NULL) ? (int)(slash - manifest) + 1 : 0, status = 0;
+	size_t lineSize = 0;
+	ssize_t length;
+	//DATA MANIPULATION
+	in = fopen(manifest, "r");
+	if(in == NULL){
+		perror(manifest);
+		return -1;
+	}
+	while(status == 0 && (length = getline(&line, &lineSize, in)) >= 0){
+		while(length > 0 && isspace((unsigned char)line[length - 1])){ //NEWLINE, CARRIAGE RETURN AND TRAILING BLANKS
+			line[--length] = '\0';
+		}
+		if(length == 0 || line[0] == '#'){
+			continue;
+		}
+		if(snprintf(path, sizeof(path), "%.*s%s", (line[0] == '/') ? 0 : baseLength, manifest, line) >= (int)sizeof(path)){ //RELATIVE TO THE MANIFEST'S DIRECTORY
+			fprintf(stderr, "Image path too long: %s\n", line);
+			continue;
+		}
+		status = addFleetImage(fleet, path, (stat(path, &info) == 0) ? (uint64_t)info.st_size : 0);
+	}
+	free(line);
+	fclose(in);
+	return status;
+}
+
+
+/*
+ * Function:  addFleetImage 
+ * --------------------
+ * Appends an image to the fleet, growing the array as needed
+ * 
+ * fleet: The fleet scan
+ * path: Path of the image (its first segment for split and EWF images)
+ * fileSize: Size of the file, used to order the submissions
+ * int: 0 on success, -1 when out of memory
+ */
+static int addFleetImage(struct FleetScan *fleet, const char *path, uint64_t fileSize){
+	//DATA DECLARATION
+	struct FleetImage *grown;
+	size_t capacity;
+	//DATA MANIPULATION
+	if(fleet->count == fleet->capacity){
+		capacity = fleet->capacity ? fleet->capacity*2 : 16;
+		grown = realloc(fleet->images, capacity*sizeof(*grown));
+		if(grown == NULL){
+			fprintf(stderr, "Out of memory listing the images\n");
+			return -1;
+		}
+		fleet->images = grown;
+		fleet->capacity = capacity;
+	}
+	memset(&fleet->images[fleet->count], 0, sizeof(fleet->images[fleet->count]));
+	snprintf(fleet->images[fleet->count].path, sizeof(fleet->images[fleet->count].path), "%s", path);
+	fleet->images[fleet->count].fileSize = fileSize;
+	fleet->count++;
+	return 0;
+}
+
+
+/*
+ * Function:  isFleetImageName 
+ * --------------------
+ * Tells image files apart from the other files kept next to them
+ * Later segments of split (.002...) and EWF (.E02..., .EAA...) images are
+ * opened through their first segment, .idx and .json files are metadata
+ * indexes and fleet output
+ * 
+ * name: File name
+ * int: 1 if the file should be scanned as an image
+ */
+static int isFleetImageName(const char *name){
+	const char *extension = strrchr(name, '.');
+	if(extension == NULL){
+		return 1;
+	}
+	extension++;
+	if(strcmp(extension, "idx") == 0 || strcmp(extension, "json") == 0){
+		return 0;
+	}
+	if(strlen(extension) != 3){
+		return 1;
+	}
+	if(isdigit((unsigned char)extension[0]) && isdigit((unsigned char)extension[1]) && isdigit((unsigned char)extension[2])){
+		return strcmp(extension, "001") == 0;
+	}
+	if((extension[0] == 'E' || extension[0] == 'e') && isdigit((unsigned char)extension[1]) && isdigit((unsigned char)extension[2])){
+		return strcmp(extension + 1, "01") == 0;
+	}
+	return !(extension[0] == 'E' && isupper((unsigned char)extension[1]) && isupper((unsigned char)extension[2]));
+}
+
+
+/*
+ * Function:  compareFleetImages 
+ * --------------------
+ * qsort comparator ordering images by size, largest first, then by path
+ * 
+ * a: First FleetImage
+ * b: Second FleetImage
+ * int: Negative, zero or positive as for qsort
+ */
+static int compareFleetImages(const void *a, const void *b){
+	const struct FleetImage *first = a, *second = b;
+	if(first->fileSize != second->fileSize){
+		return (first->fileSize > second->fileSize) ? -1 : 1;
+	}
+	return strcmp(first->path, second->path);
+}
+
+
+/*
+ * Function:  nameFleetOutput 
+ * --------------------
+ * Names the output file of an image after its file name, adding -2, -3...
+ * when an image earlier in the fleet already took the name
+ * 
+ * fleet: The fleet scan
+ * index: The image to name (the ones before it are already named)
+ * int: 0 on success, -1 if the path is too long
+ */
+static int nameFleetOutput(struct FleetScan *fleet, size_t index){
+	//DATA DECLARATION
+	struct FleetImage *image = &fleet->images[index];
+	const char *slash = strrchr(image->path, '/');
+	const char *name = (slash != NULL) ? slash + 1 : image->path;
+	size_t i;
+	int copy, length, taken = 1;
+	//DATA MANIPULATION
+	for(copy=1;taken;copy++){
+		if(copy == 1){
+			length = snprintf(image->output, sizeof(image->output), "%s/%s.json", fleet->outDir, name);
+		}else{
+			length = snprintf(image->output, sizeof(image->output), "%s/%s-%d.json", fleet->outDir, name, copy);
+		}
+		if(length >= (int)sizeof(image->output)){
+			fprintf(stderr, "Output path too long for %s\n", image->path);
+			return -1;
+		}
+		for(i=0, taken=0;i<index && !taken;i++){
+			taken = (strcmp(fleet->images[i].output, image->output) == 0);
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  scanFleetImage 
+ * --------------------
+ * Image task: opens the image, writes its "image" and partition records
+ * and submits a task per FAT or NTFS partition
+ * 
+ * arg: The FleetImage
+ */
+static void scanFleetImage(void *arg){
+	//DATA DECLARATION
+	struct FleetImage *image = arg;
+	struct FleetScan *fleet = image->fleet;
+	struct FleetPartition *partition;
+	struct JsonRecord record;
+	size_t i;
+	int fileSystem;
+	//DATA MANIPULATION
+	image->started = fetchStatsClock();
+	acquireFleetIo(fleet);
+	if(openDiskImage(image->path, &image->image) == 0){ //THE OUTPUT FILE IS ONLY CREATED FOR AN IMAGE THAT OPENED
+		image->imageOpen = 1;
+		image->out = fopen(image->output, "w");
+	}
+	if(!image->imageOpen){
+		snprintf(image->error, sizeof(image->error), "Unable to open the image: %s", strerror(errno));
+	}else if(image->out == NULL){
+		snprintf(image->error, sizeof(image->error), "Unable to write the output file: %s", strerror(errno));
+	}else{
+		buildVolumeModel(&image->image, &image->model);
+		beginJsonRecord(&record, image->out, "image");
+		addJsonString(&record, "path", image->path);
+		addJsonInt(&record, "size", (long long int)image->image.size);
+		endJsonRecord(&record);
+		image->status = runFleetCommands(&image->model, fleetImageCommands, sizeof(fleetImageCommands)/sizeof(fleetImageCommands[0]), image->out);
+		if(image->model.partitionCount > 0){
+			image->partitions = calloc(image->model.partitionCount, sizeof(*image->partitions));
+			if(image->partitions == NULL){
+				snprintf(image->error, sizeof(image->error), "%s", strerror(ENOMEM));
+			}
+		}
+		for(i=0;i<image->model.partitionCount && image->partitions != NULL;i++){
+			fileSystem = fetchPartitionFileSystem(&image->image, &image->model.partitions[i]);
+			if(fileSystem == FILESYSTEM_FAT || fileSystem == FILESYSTEM_NTFS){
+				partition = &image->partitions[image->partitionCount++];
+				partition->owner = image;
+				partition->partition = &image->model.partitions[i];
+				partition->fileSystem = fileSystem;
+			}
+		}
+	}
+	releaseFleetIo(fleet);
+	image->pending = 1 + (int)image->partitionCount; //NO OTHER TASK OF THE IMAGE EXISTS YET
+	for(i=0;i<image->partitionCount;i++){
+		if(submitWork(fleet->pool, scanFleetPartition, &image->partitions[i]) != 0){
+			scanFleetPartition(&image->partitions[i]);
+		}
+	}
+	finishFleetTask(image);
+}
+
+
+/*
+ * Function:  scanFleetPartition 
+ * --------------------
+ * Partition task: runs the FAT or NTFS commands on one partition
+ * The commands see a copy of the image's model holding only this
+ * partition's volume, which the task builds and frees itself
+ * 
+ * arg: The FleetPartition
+ */
+static void scanFleetPartition(void *arg){
+	//DATA DECLARATION
+	struct FleetPartition *partition = arg;
+	struct FleetImage *image = partition->owner;
+	struct VolumeModel model;
+	struct JsonRecord record;
+	//DATA MANIPULATION
+	acquireFleetIo(image->fleet);
+	partition->records = tmpfile();
+	if(partition->records == NULL){
+		fprintf(stderr, "%s: no temporary file for partition %d: %s\n", image->path, partition->partition->index, strerror(errno));
+		partition->status = 1;
+	}else{
+		model = image->model; //SHARES THE IMAGE AND THE PARTITION TABLE, WHICH ARE ONLY READ
+		memset(&model.fat, 0, sizeof(model.fat));
+		memset(&model.ntfs, 0, sizeof(model.ntfs));
+		beginJsonRecord(&record, partition->records, "fleetPartition");
+		addJsonInt(&record, "index", partition->partition->index);
+		addJsonString(&record, "fileSystem", (partition->fileSystem == FILESYSTEM_FAT) ? "FAT" : "NTFS");
+		addJsonInt(&record, "sectorStart", (long long int)partition->partition->sectorStart);
+		endJsonRecord(&record);
+		if(partition->fileSystem == FILESYSTEM_FAT){
+			model.fat.sectorStart = partition->partition->sectorStart;
+			fetchFatVolumeInfo(model.image, &model.fat);
+			partition->status = model.fat.present ? runFleetCommands(&model, fleetFatCommands, sizeof(fleetFatCommands)/sizeof(fleetFatCommands[0]), partition->records) : 1;
+			freeFatVolume(&model.fat);
+		}else{
+			model.ntfs.sectorStart = (long long int)partition->partition->sectorStart;
+			model.ntfs.scanThreads = 1; //THE FLEET'S POOL ALREADY RUNS ONE TASK PER PROCESSOR
+			fetchNTFSVolumeInfo(model.image, &model.ntfs);
+			partition->status = model.ntfs.present ? runFleetCommands(&model, fleetNtfsCommands, sizeof(fleetNtfsCommands)/sizeof(fleetNtfsCommands[0]), partition->records) : 1;
+			freeNtfsVolume(&model.ntfs);
+		}
+		if(partition->status != 0){
+			fprintf(stderr, "%s: partition %d was not fully read\n", image->path, partition->partition->index);
+		}
+	}
+	releaseFleetIo(image->fleet);
+	finishFleetTask(image);
+}
+
+
+/*
+ * Function:  runFleetCommands 
+ * --------------------
+ * Runs a list of argument-less scan commands on a model
+ * 
+ * model: The volume model
+ * names: Names of the commands, run in order
+ * count: Number of commands
+ * out: Stream the records are written to
+ * int: 0 if every command succeeded, 1 otherwise
+ */
+static int runFleetCommands(struct VolumeModel *model, const char *const names[], size_t count, FILE *out){
+	const struct ScanCommand *command;
+	size_t i;
+	int status = 0;
+	for(i=0;i<count;i++){
+		command = findScanCommand(names[i], 0);
+		if(command != NULL && command->run(model, NULL, out) != 0){
+			status = 1;
+		}
+	}
+	return status;
+}
+
+
+/*
+ * Function:  finishFleetTask 
+ * --------------------
+ * Called at the end of each task of an image, the last one finishes the image
+ * 
+ * image: The image the task belonged to
+ */
+static void finishFleetTask(struct FleetImage *image){
+	int last;
+	pthread_mutex_lock(&image->fleet->lock);
+	last = (--image->pending == 0);
+	pthread_mutex_unlock(&image->fleet->lock);
+	if(last){
+		finishFleetImage(image);
+	}
+}
+
+
+/*
+ * Function:  finishFleetImage 
+ * --------------------
+ * Appends the partitions' records to the image's file in partition order,
+ * releases the image and writes its "fleetImage" record to stdout
+ * 
+ * image: The image, all of whose tasks have finished
+ */
+static void finishFleetImage(struct FleetImage *image){
+	//DATA DECLARATION
+	struct FleetScan *fleet = image->fleet;
+	struct JsonRecord record;
+	char *buffer = malloc(FLEET_COPY_BUFFER);
+	size_t i, length;
+	//DATA MANIPULATION
+	for(i=0;i<image->partitionCount;i++){
+		if(image->partitions[i].status != 0){
+			image->status = 1;
+		}
+		if(image->partitions[i].records == NULL){
+			continue;
+		}
+		rewind(image->partitions[i].records);
+		while(buffer != NULL && (length = fread(buffer, 1, FLEET_COPY_BUFFER, image->partitions[i].records)) > 0){
+			if(fwrite(buffer, 1, length, image->out) != length){
+				break; //REPORTED BY fclose BELOW
+			}
+		}
+		fclose(image->partitions[i].records);
+	}
+	if(buffer == NULL && image->partitionCount > 0 && image->error[0] == '\0'){
+		snprintf(image->error, sizeof(image->error), "%s", strerror(ENOMEM));
+	}
+	if(image->out != NULL && (ferror(image->out) | fclose(image->out)) != 0 && image->error[0] == '\0'){
+		snprintf(image->error, sizeof(image->error), "Unable to write the output file: %s", strerror(errno));
+	}
+	if(image->imageOpen){
+		freeVolumeModel(&image->model);
+		closeDiskImage(&image->image);
+	}
+	free(image->partitions);
+	free(buffer);
+	if(image->error[0] != '\0'){
+		image->status = 1;
+	}
+	pthread_mutex_lock(&fleet->lock);
+	if(image->status != 0){
+		fleet->failed++;
+	}
+	beginJsonRecord(&record, stdout, "fleetImage");
+	addJsonString(&record, "image", image->path);
+	addJsonString(&record, "output", image->output);
+	addJsonInt(&record, "status", image->status);
+	addJsonInt(&record, "partitions", (long long int)image->partitionCount);
+	addJsonDouble(&record, "seconds", (double)(fetchStatsClock() - image->started)/1e9);
+	if(image->error[0] != '\0'){
+		addJsonString(&record, "error", image->error);
+	}
+	endJsonRecord(&record);
+	fflush(stdout);
+	pthread_mutex_unlock(&fleet->lock);
+}
+
+
+/*
+ * Function:  acquireFleetIo 
+ * --------------------
+ * Waits for one of the fleet's I/O slots
+ * 
+ * fleet: The fleet scan
+ */
+static void acquireFleetIo(struct FleetScan *fleet){
+	pthread_mutex_lock(&fleet->lock);
+	while(fleet->ioBusy >= fleet->ioLimit){
+		pthread_cond_wait(&fleet->ioReady, &fleet->lock);
+	}
+	fleet->ioBusy++;
+	pthread_mutex_unlock(&fleet->lock);
+}
+
+
+/*
+ * Function:  releaseFleetIo 
+ * --------------------
+ * Gives back an I/O slot taken by acquireFleetIo
+ * 
+ * fleet: The fleet scan
+ */
+static void releaseFleetIo(struct FleetScan *fleet){
+	pthread_mutex_lock(&fleet->lock);
+	fleet->ioBusy--;
+	pthread_cond_signal(&fleet->ioReady);
+	pthread_mutex_unlock(&fleet->lock);
+}
@@ -0,0 +1,21 @@
+/*
+ * fleetScan.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Fleet mode
+ * Triages every image of a directory (or listed in a manifest) at once on
+ * one work-stealing pool, with each image's records written to its own file.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef FLEETSCAN_H
+#define FLEETSCAN_H
+
+#define FLEET_COPY_BUFFER (256*1024) //BYTES COPIED AT A TIME WHEN A PARTITION'S RECORDS ARE APPENDED TO THE IMAGE'S FILE
+
+//FUNCTION & STRUCT DECLARATIONS:
+int runFleetScan(const char *source, const char *outDir, int threadCount, int ioLimit);
+
+#endif
@@ -0,0 +1,1125 @@
+/*
+ * imageGenerator.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Synthetic disk image generator
+ * Builds reproducible test and benchmark images without any formatting
+ * tools: an MBR with up to four primary partitions, each holding a FAT16,
+ * FAT32 or NTFS file system populated with numbered files, a fraction of
+ * which are deleted. The NTFS $MFT can be split into several runs.
+ * All content comes from a seeded generator, so the same options always
+ * produce a byte for byte identical image.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define GENERATE_FAT16 1 //FILE SYSTEMS THE GENERATOR CAN BUILD
+#define GENERATE_FAT32 2
+#define GENERATE_NTFS 3
+#define GENERATE_SECTOR 512 //BYTES PER SECTOR OF EVERY GENERATED VOLUME
+#define GENERATE_ALIGN 2048 //PARTITIONS START ON 1 MiB BOUNDARIES
+#define FAT_FILE_MAX 16384 //LARGEST GENERATED FAT FILE IN BYTES
+#define FAT_ROOT_ENTRIES 512 //ROOT DIRECTORY ENTRIES OF A FAT16 VOLUME
+#define NTFS_CLUSTER 4096 //BYTES PER CLUSTER OF A GENERATED NTFS VOLUME
+#define NTFS_RECORD 1024 //BYTES PER MFT FILE RECORD
+#define NTFS_FIRST_USER_RECORD 24 //RECORDS BELOW THIS ARE RESERVED FOR SYSTEM FILES
+#define NTFS_RESIDENT_MAX 600 //LARGEST $DATA STREAM KEPT INSIDE ITS FILE RECORD
+#define NTFS_TIME_BASE 132583824000000000ULL //2021-02-21 12:00 UTC AS A WINDOWS FILETIME
+#define MFT_STAGING_BYTES (1024*1024) //RECORDS ARE WRITTEN IN BATCHES OF THIS SIZE
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct GeneratedPartition{
+	int fileSystem; //GENERATE_FAT16, GENERATE_FAT32 OR GENERATE_NTFS
+	uint64_t sectorStart; //FIRST SECTOR OF THE PARTITION
+	uint64_t sectorCount; //LENGTH OF THE PARTITION IN SECTORS
+};
+
+struct GeneratorOptions{
+	const char *output; //FILE NAME OF THE IMAGE TO WRITE
+	uint64_t seed; //SEED OF THE RANDOM GENERATOR
+	struct GeneratedPartition partitions[4];
+	int partitionCount;
+	unsigned int files; //FILES PER FAT VOLUME
+	unsigned int records; //MFT RECORDS PER NTFS VOLUME
+	unsigned int fragments; //RUNS THE $MFT IS SPLIT INTO
+	double deleted; //FRACTION OF FILES MARKED DELETED
+};
+
+struct FatLayout{
+	int bits; //16 OR 32
+	uint64_t byteStart; //BYTE OFFSET OF THE VOLUME IN THE IMAGE
+	unsigned int totalSectors, reserved, fatSectors, rootSectors, sectorsPerCluster, clusterBytes, clusterCount;
+	unsigned int nextCluster; //NEXT FREE CLUSTER (CLUSTERS ARE HANDED OUT IN ORDER)
+	unsigned char *table; //ONE COPY OF THE FAT
+};
+
+struct NtfsLayout{
+	uint64_t byteStart; //BYTE OFFSET OF THE VOLUME IN THE IMAGE
+	uint64_t totalClusters;
+	unsigned char *bitmap; //CLUSTER ALLOCATION BITMAP (BECOMES THE $Bitmap FILE)
+	uint64_t cursor; //WHERE THE NEXT ALLOCATION SEARCH STARTS
+	uint64_t mftRuns[64][2]; //LCN AND LENGTH OF EACH RUN OF THE $MFT
+	unsigned int mftRunCount;
+	unsigned char *staging; //RECORDS WAITING TO BE WRITTEN
+	uint64_t stagingOffset;
+	size_t stagingLength;
+};
+
+static int parseGeneratorOptions(int argc, char *argv[], struct GeneratorOptions *options);
+static void printGeneratorUsage(const char *programName);
+static uint64_t nextRandom(uint64_t *state);
+static int writeImageBytes(int fd, uint64_t offset, const void *data, size_t length);
+static int writeMasterBootRecord(int fd, const struct GeneratorOptions *options);
+static int generateFatVolume(int fd, const struct GeneratedPartition *partition, const struct GeneratorOptions *options, uint64_t *state);
+static unsigned int allocateFatChain(struct FatLayout *fat, unsigned int clusters);
+static void setFatEntry(struct FatLayout *fat, unsigned int cluster, unsigned int value);
+static uint64_t fetchFatClusterOffset(const struct FatLayout *fat, unsigned int cluster);
+static unsigned char *appendFatEntries(unsigned char *entry, const char *longName, const char *shortName, unsigned char attributes, unsigned int cluster, unsigned int size, int deleted, uint64_t *state);
+static int generateNtfsVolume(int fd, const struct GeneratedPartition *partition, const struct GeneratorOptions *options, uint64_t *state);
+static uint64_t allocateNtfsClusters(struct NtfsLayout *ntfs, uint64_t from, uint64_t count);
+static void setNtfsClusters(struct NtfsLayout *ntfs, uint64_t lcn, uint64_t count, int allocated);
+static size_t buildNtfsRecord(unsigned char *record, uint64_t number, unsigned short sequence, unsigned short flags);
+static size_t appendResidentAttribute(unsigned char *record, size_t offset, unsigned int type, const char *name, const void *content, size_t length, unsigned short id);
+static size_t appendNonResidentAttribute(unsigned char *record, size_t offset, unsigned int type, const uint64_t (*runs)[2], unsigned int runCount, uint64_t size, unsigned short id);
+static size_t buildFileName(unsigned char *content, uint64_t parent, unsigned short parentSequence, const char *name, uint64_t time, uint64_t size, unsigned int flags);
+static size_t buildStandardInfo(unsigned char *content, uint64_t time, unsigned int flags);
+static void finishNtfsRecord(unsigned char *record, size_t used);
+static int stageNtfsRecord(int fd, struct NtfsLayout *ntfs, uint64_t number, const unsigned char *record);
+static int flushNtfsRecords(int fd, struct NtfsLayout *ntfs);
+static int writeFileContent(int fd, uint64_t offset, uint64_t allocated, uint64_t size, unsigned int number);
+
+
+/*
+ * Main: 
+ * --------------------
+ * Parses the options, sizes the image, then writes the MBR and each file system
+ * 
+ * Parameters: argc, char *argv[] The output file name followed by the options
+ * int: 0 on success, 1 on failure, 2 on a usage error
+ */
+int main(int argc, char *argv[]){
+	//DATA DECLARATION
+	struct GeneratorOptions options;
+	uint64_t state, imageSectors;
+	int fd, i, status = 0;
+	//DATA MANIPULATION
+	if(parseGeneratorOptions(argc, argv, &options) != 0){
+		printGeneratorUsage(argv[0]);
+		return 2;
+	}
+	state = options.seed*0x9E3779B97F4A7C15ULL + 1; //A ZERO STATE WOULD STICK AT ZERO
+	imageSectors = options.partitions[options.partitionCount-1].sectorStart + options.partitions[options.partitionCount-1].sectorCount;
+	fd = open(options.output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0){
+		perror(options.output);
+		return 1;
+	}
+	if(ftruncate(fd, (off_t)(imageSectors*GENERATE_SECTOR)) != 0 || writeMasterBootRecord(fd, &options) != 0){ //SPARSE FILE, UNWRITTEN SECTORS READ AS ZEROS
+		status = -1;
+	}
+	for(i=0;i<options.partitionCount && status == 0;i++){
+		if(options.partitions[i].fileSystem == GENERATE_NTFS){
+			status = generateNtfsVolume(fd, &options.partitions[i], &options, &state);
+		}else{
+			status = generateFatVolume(fd, &options.partitions[i], &options, &state);
+		}
+	}
+	if(close(fd) != 0){
+		status = -1;
+	}
+	if(status != 0){
+		fprintf(stderr, "%s: could not generate %s: %s\n", argv[0], options.output, errno ? strerror(errno) : "volume too small");
+		return 1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  parseGeneratorOptions 
+ * --------------------
+ * Reads the output file name and the options, laying the partitions out one after another
+ * 
+ * argc: Number of arguments
+ * argv: The arguments
+ * options: Set to the parsed options
+ * int: 0 on success, -1 on a usage error
+ */
+static int parseGeneratorOptions(int argc, char *argv[], struct GeneratorOptions *options){
+	//DATA DECLARATION
+	struct GeneratedPartition *partition;
+	uint64_t nextSector = GENERATE_ALIGN, sizeMiB;
+	char *type, *end;
+	int i;
+	//DATA MANIPULATION
+	memset(options, 0, sizeof(*options));
+	options->files = 1000;
+	options->records = 1000;
+	options->fragments = 1;
+	if(argc < 2 || argv[1][0] == '-'){
+		return -1;
+	}
+	options->output = argv[1];
+	for(i=2;i<argc;i++){
+		if(i + 1 >= argc){ //EVERY OPTION TAKES A VALUE
+			return -1;
+		}
+		if(strcmp(argv[i], "-p") == 0){ //-p <fat16|fat32|ntfs>:<sizeMiB>
+			if(options->partitionCount == 4){
+				return -1;
+			}
+			type = argv[++i];
+			end = strchr(type, ':');
+			if(end == NULL){
+				return -1;
+			}
+			sizeMiB = strtoull(end + 1, NULL, 10);
+			partition = &options->partitions[options->partitionCount++];
+			if(strncmp(type, "fat16:", 6) == 0){
+				partition->fileSystem = GENERATE_FAT16;
+			}else if(strncmp(type, "fat32:", 6) == 0){
+				partition->fileSystem = GENERATE_FAT32;
+			}else if(strncmp(type, "ntfs:", 5) == 0){
+				partition->fileSystem = GENERATE_NTFS;
+			}else{
+				return -1;
+			}
+			if(sizeMiB == 0 || sizeMiB > 1024*1024){ //UP TO 1 TiB PER PARTITION
+				return -1;
+			}
+			partition->sectorStart = nextSector;
+			partition->sectorCount = sizeMiB*2048;
+			nextSector += partition->sectorCount;
+		}else if(strcmp(argv[i], "--seed") == 0){
+			options->seed = strtoull(argv[++i], NULL, 10);
+		}else if(strcmp(argv[i], "--files") == 0){
+			options->files = (unsigned int)strtoul(argv[++i], NULL, 10);
+		}else if(strcmp(argv[i], "--records") == 0){
+			options->records = (unsigned int)strtoul(argv[++i], NULL, 10);
+		}else if(strcmp(argv[i], "--fragments") == 0){
+			options->fragments = (unsigned int)strtoul(argv[++i], NULL, 10);
+			if(options->fragments == 0 || options->fragments > 64){
+				return -1;
+			}
+		}else if(strcmp(argv[i], "--deleted") == 0){
+			options->deleted = strtod(argv[++i], NULL);
+			if(options->deleted < 0 || options->deleted > 1){
+				return -1;
+			}
+		}else{
+			return -1;
+		}
+	}
+	return (options->partitionCount > 0) ? 0 : -1;
+}
+
+
+/*
+ * Function:  printGeneratorUsage 
+ * --------------------
+ * Prints the options of the generator
+ * 
+ * programName: argv[0]
+ */
+static void printGeneratorUsage(const char *programName){
+	fprintf(stderr, "Usage: %s <output> -p <fat16|fat32|ntfs>:<sizeMiB> [-p ...] [options]\n", programName);
+	fprintf(stderr, "  %-20s%s\n", "-p type:sizeMiB", "add a primary partition (up to four, in disk order)");
+	fprintf(stderr, "  %-20s%s\n", "--seed N", "seed of the content generator (default 0)");
+	fprintf(stderr, "  %-20s%s\n", "--files N", "files written to each FAT volume (default 1000)");
+	fprintf(stderr, "  %-20s%s\n", "--records N", "MFT records in each NTFS volume (default 1000)");
+	fprintf(stderr, "  %-20s%s\n", "--fragments N", "runs the $MFT is split into, 1 to 64 (default 1)");
+	fprintf(stderr, "  %-20s%s\n", "--deleted F", "fraction of files and records deleted, 0 to 1 (default 0)");
+}
+
+
+/*
+ * Function:  nextRandom 
+ * --------------------
+ * xorshift64* generator, fast and identical on every platform
+ * 
+ * state: The generator state (never zero)
+ * uint64_t: The next pseudo random number
+ */
+static uint64_t nextRandom(uint64_t *state){
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state*0x2545F4914F6CDD1DULL;
+}
+
+
+/*
+ * Function:  writeImageBytes 
+ * --------------------
+ * Writes a buffer at an offset of the image, retrying short writes
+ * 
+ * fd: Descriptor of the image
+ * offset: Byte offset to write at
+ * data: The bytes to write
+ * length: Number of bytes
+ * int: 0 on success, -1 on failure (errno is set)
+ */
+static int writeImageBytes(int fd, uint64_t offset, const void *data, size_t length){
+	size_t done = 0;
+	ssize_t written;
+	while(done < length){
+		written = pwrite(fd, (const unsigned char*)data + done, length - done, (off_t)(offset + done));
+		if(written < 0 && errno == EINTR){
+			continue;
+		}
+		if(written <= 0){
+			return -1;
+		}
+		done += (size_t)written;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  writeMasterBootRecord 
+ * --------------------
+ * Writes the MBR partition table describing every requested partition
+ * 
+ * fd: Descriptor of the image
+ * options: The generator options
+ * int: 0 on success, -1 on a write error
+ */
+static int writeMasterBootRecord(int fd, const struct GeneratorOptions *options){
+	unsigned char mbr[GENERATE_SECTOR];
+	unsigned char *entry;
+	int i;
+	memset(mbr, 0, sizeof(mbr));
+	*(uint32_t*)(mbr+0x1B8) = (uint32_t)options->seed ^ 0x44534B31; //DISK SIGNATURE
+	for(i=0;i<options->partitionCount;i++){
+		entry = mbr + 0x1BE + 16*i;
+		entry[0] = (i == 0) ? 0x80 : 0x00; //FIRST PARTITION IS BOOTABLE
+		entry[1] = 0xFE; entry[2] = 0xFF; entry[3] = 0xFF; //CHS FIELDS MARKED AS UNUSABLE, LBA IS USED
+		entry[4] = (options->partitions[i].fileSystem == GENERATE_NTFS) ? 0x07 : (options->partitions[i].fileSystem == GENERATE_FAT32) ? 0x0C : 0x06;
+		entry[5] = 0xFE; entry[6] = 0xFF; entry[7] = 0xFF;
+		*(uint32_t*)(entry+8) = (uint32_t)options->partitions[i].sectorStart;
+		*(uint32_t*)(entry+12) = (uint32_t)options->partitions[i].sectorCount;
+	}
+	mbr[510] = 0x55;
+	mbr[511] = 0xAA;
+	return writeImageBytes(fd, 0, mbr, sizeof(mbr));
+}
+
+
+/*
+ * Function:  generateFatVolume 
+ * --------------------
+ * Formats a FAT16 or FAT32 volume and fills it with options->files files
+ * Files are spread over subdirectories of the root directory, each file has a
+ * long file name, and deleted files keep their data but lose their FAT chain
+ * 
+ * fd: Descriptor of the image
+ * partition: The partition to format
+ * options: The generator options
+ * state: The random generator state
+ * int: 0 on success, -1 on a write error or when the volume is too small
+ */
+static int generateFatVolume(int fd, const struct GeneratedPartition *partition, const struct GeneratorOptions *options, uint64_t *state){
+	//DATA DECLARATION
+	struct FatLayout fat;
+	unsigned char boot[GENERATE_SECTOR], *directory = NULL, *root = NULL, *entry, *rootEntry;
+	unsigned int filesPerDirectory, directoryCount, d, f, first, last, size, cluster, clusters, rootCluster = 0, directoryCluster, directoryClusters, copy;
+	char longName[32], shortName[16];
+	int deleted, status = 0;
+	size_t rootBytes;
+	//DATA MANIPULATION
+	memset(&fat, 0, sizeof(fat));
+	fat.bits = (partition->fileSystem == GENERATE_FAT32) ? 32 : 16;
+	fat.byteStart = partition->sectorStart*GENERATE_SECTOR;
+	fat.totalSectors = (unsigned int)partition->sectorCount;
+	fat.reserved = (fat.bits == 32) ? 32 : 4;
+	fat.rootSectors = (fat.bits == 32) ? 0 : FAT_ROOT_ENTRIES*32/GENERATE_SECTOR;
+	fat.sectorsPerCluster = 1;
+	while((fat.bits == 16 && fat.totalSectors/fat.sectorsPerCluster >= 65525) || (fat.bits == 32 && fat.totalSectors/fat.sectorsPerCluster >= 4*1024*1024)){ //KEEP FAT16 UNDER ITS LIMIT AND THE FAT32 TABLE SMALL
+		fat.sectorsPerCluster *= 2;
+	}
+	fat.clusterBytes = fat.sectorsPerCluster*GENERATE_SECTOR;
+	fat.fatSectors = (unsigned int)(((uint64_t)(fat.totalSectors/fat.sectorsPerCluster + 2)*(fat.bits/8) + GENERATE_SECTOR - 1)/GENERATE_SECTOR);
+	fat.clusterCount = (fat.totalSectors - fat.reserved - 2*fat.fatSectors - fat.rootSectors)/fat.sectorsPerCluster;
+	if((fat.bits == 16 && (fat.clusterCount < 4085 || fat.clusterCount >= 65525)) || (fat.bits == 32 && fat.clusterCount < 65525) || fat.sectorsPerCluster > 128){
+		errno = 0; //THE CLUSTER COUNT WOULD MAKE IT A DIFFERENT FAT TYPE
+		return -1;
+	}
+	fat.table = calloc(fat.fatSectors, GENERATE_SECTOR);
+	if(fat.table == NULL){
+		return -1;
+	}
+	fat.nextCluster = 2;
+	setFatEntry(&fat, 0, (fat.bits == 32) ? 0x0FFFFFF8 : 0xFFF8); //MEDIA DESCRIPTOR AND END OF CHAIN MARKERS
+	setFatEntry(&fat, 1, (fat.bits == 32) ? 0x0FFFFFFF : 0xFFFF);
+	//DIRECTORY TREE: THE ROOT HOLDS directoryCount SUBDIRECTORIES OF filesPerDirectory FILES
+	filesPerDirectory = (options->files + 250 - 1)/250;
+	filesPerDirectory = (filesPerDirectory < 128) ? 128 : filesPerDirectory;
+	directoryCount = (options->files + filesPerDirectory - 1)/filesPerDirectory;
+	rootBytes = (fat.bits == 32) ? (size_t)((directoryCount*2*32 + fat.clusterBytes - 1)/fat.clusterBytes + (directoryCount == 0))*fat.clusterBytes : (size_t)fat.rootSectors*GENERATE_SECTOR;
+	root = calloc(1, rootBytes);
+	if(root == NULL){
+		free(fat.table);
+		return -1;
+	}
+	if(fat.bits == 32){
+		rootCluster = allocateFatChain(&fat, (unsigned int)(rootBytes/fat.clusterBytes));
+		status = (rootCluster == 0) ? -1 : 0;
+	}
+	rootEntry = root;
+	for(d=0;d<directoryCount && status == 0;d++){
+		first = d*filesPerDirectory;
+		last = (first + filesPerDirectory < options->files) ? first + filesPerDirectory : options->files;
+		directoryClusters = ((2 + 3*(last - first))*32 + fat.clusterBytes - 1)/fat.clusterBytes; //DOT ENTRIES, THEN TWO LFN ENTRIES AND A SHORT ENTRY PER FILE
+		directoryCluster = allocateFatChain(&fat, directoryClusters);
+		directory = calloc(directoryClusters, fat.clusterBytes);
+		if(directoryCluster == 0 || directory == NULL){
+			status = -1;
+			break;
+		}
+		snprintf(longName, sizeof(longName), "dir-%05u", d);
+		snprintf(shortName, sizeof(shortName), "D%07u   ", d);
+		rootEntry = appendFatEntries(rootEntry, longName, shortName, 0x10, directoryCluster, 0, 0, state);
+		entry = appendFatEntries(directory, NULL, ".          ", 0x10, directoryCluster, 0, 0, state);
+		entry = appendFatEntries(entry, NULL, "..         ", 0x10, 0, 0, 0, state); //PARENT IS THE ROOT (CLUSTER 0 BY CONVENTION)
+		for(f=first;f<last && status == 0;f++){
+			size = (unsigned int)(nextRandom(state) % FAT_FILE_MAX) + 1;
+			clusters = (size + fat.clusterBytes - 1)/fat.clusterBytes;
+			deleted = ((double)(nextRandom(state) >> 11)/(double)(1ULL << 53) < options->deleted);
+			copy = allocateFatChain(&fat, clusters);
+			if(copy == 0){
+				status = -1;
+				break;
+			}
+			status = writeFileContent(fd, fetchFatClusterOffset(&fat, copy), (uint64_t)clusters*fat.clusterBytes, size, f);
+			if(deleted){ //A DELETED FILE'S CLUSTERS ARE FREE AGAIN BUT STILL HOLD ITS DATA
+				for(cluster=copy;cluster<copy+clusters;cluster++){
+					setFatEntry(&fat, cluster, 0);
+				}
+			}
+			snprintf(longName, sizeof(longName), "file-%07u.dat", f);
+			snprintf(shortName, sizeof(shortName), "F%07uDAT", f);
+			entry = appendFatEntries(entry, longName, shortName, 0x20, copy, size, deleted, state);
+		}
+		if(status == 0){
+			status = writeImageBytes(fd, fetchFatClusterOffset(&fat, directoryCluster), directory, (size_t)directoryClusters*fat.clusterBytes);
+		}
+		free(directory);
+		directory = NULL;
+	}
+	//BOOT SECTOR
+	memset(boot, 0, sizeof(boot));
+	boot[0] = 0xEB; boot[1] = (fat.bits == 32) ? 0x58 : 0x3C; boot[2] = 0x90;
+	memcpy(boot+0x03, "MSDOS5.0", 8);
+	*(uint16_t*)(boot+0x0B) = GENERATE_SECTOR; //BYTES PER SECTOR
+	boot[0x0D] = (unsigned char)fat.sectorsPerCluster;
+	*(uint16_t*)(boot+0x0E) = (uint16_t)fat.reserved;
+	boot[0x10] = 2; //NUMBER OF FATS
+	*(uint16_t*)(boot+0x11) = (fat.bits == 32) ? 0 : FAT_ROOT_ENTRIES;
+	if(fat.totalSectors < 65536 && fat.bits == 16){
+		*(uint16_t*)(boot+0x13) = (uint16_t)fat.totalSectors;
+	}else{
+		*(uint32_t*)(boot+0x20) = fat.totalSectors;
+	}
+	boot[0x15] = 0xF8; //FIXED DISK
+	*(uint16_t*)(boot+0x18) = 63; //SECTORS PER TRACK
+	*(uint16_t*)(boot+0x1A) = 255; //HEADS
+	*(uint32_t*)(boot+0x1C) = (uint32_t)partition->sectorStart; //HIDDEN SECTORS
+	if(fat.bits == 32){
+		*(uint32_t*)(boot+0x24) = fat.fatSectors;
+		*(uint32_t*)(boot+0x2C) = rootCluster;
+		*(uint16_t*)(boot+0x30) = 1; //FSINFO SECTOR
+		*(uint16_t*)(boot+0x32) = 6; //BACKUP BOOT SECTOR
+		boot[0x40] = 0x80;
+		boot[0x42] = 0x29;
+		*(uint32_t*)(boot+0x43) = (uint32_t)nextRandom(state); //VOLUME SERIAL NUMBER
+		memcpy(boot+0x47, "SYNTHETIC  FAT32   ", 19);
+	}else{
+		*(uint16_t*)(boot+0x16) = (uint16_t)fat.fatSectors;
+		boot[0x24] = 0x80;
+		boot[0x26] = 0x29;
+		*(uint32_t*)(boot+0x27) = (uint32_t)nextRandom(state);
+		memcpy(boot+0x2B, "SYNTHETIC  FAT16   ", 19);
+	}
+	boot[510] = 0x55;
+	boot[511] = 0xAA;
+	if(status == 0){
+		status = writeImageBytes(fd, fat.byteStart, boot, sizeof(boot));
+	}
+	if(status == 0 && fat.bits == 32){ //FSINFO AND BACKUP BOOT SECTOR
+		status = writeImageBytes(fd, fat.byteStart + 6*GENERATE_SECTOR, boot, sizeof(boot));
+		memset(boot, 0, sizeof(boot));
+		*(uint32_t*)(boot+0) = 0x41615252;
+		*(uint32_t*)(boot+484) = 0x61417272;
+		*(uint32_t*)(boot+488) = 0xFFFFFFFF; //FREE COUNT UNKNOWN
+		*(uint32_t*)(boot+492) = fat.nextCluster;
+		*(uint32_t*)(boot+508) = 0xAA550000;
+		status |= writeImageBytes(fd, fat.byteStart + GENERATE_SECTOR, boot, sizeof(boot));
+	}
+	for(copy=0;copy<2 && status == 0;copy++){
+		status = writeImageBytes(fd, fat.byteStart + (uint64_t)(fat.reserved + copy*fat.fatSectors)*GENERATE_SECTOR, fat.table, (size_t)fat.fatSectors*GENERATE_SECTOR);
+	}
+	if(status == 0){
+		status = writeImageBytes(fd, (fat.bits == 32) ? fetchFatClusterOffset(&fat, rootCluster) : fat.byteStart + (uint64_t)(fat.reserved + 2*fat.fatSectors)*GENERATE_SECTOR, root, rootBytes);
+	}
+	free(root);
+	free(fat.table);
+	return status;
+}
+
+
+/*
+ * Function:  allocateFatChain 
+ * --------------------
+ * Hands out the next clusters of the volume and links them into a chain
+ * 
+ * fat: The volume being generated
+ * clusters: Number of clusters (at least one)
+ * unsigned int: First cluster of the chain, 0 if the volume is full
+ */
+static unsigned int allocateFatChain(struct FatLayout *fat, unsigned int clusters){
+	unsigned int first = fat->nextCluster, i;
+	if(clusters == 0){
+		clusters = 1;
+	}
+	if(first + clusters > fat->clusterCount + 2){
+		errno = 0;
+		return 0;
+	}
+	for(i=0;i<clusters;i++){
+		setFatEntry(fat, first + i, (i + 1 < clusters) ? first + i + 1 : ((fat->bits == 32) ? 0x0FFFFFFF : 0xFFFF));
+	}
+	fat->nextCluster += clusters;
+	return first;
+}
+
+
+/*
+ * Function:  setFatEntry 
+ * --------------------
+ * Sets one entry of the in-memory FAT
+ * 
+ * fat: The volume being generated
+ * cluster: The cluster number
+ * value: Next cluster, end of chain marker or 0 for free
+ */
+static void setFatEntry(struct FatLayout *fat, unsigned int cluster, unsigned int value){
+	if(fat->bits == 32){
+		((uint32_t*)fat->table)[cluster] = value;
+	}else{
+		((uint16_t*)fat->table)[cluster] = (uint16_t)value;
+	}
+}
+
+
+/*
+ * Function:  fetchFatClusterOffset 
+ * --------------------
+ * Byte offset in the image of a data cluster
+ * 
+ * fat: The volume being generated
+ * cluster: The cluster number (2 or higher)
+ * uint64_t: Byte offset of the cluster
+ */
+static uint64_t fetchFatClusterOffset(const struct FatLayout *fat, unsigned int cluster){
+	return fat->byteStart + (uint64_t)(fat->reserved + 2*fat->fatSectors + fat->rootSectors)*GENERATE_SECTOR + (uint64_t)(cluster - 2)*fat->clusterBytes;
+}
+
+
+/*
+ * Function:  appendFatEntries 
+ * --------------------
+ * Writes the long file name entries (if any) and the short entry of a file
+ * 
+ * entry: Where the first 32 byte entry goes
+ * longName: ASCII long file name, NULL for none
+ * shortName: 11 character 8.3 name without the dot
+ * attributes: Attribute byte (0x10 directory, 0x20 archive)
+ * cluster: First cluster
+ * size: File size in bytes
+ * deleted: 1 to mark every entry of the file with 0xE5
+ * state: The random generator state (for the timestamps)
+ * unsigned char*: The entry after the ones written
+ */
+static unsigned char *appendFatEntries(unsigned char *entry, const char *longName, const char *shortName, unsigned char attributes, unsigned int cluster, unsigned int size, int deleted, uint64_t *state){
+	static const int lfnOffsets[13] = {1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30}; //UTF-16 CHARACTER POSITIONS IN AN LFN ENTRY
+	unsigned char checksum = 0;
+	size_t nameLength, parts, part, c, position;
+	uint64_t random = nextRandom(state);
+	unsigned short date, time;
+	int i;
+	for(i=0;i<11;i++){
+		checksum = (unsigned char)(((checksum & 1) << 7) + (checksum >> 1) + (unsigned char)shortName[i]);
+	}
+	if(longName != NULL){
+		nameLength = strlen(longName);
+		parts = (nameLength + 12)/13;
+		for(part=parts;part>0;part--){ //LFN ENTRIES ARE STORED LAST PART FIRST
+			memset(entry, 0, 32);
+			entry[0] = deleted ? 0xE5 : (unsigned char)(part | ((part == parts) ? 0x40 : 0));
+			entry[11] = 0x0F;
+			entry[13] = checksum;
+			for(c=0;c<13;c++){
+				position = (part - 1)*13 + c;
+				*(uint16_t*)(entry + lfnOffsets[c]) = (position < nameLength) ? (uint16_t)longName[position] : (position == nameLength) ? 0x0000 : 0xFFFF;
+			}
+			entry += 32;
+		}
+	}
+	memset(entry, 0, 32);
+	memcpy(entry, shortName, 11);
+	if(deleted){
+		entry[0] = 0xE5;
+	}
+	entry[11] = attributes;
+	date = (unsigned short)(((2021 - 1980) << 9) | ((1 + random % 12) << 5) | (1 + (random >> 8) % 28));
+	time = (unsigned short)((((random >> 16) % 24) << 11) | (((random >> 24) % 60) << 5) | ((random >> 32) % 30));
+	*(uint16_t*)(entry+0x0E) = time; //CREATED
+	*(uint16_t*)(entry+0x10) = date;
+	*(uint16_t*)(entry+0x12) = date; //ACCESSED
+	*(uint16_t*)(entry+0x14) = (uint16_t)(cluster >> 16);
+	*(uint16_t*)(entry+0x16) = time; //MODIFIED
+	*(uint16_t*)(entry+0x18) = date;
+	*(uint16_t*)(entry+0x1A) = (uint16_t)cluster;
+	*(uint32_t*)(entry+0x1C) = size;
+	return entry + 32;
+}
+
+
+/*
+ * Function:  generateNtfsVolume 
+ * --------------------
+ * Formats an NTFS volume with options->records MFT records
+ * The $MFT is split into options->fragments runs spread over the volume,
+ * most files are resident and about one in ten has clusters of its own
+ * 
+ * fd: Descriptor of the image
+ * partition: The partition to format
+ * options: The generator options
+ * state: The random generator state
+ * int: 0 on success, -1 on a write error or when the volume is too small
+ */
+static int generateNtfsVolume(int fd, const struct GeneratedPartition *partition, const struct GeneratorOptions *options, uint64_t *state){
+	//DATA DECLARATION
+	static const char *systemNames[12] = {"$MFT", "$MFTMirr", "$LogFile", "$Volume", "$AttrDef", ".", "$Bitmap", "$Boot", "$BadClus", "$Secure", "$UpCase", "$Extend"};
+	struct NtfsLayout ntfs;
+	unsigned char record[NTFS_RECORD], content[NTFS_RECORD], boot[GENERATE_SECTOR], mirror[4*NTFS_RECORD], indexRoot[48];
+	uint64_t records = (options->records < NTFS_FIRST_USER_RECORD + 1) ? NTFS_FIRST_USER_RECORD + 1 : options->records;
+	uint64_t mftClusters = (records*NTFS_RECORD + NTFS_CLUSTER - 1)/NTFS_CLUSTER, bitmapBytes, bitmapClusters, bitmapLcn;
+	uint64_t number, runLength, size, clusters, time, dataRuns[2][2], *directories = NULL, directoryCount = 0, parent;
+	unsigned int r, dataRunCount;
+	unsigned short flags, sequence;
+	size_t used, length;
+	int status = 0, deleted, isDirectory;
+	char name[32];
+	//DATA MANIPULATION
+	memset(&ntfs, 0, sizeof(ntfs));
+	ntfs.byteStart = partition->sectorStart*GENERATE_SECTOR;
+	ntfs.totalClusters = (partition->sectorCount - 1)*GENERATE_SECTOR/NTFS_CLUSTER; //THE LAST SECTOR HOLDS THE BACKUP BOOT SECTOR
+	bitmapBytes = (ntfs.totalClusters + 7)/8;
+	bitmapClusters = (bitmapBytes + NTFS_CLUSTER - 1)/NTFS_CLUSTER;
+	if(ntfs.totalClusters < mftClusters + bitmapClusters + 64){
+		errno = 0;
+		return -1;
+	}
+	ntfs.bitmap = calloc(bitmapClusters, NTFS_CLUSTER);
+	ntfs.staging = malloc(MFT_STAGING_BYTES);
+	directories = malloc((size_t)records*sizeof(uint64_t));
+	if(ntfs.bitmap == NULL || ntfs.staging == NULL || directories == NULL){
+		free(ntfs.bitmap);
+		free(ntfs.staging);
+		free(directories);
+		return -1;
+	}
+	for(number=ntfs.totalClusters;number<bitmapClusters*NTFS_CLUSTER*8;number++){ //CLUSTERS PAST THE END ARE MARKED IN USE
+		ntfs.bitmap[number/8] |= (unsigned char)(1 << (number % 8));
+	}
+	setNtfsClusters(&ntfs, 0, 3, 1); //BOOT SECTORS AND THE $MFTMirr AT LCN 2
+	ntfs.mftRunCount = (options->fragments < mftClusters) ? options->fragments : (unsigned int)mftClusters;
+	for(r=0;r<ntfs.mftRunCount;r++){ //RUNS START AT EVENLY SPACED POINTS OF THE VOLUME
+		runLength = mftClusters/ntfs.mftRunCount + ((r < mftClusters % ntfs.mftRunCount) ? 1 : 0);
+		ntfs.mftRuns[r][0] = allocateNtfsClusters(&ntfs, (r == 0) ? 16 : r*(ntfs.totalClusters/ntfs.mftRunCount), runLength);
+		ntfs.mftRuns[r][1] = runLength;
+		if(ntfs.mftRuns[r][0] == UINT64_MAX){
+			status = -1;
+		}
+	}
+	bitmapLcn = allocateNtfsClusters(&ntfs, 16, bitmapClusters);
+	if(bitmapLcn == UINT64_MAX){
+		status = -1;
+	}
+	ntfs.cursor = 16;
+	memset(indexRoot, 0, sizeof(indexRoot)); //EMPTY $I30 INDEX ROOT: HEADER, NODE HEADER, END ENTRY
+	*(uint32_t*)(indexRoot+0) = 0x30; //INDEXES $FILE_NAME
+	*(uint32_t*)(indexRoot+4) = 1; //COLLATION BY FILE NAME
+	*(uint32_t*)(indexRoot+8) = NTFS_CLUSTER; //INDEX RECORD SIZE
+	indexRoot[12] = 1;
+	*(uint32_t*)(indexRoot+16) = 16; //FIRST ENTRY OFFSET
+	*(uint32_t*)(indexRoot+20) = 32; //SIZE OF THE ENTRIES
+	*(uint32_t*)(indexRoot+24) = 32;
+	*(uint16_t*)(indexRoot+40) = 16; //END ENTRY LENGTH
+	*(uint16_t*)(indexRoot+44) = 2; //LAST ENTRY FLAG
+	for(number=0;number<records && status == 0;number++){
+		time = NTFS_TIME_BASE + (nextRandom(state) % (365ULL*86400))*10000000ULL; //SOMETIME IN THE YEAR AFTER THE BASE
+		if(number < 12){ //SYSTEM FILES
+			used = buildNtfsRecord(record, number, (number == 5) ? 5 : 1, (number == 5) ? 3 : 1);
+			length = buildStandardInfo(content, NTFS_TIME_BASE, 0x06);
+			used = appendResidentAttribute(record, used, 0x10, NULL, content, length, 0);
+			size = (number == 0) ? records*NTFS_RECORD : (number == 1) ? 4*NTFS_RECORD : (number == 6) ? bitmapBytes : (number == 7) ? NTFS_CLUSTER : 0;
+			length = buildFileName(content, 5, 5, systemNames[number], NTFS_TIME_BASE, size, (number == 5) ? 0x10000006 : 0x06);
+			used = appendResidentAttribute(record, used, 0x30, NULL, content, length, 1);
+			if(number == 0){
+				used = appendNonResidentAttribute(record, used, 0x80, (const uint64_t (*)[2])ntfs.mftRuns, ntfs.mftRunCount, size, 2);
+			}else if(number == 1 || number == 6 || number == 7){
+				dataRuns[0][0] = (number == 1) ? 2 : (number == 6) ? bitmapLcn : 0;
+				dataRuns[0][1] = (number == 6) ? bitmapClusters : 1;
+				used = appendNonResidentAttribute(record, used, 0x80, (const uint64_t (*)[2])dataRuns, 1, size, 2);
+			}else if(number == 5){
+				used = appendResidentAttribute(record, used, 0x90, "$I30", indexRoot, sizeof(indexRoot), 2);
+			}else{
+				used = appendResidentAttribute(record, used, 0x80, NULL, NULL, 0, 2);
+			}
+		}else if(number < NTFS_FIRST_USER_RECORD){ //RESERVED, FORMATTED BUT NOT IN USE
+			used = buildNtfsRecord(record, number, 1, 0);
+		}else{ //USER FILES AND DIRECTORIES
+			deleted = ((double)(nextRandom(state) >> 11)/(double)(1ULL << 53) < options->deleted);
+			isDirectory = (number == NTFS_FIRST_USER_RECORD || nextRandom(state) % 50 == 0);
+			parent = (directoryCount == 0 || nextRandom(state) % 8 == 0) ? 5 : directories[nextRandom(state) % directoryCount];
+			flags = (unsigned short)((deleted ? 0 : 1) | (isDirectory ? 2 : 0));
+			sequence = deleted ? 2 : 1;
+			used = buildNtfsRecord(record, number, sequence, flags);
+			length = buildStandardInfo(content, time, isDirectory ? 0x10 : 0x20);
+			used = appendResidentAttribute(record, used, 0x10, NULL, content, length, 0);
+			size = isDirectory ? 0 : (nextRandom(state) % 10 == 0) ? NTFS_RESIDENT_MAX + nextRandom(state) % (16*NTFS_CLUSTER) : nextRandom(state) % NTFS_RESIDENT_MAX;
+			if(isDirectory){
+				snprintf(name, sizeof(name), "dir-%07llu", (unsigned long long)number);
+			}else{
+				snprintf(name, sizeof(name), "file-%07llu.dat", (unsigned long long)number);
+			}
+			length = buildFileName(content, parent, (parent == 5) ? 5 : 1, name, time, size, isDirectory ? 0x10000000 : 0x20);
+			used = appendResidentAttribute(record, used, 0x30, NULL, content, length, 1);
+			if(isDirectory){
+				used = appendResidentAttribute(record, used, 0x90, "$I30", indexRoot, sizeof(indexRoot), 2);
+				if(!deleted){
+					directories[directoryCount++] = number;
+				}
+			}else if(size <= NTFS_RESIDENT_MAX){
+				memset(content, 0, (size_t)size);
+				snprintf((char*)content, (size_t)size + 1, "record %llu", (unsigned long long)number); //size IS BELOW NTFS_RESIDENT_MAX SO THIS FITS
+				used = appendResidentAttribute(record, used, 0x80, NULL, content, (size_t)size, 2);
+			}else{
+				clusters = (size + NTFS_CLUSTER - 1)/NTFS_CLUSTER;
+				dataRunCount = (options->fragments > 1 && clusters > 1) ? 2 : 1; //FRAGMENTED VOLUMES ALSO GET FRAGMENTED FILES
+				dataRuns[0][1] = (dataRunCount == 2) ? clusters/2 : clusters;
+				dataRuns[0][0] = allocateNtfsClusters(&ntfs, ntfs.cursor, dataRuns[0][1]);
+				if(dataRunCount == 2){
+					dataRuns[1][1] = clusters - dataRuns[0][1];
+					dataRuns[1][0] = allocateNtfsClusters(&ntfs, 16 + nextRandom(state) % (ntfs.totalClusters - 16), dataRuns[1][1]);
+				}
+				if(dataRuns[0][0] == UINT64_MAX || (dataRunCount == 2 && dataRuns[1][0] == UINT64_MAX)){
+					errno = 0; //VOLUME FULL
+					status = -1;
+					break;
+				}
+				ntfs.cursor = dataRuns[0][0] + dataRuns[0][1];
+				status = writeFileContent(fd, ntfs.byteStart + dataRuns[0][0]*NTFS_CLUSTER, dataRuns[0][1]*NTFS_CLUSTER, (size < dataRuns[0][1]*NTFS_CLUSTER) ? size : dataRuns[0][1]*NTFS_CLUSTER, (unsigned int)number);
+				if(dataRunCount == 2 && status == 0){
+					status = writeFileContent(fd, ntfs.byteStart + dataRuns[1][0]*NTFS_CLUSTER, dataRuns[1][1]*NTFS_CLUSTER, size - dataRuns[0][1]*NTFS_CLUSTER, (unsigned int)number);
+				}
+				if(deleted){ //A DELETED FILE'S CLUSTERS ARE FREE AGAIN BUT STILL HOLD ITS DATA
+					for(r=0;r<dataRunCount;r++){
+						setNtfsClusters(&ntfs, dataRuns[r][0], dataRuns[r][1], 0);
+					}
+				}
+				used = appendNonResidentAttribute(record, used, 0x80, (const uint64_t (*)[2])dataRuns, dataRunCount, size, 2);
+			}
+		}
+		finishNtfsRecord(record, used);
+		if(number < 4){
+			memcpy(mirror + number*NTFS_RECORD, record, NTFS_RECORD);
+		}
+		if(status == 0){
+			status = stageNtfsRecord(fd, &ntfs, number, record);
+		}
+	}
+	if(status == 0){
+		status = flushNtfsRecords(fd, &ntfs);
+	}
+	if(status == 0){
+		status = writeImageBytes(fd, ntfs.byteStart + 2*NTFS_CLUSTER, mirror, sizeof(mirror));
+	}
+	if(status == 0){
+		status = writeImageBytes(fd, ntfs.byteStart + bitmapLcn*NTFS_CLUSTER, ntfs.bitmap, (size_t)bitmapBytes);
+	}
+	//BOOT SECTOR, ALSO COPIED TO THE LAST SECTOR OF THE PARTITION
+	memset(boot, 0, sizeof(boot));
+	boot[0] = 0xEB; boot[1] = 0x52; boot[2] = 0x90;
+	memcpy(boot+0x03, "NTFS    ", 8);
+	*(uint16_t*)(boot+0x0B) = GENERATE_SECTOR;
+	boot[0x0D] = NTFS_CLUSTER/GENERATE_SECTOR;
+	boot[0x15] = 0xF8;
+	*(uint16_t*)(boot+0x18) = 63;
+	*(uint16_t*)(boot+0x1A) = 255;
+	*(uint32_t*)(boot+0x1C) = (uint32_t)partition->sectorStart;
+	boot[0x24] = 0x80;
+	*(uint64_t*)(boot+0x28) = partition->sectorCount - 1; //TOTAL SECTORS (EXCLUDING THE BACKUP BOOT SECTOR)
+	*(uint64_t*)(boot+0x30) = ntfs.mftRuns[0][0]; //LCN OF THE $MFT
+	*(uint64_t*)(boot+0x38) = 2; //LCN OF THE $MFTMirr
+	boot[0x40] = 0xF6; //2^10 = 1024 BYTE FILE RECORDS
+	boot[0x44] = 1; //ONE CLUSTER PER INDEX RECORD
+	*(uint64_t*)(boot+0x48) = nextRandom(state); //VOLUME SERIAL NUMBER
+	boot[510] = 0x55;
+	boot[511] = 0xAA;
+	if(status == 0){
+		status = writeImageBytes(fd, ntfs.byteStart, boot, sizeof(boot));
+	}
+	if(status == 0){
+		status = writeImageBytes(fd, ntfs.byteStart + (partition->sectorCount - 1)*GENERATE_SECTOR, boot, sizeof(boot));
+	}
+	free(ntfs.bitmap);
+	free(ntfs.staging);
+	free(directories);
+	return status;
+}
+
+
+/*
+ * Function:  allocateNtfsClusters 
+ * --------------------
+ * Finds and marks the first free run of count clusters at or after from
+ * wrapping round to the start of the volume when nothing fits after it
+ * 
+ * ntfs: The volume being generated
+ * from: Cluster to start searching at
+ * count: Number of contiguous clusters wanted
+ * uint64_t: LCN of the run, UINT64_MAX if no free run is long enough
+ */
+static uint64_t allocateNtfsClusters(struct NtfsLayout *ntfs, uint64_t from, uint64_t count){
+	uint64_t start, lcn, found = 0, pass;
+	for(pass=0;pass<2;pass++){
+		start = (pass == 0) ? from : 16;
+		found = 0;
+		for(lcn=start;lcn<ntfs->totalClusters;lcn++){
+			if(ntfs->bitmap[lcn/8] & (1 << (lcn % 8))){
+				found = 0;
+				continue;
+			}
+			if(++found == count){
+				setNtfsClusters(ntfs, lcn + 1 - count, count, 1);
+				return lcn + 1 - count;
+			}
+		}
+	}
+	return UINT64_MAX;
+}
+
+
+/*
+ * Function:  setNtfsClusters 
+ * --------------------
+ * Marks a run of clusters allocated or free in the volume bitmap
+ * 
+ * ntfs: The volume being generated
+ * lcn: First cluster
+ * count: Number of clusters
+ * allocated: 1 to allocate, 0 to free
+ */
+static void setNtfsClusters(struct NtfsLayout *ntfs, uint64_t lcn, uint64_t count, int allocated){
+	uint64_t i;
+	for(i=lcn;i<lcn+count;i++){
+		if(allocated){
+			ntfs->bitmap[i/8] |= (unsigned char)(1 << (i % 8));
+		}else{
+			ntfs->bitmap[i/8] &= (unsigned char)~(1 << (i % 8));
+		}
+	}
+}
+
+
+/*
+ * Function:  buildNtfsRecord 
+ * --------------------
+ * Writes the header of an empty file record
+ * 
+ * record: Buffer of NTFS_RECORD bytes
+ * number: MFT record number
+ * sequence: Sequence number
+ * flags: In use 0x01, directory 0x02
+ * size_t: Offset of the first attribute
+ */
+static size_t buildNtfsRecord(unsigned char *record, uint64_t number, unsigned short sequence, unsigned short flags){
+	memset(record, 0, NTFS_RECORD);
+	memcpy(record, "FILE", 4);
+	*(uint16_t*)(record+0x04) = 0x30; //UPDATE SEQUENCE ARRAY OFFSET
+	*(uint16_t*)(record+0x06) = NTFS_RECORD/GENERATE_SECTOR + 1; //UPDATE SEQUENCE NUMBER PLUS ONE ENTRY PER SECTOR
+	*(uint16_t*)(record+0x10) = sequence;
+	*(uint16_t*)(record+0x12) = (flags & 1) ? 1 : 0; //HARD LINKS
+	*(uint16_t*)(record+0x14) = 0x38; //FIRST ATTRIBUTE
+	*(uint16_t*)(record+0x16) = flags;
+	*(uint32_t*)(record+0x1C) = NTFS_RECORD; //ALLOCATED SIZE
+	*(uint16_t*)(record+0x28) = 3; //NEXT ATTRIBUTE ID
+	*(uint32_t*)(record+0x2C) = (uint32_t)number;
+	return 0x38;
+}
+
+
+/*
+ * Function:  appendResidentAttribute 
+ * --------------------
+ * Appends an attribute whose content is stored in the record
+ * 
+ * record: The file record
+ * offset: Where the attribute goes
+ * type: Attribute type code
+ * name: ASCII attribute name, NULL for none
+ * content: The content (may be NULL when length is 0)
+ * length: Content length in bytes
+ * id: Attribute id
+ * size_t: Offset after the attribute
+ */
+static size_t appendResidentAttribute(unsigned char *record, size_t offset, unsigned int type, const char *name, const void *content, size_t length, unsigned short id){
+	unsigned char *attribute = record + offset;
+	size_t nameLength = (name == NULL) ? 0 : strlen(name), contentOffset = (0x18 + 2*nameLength + 7) & ~(size_t)7, i;
+	size_t total = (contentOffset + length + 7) & ~(size_t)7;
+	*(uint32_t*)(attribute+0x00) = type;
+	*(uint32_t*)(attribute+0x04) = (uint32_t)total;
+	attribute[0x08] = 0; //RESIDENT
+	attribute[0x09] = (unsigned char)nameLength;
+	*(uint16_t*)(attribute+0x0A) = 0x18; //NAME OFFSET
+	*(uint16_t*)(attribute+0x0E) = id;
+	*(uint32_t*)(attribute+0x10) = (uint32_t)length;
+	*(uint16_t*)(attribute+0x14) = (uint16_t)contentOffset;
+	for(i=0;i<nameLength;i++){
+		*(uint16_t*)(attribute + 0x18 + 2*i) = (uint16_t)name[i];
+	}
+	if(length > 0){
+		memcpy(attribute + contentOffset, content, length);
+	}
+	return offset + total;
+}
+
+
+/*
+ * Function:  appendNonResidentAttribute 
+ * --------------------
+ * Appends an attribute stored in clusters, encoding its runlist
+ * 
+ * record: The file record
+ * offset: Where the attribute goes
+ * type: Attribute type code
+ * runs: LCN and length of each run in stream order
+ * runCount: Number of runs
+ * size: Real size of the stream in bytes
+ * id: Attribute id
+ * size_t: Offset after the attribute
+ */
+static size_t appendNonResidentAttribute(unsigned char *record, size_t offset, unsigned int type, const uint64_t (*runs)[2], unsigned int runCount, uint64_t size, unsigned short id){
+	unsigned char *attribute = record + offset, *run = attribute + 0x40;
+	uint64_t clusters = 0, previous = 0, value;
+	int64_t delta;
+	unsigned int r, lengthBytes, offsetBytes, b;
+	for(r=0;r<runCount;r++){
+		lengthBytes = 1;
+		for(value=runs[r][1] >> 8;value != 0;value >>= 8){
+			lengthBytes++;
+		}
+		delta = (int64_t)(runs[r][0] - previous); //RUN OFFSETS ARE SIGNED DELTAS FROM THE PREVIOUS RUN
+		offsetBytes = 1;
+		while(offsetBytes < 8 && (delta < -(1LL << (8*offsetBytes - 1)) || delta >= (1LL << (8*offsetBytes - 1)))){
+			offsetBytes++;
+		}
+		*run++ = (unsigned char)((offsetBytes << 4) | lengthBytes);
+		for(b=0;b<lengthBytes;b++){
+			*run++ = (unsigned char)(runs[r][1] >> (8*b));
+		}
+		for(b=0;b<offsetBytes;b++){
+			*run++ = (unsigned char)((uint64_t)delta >> (8*b));
+		}
+		previous = runs[r][0];
+		clusters += runs[r][1];
+	}
+	*run++ = 0; //END OF THE RUNLIST
+	*(uint32_t*)(attribute+0x00) = type;
+	*(uint32_t*)(attribute+0x04) = (uint32_t)(((size_t)(run - attribute) + 7) & ~(size_t)7);
+	attribute[0x08] = 1; //NON-RESIDENT
+	*(uint16_t*)(attribute+0x0A) = 0x40;
+	*(uint16_t*)(attribute+0x0E) = id;
+	*(uint64_t*)(attribute+0x10) = 0; //FIRST VCN
+	*(uint64_t*)(attribute+0x18) = clusters - 1; //LAST VCN
+	*(uint16_t*)(attribute+0x20) = 0x40; //RUNLIST OFFSET
+	*(uint64_t*)(attribute+0x28) = clusters*NTFS_CLUSTER; //ALLOCATED SIZE
+	*(uint64_t*)(attribute+0x30) = size; //REAL SIZE
+	*(uint64_t*)(attribute+0x38) = size; //INITIALISED SIZE
+	return offset + *(uint32_t*)(attribute+0x04);
+}
+
+
+/*
+ * Function:  buildFileName 
+ * --------------------
+ * Builds the content of a $FILE_NAME attribute with a Win32 name
+ * 
+ * content: Output buffer
+ * parent: MFT record number of the parent directory
+ * parentSequence: Sequence number of the parent
+ * name: ASCII file name
+ * time: Windows FILETIME used for all four timestamps
+ * size: Real size of the file
+ * flags: File attribute flags
+ * size_t: Length of the content
+ */
+static size_t buildFileName(unsigned char *content, uint64_t parent, unsigned short parentSequence, const char *name, uint64_t time, uint64_t size, unsigned int flags){
+	size_t nameLength = strlen(name), i;
+	memset(content, 0, 0x42);
+	*(uint64_t*)(content+0x00) = parent | ((uint64_t)parentSequence << 48);
+	*(uint64_t*)(content+0x08) = time;
+	*(uint64_t*)(content+0x10) = time;
+	*(uint64_t*)(content+0x18) = time;
+	*(uint64_t*)(content+0x20) = time;
+	*(uint64_t*)(content+0x28) = (size + NTFS_CLUSTER - 1)/NTFS_CLUSTER*NTFS_CLUSTER;
+	*(uint64_t*)(content+0x30) = size;
+	*(uint32_t*)(content+0x38) = flags;
+	content[0x40] = (unsigned char)nameLength;
+	content[0x41] = 1; //WIN32 NAMESPACE
+	for(i=0;i<nameLength;i++){
+		*(uint16_t*)(content + 0x42 + 2*i) = (uint16_t)name[i];
+	}
+	return 0x42 + 2*nameLength;
+}
+
+
+/*
+ * Function:  buildStandardInfo 
+ * --------------------
+ * Builds the content of a $STANDARD_INFORMATION attribute
+ * The timestamps are one second apart so each can be told apart
+ * 
+ * content: Output buffer
+ * time: Windows FILETIME of creation
+ * flags: File attribute flags
+ * size_t: Length of the content
+ */
+static size_t buildStandardInfo(unsigned char *content, uint64_t time, unsigned int flags){
+	memset(content, 0, 0x48);
+	*(uint64_t*)(content+0x00) = time; //CREATED
+	*(uint64_t*)(content+0x08) = time + 10000000; //MODIFIED
+	*(uint64_t*)(content+0x10) = time + 20000000; //MFT MODIFIED
+	*(uint64_t*)(content+0x18) = time + 30000000; //ACCESSED
+	*(uint32_t*)(content+0x20) = flags;
+	return 0x48;
+}
+
+
+/*
+ * Function:  finishNtfsRecord 
+ * --------------------
+ * Ends the attribute list and applies the update sequence (fixups)
+ * 
+ * record: The file record
+ * used: Offset after the last attribute
+ */
+static void finishNtfsRecord(unsigned char *record, size_t used){
+	unsigned short usn = 1;
+	int sector;
+	*(uint32_t*)(record + used) = 0xFFFFFFFF; //END OF ATTRIBUTES MARKER
+	*(uint32_t*)(record+0x18) = (uint32_t)(used + 8); //USED SIZE
+	*(uint16_t*)(record+0x30) = usn;
+	for(sector=0;sector<NTFS_RECORD/GENERATE_SECTOR;sector++){ //THE LAST TWO BYTES OF EACH SECTOR MOVE INTO THE ARRAY
+		memcpy(record + 0x32 + 2*sector, record + (sector + 1)*GENERATE_SECTOR - 2, 2);
+		*(uint16_t*)(record + (sector + 1)*GENERATE_SECTOR - 2) = usn;
+	}
+}
+
+
+/*
+ * Function:  stageNtfsRecord 
+ * --------------------
+ * Queues a record for writing at its place in the $MFT runs
+ * Consecutive records are written together in one large write
+ * 
+ * fd: Descriptor of the image
+ * ntfs: The volume being generated
+ * number: MFT record number
+ * record: The finished record
+ * int: 0 on success, -1 on a write error
+ */
+static int stageNtfsRecord(int fd, struct NtfsLayout *ntfs, uint64_t number, const unsigned char *record){
+	uint64_t vcnByte = number*NTFS_RECORD, runStart = 0, offset = 0;
+	unsigned int r;
+	for(r=0;r<ntfs->mftRunCount;r++){ //FIND THE RUN HOLDING THE RECORD
+		if(vcnByte < runStart + ntfs->mftRuns[r][1]*NTFS_CLUSTER){
+			offset = ntfs->byteStart + ntfs->mftRuns[r][0]*NTFS_CLUSTER + (vcnByte - runStart);
+			break;
+		}
+		runStart += ntfs->mftRuns[r][1]*NTFS_CLUSTER;
+	}
+	if(ntfs->stagingLength > 0 && (offset != ntfs->stagingOffset + ntfs->stagingLength || ntfs->stagingLength == MFT_STAGING_BYTES)){
+		if(flushNtfsRecords(fd, ntfs) != 0){
+			return -1;
+		}
+	}
+	if(ntfs->stagingLength == 0){
+		ntfs->stagingOffset = offset;
+	}
+	memcpy(ntfs->staging + ntfs->stagingLength, record, NTFS_RECORD);
+	ntfs->stagingLength += NTFS_RECORD;
+	return 0;
+}
+
+
+/*
+ * Function:  flushNtfsRecords 
+ * --------------------
+ * Writes the staged records
+ * 
+ * fd: Descriptor of the image
+ * ntfs: The volume being generated
+ * int: 0 on success, -1 on a write error
+ */
+static int flushNtfsRecords(int fd, struct NtfsLayout *ntfs){
+	int status = writeImageBytes(fd, ntfs->stagingOffset, ntfs->staging, ntfs->stagingLength);
+	ntfs->stagingLength = 0;
+	return status;
+}
+
+
+/*
+ * Function:  writeFileContent 
+ * --------------------
+ * Writes recognisable content for a file: its number and offset every 64 bytes
+ * followed by zeros to the end of its last cluster
+ * 
+ * fd: Descriptor of the image
+ * offset: Byte offset of the file's first cluster
+ * allocated: Bytes of clusters allocated to the file
+ * size: Size of the file content
+ * number: File number written into the content
+ * int: 0 on success, -1 on a write error
+ */
+static int writeFileContent(int fd, uint64_t offset, uint64_t allocated, uint64_t size, unsigned int number){
+	unsigned char *content = calloc(1, (size_t)allocated);
+	char line[80];
+	uint64_t i;
+	int status;
+	if(content == NULL){
+		return -1;
+	}
+	for(i=0;i+64<=size;i+=64){
+		snprintf(line, sizeof(line), "file %010u offset %010llu ......................................", number, (unsigned long long)i);
+		memcpy(content + i, line, 63);
+		content[i+63] = '\n';
+	}
+	status = writeImageBytes(fd, offset, content, (size_t)allocated);
+	free(content);
+	return status;
+}
@@ -0,0 +1,265 @@
+/*
+ * imageHash.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Chain of custody hashing
+ * The image is read once in HASH_READ_BYTES aligned blocks
+ * into two buffers. While the work pool hashes one buffer the next one
+ * is read. Every digest (whole image and per partition, for each of
+ * MD5, SHA-1 and SHA-256) is its own pool task, as is every per-block
+ * hash, so all of them run at the same time on one read.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <openssl/evp.h>
+#include "imageHash.h"
+#include "workPool.h"
+
+#define HASH_ALGORITHMS 3 //MD5, SHA-1 AND SHA-256
+
+struct DigestTask{
+	EVP_MD_CTX *context; //RUNNING DIGEST OF THE IMAGE OR OF ONE PARTITION
+	uint64_t start, end; //BYTE RANGE OF THE IMAGE THE DIGEST COVERS
+	const unsigned char *data; //CURRENT BUFFER
+	uint64_t dataOffset; //IMAGE OFFSET OF THE CURRENT BUFFER
+	size_t dataLength;
+	int failed;
+};
+
+struct BlockTask{
+	struct HashBlock block;
+	const unsigned char *data;
+	int failed;
+};
+
+static void updateDigestTask(void *arg);
+static void hashBlockTask(void *arg);
+static long long int readImageBlock(struct DiskImage *image, uint64_t offset, unsigned char *buffer, size_t length);
+static void finishDigests(struct DigestTask *tasks, struct ImageDigest *digest);
+
+
+/*
+ * Function:  hashImage 
+ * --------------------
+ * Hashes the whole image, each partition and optionally each block in one read
+ * Per-block hashes are handed to visitBlock in block order as each read completes
+ * 
+ * image: The open disk image
+ * partitions: Byte ranges of the partitions to hash (may be NULL when partitionCount is 0)
+ * partitionCount: Number of partitions
+ * blockSize: Size of the per-block SHA-256 hashes (a multiple of HASH_ALIGN), 0 for none
+ * threadCount: Number of hashing threads, 0 for one per processor
+ * visitBlock: Called with each block hash (may be NULL when blockSize is 0)
+ * context: Passed through to visitBlock
+ * imageDigest: Set to the digests of the whole image
+ * partitionDigests: Array of partitionCount entries set to the digests of each partition
+ * int: 0 on success, -1 on a read or hashing failure (errno is set for read errors)
+ */
+int hashImage(struct DiskImage *image, const struct ImageExtent *partitions, size_t partitionCount, uint64_t blockSize, int threadCount, int (*visitBlock)(const struct HashBlock *block, void *context), void *context, struct ImageDigest *imageDigest, struct ImageDigest *partitionDigests){
+	//DATA DECLARATION
+	const EVP_MD *algorithms[HASH_ALGORITHMS];
+	struct WorkPool *pool;
+	struct DigestTask *digests;
+	struct BlockTask *blocks = NULL;
+	unsigned char *buffers[2] = {NULL, NULL};
+	size_t readBytes = HASH_READ_BYTES, digestCount, blocksPerRead = 0, d, b;
+	uint64_t offset = 0, nextOffset, blockIndex = 0;
+	long long int lengths[2] = {0, 0};
+	int current = 0, status = 0, a;
+	//DATA MANIPULATION
+	if(blockSize % HASH_ALIGN != 0){
+		errno = EINVAL;
+		return -1;
+	}
+	if(blockSize > 0){ //A READ HOLDS A WHOLE NUMBER OF BLOCKS
+		readBytes = (size_t)(blockSize*((HASH_READ_BYTES + blockSize - 1)/blockSize));
+		blocksPerRead = (size_t)(readBytes/blockSize);
+	}
+	algorithms[0] = EVP_md5();
+	algorithms[1] = EVP_sha1();
+	algorithms[2] = EVP_sha256();
+	digestCount = (1 + partitionCount)*HASH_ALGORITHMS; //WHOLE IMAGE FIRST, THEN EACH PARTITION
+	digests = calloc(digestCount, sizeof(struct DigestTask));
+	pool = createWorkPool(threadCount);
+	if(blocksPerRead > 0){
+		blocks = calloc(blocksPerRead, sizeof(struct BlockTask));
+	}
+	if(posix_memalign((void**)&buffers[0], HASH_ALIGN, readBytes) != 0 || posix_memalign((void**)&buffers[1], HASH_ALIGN, readBytes) != 0){ //ALIGNED FOR LARGE, PAGE SIZED READS
+		status = -1;
+	}
+	if(digests == NULL || pool == NULL || (blocksPerRead > 0 && blocks == NULL)){
+		status = -1;
+	}
+	for(d=0;d<digestCount && status == 0;d++){
+		a = (int)(d % HASH_ALGORITHMS);
+		digests[d].context = EVP_MD_CTX_new();
+		if(d < HASH_ALGORITHMS){
+			digests[d].start = 0;
+			digests[d].end = image->size;
+		}else{
+			digests[d].start = partitions[d/HASH_ALGORITHMS - 1].offset;
+			digests[d].end = digests[d].start + partitions[d/HASH_ALGORITHMS - 1].length;
+		}
+		if(digests[d].context == NULL || EVP_DigestInit_ex(digests[d].context, algorithms[a], NULL) != 1){
+			status = -1;
+		}
+	}
+	if(status == 0){
+		lengths[current] = readImageBlock(image, offset, buffers[current], readBytes); //FIRST READ FILLS THE PIPELINE
+		status = (lengths[current] < 0) ? -1 : 0;
+	}
+	while(status == 0 && lengths[current] > 0){
+		for(d=0;d<digestCount;d++){ //EVERY RUNNING DIGEST HASHES THIS BUFFER IN PARALLEL
+			digests[d].data = buffers[current];
+			digests[d].dataOffset = offset;
+			digests[d].dataLength = (size_t)lengths[current];
+			if(digests[d].end > offset && digests[d].start < offset + (uint64_t)lengths[current] && submitWork(pool, updateDigestTask, &digests[d]) != 0){
+				digests[d].failed = 1;
+			}
+		}
+		for(b=0;b<blocksPerRead && (uint64_t)b*blockSize < (uint64_t)lengths[current];b++){ //INDEPENDENT PER-BLOCK HASHES
+			blocks[b].block.index = blockIndex + b;
+			blocks[b].block.offset = offset + b*blockSize;
+			blocks[b].block.length = ((uint64_t)lengths[current] - b*blockSize < blockSize) ? (uint64_t)lengths[current] - b*blockSize : blockSize;
+			blocks[b].data = buffers[current] + b*blockSize;
+			blocks[b].failed = (submitWork(pool, hashBlockTask, &blocks[b]) != 0);
+		}
+		nextOffset = offset + (uint64_t)lengths[current];
+		lengths[!current] = readImageBlock(image, nextOffset, buffers[!current], readBytes); //READ THE NEXT BUFFER WHILE THIS ONE IS HASHED
+		waitWorkPool(pool);
+		if(lengths[!current] < 0){
+			status = -1;
+		}
+		for(d=0;d<digestCount;d++){
+			status |= digests[d].failed ? -1 : 0;
+		}
+		for(b=0;b<blocksPerRead && (uint64_t)b*blockSize < (uint64_t)lengths[current] && status == 0;b++){
+			status = blocks[b].failed ? -1 : visitBlock(&blocks[b].block, context);
+			blockIndex++;
+		}
+		offset = nextOffset;
+		current = !current;
+	}
+	if(status == 0 && offset != image->size){ //IMAGE SHRANK WHILE IT WAS READ
+		errno = EIO;
+		status = -1;
+	}
+	for(d=0;d<digestCount && digests != NULL;d+=HASH_ALGORITHMS){ //THREE CONTEXTS PER RANGE: MD5, SHA-1, SHA-256
+		if(status == 0){
+			finishDigests(&digests[d], (d == 0) ? imageDigest : &partitionDigests[d/HASH_ALGORITHMS - 1]);
+		}
+		for(a=0;a<HASH_ALGORITHMS;a++){
+			EVP_MD_CTX_free(digests[d + a].context);
+		}
+	}
+	if(pool != NULL){
+		destroyWorkPool(pool);
+	}
+	free(digests);
+	free(blocks);
+	free(buffers[0]);
+	free(buffers[1]);
+	return status;
+}
+
+
+/*
+ * Function:  formatDigest 
+ * --------------------
+ * Formats a digest as lower case hexadecimal
+ * 
+ * digest: The digest bytes
+ * length: Number of digest bytes
+ * hex: Output buffer of at least 2*length+1 bytes
+ */
+void formatDigest(const unsigned char *digest, size_t length, char *hex){
+	static const char digits[] = "0123456789abcdef";
+	size_t i;
+	for(i=0;i<length;i++){
+		hex[2*i] = digits[digest[i] >> 4];
+		hex[2*i+1] = digits[digest[i] & 0x0F];
+	}
+	hex[2*length] = '\0';
+}
+
+
+/*
+ * Function:  updateDigestTask 
+ * --------------------
+ * Pool task adding the part of the current buffer that lies in
+ * the digest's byte range to a running digest
+ * 
+ * arg: The DigestTask
+ */
+static void updateDigestTask(void *arg){
+	struct DigestTask *task = arg;
+	uint64_t start = (task->start > task->dataOffset) ? task->start : task->dataOffset;
+	uint64_t end = (task->end < task->dataOffset + task->dataLength) ? task->end : task->dataOffset + task->dataLength;
+	if(EVP_DigestUpdate(task->context, task->data + (start - task->dataOffset), (size_t)(end - start)) != 1){
+		task->failed = 1;
+	}
+}
+
+
+/*
+ * Function:  hashBlockTask 
+ * --------------------
+ * Pool task computing the SHA-256 of one block
+ * 
+ * arg: The BlockTask
+ */
+static void hashBlockTask(void *arg){
+	struct BlockTask *task = arg;
+	task->failed = (EVP_Digest(task->data, (size_t)task->block.length, task->block.sha256, NULL, EVP_sha256(), NULL) != 1);
+}
+
+
+/*
+ * Function:  readImageBlock 
+ * --------------------
+ * Fills a buffer from the image, clamping the read to the end of the image
+ * The range is advised as sequential first so the mapping, which is opened
+ * for random metadata access, reads ahead across the hashed range
+ * 
+ * image: The open disk image
+ * offset: Byte offset to read from
+ * buffer: Buffer to read into
+ * length: Number of bytes wanted
+ * long long int: Bytes read (less than length only at the end of the image), -1 on error
+ */
+static long long int readImageBlock(struct DiskImage *image, uint64_t offset, unsigned char *buffer, size_t length){
+	if(offset >= image->size){
+		return 0;
+	}
+	if(length > image->size - offset){
+		length = (size_t)(image->size - offset);
+	}
+	adviseImageRange(image, offset, length);
+	if(readImage(image, offset, buffer, length) != 0){
+		return -1;
+	}
+	return (long long int)length;
+}
+
+
+/*
+ * Function:  finishDigests 
+ * --------------------
+ * Finalises the MD5, SHA-1 and SHA-256 contexts of one byte range
+ * 
+ * tasks: The three DigestTasks of the range (MD5, SHA-1, SHA-256 in that order)
+ * digest: Set to the final digests
+ */
+static void finishDigests(struct DigestTask *tasks, struct ImageDigest *digest){
+	EVP_DigestFinal_ex(tasks[0].context, digest->md5, NULL);
+	EVP_DigestFinal_ex(tasks[1].context, digest->sha1, NULL);
+	EVP_DigestFinal_ex(tasks[2].context, digest->sha256, NULL);
+}
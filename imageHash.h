@@ -0,0 +1,42 @@
+/*
+ * imageHash.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Chain of custody hashing
+ * Hashes a disk image in one sequential pass: whole image MD5, SHA-1
+ * and SHA-256, the same digests for each partition, and optionally a
+ * SHA-256 per fixed size block for later partial re-verification.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef IMAGEHASH_H
+#define IMAGEHASH_H
+
+//IMPORTED LIBRARIES
+#include <stddef.h>
+#include <stdint.h>
+#include "diskImage.h"
+
+#define HASH_READ_BYTES (4*1024*1024) //SIZE OF EACH ALIGNED READ OF THE PIPELINE
+#define HASH_ALIGN 4096 //ALIGNMENT OF THE READ BUFFERS AND OF THE BLOCK SIZE
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct ImageDigest{
+	unsigned char md5[16];
+	unsigned char sha1[20];
+	unsigned char sha256[32];
+};
+
+struct HashBlock{
+	uint64_t index; //BLOCK NUMBER FROM THE START OF THE IMAGE
+	uint64_t offset; //BYTE OFFSET OF THE BLOCK
+	uint64_t length; //LENGTH OF THE BLOCK (THE LAST ONE MAY BE SHORT)
+	unsigned char sha256[32];
+};
+
+int hashImage(struct DiskImage *image, const struct ImageExtent *partitions, size_t partitionCount, uint64_t blockSize, int threadCount, int (*visitBlock)(const struct HashBlock *block, void *context), void *context, struct ImageDigest *imageDigest, struct ImageDigest *partitionDigests);
+void formatDigest(const unsigned char *digest, size_t length, char *hex);
+
+#endif
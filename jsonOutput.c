@@ -0,0 +1,250 @@
+/*
+ * jsonOutput.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Streaming newline-delimited JSON (NDJSON) writer
+ * Records are written field by field to the stream,
+ * one record per line, with strings escaped as they are written.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <string.h>
+#include "jsonOutput.h"
+#include "scanStats.h"
+
+static void writeJsonKey(struct JsonRecord *record, const char *key);
+static void writeJsonEscaped(FILE *out, const char *value, size_t length, int rawBytes);
+
+
+/*
+ * Function:  beginJsonRecord 
+ * --------------------
+ * Starts a new record and writes its "record" type field
+ * 
+ * record: The record being written
+ * out: Stream the record is written to
+ * recordType: Value of the "record" field naming the kind of record
+ */
+void beginJsonRecord(struct JsonRecord *record, FILE *out, const char *recordType){
+	record->out = out;
+	record->depth = 0;
+	record->fields[0] = 0;
+	record->started = (statsMode != STATS_OFF) ? fetchStatsClock() : 0;
+	fputc('{', out);
+	addJsonString(record, "record", recordType);
+}
+
+
+/*
+ * Function:  addJsonString 
+ * --------------------
+ * Adds a NUL terminated UTF-8 string field to the record
+ * 
+ * record: The record being written
+ * key: Field name
+ * value: Field value
+ */
+void addJsonString(struct JsonRecord *record, const char *key, const char *value){
+	writeJsonKey(record, key);
+	fputc('"', record->out);
+	writeJsonEscaped(record->out, value, strlen(value), 0);
+	fputc('"', record->out);
+}
+
+
+/*
+ * Function:  addJsonBytes 
+ * --------------------
+ * Adds a string field of exactly length bytes to the record
+ * Used for raw on-disk names and file content which may hold
+ * NUL or non-printable bytes
+ * 
+ * record: The record being written
+ * key: Field name
+ * value: Bytes of the field value
+ * length: Number of bytes in value
+ */
+void addJsonBytes(struct JsonRecord *record, const char *key, const char *value, size_t length){
+	writeJsonKey(record, key);
+	fputc('"', record->out);
+	writeJsonEscaped(record->out, value, length, 1);
+	fputc('"', record->out);
+}
+
+
+/*
+ * Function:  addJsonInt 
+ * --------------------
+ * Adds an integer field to the record
+ * 
+ * record: The record being written
+ * key: Field name
+ * value: Field value
+ */
+void addJsonInt(struct JsonRecord *record, const char *key, long long int value){
+	writeJsonKey(record, key);
+	fprintf(record->out, "%lld", value);
+}
+
+
+/*
+ * Function:  addJsonDouble 
+ * --------------------
+ * Adds a decimal number field to the record, rounded to three decimal places
+ * 
+ * record: The record being written
+ * key: Field name
+ * value: Field value (must be finite, JSON has no NaN or infinity)
+ */
+void addJsonDouble(struct JsonRecord *record, const char *key, double value){
+	writeJsonKey(record, key);
+	fprintf(record->out, "%.3f", value);
+}
+
+
+/*
+ * Function:  addJsonBool 
+ * --------------------
+ * Adds a true/false field to the record
+ * 
+ * record: The record being written
+ * key: Field name
+ * value: Non zero for true
+ */
+void addJsonBool(struct JsonRecord *record, const char *key, int value){
+	writeJsonKey(record, key);
+	fputs(value ? "true" : "false", record->out);
+}
+
+
+/*
+ * Function:  openJsonObject 
+ * --------------------
+ * Starts a nested object field
+ * 
+ * record: The record being written
+ * key: Field name, NULL when the object is an element of an array
+ */
+void openJsonObject(struct JsonRecord *record, const char *key){
+	writeJsonKey(record, key);
+	fputc('{', record->out);
+	if(record->depth < JSON_MAX_DEPTH - 1){
+		record->fields[++record->depth] = 0;
+	}
+}
+
+
+/*
+ * Function:  closeJsonObject 
+ * --------------------
+ * Ends the nested object started by openJsonObject
+ * 
+ * record: The record being written
+ */
+void closeJsonObject(struct JsonRecord *record){
+	fputc('}', record->out);
+	if(record->depth > 0){
+		record->depth--;
+	}
+}
+
+
+/*
+ * Function:  openJsonArray 
+ * --------------------
+ * Starts an array field, elements are added with a NULL key
+ * 
+ * record: The record being written
+ * key: Field name, NULL when the array is an element of another array
+ */
+void openJsonArray(struct JsonRecord *record, const char *key){
+	writeJsonKey(record, key);
+	fputc('[', record->out);
+	if(record->depth < JSON_MAX_DEPTH - 1){
+		record->fields[++record->depth] = 0;
+	}
+}
+
+
+/*
+ * Function:  closeJsonArray 
+ * --------------------
+ * Ends the array started by openJsonArray
+ * 
+ * record: The record being written
+ */
+void closeJsonArray(struct JsonRecord *record){
+	fputc(']', record->out);
+	if(record->depth > 0){
+		record->depth--;
+	}
+}
+
+
+/*
+ * Function:  endJsonRecord 
+ * --------------------
+ * Closes the record and terminates its line
+ * With --stats the time since beginJsonRecord is counted as output time
+ * 
+ * record: The record being written
+ */
+void endJsonRecord(struct JsonRecord *record){
+	fputs("}\n", record->out);
+	if(statsMode != STATS_OFF){
+		countStat(&statsCounters.outputRecords, 1);
+		countStat(&statsCounters.outputNanoseconds, fetchStatsClock() - record->started);
+	}
+}
+
+
+/*
+ * Function:  writeJsonKey 
+ * --------------------
+ * Writes the separating comma (if needed) and the quoted field name
+ * 
+ * record: The record being written
+ * key: Field name, NULL for an array element (no name is written)
+ */
+static void writeJsonKey(struct JsonRecord *record, const char *key){
+	if(record->fields[record->depth]++ > 0){
+		fputc(',', record->out);
+	}
+	if(key != NULL){
+		fputc('"', record->out);
+		fputs(key, record->out);
+		fputs("\":", record->out);
+	}
+}
+
+
+/*
+ * Function:  writeJsonEscaped 
+ * --------------------
+ * Writes string bytes with JSON escaping
+ * Control characters are always written as \u00XX
+ * Raw on-disk bytes above 0x7E are escaped too so they always produce valid JSON
+ * 
+ * out: Stream to write to
+ * value: Bytes to write
+ * length: Number of bytes in value
+ * rawBytes: 1 if value is raw on-disk bytes, 0 if it is UTF-8 text
+ */
+static void writeJsonEscaped(FILE *out, const char *value, size_t length, int rawBytes){
+	size_t i;
+	unsigned char byte;
+	for(i=0;i<length;i++){
+		byte = (unsigned char)value[i];
+		if(byte == '"' || byte == '\\'){
+			fputc('\\', out);
+			fputc(byte, out);
+		}else if(byte < 0x20 || byte == 0x7F || (rawBytes && byte > 0x7E)){
+			fprintf(out, "\\u%04x", byte);
+		}else{
+			fputc(byte, out);
+		}
+	}
+}
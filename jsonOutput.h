@@ -0,0 +1,43 @@
+/*
+ * jsonOutput.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Streaming newline-delimited JSON (NDJSON) writer
+ * Each record is written straight to the output stream as one line
+ * so nothing is buffered beyond the record being written.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef JSONOUTPUT_H
+#define JSONOUTPUT_H
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//FUNCTION & STRUCT DECLARATIONS:
+#define JSON_MAX_DEPTH 8 //DEEPEST NESTING OF OBJECTS AND ARRAYS IN A RECORD
+
+struct JsonRecord{
+	FILE *out; //STREAM THE RECORD IS WRITTEN TO
+	int depth; //CURRENT NESTING LEVEL (0 IS THE RECORD ITSELF)
+	int fields[JSON_MAX_DEPTH]; //NUMBER OF FIELDS WRITTEN AT EACH LEVEL (CONTROLS COMMA PLACEMENT)
+	uint64_t started; //CLOCK WHEN THE RECORD WAS BEGUN (ONLY READ WITH --stats)
+};
+
+void beginJsonRecord(struct JsonRecord *record, FILE *out, const char *recordType);
+void addJsonString(struct JsonRecord *record, const char *key, const char *value);
+void addJsonBytes(struct JsonRecord *record, const char *key, const char *value, size_t length);
+void addJsonInt(struct JsonRecord *record, const char *key, long long int value);
+void addJsonDouble(struct JsonRecord *record, const char *key, double value);
+void addJsonBool(struct JsonRecord *record, const char *key, int value);
+void openJsonObject(struct JsonRecord *record, const char *key);
+void closeJsonObject(struct JsonRecord *record);
+void openJsonArray(struct JsonRecord *record, const char *key);
+void closeJsonArray(struct JsonRecord *record);
+void endJsonRecord(struct JsonRecord *record);
+
+#endif
@@ -0,0 +1,363 @@
+/*
+ * keywordSearch.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Keyword and regular expression search
+ * Regions of the image are split into SEARCH_CHUNK_BYTES chunks that are
+ * scanned in parallel on the work pool, each read with an overlap so a
+ * match crossing a chunk boundary is still found (by the chunk it starts
+ * in). Keywords are found with memmem, once as given and once widened
+ * to UTF-16LE. Regular expressions run over the raw bytes with
+ * REG_STARTEND, each slot holding its own compiled copy because regexec
+ * serialises callers sharing one. Hits are handed to the visitor as each
+ * chunk finishes, in offset order within the chunk.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#define _GNU_SOURCE //memmem, REG_STARTEND
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <regex.h>
+#include "keywordSearch.h"
+#include "workPool.h"
+
+struct SearchJob{
+	struct DiskImage *image;
+	int mode; //SEARCH_KEYWORD OR SEARCH_REGEX
+	const unsigned char *needles[2]; //KEYWORD AS GIVEN AND WIDENED TO UTF-16LE (NULL IF IT IS NOT ASCII)
+	size_t needleLengths[2];
+	size_t overlap; //BYTES READ PAST THE END OF A CHUNK
+	int (*visit)(const struct SearchHit *hit, void *context);
+	void *context;
+	int status; //NON ZERO ONCE THE VISITOR STOPPED THE SEARCH OR A CHUNK RAN OUT OF MEMORY
+	pthread_mutex_t lock; //SERIALISES THE VISITOR AND GUARDS THE FREE SLOTS
+	pthread_cond_t slotFree;
+	int freeSlots;
+};
+
+struct SearchSlot{
+	struct SearchJob *job;
+	int busy;
+	uint64_t base; //IMAGE OFFSET OF THE CHUNK
+	size_t length; //BYTES OF THE CHUNK WHERE A MATCH MAY START
+	size_t available; //BYTES READABLE FROM base (length PLUS THE OVERLAP)
+	unsigned char *chunkBuffer; //PREAD FALLBACK BUFFER FOR THE CHUNK (NULL WHEN THE IMAGE IS MAPPED)
+	regex_t regex; //THIS SLOT'S COPY OF THE COMPILED EXPRESSION
+	int regexReady;
+	struct SearchHit *hits; //HITS OF THE CHUNK, IN OFFSET ORDER ONCE SORTED
+	size_t hitCount, hitCapacity;
+};
+
+static void searchChunkTask(void *arg);
+static int findKeywords(struct SearchSlot *slot, const unsigned char *data);
+static int findExpressions(struct SearchSlot *slot, const unsigned char *data);
+static int addSearchHit(struct SearchSlot *slot, const unsigned char *data, size_t position, size_t length, int encoding);
+static int compareSearchHits(const void *a, const void *b);
+
+
+/*
+ * Function:  searchImage 
+ * --------------------
+ * Searches a set of image regions for a keyword or a regular expression
+ * on a work pool
+ * A hit starts inside a region but may run past its end
+ * 
+ * image: The open disk image
+ * regions: Byte ranges of the image to search
+ * regionCount: Number of regions
+ * mode: SEARCH_KEYWORD or SEARCH_REGEX
+ * pattern: The keyword, or a POSIX extended regular expression
+ * threadCount: Number of scanning threads, 0 for one per processor
+ * visit: Called for each hit (one call at a time), a non zero return stops the search
+ * context: Passed through to visit
+ * int: 0 when the search finished, the non zero value returned by visit, -1 on failure, -2 if the pattern is invalid
+ */
+int searchImage(struct DiskImage *image, const struct ImageExtent *regions, size_t regionCount, int mode, const char *pattern, int threadCount, int (*visit)(const struct SearchHit *hit, void *context), void *context){
+	//DATA DECLARATION
+	struct SearchJob job;
+	struct SearchSlot *slots;
+	struct WorkPool *pool;
+	unsigned char *wide = NULL;
+	uint64_t offset, end;
+	size_t r, s, i, length = strlen(pattern), slotCount;
+	int status = 0;
+	//DATA MANIPULATION
+	memset(&job, 0, sizeof(job));
+	job.image = image;
+	job.mode = mode;
+	job.visit = visit;
+	job.context = context;
+	if(length == 0){
+		return -2;
+	}
+	if(mode == SEARCH_KEYWORD){
+		job.needles[SEARCH_ASCII] = (const unsigned char*)pattern;
+		job.needleLengths[SEARCH_ASCII] = length;
+		for(i=0;i<length && (unsigned char)pattern[i] < 0x80;i++);
+		if(i == length){ //ONLY ASCII WIDENS TO UTF-16LE BYTE FOR BYTE
+			wide = calloc(length, 2);
+			if(wide == NULL){
+				return -1;
+			}
+			for(i=0;i<length;i++){
+				wide[i*2] = (unsigned char)pattern[i];
+			}
+			job.needles[SEARCH_UTF16LE] = wide;
+			job.needleLengths[SEARCH_UTF16LE] = length*2;
+		}
+		job.overlap = (wide != NULL) ? length*2 - 1 : length - 1;
+	}else{
+		job.overlap = SEARCH_MATCH_MAX;
+	}
+	pool = createWorkPool(threadCount);
+	if(pool == NULL){
+		free(wide);
+		return -1;
+	}
+	slotCount = (size_t)fetchWorkPoolSize(pool)*2; //ENOUGH CHUNKS IN FLIGHT TO KEEP EVERY THREAD BUSY
+	slots = calloc(slotCount, sizeof(struct SearchSlot));
+	if(slots == NULL){
+		destroyWorkPool(pool);
+		free(wide);
+		return -1;
+	}
+	pthread_mutex_init(&job.lock, NULL);
+	pthread_cond_init(&job.slotFree, NULL);
+	job.freeSlots = (int)slotCount;
+	for(s=0;s<slotCount && status == 0;s++){
+		slots[s].job = &job;
+		if(mode == SEARCH_REGEX){
+			if(regcomp(&slots[s].regex, pattern, REG_EXTENDED) != 0){
+				status = -2;
+				break;
+			}
+			slots[s].regexReady = 1;
+		}
+		if(image->map == NULL){
+			slots[s].chunkBuffer = malloc(SEARCH_CHUNK_BYTES + job.overlap);
+			if(slots[s].chunkBuffer == NULL){
+				status = -1;
+			}
+		}
+	}
+	for(r=0;r<regionCount && status == 0;r++){
+		end = regions[r].offset + regions[r].length;
+		if(end > image->size){
+			end = image->size;
+		}
+		for(offset=regions[r].offset;offset < end;offset += SEARCH_CHUNK_BYTES){
+			pthread_mutex_lock(&job.lock);
+			while(job.freeSlots == 0){ //BOUNDS THE MEMORY USED ON A MULTI TERABYTE IMAGE
+				pthread_cond_wait(&job.slotFree, &job.lock);
+			}
+			status = job.status;
+			for(s=0;slots[s].busy;s++);
+			slots[s].busy = 1;
+			job.freeSlots--;
+			pthread_mutex_unlock(&job.lock);
+			if(status != 0){
+				pthread_mutex_lock(&job.lock);
+				slots[s].busy = 0;
+				job.freeSlots++;
+				pthread_mutex_unlock(&job.lock);
+				break;
+			}
+			slots[s].base = offset;
+			slots[s].length = (end - offset < SEARCH_CHUNK_BYTES) ? (size_t)(end - offset) : SEARCH_CHUNK_BYTES;
+			slots[s].available = (image->size - offset < slots[s].length + job.overlap) ? (size_t)(image->size - offset) : slots[s].length + job.overlap;
+			adviseImageRange(image, offset, slots[s].available);
+			if(submitWork(pool, searchChunkTask, &slots[s]) != 0){
+				status = -1;
+				break;
+			}
+		}
+	}
+	waitWorkPool(pool);
+	destroyWorkPool(pool);
+	if(status == 0){
+		status = job.status;
+	}
+	for(s=0;s<slotCount;s++){
+		if(slots[s].regexReady){
+			regfree(&slots[s].regex);
+		}
+		free(slots[s].chunkBuffer);
+		free(slots[s].hits);
+	}
+	free(slots);
+	free(wide);
+	pthread_mutex_destroy(&job.lock);
+	pthread_cond_destroy(&job.slotFree);
+	return status;
+}
+
+
+/*
+ * Function:  searchChunkTask 
+ * --------------------
+ * Pool task searching one chunk and reporting its hits
+ * Running out of memory for the hits fails the whole search (status -1)
+ * rather than reporting the chunk with hits missing
+ * 
+ * arg: The SearchSlot describing the chunk
+ */
+static void searchChunkTask(void *arg){
+	//DATA DECLARATION
+	struct SearchSlot *slot = arg;
+	struct SearchJob *job = slot->job;
+	const unsigned char *data;
+	size_t h;
+	int status = 0;
+	//DATA MANIPULATION
+	slot->hitCount = 0;
+	data = (__atomic_load_n(&job->status, __ATOMIC_RELAXED) != 0) ? NULL : fetchImageView(job->image, slot->base, slot->available, slot->chunkBuffer);
+	if(data != NULL){
+		if(job->mode == SEARCH_KEYWORD){
+			status = findKeywords(slot, data);
+		}else{
+			status = findExpressions(slot, data);
+		}
+		if(slot->hitCount > 1){
+			qsort(slot->hits, slot->hitCount, sizeof(struct SearchHit), compareSearchHits);
+		}
+	}
+	pthread_mutex_lock(&job->lock);
+	if(status != 0 && job->status == 0){ //THE CHUNK'S HITS ARE INCOMPLETE, NONE OF THEM ARE REPORTED
+		__atomic_store_n(&job->status, status, __ATOMIC_RELAXED);
+	}
+	for(h=0;h<slot->hitCount && job->status == 0;h++){ //STREAM THE HITS OF THIS CHUNK WHILE ITS BYTES ARE STILL HELD
+		__atomic_store_n(&job->status, job->visit(&slot->hits[h], job->context), __ATOMIC_RELAXED);
+	}
+	slot->busy = 0;
+	job->freeSlots++;
+	pthread_cond_signal(&job->slotFree);
+	pthread_mutex_unlock(&job->lock);
+}
+
+
+/*
+ * Function:  findKeywords 
+ * --------------------
+ * Finds every occurrence of the keyword, in each encoding, that starts
+ * inside the chunk
+ * 
+ * slot: The chunk being searched
+ * data: The bytes of the chunk
+ * int: 0 on success, -1 when out of memory
+ */
+static int findKeywords(struct SearchSlot *slot, const unsigned char *data){
+	//DATA DECLARATION
+	struct SearchJob *job = slot->job;
+	const unsigned char *found;
+	size_t position;
+	int encoding;
+	//DATA MANIPULATION
+	for(encoding=SEARCH_ASCII;encoding<=SEARCH_UTF16LE;encoding++){
+		if(job->needles[encoding] == NULL){
+			continue;
+		}
+		for(position=0;position < slot->length;position = (size_t)(found - data) + 1){
+			found = memmem(data + position, slot->available - position, job->needles[encoding], job->needleLengths[encoding]);
+			if(found == NULL || (size_t)(found - data) >= slot->length){
+				break; //MATCHES STARTING IN THE OVERLAP BELONG TO THE NEXT CHUNK
+			}
+			if(addSearchHit(slot, data, (size_t)(found - data), job->needleLengths[encoding], encoding) != 0){
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  findExpressions 
+ * --------------------
+ * Finds the leftmost longest matches of the regular expression that start
+ * inside the chunk, moving past each match before looking for the next
+ * Empty matches are skipped
+ * 
+ * slot: The chunk being searched
+ * data: The bytes of the chunk
+ * int: 0 on success, -1 when out of memory
+ */
+static int findExpressions(struct SearchSlot *slot, const unsigned char *data){
+	//DATA DECLARATION
+	regmatch_t match;
+	size_t position = 0;
+	//DATA MANIPULATION
+	while(position < slot->length){
+		match.rm_so = (regoff_t)position;
+		match.rm_eo = (regoff_t)slot->available;
+		if(regexec(&slot->regex, (const char*)data, 1, &match, REG_STARTEND) != 0 || (size_t)match.rm_so >= slot->length){
+			break;
+		}
+		if(match.rm_eo > match.rm_so){
+			if(addSearchHit(slot, data, (size_t)match.rm_so, (size_t)(match.rm_eo - match.rm_so), SEARCH_ASCII) != 0){
+				return -1;
+			}
+			position = (size_t)match.rm_eo;
+		}else{
+			position = (size_t)match.rm_so + 1;
+		}
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  addSearchHit 
+ * --------------------
+ * Appends a hit to the chunk's list
+ * 
+ * slot: The chunk being searched
+ * data: The bytes of the chunk
+ * position: Offset of the match within the chunk
+ * length: Length of the match in bytes
+ * encoding: SEARCH_ASCII or SEARCH_UTF16LE
+ * int: 0 on success, -1 when out of memory
+ */
+static int addSearchHit(struct SearchSlot *slot, const unsigned char *data, size_t position, size_t length, int encoding){
+	//DATA DECLARATION
+	struct SearchHit *grown;
+	//DATA MANIPULATION
+	if(slot->hitCount == slot->hitCapacity){
+		grown = realloc(slot->hits, (slot->hitCapacity ? slot->hitCapacity*2 : 16)*sizeof(struct SearchHit));
+		if(grown == NULL){
+			return -1;
+		}
+		slot->hits = grown;
+		slot->hitCapacity = slot->hitCapacity ? slot->hitCapacity*2 : 16;
+	}
+	slot->hits[slot->hitCount].offset = slot->base + position;
+	slot->hits[slot->hitCount].length = length;
+	slot->hits[slot->hitCount].encoding = encoding;
+	slot->hits[slot->hitCount].data = data + position;
+	slot->hitCount++;
+	return 0;
+}
+
+
+/*
+ * Function:  compareSearchHits 
+ * --------------------
+ * qsort comparator ordering hits by offset, ASCII before UTF-16LE
+ * 
+ * a: First hit
+ * b: Second hit
+ * int: Negative, zero or positive like strcmp
+ */
+static int compareSearchHits(const void *a, const void *b){
+	//DATA DECLARATION
+	const struct SearchHit *first = a, *second = b;
+	//DATA MANIPULATION
+	if(first->offset != second->offset){
+		return (first->offset < second->offset) ? -1 : 1;
+	}
+	return first->encoding - second->encoding;
+}
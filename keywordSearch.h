@@ -0,0 +1,38 @@
+/*
+ * keywordSearch.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Keyword and regular expression search
+ * Scans regions of the image for a keyword (as ASCII and UTF-16LE) or a
+ * POSIX extended regular expression, in parallel chunks on the work pool.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef KEYWORDSEARCH_H
+#define KEYWORDSEARCH_H
+
+//IMPORTED LIBRARIES
+#include <stddef.h>
+#include <stdint.h>
+#include "diskImage.h"
+
+#define SEARCH_CHUNK_BYTES (8*1024*1024) //BYTES OF A REGION SCANNED PER POOL TASK
+#define SEARCH_MATCH_MAX 4096 //LONGEST REGULAR EXPRESSION MATCH (ALSO THE CHUNK OVERLAP)
+#define SEARCH_KEYWORD 0 //SEARCH MODES
+#define SEARCH_REGEX 1
+#define SEARCH_ASCII 0 //SearchHit ENCODINGS: THE BYTES AS GIVEN
+#define SEARCH_UTF16LE 1 //THE KEYWORD WIDENED TO UTF-16LE
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct SearchHit{
+	uint64_t offset; //BYTE OFFSET OF THE MATCH IN THE IMAGE
+	size_t length; //LENGTH OF THE MATCH IN BYTES
+	int encoding; //SEARCH_ASCII OR SEARCH_UTF16LE
+	const unsigned char *data; //THE MATCHED BYTES (ONLY VALID DURING THE VISIT)
+};
+
+int searchImage(struct DiskImage *image, const struct ImageExtent *regions, size_t regionCount, int mode, const char *pattern, int threadCount, int (*visit)(const struct SearchHit *hit, void *context), void *context);
+
+#endif
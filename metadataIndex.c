@@ -0,0 +1,756 @@
+/*
+ * metadataIndex.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Persistent metadata index
+ * The index file is a header followed by sections of fixed size records
+ * (and a string section), each 8 byte aligned. The header and records are
+ * written in the layout of this build; INDEX_VERSION, the byte order mark
+ * and the record sizes in the section table reject an index written by a
+ * different build, which is then simply rebuilt.
+ * $MFT records are kept with their fixups applied, cut to their used size,
+ * and decoded again when visited, so every record based query gets the same
+ * records it would get from the image.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "metadataIndex.h"
+
+#define INDEX_MAGIC "DFINDEX" //FIRST 8 BYTES OF AN INDEX FILE (WITH THE NUL)
+#define INDEX_BYTE_ORDER 0x01020304u
+#define INDEX_MFT_MIN_BYTES 0x30 //RECORD HEADER KEPT EVEN IF THE USED SIZE IS SMALLER
+
+enum IndexSectionType{
+	INDEX_PARTITIONS,
+	INDEX_FAT_ENTRIES,
+	INDEX_FAT_EXTENTS,
+	INDEX_FAT_CHILDREN,
+	INDEX_MFT_RECORDS,
+	INDEX_MFT_DATA,
+	INDEX_MFT_RUNS,
+	INDEX_MFT_CHILDREN,
+	INDEX_STRINGS,
+	INDEX_SECTION_COUNT
+};
+
+struct IndexSection{
+	uint64_t offset; //BYTE OFFSET OF THE SECTION IN THE FILE
+	uint64_t count; //NUMBER OF RECORDS
+	uint64_t recordSize; //BYTES PER RECORD (1 FOR THE BYTE SECTIONS)
+};
+
+struct IndexHeader{
+	char magic[8];
+	uint32_t version;
+	uint32_t byteOrder; //INDEX_BYTE_ORDER AS STORED BY THE MACHINE THAT WROTE THE INDEX
+	uint64_t headerSize;
+	uint64_t imageFileSize; //KEY OF THE IMAGE THE INDEX WAS BUILT FROM
+	int64_t imageModified;
+	int64_t imageModifiedNanoseconds;
+	uint64_t mediaSize; //SIZE OF THE IMAGE MEDIA (DIFFERS FROM THE FILE SIZE FOR E01 IMAGES)
+	int32_t partitionBlank;
+	int32_t partitionScheme;
+	struct FatVolume fat; //VOLUME INFORMATION OF THE MODEL, WITH THE POINTERS CLEARED
+	struct NtfsVolume ntfs;
+	struct IndexSection sections[INDEX_SECTION_COUNT];
+};
+
+struct IndexBuffer{ //A SECTION BEING BUILT IN MEMORY
+	unsigned char *data;
+	size_t length, capacity;
+};
+
+struct IndexBuilder{
+	struct VolumeModel *model;
+	FILE *out;
+	uint64_t written; //BYTES WRITTEN TO out SO FAR
+	struct IndexBuffer sections[INDEX_SECTION_COUNT];
+	size_t directoryCursor; //FAT ENTRY OF THE DIRECTORY THE WALK IS READING
+	int status; //-1 ONCE A SECTION COULD NOT BE GROWN OR WRITTEN
+};
+
+static const uint64_t indexRecordSizes[INDEX_SECTION_COUNT] = {sizeof(struct Partition), sizeof(struct IndexFatEntry), sizeof(struct ImageExtent), sizeof(struct IndexChild),
+	sizeof(struct IndexMftRecord), 1, sizeof(struct NtfsRun), sizeof(struct IndexChild), 1};
+
+static int indexFatEntry(const struct FatDirEntry *entry, void *context);
+static int indexMftRecord(const struct MftRecord *record, void *context);
+static uint32_t findFatParent(struct IndexBuilder *builder, const char *path);
+static int appendIndexBuffer(struct IndexBuilder *builder, int section, const void *data, size_t length);
+static uint64_t appendIndexString(struct IndexBuilder *builder, const char *text);
+static int writeIndexSection(struct IndexBuilder *builder, struct IndexHeader *header, int section, const void *data, uint64_t count);
+static int writeIndexPadding(struct IndexBuilder *builder);
+static const struct IndexMftRecord *findIndexedMftRecord(const struct MetadataIndex *index, uint64_t number);
+static int compareIndexChildren(const void *a, const void *b);
+
+
+/*
+ * Function:  writeMetadataIndex 
+ * --------------------
+ * Writes the index of a model built from the image to <imagePath>.idx
+ * The FAT volume is walked and the $MFT scanned once; the $MFT records go
+ * straight to the file, the other sections are collected and written after
+ * them. The index is written to a temporary file that replaces the old index
+ * only once it is complete
+ * 
+ * model: The volume model of the open disk image
+ * imagePath: Path the image was opened with (the index is keyed by its size and time)
+ * int: 0 on success, -1 on failure (errno is set)
+ */
+int writeMetadataIndex(struct VolumeModel *model, const char *imagePath){
+	//DATA DECLARATION
+	struct IndexBuilder builder;
+	struct IndexHeader header;
+	struct stat image;
+	char path[INDEX_PATH_MAX], temporary[INDEX_PATH_MAX + 4];
+	int i, status = 0, saved;
+	//DATA MANIPULATION
+	if(stat(imagePath, &image) != 0){
+		return -1;
+	}
+	if(snprintf(path, sizeof(path), "%s.idx", imagePath) >= (int)sizeof(path)){
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+	memset(&builder, 0, sizeof(builder));
+	memset(&header, 0, sizeof(header));
+	builder.model = model;
+	builder.out = fopen(temporary, "wb");
+	if(builder.out == NULL){
+		return -1;
+	}
+	if(fwrite(&header, sizeof(header), 1, builder.out) != 1){ //PLACEHOLDER, FILLED IN ONCE THE SECTIONS ARE WRITTEN
+		status = -1;
+	}
+	builder.written = sizeof(header);
+	appendIndexString(&builder, ""); //OFFSET 0 IS THE EMPTY STRING
+	if(status == 0 && writeIndexPadding(&builder) != 0){
+		status = -1;
+	}
+	header.sections[INDEX_MFT_DATA].offset = builder.written;
+	header.sections[INDEX_MFT_DATA].recordSize = 1;
+	if(status == 0 && model->ntfs.present && scanMftRecords(model->image, &model->ntfs, 0, indexMftRecord, &builder) != 0){
+		status = -1;
+	}
+	header.sections[INDEX_MFT_DATA].count = builder.written - header.sections[INDEX_MFT_DATA].offset;
+	if(status == 0 && model->fat.present && walkFatDirectories(model->image, &model->fat, indexFatEntry, &builder) != 0){
+		status = -1;
+	}
+	if(status == 0 && builder.status == 0){
+		qsort(builder.sections[INDEX_FAT_CHILDREN].data, builder.sections[INDEX_FAT_CHILDREN].length/sizeof(struct IndexChild), sizeof(struct IndexChild), compareIndexChildren);
+		qsort(builder.sections[INDEX_MFT_CHILDREN].data, builder.sections[INDEX_MFT_CHILDREN].length/sizeof(struct IndexChild), sizeof(struct IndexChild), compareIndexChildren);
+		status = writeIndexSection(&builder, &header, INDEX_PARTITIONS, model->partitions, model->partitionCount);
+		for(i=0;i<INDEX_SECTION_COUNT && status == 0;i++){
+			if(i != INDEX_PARTITIONS && i != INDEX_MFT_DATA){
+				status = writeIndexSection(&builder, &header, i, builder.sections[i].data, builder.sections[i].length/indexRecordSizes[i]);
+			}
+		}
+	}
+	if(builder.status != 0){
+		status = -1;
+	}
+	memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+	header.version = INDEX_VERSION;
+	header.byteOrder = INDEX_BYTE_ORDER;
+	header.headerSize = sizeof(header);
+	header.imageFileSize = (uint64_t)image.st_size;
+	header.imageModified = (int64_t)image.st_mtim.tv_sec;
+	header.imageModifiedNanoseconds = (int64_t)image.st_mtim.tv_nsec;
+	header.mediaSize = model->image->size;
+	header.partitionBlank = model->partitionBlank;
+	header.partitionScheme = model->partitionScheme;
+	header.fat = model->fat;
+	header.fat.table = NULL; //POINTERS MEAN NOTHING ONCE THE PROCESS HAS EXITED
+	header.fat.tableBuffer = NULL;
+	header.fat.tableEntries = 0;
+	header.ntfs = model->ntfs;
+	memset(&header.ntfs.mftMap, 0, sizeof(header.ntfs.mftMap));
+	header.ntfs.extentCache = NULL;
+	if(status == 0 && (fseek(builder.out, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, builder.out) != 1 || fflush(builder.out) != 0 || fsync(fileno(builder.out)) != 0)){
+		status = -1;
+	}
+	saved = errno;
+	if(fclose(builder.out) != 0){
+		status = -1;
+	}
+	for(i=0;i<INDEX_SECTION_COUNT;i++){
+		free(builder.sections[i].data);
+	}
+	if(status == 0 && rename(temporary, path) != 0){
+		status = -1;
+	}
+	if(status != 0){
+		saved = errno ? errno : saved;
+		unlink(temporary);
+		errno = saved;
+	}
+	return status;
+}
+
+
+/*
+ * Function:  openMetadataIndex 
+ * --------------------
+ * Maps the index next to an image and checks that it belongs to the image
+ * as it is now and that every section lies within the file
+ * 
+ * imagePath: Path of the image
+ * index: Filled in with the sections of the mapped index
+ * int: INDEX_OPENED, INDEX_MISSING if there is no index, INDEX_STALE if it must be rebuilt
+ */
+int openMetadataIndex(const char *imagePath, struct MetadataIndex *index){
+	//DATA DECLARATION
+	const struct IndexHeader *header;
+	const struct IndexSection *section;
+	struct stat image, file;
+	void *map;
+	int fd, i;
+	//DATA MANIPULATION
+	memset(index, 0, sizeof(*index));
+	if(snprintf(index->path, sizeof(index->path), "%s.idx", imagePath) >= (int)sizeof(index->path) || stat(imagePath, &image) != 0){
+		return INDEX_MISSING;
+	}
+	fd = open(index->path, O_RDONLY);
+	if(fd < 0){
+		return (errno == ENOENT) ? INDEX_MISSING : INDEX_STALE;
+	}
+	if(fstat(fd, &file) != 0 || (uint64_t)file.st_size < sizeof(struct IndexHeader)){
+		close(fd);
+		return INDEX_STALE;
+	}
+	map = mmap(NULL, (size_t)file.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED){
+		return INDEX_STALE;
+	}
+	index->map = map;
+	index->size = (size_t)file.st_size;
+	index->header = header = map;
+	if(memcmp(header->magic, INDEX_MAGIC, sizeof(header->magic)) != 0 || header->version != INDEX_VERSION || header->byteOrder != INDEX_BYTE_ORDER || header->headerSize != sizeof(*header)
+		|| header->imageFileSize != (uint64_t)image.st_size || header->imageModified != (int64_t)image.st_mtim.tv_sec || header->imageModifiedNanoseconds != (int64_t)image.st_mtim.tv_nsec
+		|| (header->ntfs.present && (header->ntfs.mftRecordSize < INDEX_MFT_MIN_BYTES || header->ntfs.mftRecordSize > 65536))){
+		closeMetadataIndex(index);
+		return INDEX_STALE;
+	}
+	for(i=0;i<INDEX_SECTION_COUNT;i++){ //EVERY SECTION MUST HOLD THE RECORDS OF THIS BUILD AND LIE INSIDE THE FILE
+		section = &header->sections[i];
+		if(section->recordSize != indexRecordSizes[i] || section->offset % 8 != 0 || section->offset > index->size || section->count > (index->size - section->offset)/section->recordSize){
+			closeMetadataIndex(index);
+			return INDEX_STALE;
+		}
+	}
+	if(header->sections[INDEX_STRINGS].count == 0 || index->map[header->sections[INDEX_STRINGS].offset + header->sections[INDEX_STRINGS].count - 1] != '\0'){
+		closeMetadataIndex(index);
+		return INDEX_STALE;
+	}
+	index->partitions = (const void*)(index->map + header->sections[INDEX_PARTITIONS].offset);
+	index->partitionCount = header->sections[INDEX_PARTITIONS].count;
+	index->fatEntries = (const void*)(index->map + header->sections[INDEX_FAT_ENTRIES].offset);
+	index->fatEntryCount = header->sections[INDEX_FAT_ENTRIES].count;
+	index->fatExtents = (const void*)(index->map + header->sections[INDEX_FAT_EXTENTS].offset);
+	index->fatExtentCount = header->sections[INDEX_FAT_EXTENTS].count;
+	index->fatChildren = (const void*)(index->map + header->sections[INDEX_FAT_CHILDREN].offset);
+	index->fatChildCount = header->sections[INDEX_FAT_CHILDREN].count;
+	index->mftRecords = (const void*)(index->map + header->sections[INDEX_MFT_RECORDS].offset);
+	index->mftRecordCount = header->sections[INDEX_MFT_RECORDS].count;
+	index->mftData = index->map + header->sections[INDEX_MFT_DATA].offset;
+	index->mftDataSize = header->sections[INDEX_MFT_DATA].count;
+	index->mftRuns = (const void*)(index->map + header->sections[INDEX_MFT_RUNS].offset);
+	index->mftRunCount = header->sections[INDEX_MFT_RUNS].count;
+	index->mftChildren = (const void*)(index->map + header->sections[INDEX_MFT_CHILDREN].offset);
+	index->mftChildCount = header->sections[INDEX_MFT_CHILDREN].count;
+	index->strings = (const char*)index->map + header->sections[INDEX_STRINGS].offset;
+	index->stringsSize = header->sections[INDEX_STRINGS].count;
+	return INDEX_OPENED;
+}
+
+
+/*
+ * Function:  closeMetadataIndex 
+ * --------------------
+ * Unmaps an index opened with openMetadataIndex
+ * 
+ * index: The index
+ */
+void closeMetadataIndex(struct MetadataIndex *index){
+	if(index->map != NULL){
+		munmap(index->map, index->size);
+	}
+	index->map = NULL;
+	index->header = NULL;
+}
+
+
+/*
+ * Function:  loadIndexedModel 
+ * --------------------
+ * Fills in a volume model from an index instead of the image
+ * The model has no image; commands read the FAT entries and $MFT records
+ * of model->index instead
+ * 
+ * index: The opened index (kept open while the model is used)
+ * model: The model to fill in (released with freeVolumeModel)
+ */
+void loadIndexedModel(const struct MetadataIndex *index, struct VolumeModel *model){
+	memset(model, 0, sizeof(*model));
+	model->index = index;
+	model->partitions = malloc(index->partitionCount*sizeof(struct Partition) + 1);
+	if(model->partitions != NULL){
+		memcpy(model->partitions, index->partitions, index->partitionCount*sizeof(struct Partition));
+		model->partitionCount = model->partitionCapacity = index->partitionCount;
+	}
+	model->partitionBlank = index->header->partitionBlank;
+	model->partitionScheme = index->header->partitionScheme;
+	model->fat = index->header->fat;
+	model->fat.table = NULL; //ALREADY CLEARED WHEN WRITTEN, NEVER TRUSTED FROM THE FILE
+	model->fat.tableBuffer = NULL;
+	model->fat.tableEntries = 0;
+	model->ntfs = index->header->ntfs;
+	memset(&model->ntfs.mftMap, 0, sizeof(model->ntfs.mftMap));
+	model->ntfs.extentCache = NULL;
+}
+
+
+/*
+ * Function:  walkIndexedFatEntries 
+ * --------------------
+ * Visits FAT directory entries kept in the index, in the order the
+ * directory walk found them
+ * 
+ * index: The opened index
+ * children: Entries to visit (their child fields), NULL to visit every entry
+ * count: Number of children
+ * visit: Called for each entry, a non zero return stops the walk
+ * context: Passed through to visit
+ * int: 0 when every entry was visited, the non zero value returned by visit, -1 on failure
+ */
+int walkIndexedFatEntries(const struct MetadataIndex *index, const struct IndexChild *children, size_t count, int (*visit)(const struct FatDirEntry *entry, void *context), void *context){
+	//DATA DECLARATION
+	struct FatDirEntry *entry = malloc(sizeof(struct FatDirEntry));
+	const struct IndexFatEntry *stored;
+	size_t i, number;
+	int status = 0;
+	//DATA MANIPULATION
+	if(entry == NULL){
+		return -1;
+	}
+	if(children == NULL){
+		count = index->fatEntryCount;
+	}
+	for(i=0;i<count && status == 0;i++){
+		number = (children == NULL) ? i : (size_t)children[i].child;
+		if(number >= index->fatEntryCount){
+			status = -1;
+			break;
+		}
+		stored = &index->fatEntries[number];
+		snprintf(entry->path, sizeof(entry->path), "%s", fetchIndexString(index, stored->path));
+		snprintf(entry->longName, sizeof(entry->longName), "%s", fetchIndexString(index, stored->longName));
+		memcpy(entry->shortName, stored->shortName, sizeof(entry->shortName));
+		entry->shortName[sizeof(entry->shortName) - 1] = '\0';
+		entry->attributes = stored->attributes;
+		entry->deleted = stored->deleted;
+		entry->parentDeleted = stored->parentDeleted;
+		entry->startCluster = stored->startCluster;
+		entry->fileSize = stored->fileSize;
+		entry->entryOffset = stored->entryOffset;
+		entry->raw = stored->raw;
+		status = visit(entry, context);
+	}
+	free(entry);
+	return status;
+}
+
+
+/*
+ * Function:  fetchIndexedPreview 
+ * --------------------
+ * Copies the content kept for a deleted entry visited by walkIndexedFatEntries
+ * (the counterpart of fetchFilePreview, which reads it from the image)
+ * 
+ * entry: An entry being visited by walkIndexedFatEntries
+ * buffer: Receives the content
+ * length: Number of bytes wanted
+ * size_t: Number of bytes copied
+ */
+size_t fetchIndexedPreview(const struct FatDirEntry *entry, char *buffer, size_t length){
+	const struct IndexFatEntry *stored = (const void*)(entry->raw - offsetof(struct IndexFatEntry, raw)); //raw POINTS INTO THE INDEXED ENTRY
+	if(length > stored->previewLength){
+		length = stored->previewLength;
+	}
+	memcpy(buffer, stored->preview, length);
+	return length;
+}
+
+
+/*
+ * Function:  scanIndexedMftRecords 
+ * --------------------
+ * Visits $MFT records kept in the index in record number order,
+ * decoding each one again as scanMftRecords would
+ * 
+ * index: The opened index
+ * children: Records to visit (their child fields hold the numbers), NULL to visit every record
+ * count: Number of children
+ * visit: Called for each record, a non zero return stops the scan
+ * context: Passed through to visit
+ * int: 0 when every record was visited, the non zero value returned by visit, -1 on failure
+ */
+int scanIndexedMftRecords(const struct MetadataIndex *index, const struct IndexChild *children, size_t count, int (*visit)(const struct MftRecord *record, void *context), void *context){
+	//DATA DECLARATION
+	int recordSize = index->header->ntfs.mftRecordSize;
+	unsigned char *buffer = malloc((size_t)recordSize);
+	struct MftRecord *record = malloc(sizeof(struct MftRecord));
+	const struct IndexMftRecord *stored;
+	size_t i;
+	int status = 0;
+	//DATA MANIPULATION
+	if(buffer == NULL || record == NULL){
+		status = -1;
+	}
+	if(children == NULL){
+		count = index->mftRecordCount;
+	}
+	for(i=0;i<count && status == 0;i++){
+		stored = (children == NULL) ? &index->mftRecords[i] : findIndexedMftRecord(index, children[i].child);
+		if(stored == NULL || stored->dataLength > (uint32_t)recordSize || stored->dataOffset > index->mftDataSize || stored->dataLength > index->mftDataSize - stored->dataOffset){
+			status = -1;
+			break;
+		}
+		memcpy(buffer, index->mftData + stored->dataOffset, stored->dataLength);
+		memset(buffer + stored->dataLength, 0, (size_t)recordSize - stored->dataLength);
+		if(decodeMftRecord(buffer, recordSize, stored->number, record) != 0){
+			status = -1;
+			break;
+		}
+		record->fixupError = (int)stored->fixupError;
+		status = visit(record, context);
+	}
+	free(buffer);
+	free(record);
+	return status;
+}
+
+
+/*
+ * Function:  findIndexedChildren 
+ * --------------------
+ * Finds the children of a parent in a sorted children section
+ * 
+ * children: The children section
+ * count: Number of entries in the section
+ * parent: Parent record number or FAT parent key
+ * found: Receives the number of children
+ * const struct IndexChild*: The first child, in child order
+ */
+const struct IndexChild *findIndexedChildren(const struct IndexChild *children, size_t count, uint64_t parent, size_t *found){
+	size_t low = 0, high = count, middle, end;
+	while(low < high){ //FIRST ENTRY WITH THIS PARENT OR A LATER ONE
+		middle = low + (high - low)/2;
+		if(children[middle].parent < parent){
+			low = middle + 1;
+		}else{
+			high = middle;
+		}
+	}
+	for(end=low;end<count && children[end].parent == parent;end++);
+	*found = end - low;
+	return children + low;
+}
+
+
+/*
+ * Function:  fetchIndexString 
+ * --------------------
+ * Looks up a string of the string section
+ * 
+ * index: The opened index
+ * offset: Offset of the string
+ * const char*: The string, empty if the offset is outside the section
+ */
+const char *fetchIndexString(const struct MetadataIndex *index, uint64_t offset){
+	return (offset < index->stringsSize) ? index->strings + offset : "";
+}
+
+
+/*
+ * Function:  indexFatEntry 
+ * --------------------
+ * Directory walk visitor adding an entry, its extents, its preview (when
+ * deleted) and its place in the parent to children map
+ * 
+ * entry: The directory entry being visited
+ * context: The IndexBuilder
+ * int: 0 to continue the walk, -1 once the index cannot be built
+ */
+static int indexFatEntry(const struct FatDirEntry *entry, void *context){
+	//DATA DECLARATION
+	struct IndexBuilder *builder = context;
+	struct VolumeModel *model = builder->model;
+	struct IndexFatEntry stored;
+	struct IndexChild child;
+	struct FileExtents extents = {NULL, 0, 0, 0, 0, 0};
+	//DATA MANIPULATION
+	memset(&stored, 0, sizeof(stored));
+	stored.entryOffset = entry->entryOffset;
+	stored.path = appendIndexString(builder, entry->path);
+	stored.longName = entry->longName[0] ? appendIndexString(builder, entry->longName) : 0;
+	stored.parent = findFatParent(builder, entry->path);
+	stored.startCluster = entry->startCluster;
+	stored.fileSize = entry->fileSize;
+	stored.attributes = entry->attributes;
+	stored.deleted = (unsigned char)entry->deleted;
+	stored.parentDeleted = (unsigned char)entry->parentDeleted;
+	memcpy(stored.shortName, entry->shortName, sizeof(stored.shortName));
+	memcpy(stored.raw, entry->raw, sizeof(stored.raw));
+	if(entry->deleted || entry->parentDeleted){
+		stored.previewLength = (unsigned char)fetchFilePreview(model->image, &model->fat, entry, stored.preview, sizeof(stored.preview));
+	}
+	if(entry->startCluster >= 2 && fetchFileExtents(model->image, &model->fat, entry, &extents) == 0){
+		stored.firstExtent = builder->sections[INDEX_FAT_EXTENTS].length/sizeof(struct ImageExtent);
+		stored.extentCount = (uint32_t)extents.count;
+		stored.extentFlags = (unsigned char)((extents.truncated ? 1 : 0) | (extents.overwritten ? 2 : 0));
+		appendIndexBuffer(builder, INDEX_FAT_EXTENTS, extents.extents, extents.count*sizeof(struct ImageExtent));
+	}
+	freeFileExtents(&extents);
+	child.parent = stored.parent;
+	child.child = builder->sections[INDEX_FAT_ENTRIES].length/sizeof(stored);
+	appendIndexBuffer(builder, INDEX_FAT_CHILDREN, &child, sizeof(child));
+	appendIndexBuffer(builder, INDEX_FAT_ENTRIES, &stored, sizeof(stored));
+	return builder->status;
+}
+
+
+/*
+ * Function:  indexMftRecord 
+ * --------------------
+ * MFT scan visitor writing a record (with its fixups applied, up to its
+ * used size) to the index file and adding its $DATA runs and its place
+ * in the parent to children map
+ * 
+ * record: The decoded MFT record
+ * context: The IndexBuilder
+ * int: 0 to continue the scan, -1 once the index cannot be built
+ */
+static int indexMftRecord(const struct MftRecord *record, void *context){
+	//DATA DECLARATION
+	struct IndexBuilder *builder = context;
+	struct IndexMftRecord stored;
+	struct IndexChild child;
+	struct NtfsExtentMap map;
+	uint32_t length = record->usedSize;
+	//DATA MANIPULATION
+	if(length < INDEX_MFT_MIN_BYTES){
+		length = INDEX_MFT_MIN_BYTES;
+	}
+	memset(&stored, 0, sizeof(stored));
+	stored.number = record->number;
+	stored.dataLength = length;
+	stored.fixupError = (uint32_t)record->fixupError;
+	if(record->baseRecord == 0 && record->hasFileName){
+		stored.parentRecord = record->fileName.parentRecord;
+		child.parent = record->fileName.parentRecord;
+		child.child = record->number;
+		appendIndexBuffer(builder, INDEX_MFT_CHILDREN, &child, sizeof(child));
+	}
+	if(record->baseRecord == 0 && buildExtentMap(record, &map) == 0){
+		if(map.resident == NULL){
+			stored.firstRun = builder->sections[INDEX_MFT_RUNS].length/sizeof(struct NtfsRun);
+			stored.runCount = (uint32_t)map.count;
+			appendIndexBuffer(builder, INDEX_MFT_RUNS, map.runs, map.count*sizeof(struct NtfsRun));
+		}
+		freeExtentMap(&map);
+	}
+	stored.dataOffset = builder->sections[INDEX_MFT_DATA].length;
+	builder->sections[INDEX_MFT_DATA].length += length; //ONLY COUNTED, THE BYTES GO STRAIGHT TO THE FILE
+	if(fwrite(record->data, 1, length, builder->out) != length){
+		builder->status = -1;
+	}
+	builder->written += length;
+	appendIndexBuffer(builder, INDEX_MFT_RECORDS, &stored, sizeof(stored));
+	return builder->status;
+}
+
+
+/*
+ * Function:  findFatParent 
+ * --------------------
+ * Finds the entry of the directory an entry was found in
+ * The walk reads directories in the order their entries were found and
+ * visits the entries of one directory together, so the directory is the
+ * first directory entry from the cursor on whose path is the entry's path
+ * without its last component (directories that were not read are skipped)
+ * 
+ * builder: The IndexBuilder
+ * path: Path of the entry being visited
+ * uint32_t: INDEX_ROOT, or 1 + the index of the directory's entry
+ */
+static uint32_t findFatParent(struct IndexBuilder *builder, const char *path){
+	//DATA DECLARATION
+	const struct IndexFatEntry *entries = (const void*)builder->sections[INDEX_FAT_ENTRIES].data;
+	const char *strings = (const char*)builder->sections[INDEX_STRINGS].data;
+	size_t count = builder->sections[INDEX_FAT_ENTRIES].length/sizeof(struct IndexFatEntry), i;
+	size_t length = (size_t)(strrchr(path, '/') - path);
+	//DATA MANIPULATION
+	if(length == 0){
+		return INDEX_ROOT;
+	}
+	for(i=builder->directoryCursor;i<count;i++){
+		if((entries[i].attributes & 0x10) && strncmp(strings + entries[i].path, path, length) == 0 && strings[entries[i].path + length] == '\0'){
+			builder->directoryCursor = i;
+			return (uint32_t)(i + 1);
+		}
+	}
+	for(i=builder->directoryCursor;i-- > 0;){ //NOT IN WALK ORDER, TAKE THE LATEST DIRECTORY WITH THE PATH
+		if((entries[i].attributes & 0x10) && strncmp(strings + entries[i].path, path, length) == 0 && strings[entries[i].path + length] == '\0'){
+			return (uint32_t)(i + 1);
+		}
+	}
+	return INDEX_ROOT;
+}
+
+
+/*
+ * Function:  appendIndexBuffer 
+ * --------------------
+ * Appends bytes to a section being built, doubling its buffer as needed
+ * 
+ * builder: The IndexBuilder (status is set to -1 when out of memory)
+ * section: The section
+ * data: Bytes to append
+ * length: Number of bytes
+ * int: 0 on success, -1 when out of memory
+ */
+static int appendIndexBuffer(struct IndexBuilder *builder, int section, const void *data, size_t length){
+	struct IndexBuffer *buffer = &builder->sections[section];
+	unsigned char *grown;
+	size_t capacity;
+	if(buffer->length + length > buffer->capacity){
+		for(capacity = buffer->capacity ? buffer->capacity : 4096;capacity < buffer->length + length;capacity *= 2);
+		grown = realloc(buffer->data, capacity);
+		if(grown == NULL){
+			builder->status = -1;
+			return -1;
+		}
+		buffer->data = grown;
+		buffer->capacity = capacity;
+	}
+	if(length > 0){
+		memcpy(buffer->data + buffer->length, data, length);
+	}
+	buffer->length += length;
+	return 0;
+}
+
+
+/*
+ * Function:  appendIndexString 
+ * --------------------
+ * Appends a NUL terminated string to the string section
+ * 
+ * builder: The IndexBuilder
+ * text: The string
+ * uint64_t: Offset of the string in the section
+ */
+static uint64_t appendIndexString(struct IndexBuilder *builder, const char *text){
+	uint64_t offset = builder->sections[INDEX_STRINGS].length;
+	appendIndexBuffer(builder, INDEX_STRINGS, text, strlen(text) + 1);
+	return offset;
+}
+
+
+/*
+ * Function:  writeIndexSection 
+ * --------------------
+ * Writes a section at the next 8 byte boundary of the file and records it in the header
+ * 
+ * builder: The IndexBuilder
+ * header: The header being built
+ * section: The section
+ * data: Its records
+ * count: Number of records
+ * int: 0 on success, -1 on a write error
+ */
+static int writeIndexSection(struct IndexBuilder *builder, struct IndexHeader *header, int section, const void *data, uint64_t count){
+	if(writeIndexPadding(builder) != 0){
+		return -1;
+	}
+	header->sections[section].offset = builder->written;
+	header->sections[section].count = count;
+	header->sections[section].recordSize = indexRecordSizes[section];
+	if(count > 0 && fwrite(data, (size_t)indexRecordSizes[section], (size_t)count, builder->out) != count){
+		return -1;
+	}
+	builder->written += count*indexRecordSizes[section];
+	return 0;
+}
+
+
+/*
+ * Function:  writeIndexPadding 
+ * --------------------
+ * Pads the file with zeros to the next 8 byte boundary
+ * 
+ * builder: The IndexBuilder
+ * int: 0 on success, -1 on a write error
+ */
+static int writeIndexPadding(struct IndexBuilder *builder){
+	static const unsigned char zeros[8];
+	size_t padding = (size_t)((8 - builder->written % 8) % 8);
+	if(padding > 0 && fwrite(zeros, 1, padding, builder->out) != padding){
+		return -1;
+	}
+	builder->written += padding;
+	return 0;
+}
+
+
+/*
+ * Function:  findIndexedMftRecord 
+ * --------------------
+ * Binary search of the record table, which is in record number order
+ * 
+ * index: The opened index
+ * number: Record number
+ * const struct IndexMftRecord*: The record, NULL if it is not in the index
+ */
+static const struct IndexMftRecord *findIndexedMftRecord(const struct MetadataIndex *index, uint64_t number){
+	size_t low = 0, high = index->mftRecordCount, middle;
+	while(low < high){
+		middle = low + (high - low)/2;
+		if(index->mftRecords[middle].number == number){
+			return &index->mftRecords[middle];
+		}
+		if(index->mftRecords[middle].number < number){
+			low = middle + 1;
+		}else{
+			high = middle;
+		}
+	}
+	return NULL;
+}
+
+
+/*
+ * Function:  compareIndexChildren 
+ * --------------------
+ * qsort comparison ordering children by parent, then by child
+ */
+static int compareIndexChildren(const void *a, const void *b){
+	const struct IndexChild *first = a, *second = b;
+	if(first->parent != second->parent){
+		return (first->parent > second->parent) - (first->parent < second->parent);
+	}
+	return (first->child > second->child) - (first->child < second->child);
+}
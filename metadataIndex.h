@@ -0,0 +1,108 @@
+/*
+ * metadataIndex.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Persistent metadata index
+ * Keeps the parsed partition table, FAT directory entries, $MFT records,
+ * parent to children maps and file extents in a versioned file next to
+ * the image (<image>.idx). The file is memory mapped and its sections are
+ * used in place, so later queries are answered without reading the image.
+ * The index is keyed by the size and modification time of the image file
+ * and is rebuilt when they change.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef METADATAINDEX_H
+#define METADATAINDEX_H
+
+//IMPORTED LIBRARIES
+#include <stddef.h>
+#include <stdint.h>
+#include "diskImage.h"
+#include "volumeModel.h"
+#include "fatVolume.h"
+#include "ntfsVolume.h"
+
+#define INDEX_OPENED 0 //openMetadataIndex RESULTS
+#define INDEX_MISSING 1 //NO INDEX NEXT TO THE IMAGE
+#define INDEX_STALE 2 //THE IMAGE CHANGED, OR THE INDEX IS DAMAGED OR FROM ANOTHER VERSION
+#define INDEX_VERSION 1 //RAISED WHENEVER THE LAYOUT OF A SECTION CHANGES
+#define INDEX_PATH_MAX 4096
+#define INDEX_PREVIEW_BYTES 16 //CONTENT KEPT FOR DELETED FAT ENTRIES
+#define INDEX_ROOT 0 //PARENT KEY OF THE ENTRIES OF THE FAT ROOT DIRECTORY
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct IndexFatEntry{
+	uint64_t entryOffset; //BYTE OFFSET OF THE 32 BYTE ENTRY IN THE IMAGE
+	uint64_t path; //OFFSETS OF THE PATH AND LONG NAME IN THE STRING SECTION
+	uint64_t longName;
+	uint64_t firstExtent; //FIRST OF THE FILE'S EXTENTS IN THE FAT EXTENT SECTION
+	uint32_t extentCount;
+	uint32_t parent; //INDEX_ROOT, OR 1 + THE INDEX OF THE ENTRY OF ITS DIRECTORY
+	uint32_t startCluster;
+	uint32_t fileSize;
+	unsigned char attributes;
+	unsigned char deleted;
+	unsigned char parentDeleted;
+	unsigned char previewLength;
+	unsigned char extentFlags; //1 TRUNCATED, 2 OVERWRITTEN (AS IN FileExtents)
+	char shortName[13];
+	unsigned char raw[32]; //THE RAW DIRECTORY ENTRY
+	char preview[INDEX_PREVIEW_BYTES]; //FIRST BYTES OF A DELETED FILE
+};
+
+struct IndexMftRecord{
+	uint64_t number; //MFT RECORD NUMBER
+	uint64_t dataOffset; //OFFSET OF THE RECORD BYTES IN THE MFT DATA SECTION
+	uint64_t parentRecord; //PARENT OF THE PREFERRED $FILE_NAME (0 IF THERE IS NONE)
+	uint64_t firstRun; //FIRST RUN OF THE UNNAMED $DATA STREAM IN THE RUN SECTION
+	uint32_t dataLength; //BYTES KEPT, THE USED SIZE OF THE RECORD WITH ITS FIXUPS APPLIED
+	uint32_t runCount;
+	uint32_t fixupError;
+	uint32_t reserved;
+};
+
+struct IndexChild{ //SORTED BY PARENT, THEN BY CHILD
+	uint64_t parent; //PARENT RECORD NUMBER, OR THE PARENT KEY OF A FAT ENTRY
+	uint64_t child; //CHILD RECORD NUMBER, OR THE INDEX OF A FAT ENTRY
+};
+
+struct MetadataIndex{
+	unsigned char *map; //THE MAPPED INDEX FILE
+	size_t size;
+	int rebuilt; //1 IF THE INDEX WAS WRITTEN BY THIS RUN
+	char path[INDEX_PATH_MAX];
+	const struct IndexHeader *header;
+	const struct Partition *partitions;
+	size_t partitionCount;
+	const struct IndexFatEntry *fatEntries;
+	size_t fatEntryCount;
+	const struct ImageExtent *fatExtents;
+	size_t fatExtentCount;
+	const struct IndexChild *fatChildren;
+	size_t fatChildCount;
+	const struct IndexMftRecord *mftRecords;
+	size_t mftRecordCount;
+	const unsigned char *mftData;
+	size_t mftDataSize;
+	const struct NtfsRun *mftRuns;
+	size_t mftRunCount;
+	const struct IndexChild *mftChildren;
+	size_t mftChildCount;
+	const char *strings;
+	size_t stringsSize;
+};
+
+int writeMetadataIndex(struct VolumeModel *model, const char *imagePath);
+int openMetadataIndex(const char *imagePath, struct MetadataIndex *index);
+void closeMetadataIndex(struct MetadataIndex *index);
+void loadIndexedModel(const struct MetadataIndex *index, struct VolumeModel *model);
+int walkIndexedFatEntries(const struct MetadataIndex *index, const struct IndexChild *children, size_t count, int (*visit)(const struct FatDirEntry *entry, void *context), void *context);
+size_t fetchIndexedPreview(const struct FatDirEntry *entry, char *buffer, size_t length);
+int scanIndexedMftRecords(const struct MetadataIndex *index, const struct IndexChild *children, size_t count, int (*visit)(const struct MftRecord *record, void *context), void *context);
+const struct IndexChild *findIndexedChildren(const struct IndexChild *children, size_t count, uint64_t parent, size_t *found);
+const char *fetchIndexString(const struct MetadataIndex *index, uint64_t offset);
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * nameConvert.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: On-disk name conversion
+ * Converts UTF-16LE names (FAT long file names, NTFS $FILE_NAME)
+ * to NUL terminated UTF-8.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include "nameConvert.h"
+
+
+/*
+ * Function:  convertUtf16Name
+ * --------------------
+ * Converts a UTF-16LE name to UTF-8
+ * Stops early at a NUL or 0xFFFF (FAT long name padding)
+ * Surrogate pairs are joined, unpaired surrogates are kept as they are
+ *
+ * utf16: The UTF-16LE bytes
+ * units: Number of UTF-16 code units (2 bytes each)
+ * out: Output buffer
+ * size: Size of the output buffer in bytes
+ * size_t: Length of the UTF-8 name (excluding the terminator)
+ */
+size_t convertUtf16Name(const unsigned char *utf16, size_t units, char *out, size_t size){
+	size_t i, used = 0;
+	unsigned int unit, low;
+	if(size == 0){
+		return 0;
+	}
+	for(i=0;i<units;i++){
+		unit = utf16[2*i] | (utf16[2*i+1] << 8);
+		if(unit == 0x0000 || unit == 0xFFFF){ //NAME IS NUL TERMINATED OR PADDED WITH 0xFFFF
+			break;
+		}
+		if(unit >= 0xD800 && unit < 0xDC00 && i + 1 < units){ //UTF-16 SURROGATE PAIR
+			low = utf16[2*i+2] | (utf16[2*i+3] << 8);
+			if(low >= 0xDC00 && low < 0xE000){
+				unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+				i++;
+			}
+		}
+		used = appendUtf8(out, used, size, unit);
+	}
+	out[used] = '\0';
+	return used;
+}
+
+
+/*
+ * Function:  appendUtf8
+ * --------------------
+ * Appends one code point to a buffer as UTF-8
+ *
+ * out: Output buffer
+ * used: Number of bytes already in the buffer
+ * size: Size of the buffer (one byte is always kept for the terminator)
+ * codePoint: Character to append
+ * size_t: New number of bytes in the buffer
+ */
+size_t appendUtf8(char *out, size_t used, size_t size, unsigned int codePoint){
+	if(codePoint < 0x80 && used + 1 < size){
+		out[used++] = (char)codePoint;
+	}else if(codePoint >= 0x80 && codePoint < 0x800 && used + 2 < size){
+		out[used++] = (char)(0xC0 | (codePoint >> 6));
+		out[used++] = (char)(0x80 | (codePoint & 0x3F));
+	}else if(codePoint >= 0x800 && codePoint < 0x10000 && used + 3 < size){
+		out[used++] = (char)(0xE0 | (codePoint >> 12));
+		out[used++] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+		out[used++] = (char)(0x80 | (codePoint & 0x3F));
+	}else if(codePoint >= 0x10000 && used + 4 < size){
+		out[used++] = (char)(0xF0 | (codePoint >> 18));
+		out[used++] = (char)(0x80 | ((codePoint >> 12) & 0x3F));
+		out[used++] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+		out[used++] = (char)(0x80 | (codePoint & 0x3F));
+	}
+	return used;
+}
@@ -0,0 +1,23 @@
+/*
+ * nameConvert.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: On-disk name conversion
+ * FAT long file names and NTFS names are stored as UTF-16LE,
+ * these helpers turn them into UTF-8 for printing and JSON output.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef NAMECONVERT_H
+#define NAMECONVERT_H
+
+//IMPORTED LIBRARIES
+#include <stddef.h>
+
+//FUNCTION & STRUCT DECLARATIONS:
+size_t convertUtf16Name(const unsigned char *utf16, size_t units, char *out, size_t size);
+size_t appendUtf8(char *out, size_t used, size_t size, unsigned int codePoint);
+
+#endif
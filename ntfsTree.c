@@ -0,0 +1,435 @@
+/*
+ * ntfsTree.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: NTFS directory tree
+ * One pass over the $MFT keeps, per record number, the parent reference
+ * and an interned name. A path is resolved by climbing parent references
+ * until an ancestor whose path is already resolved, and each record
+ * climbed keeps the parent its path goes through, so every record is
+ * climbed once however many files sit below it. Paths are then written
+ * leaf first from the end of the caller's buffer.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "ntfsTree.h"
+#include "metadataIndex.h"
+#include "diskLayout.h"
+
+struct IndexWalk{
+	struct DiskImage *image;
+	struct NtfsVolume *ntfs;
+	struct NtfsExtentMap allocation; //THE $I30 $INDEX_ALLOCATION STREAM (EMPTY FOR A SMALL DIRECTORY)
+	unsigned char *bitmap; //THE $I30 $BITMAP, ONE BIT PER INDEX BLOCK IN USE (NULL IF THERE IS NONE)
+	uint64_t bitmapBytes;
+	unsigned char *visited; //ONE BIT PER INDEX BLOCK ALREADY WALKED
+	uint64_t blockCount;
+	unsigned int blockSize; //BYTES PER INDEX BLOCK
+	uint64_t vcnSize; //BYTES PER VCN IN A SUB-NODE REFERENCE
+	struct NtfsIndexEntry entry; //FILLED IN FOR EACH VISIT
+	int (*visit)(const struct NtfsIndexEntry *entry, void *context);
+	void *context;
+};
+
+static int addNtfsTreeNode(const struct MftRecord *record, void *context);
+static void resolveNtfsNode(struct NtfsTree *tree, uint64_t number);
+static int isNtfsParent(const struct NtfsTree *tree, const struct NtfsTreeNode *node);
+static void loadIndexBitmap(struct IndexWalk *walk, const struct MftRecord *record);
+static int walkIndexNode(struct IndexWalk *walk, const unsigned char *node, size_t length, int inAllocation, uint64_t vcn, int depth);
+static int walkIndexBlock(struct IndexWalk *walk, uint64_t vcn, int depth);
+
+
+/*
+ * Function:  buildNtfsTree 
+ * --------------------
+ * Reads the name and parent reference of every base record of the $MFT,
+ * from the metadata index when the model was loaded from one
+ * 
+ * model: The volume model
+ * tree: Filled in (released with freeNtfsTree)
+ * int: 0 on success, -1 if there is no NTFS volume, the $MFT could not be read or when out of memory
+ */
+int buildNtfsTree(struct VolumeModel *model, struct NtfsTree *tree){
+	int status;
+	memset(tree, 0, sizeof(*tree));
+	if(!model->ntfs.present){
+		return -1;
+	}
+	if(model->index != NULL){
+		status = scanIndexedMftRecords(model->index, NULL, 0, addNtfsTreeNode, tree);
+	}else{
+		status = scanMftRecords(model->image, &model->ntfs, 0, addNtfsTreeNode, tree);
+	}
+	if(status != 0){
+		freeNtfsTree(tree);
+		return -1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  resolveNtfsPath 
+ * --------------------
+ * Writes the full path of a record ("/" for the root directory)
+ * The path is built from the end of the buffer, so the returned pointer
+ * is usually past its start
+ * 
+ * tree: The directory tree
+ * number: Record number
+ * buffer: Buffer the path is written into
+ * size: Size of the buffer (NTFS_PATH_MAX holds any path)
+ * orphan: Set to 1 if the path is under NTFS_ORPHAN_DIRECTORY
+ * const char*: The path inside buffer, NULL if the record has no name or the path does not fit
+ */
+const char *resolveNtfsPath(struct NtfsTree *tree, uint64_t number, char *buffer, size_t size, int *orphan){
+	//DATA DECLARATION
+	char *cursor;
+	const char *name;
+	size_t length;
+	uint64_t current;
+	//DATA MANIPULATION
+	if(size < 2 || number >= tree->count || !(tree->nodes[number].flags & NTFS_NODE_NAMED)){
+		return NULL;
+	}
+	resolveNtfsNode(tree, number);
+	cursor = buffer + size - 1;
+	*cursor = '\0';
+	*orphan = 0;
+	for(current = number;current != NTFS_ROOT_RECORD && current != NTFS_PATH_ORPHAN;current = tree->nodes[current].pathParent){
+		name = fetchInternedString(&tree->names, tree->nodes[current].name);
+		length = strlen(name);
+		if((size_t)(cursor - buffer) < length + 1){
+			errno = ENAMETOOLONG;
+			return NULL;
+		}
+		cursor -= length;
+		memcpy(cursor, name, length);
+		*--cursor = '/';
+	}
+	if(current == NTFS_PATH_ORPHAN){
+		length = strlen(NTFS_ORPHAN_DIRECTORY);
+		if((size_t)(cursor - buffer) < length){
+			errno = ENAMETOOLONG;
+			return NULL;
+		}
+		cursor -= length;
+		memcpy(cursor, NTFS_ORPHAN_DIRECTORY, length);
+		*orphan = 1;
+	}else if(*cursor == '\0'){ //THE ROOT DIRECTORY ITSELF
+		*--cursor = '/';
+	}
+	return cursor;
+}
+
+
+/*
+ * Function:  freeNtfsTree 
+ * --------------------
+ * Releases the nodes and names of a tree
+ * 
+ * tree: The directory tree
+ */
+void freeNtfsTree(struct NtfsTree *tree){
+	free(tree->nodes);
+	freeStringTable(&tree->names);
+	memset(tree, 0, sizeof(*tree));
+}
+
+
+/*
+ * Function:  walkNtfsIndex 
+ * --------------------
+ * Visits the entries of a directory's $I30 index in collation (name) order
+ * The B-tree is walked from $INDEX_ROOT down into the $INDEX_ALLOCATION
+ * blocks its entries point to. Blocks the $BITMAP marks as free, blocks
+ * already walked and references past the end of the stream are skipped.
+ * DOS 8.3 entries are skipped, the long name entry of the same file is visited
+ * 
+ * image: The open disk image
+ * ntfs: The NTFS volume of the volume model
+ * number: Record number of the directory
+ * visit: Called for each entry, a non zero return stops the walk
+ * context: Passed through to visit
+ * int: 0 when the walk finished, the non zero value returned by visit,
+ *      -1 if the record could not be read or has no $I30 index (errno ENOTDIR)
+ */
+int walkNtfsIndex(struct DiskImage *image, struct NtfsVolume *ntfs, uint64_t number, int (*visit)(const struct NtfsIndexEntry *entry, void *context), void *context){
+	//DATA DECLARATION
+	struct IndexWalk walk;
+	const struct MftAttribute *root;
+	struct MftRecord *record;
+	unsigned char *buffer;
+	int status = -1;
+	//DATA MANIPULATION
+	if(!ntfs->present){
+		return -1;
+	}
+	memset(&walk, 0, sizeof(walk));
+	walk.image = image;
+	walk.ntfs = ntfs;
+	walk.visit = visit;
+	walk.context = context;
+	walk.entry.directory = number;
+	buffer = malloc((size_t)ntfs->mftRecordSize);
+	record = malloc(sizeof(*record));
+	if(buffer != NULL && record != NULL && fetchMftRecord(image, ntfs, number, buffer, record) == 0){
+		root = findMftAttribute(record, 0x90, "$I30");
+		if(root == NULL || root->nonResident || root->content == NULL || root->contentLength < 0x20){
+			errno = ENOTDIR;
+		}else{
+			walk.blockSize = readLe32(root->content + NTFS_INDEX_ROOT_BLOCK_SIZE); //BYTES PER INDEX BLOCK
+			walk.vcnSize = (walk.blockSize >= (unsigned int)ntfs->clusterSize) ? (uint64_t)ntfs->clusterSize : 512; //SMALL BLOCKS ARE ADDRESSED IN 512 BYTE UNITS
+			if(walk.blockSize >= 512 && walk.blockSize <= NTFS_INDEX_BLOCK_MAX && buildListedExtentMap(image, ntfs, record, 0xA0, "$I30", &walk.allocation) == 0 && walk.allocation.resident == NULL){
+				walk.blockCount = walk.allocation.dataSize/walk.blockSize;
+				walk.visited = calloc((size_t)(walk.blockCount/8 + 1), 1);
+				loadIndexBitmap(&walk, record);
+			}
+			status = walkIndexNode(&walk, root->content + NTFS_INDEX_ROOT_NODE, root->contentLength - NTFS_INDEX_ROOT_NODE, 0, 0, 0); //THE NODE HEADER FOLLOWS THE 16 BYTE ROOT HEADER
+		}
+	}
+	freeExtentMap(&walk.allocation);
+	free(walk.bitmap);
+	free(walk.visited);
+	free(buffer);
+	free(record);
+	return status;
+}
+
+
+/*
+ * Function:  addNtfsTreeNode 
+ * --------------------
+ * scanMftRecords visitor keeping the name and parent of a base record
+ * 
+ * record: The decoded record
+ * context: The NtfsTree
+ * int: 0, or -1 when out of memory (stops the scan)
+ */
+static int addNtfsTreeNode(const struct MftRecord *record, void *context){
+	//DATA DECLARATION
+	struct NtfsTree *tree = context;
+	struct NtfsTreeNode *node, *grown;
+	size_t capacity;
+	//DATA MANIPULATION
+	if(record->baseRecord != 0 || !record->hasFileName){
+		return 0;
+	}
+	if(record->number >= tree->capacity){ //RECORDS ARRIVE IN NUMBER ORDER SO THIS GROWS GEOMETRICALLY
+		capacity = tree->capacity ? tree->capacity*2 : 1024;
+		while(record->number >= capacity){
+			capacity *= 2;
+		}
+		grown = realloc(tree->nodes, capacity*sizeof(*grown));
+		if(grown == NULL){
+			return -1;
+		}
+		memset(grown + tree->capacity, 0, (capacity - tree->capacity)*sizeof(*grown));
+		tree->nodes = grown;
+		tree->capacity = capacity;
+	}
+	node = &tree->nodes[record->number];
+	if(internString(&tree->names, record->fileName.name, strlen(record->fileName.name), &node->name) != 0){
+		return -1;
+	}
+	node->parent = record->fileName.parentRecord;
+	node->pathParent = NTFS_PATH_UNRESOLVED;
+	node->sequence = record->sequence;
+	node->parentSequence = record->fileName.parentSequence;
+	node->flags = NTFS_NODE_NAMED | (record->inUse ? NTFS_NODE_IN_USE : 0) | (record->isDirectory ? NTFS_NODE_DIRECTORY : 0);
+	if(record->number >= tree->count){
+		tree->count = (size_t)record->number + 1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  resolveNtfsNode 
+ * --------------------
+ * Resolves the parent the path of a record goes through, and that of each
+ * unresolved ancestor on the way up. The climb stops at the first ancestor
+ * already resolved, at the root, or at a record whose parent is not a
+ * valid directory, which becomes an orphan (as does a directory that
+ * names itself as its parent)
+ * 
+ * tree: The directory tree
+ * number: Record number of a named record
+ */
+static void resolveNtfsNode(struct NtfsTree *tree, uint64_t number){
+	//DATA DECLARATION
+	struct NtfsTreeNode *node;
+	uint64_t current;
+	//DATA MANIPULATION
+	for(current = number;tree->nodes[current].pathParent == NTFS_PATH_UNRESOLVED;current = node->parent){
+		node = &tree->nodes[current];
+		if(current == NTFS_ROOT_RECORD){
+			node->pathParent = NTFS_PATH_TOP;
+			break;
+		}
+		if(!isNtfsParent(tree, node)){
+			node->flags &= (unsigned char)~NTFS_NODE_RESOLVING; //A DIRECTORY NAMING ITSELF AS PARENT IS ALREADY ON THE CHAIN, IT STAYS AN ORPHAN
+			node->pathParent = NTFS_PATH_ORPHAN;
+			tree->orphans++;
+			break;
+		}
+		node->flags |= NTFS_NODE_RESOLVING;
+	}
+	for(current = number;tree->nodes[current].flags & NTFS_NODE_RESOLVING;current = tree->nodes[current].parent){ //THE CLIMB ENDED ON A RESOLVED RECORD, SO EVERY RECORD BELOW IT IS TOO
+		tree->nodes[current].flags &= (unsigned char)~NTFS_NODE_RESOLVING;
+		tree->nodes[current].pathParent = tree->nodes[current].parent;
+	}
+}
+
+
+/*
+ * Function:  isNtfsParent 
+ * --------------------
+ * Checks that the parent reference of a record still leads to its directory
+ * The parent must be a named directory record with the sequence number
+ * given in the reference (one more if the directory was deleted since,
+ * deletion increments it), and not on the chain being resolved (a loop)
+ * 
+ * tree: The directory tree
+ * node: The record whose parent is checked
+ * int: 1 if the parent is valid
+ */
+static int isNtfsParent(const struct NtfsTree *tree, const struct NtfsTreeNode *node){
+	const struct NtfsTreeNode *parent;
+	if(node->parent >= tree->count){
+		return 0;
+	}
+	parent = &tree->nodes[node->parent];
+	if(!(parent->flags & NTFS_NODE_NAMED) || !(parent->flags & NTFS_NODE_DIRECTORY) || (parent->flags & NTFS_NODE_RESOLVING)){
+		return 0;
+	}
+	return node->parentSequence == 0 || parent->sequence == node->parentSequence || (!(parent->flags & NTFS_NODE_IN_USE) && parent->sequence == (unsigned short)(node->parentSequence + 1));
+}
+
+
+/*
+ * Function:  loadIndexBitmap 
+ * --------------------
+ * Reads the $I30 $BITMAP of the directory (the walk then visits every block if there is none)
+ * 
+ * walk: The walk, with its allocation stream loaded
+ * record: The directory's record
+ */
+static void loadIndexBitmap(struct IndexWalk *walk, const struct MftRecord *record){
+	struct NtfsExtentMap map;
+	if(buildListedExtentMap(walk->image, walk->ntfs, record, 0xB0, "$I30", &map) != 0){
+		return;
+	}
+	walk->bitmapBytes = (map.dataSize < walk->blockCount/8 + 1) ? map.dataSize : walk->blockCount/8 + 1;
+	walk->bitmap = malloc((size_t)walk->bitmapBytes + 1);
+	if(walk->bitmap != NULL && readNtfsData(walk->image, walk->ntfs, &map, 0, walk->bitmap, (size_t)walk->bitmapBytes) != (long long int)walk->bitmapBytes){
+		free(walk->bitmap);
+		walk->bitmap = NULL;
+	}
+	freeExtentMap(&map);
+}
+
+
+/*
+ * Function:  walkIndexNode 
+ * --------------------
+ * Visits the entries of one index node, walking the sub-node of each
+ * entry before the entry itself so the entries come out in order
+ * Each entry: file reference (8), entry length (2), key length (2),
+ * flags (2: 1 sub-node, 2 last entry), then the $FILE_NAME key and,
+ * with a sub-node, the sub-node's VCN in its last 8 bytes
+ * 
+ * walk: The walk
+ * node: Index node header (in $INDEX_ROOT or an INDX block)
+ * length: Bytes available from node
+ * inAllocation: 1 for a node of an INDX block
+ * vcn: VCN of that block
+ * depth: Levels below $INDEX_ROOT
+ * int: 0 when the node was walked, the non zero value returned by visit, -1 on a read failure
+ */
+static int walkIndexNode(struct IndexWalk *walk, const unsigned char *node, size_t length, int inAllocation, uint64_t vcn, int depth){
+	//DATA DECLARATION
+	const unsigned char *entry;
+	size_t offset, end, entryLength, keyLength;
+	unsigned int flags;
+	int status = 0;
+	//DATA MANIPULATION
+	if(length < 0x10){
+		return 0;
+	}
+	offset = readLe32(node + NTFS_INDEX_NODE_ENTRIES_OFFSET); //OFFSET OF THE FIRST ENTRY FROM THE NODE HEADER
+	end = readLe32(node + NTFS_INDEX_NODE_ENTRIES_END); //END OF THE ENTRIES IN USE
+	if(end > length){
+		end = length;
+	}
+	for(;offset + 0x10 <= end && status == 0;offset += entryLength){
+		entry = node + offset;
+		entryLength = readLe16(entry + NTFS_INDEX_ENTRY_LENGTH);
+		keyLength = readLe16(entry + NTFS_INDEX_ENTRY_KEY_LENGTH);
+		flags = readLe16(entry + NTFS_INDEX_ENTRY_FLAGS);
+		if(entryLength < 0x10 || offset + entryLength > end){ //CORRUPT ENTRY, THE REST OF THE NODE CANNOT BE FOUND
+			break;
+		}
+		if((flags & 0x01) && entryLength >= 0x18){
+			status = walkIndexBlock(walk, readLe64(entry + entryLength - 8), depth + 1); //SUB-NODE VCN ENDS THE ENTRY
+		}
+		if(status != 0 || (flags & 0x02)){ //THE LAST ENTRY HOLDS NO KEY
+			break;
+		}
+		if(NTFS_INDEX_ENTRY_KEY + keyLength <= entryLength && decodeFileNameKey(entry + NTFS_INDEX_ENTRY_KEY, (unsigned int)keyLength, &walk->entry.fileName) == 0 && walk->entry.fileName.nameSpace != 2){
+			walk->entry.record = NTFS_REFERENCE_RECORD(readLe64(entry + NTFS_INDEX_ENTRY_REFERENCE));
+			walk->entry.sequence = NTFS_REFERENCE_SEQUENCE(readLe64(entry + NTFS_INDEX_ENTRY_REFERENCE));
+			walk->entry.inAllocation = inAllocation;
+			walk->entry.vcn = vcn;
+			status = walk->visit(&walk->entry, walk->context);
+		}
+	}
+	return status;
+}
+
+
+/*
+ * Function:  walkIndexBlock 
+ * --------------------
+ * Reads an INDX block of the $INDEX_ALLOCATION stream and walks its node
+ * 
+ * walk: The walk
+ * vcn: VCN of the block, as given by the entry pointing to it
+ * depth: Levels below $INDEX_ROOT
+ * int: 0 when the block was walked or skipped, the non zero value returned by visit, -1 on a read failure
+ */
+static int walkIndexBlock(struct IndexWalk *walk, uint64_t vcn, int depth){
+	//DATA DECLARATION
+	uint64_t offset = vcn*walk->vcnSize, block;
+	unsigned char *buffer;
+	int status = 0;
+	//DATA MANIPULATION
+	if(walk->visited == NULL || depth > NTFS_INDEX_MAX_DEPTH || offset % walk->blockSize != 0){
+		return 0;
+	}
+	block = offset/walk->blockSize;
+	if(block >= walk->blockCount || (walk->visited[block/8] & (1 << (block % 8)))){
+		return 0;
+	}
+	if(walk->bitmap != NULL && block/8 < walk->bitmapBytes && !(walk->bitmap[block/8] & (1 << (block % 8)))){ //FREE BLOCK, ITS ENTRIES ARE STALE
+		return 0;
+	}
+	walk->visited[block/8] |= (unsigned char)(1 << (block % 8));
+	buffer = malloc(walk->blockSize);
+	if(buffer == NULL || readNtfsData(walk->image, walk->ntfs, &walk->allocation, offset, buffer, walk->blockSize) != (long long int)walk->blockSize){
+		free(buffer);
+		return -1;
+	}
+	if(memcmp(buffer, "INDX", 4) == 0){
+		applyMftFixups(buffer, (int)walk->blockSize); //A TORN BLOCK IS STILL WALKED, ITS ENTRIES ARE BOUNDS CHECKED
+		status = walkIndexNode(walk, buffer + 0x18, walk->blockSize - 0x18, 1, vcn, depth); //THE NODE HEADER FOLLOWS THE 24 BYTE INDX HEADER
+	}
+	free(buffer);
+	return status;
+}
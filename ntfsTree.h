@@ -0,0 +1,72 @@
+/*
+ * ntfsTree.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: NTFS directory tree
+ * Rebuilds the full path of every $MFT record from the parent references
+ * of its $FILE_NAME, deleted records included. Records whose parent is
+ * gone (reused, not a directory, or part of a loop) are placed under
+ * /$OrphanFiles. Also walks the $I30 index of a directory
+ * ($INDEX_ROOT and its $INDEX_ALLOCATION blocks) to list it the way
+ * the file system itself does.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef NTFSTREE_H
+#define NTFSTREE_H
+
+//IMPORTED LIBRARIES
+#include <stddef.h>
+#include <stdint.h>
+#include "diskImage.h"
+#include "volumeModel.h"
+#include "ntfsVolume.h"
+#include "stringTable.h"
+
+#define NTFS_ROOT_RECORD 5 //RECORD OF THE ROOT DIRECTORY
+#define NTFS_ORPHAN_DIRECTORY "/$OrphanFiles" //VIRTUAL DIRECTORY HOLDING RECORDS WHOSE PARENT IS GONE
+#define NTFS_PATH_MAX 32768 //LONGEST PATH RESOLVED (NTFS ALLOWS ABOUT 32767 UTF-16 CHARACTERS)
+#define NTFS_NODE_NAMED 0x01 //NtfsTreeNode FLAGS: THE RECORD HAS A $FILE_NAME
+#define NTFS_NODE_IN_USE 0x02
+#define NTFS_NODE_DIRECTORY 0x04
+#define NTFS_NODE_RESOLVING 0x08 //ON THE CHAIN BEING RESOLVED (FINDS PARENT LOOPS)
+#define NTFS_PATH_UNRESOLVED UINT64_MAX //pathParent VALUES OTHER THAN A RECORD NUMBER
+#define NTFS_PATH_ORPHAN (UINT64_MAX - 1)
+#define NTFS_PATH_TOP (UINT64_MAX - 2) //THE ROOT DIRECTORY ITSELF
+#define NTFS_INDEX_MAX_DEPTH 32 //DEEPEST $I30 B-TREE WALKED (REAL ONES ARE A FEW LEVELS DEEP)
+#define NTFS_INDEX_BLOCK_MAX 65536 //LARGEST INDEX BLOCK SIZE ACCEPTED FROM $INDEX_ROOT (USUALLY 4096)
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct NtfsTreeNode{ //ONE PER MFT RECORD NUMBER
+	uint64_t parent; //PARENT RECORD NUMBER FROM THE PREFERRED $FILE_NAME
+	uint64_t name; //OFFSET OF THE FILE NAME IN THE TREE'S STRING TABLE
+	uint64_t pathParent; //PARENT THE PATH GOES THROUGH ONCE RESOLVED (A RECORD OR NTFS_PATH_ORPHAN)
+	unsigned short sequence; //SEQUENCE NUMBER OF THE RECORD
+	unsigned short parentSequence; //SEQUENCE NUMBER THE PARENT HAD WHEN THE NAME WAS WRITTEN
+	unsigned char flags; //NTFS_NODE_ FLAGS
+};
+
+struct NtfsTree{
+	struct NtfsTreeNode *nodes; //INDEXED BY RECORD NUMBER
+	size_t count, capacity;
+	struct StringTable names; //EACH DISTINCT PATH COMPONENT STORED ONCE
+	uint64_t orphans; //RECORDS RESOLVED UNDER NTFS_ORPHAN_DIRECTORY SO FAR
+};
+
+struct NtfsIndexEntry{
+	uint64_t directory; //RECORD OF THE DIRECTORY THE INDEX BELONGS TO
+	uint64_t record; //RECORD THE ENTRY POINTS TO
+	unsigned short sequence; //SEQUENCE NUMBER IN THE ENTRY'S FILE REFERENCE
+	int inAllocation; //0 FOR AN ENTRY OF $INDEX_ROOT, 1 FOR ONE IN AN $INDEX_ALLOCATION BLOCK
+	uint64_t vcn; //VCN OF THE INDEX BLOCK HOLDING THE ENTRY (0 IN $INDEX_ROOT)
+	struct MftFileName fileName; //THE ENTRY'S KEY, A COPY OF THE FILE'S $FILE_NAME
+};
+
+int buildNtfsTree(struct VolumeModel *model, struct NtfsTree *tree);
+const char *resolveNtfsPath(struct NtfsTree *tree, uint64_t number, char *buffer, size_t size, int *orphan);
+void freeNtfsTree(struct NtfsTree *tree);
+int walkNtfsIndex(struct DiskImage *image, struct NtfsVolume *ntfs, uint64_t number, int (*visit)(const struct NtfsIndexEntry *entry, void *context), void *context);
+
+#endif
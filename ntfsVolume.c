@@ -0,0 +1,1296 @@
+/*
+ * ntfsVolume.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: NTFS $MFT record parsing
+ * Decodes MFT file records and streams the whole $MFT.
+ * The $MFT is read in large sequential batches and the records of a batch
+ * are parsed in parallel on the work pool while the next batch is read.
+ * Non-resident streams (the $MFT included) are read through extent maps
+ * decoded from their runlists.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "ntfsVolume.h"
+#include "nameConvert.h"
+#include "diskLayout.h"
+#include "workPool.h"
+
+#define MFT_BATCH_BYTES (4*1024*1024) //BYTES OF $MFT READ PER BATCH
+#define MFT_TASK_RECORDS 256 //RECORDS PARSED PER POOL TASK
+
+struct MftBatch{
+	unsigned char *buffer; //COPY OF THE BATCH (FIXUPS ARE APPLIED IN PLACE)
+	struct MftRecord *records; //PARSED RECORDS OF THE BATCH
+	int *valid; //1 FOR EACH RECORD WITH A VALID "FILE" SIGNATURE
+	uint64_t firstNumber; //RECORD NUMBER OF THE FIRST RECORD IN THE BATCH
+	size_t count; //RECORDS IN THE BATCH
+	int recordSize;
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+	size_t tasksLeft; //TASKS OF THIS BATCH STILL RUNNING
+};
+
+struct MftTask{
+	struct MftBatch *batch;
+	size_t first, count; //RANGE OF RECORDS IN THE BATCH PARSED BY THIS TASK
+};
+
+static void decodeMftAttribute(const unsigned char *header, unsigned int length, struct MftAttribute *attribute);
+static void decodeStandardInfo(const struct MftAttribute *attribute, struct MftRecord *record);
+static void decodeFileName(const struct MftAttribute *attribute, struct MftRecord *record);
+static int isMftAttributeNamed(const struct MftAttribute *attribute, const char *name);
+static int isUtf16Named(const unsigned char *utf16, size_t units, const char *name);
+static unsigned char *loadAttributeList(struct DiskImage *image, struct NtfsVolume *ntfs, const struct MftRecord *record, size_t *length);
+static int appendNtfsRun(struct NtfsExtentMap *map, uint64_t vcn, uint64_t lcn, uint64_t length);
+static int compareNtfsRuns(const void *a, const void *b);
+static uint64_t fetchNtfsClusterOffset(struct NtfsVolume *ntfs, uint64_t lcn);
+static int fillMftBatch(struct DiskImage *image, struct NtfsVolume *ntfs, struct MftBatch *batch, uint64_t firstNumber, size_t count);
+static int submitMftBatch(struct WorkPool *pool, struct MftBatch *batch, struct MftTask *tasks);
+static void waitMftBatch(struct MftBatch *batch);
+static void parseMftTask(void *arg);
+
+
+/*
+ * Function:  parseMftRecord 
+ * --------------------
+ * Applies the update sequence fixups to a record and decodes its header
+ * and every attribute header. $STANDARD_INFORMATION, $FILE_NAME and the
+ * size of the unnamed $DATA stream are decoded into the record as well
+ * 
+ * buffer: One MFT record (modified in place by the fixups)
+ * recordSize: Size of the record in bytes
+ * number: Record number of this record
+ * record: Filled in with the decoded record
+ * int: 0 for a valid record, -1 if the record has no "FILE" signature
+ */
+int parseMftRecord(unsigned char *buffer, int recordSize, uint64_t number, struct MftRecord *record){
+	int fixupError = (memcmp(buffer, "FILE", 4) == 0 && applyMftFixups(buffer, recordSize) != 0);
+	int status = decodeMftRecord(buffer, recordSize, number, record);
+	record->fixupError = fixupError;
+	return status;
+}
+
+
+/*
+ * Function:  decodeMftRecord 
+ * --------------------
+ * Decodes the header and attributes of a record whose fixups were already
+ * applied (or that was kept with them applied, as in the metadata index)
+ * 
+ * buffer: One MFT record with its fixups applied
+ * recordSize: Size of the record in bytes
+ * number: Record number of this record
+ * record: Filled in with the decoded record (fixupError is left unchanged)
+ * int: 0 for a valid record, -1 if the record has no "FILE" signature
+ */
+int decodeMftRecord(unsigned char *buffer, int recordSize, uint64_t number, struct MftRecord *record){
+	//DATA DECLARATION
+	unsigned int offset, length;
+	struct MftAttribute *attribute;
+	//DATA MANIPULATION
+	record->number = number;
+	record->attributeCount = 0;
+	record->attributesTruncated = 0;
+	record->hasStandardInfo = 0;
+	record->hasFileName = 0;
+	record->dataSize = 0;
+	record->data = buffer;
+	if(memcmp(buffer, "FILE", 4) != 0){ //UNUSED OR NEVER WRITTEN RECORD
+		return -1;
+	}
+	record->sequence = readLe16(buffer + MFT_RECORD_SEQUENCE); //SEQUENCE NUMBER
+	record->linkCount = readLe16(buffer + MFT_RECORD_LINK_COUNT); //HARD LINK COUNT
+	record->flags = readLe16(buffer + MFT_RECORD_FLAGS); //IN USE / DIRECTORY FLAGS
+	record->inUse = (record->flags & 0x01) != 0;
+	record->isDirectory = (record->flags & 0x02) != 0;
+	record->usedSize = readLe32(buffer + MFT_RECORD_USED_SIZE); //USED SIZE OF THE RECORD
+	record->baseRecord = NTFS_REFERENCE_RECORD(readLe64(buffer + MFT_RECORD_BASE_RECORD)); //BASE RECORD REFERENCE (LOW 48 BITS)
+	if(record->usedSize > (unsigned int)recordSize){
+		record->usedSize = (unsigned int)recordSize;
+	}
+	offset = readLe16(buffer + MFT_RECORD_ATTRIBUTE_OFFSET); //OFFSET OF THE FIRST ATTRIBUTE
+	while(offset + 8 <= record->usedSize){ //WALK THE ATTRIBUTE HEADERS
+		if(readLe32(buffer + offset + MFT_ATTR_TYPE) == 0xFFFFFFFF){ //END OF ATTRIBUTES MARKER
+			break;
+		}
+		length = readLe32(buffer + offset + MFT_ATTR_LENGTH); //ATTRIBUTE LENGTH
+		if(length < 0x18 || offset + length > record->usedSize){ //CORRUPT HEADER, STOP RATHER THAN READ PAST THE RECORD
+			break;
+		}
+		if(record->attributeCount == MFT_MAX_ATTRIBUTES){
+			record->attributesTruncated = 1;
+			break;
+		}
+		attribute = &record->attributes[record->attributeCount++];
+		decodeMftAttribute(buffer + offset, length, attribute);
+		if(attribute->type == 0x10 && !attribute->nonResident){
+			decodeStandardInfo(attribute, record);
+		}else if(attribute->type == 0x30 && !attribute->nonResident){
+			decodeFileName(attribute, record);
+		}else if(attribute->type == 0x80 && attribute->nameLength == 0 && attribute->startVcn == 0){ //UNNAMED $DATA STREAM
+			record->dataSize = attribute->realSize;
+		}
+		offset += length;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  fetchMftRecord 
+ * --------------------
+ * Reads and decodes a single MFT record by number
+ * The record is located through the extent map of the $MFT
+ * 
+ * image: The open disk image
+ * ntfs: The NTFS volume of the volume model
+ * number: Record number to read
+ * buffer: Buffer of at least mftRecordSize bytes the record is copied into
+ * record: Filled in with the decoded record
+ * int: 0 for a valid record, -1 if it could not be read or has no "FILE" signature
+ */
+int fetchMftRecord(struct DiskImage *image, struct NtfsVolume *ntfs, uint64_t number, unsigned char *buffer, struct MftRecord *record){
+	if(loadMftExtentMap(image, ntfs) != 0 || readNtfsData(image, ntfs, &ntfs->mftMap, number*ntfs->mftRecordSize, buffer, (size_t)ntfs->mftRecordSize) != ntfs->mftRecordSize){
+		return -1;
+	}
+	return parseMftRecord(buffer, ntfs->mftRecordSize, number, record);
+}
+
+
+/*
+ * Function:  scanMftRecords 
+ * --------------------
+ * Streams every record of the $MFT to a visitor in record number order
+ * The $MFT is read in MFT_BATCH_BYTES batches. While the pool parses one
+ * batch (MFT_TASK_RECORDS records per task) the next batch is read, and
+ * the previous batch is handed to the visitor
+ * Records without a "FILE" signature are skipped
+ * 
+ * image: The open disk image
+ * ntfs: The NTFS volume of the volume model
+ * threadCount: Number of parser threads, 0 for the volume's scanThreads
+ * visit: Called for each record, a non zero return stops the scan
+ * context: Passed through to visit
+ * int: 0 when the scan finished, the non zero value returned by visit, -1 on failure
+ */
+int scanMftRecords(struct DiskImage *image, struct NtfsVolume *ntfs, int threadCount, int (*visit)(const struct MftRecord *record, void *context), void *context){
+	//DATA DECLARATION
+	struct WorkPool *pool;
+	struct MftBatch batches[2];
+	struct MftTask *tasks[2] = {NULL, NULL};
+	uint64_t totalRecords, nextNumber = 0;
+	size_t batchRecords, taskCount, i, r;
+	int current = 0, status = 0, b, pending[2] = {0, 0};
+	//DATA MANIPULATION
+	if(!ntfs->present){
+		return 0;
+	}
+	if(loadMftExtentMap(image, ntfs) != 0){
+		return -1;
+	}
+	totalRecords = ntfs->mftMap.dataSize/ntfs->mftRecordSize;
+	batchRecords = MFT_BATCH_BYTES/ntfs->mftRecordSize;
+	taskCount = (batchRecords + MFT_TASK_RECORDS - 1)/MFT_TASK_RECORDS;
+	pool = createWorkPool(threadCount ? threadCount : ntfs->scanThreads);
+	if(pool == NULL){
+		return -1;
+	}
+	memset(batches, 0, sizeof(batches));
+	for(b=0;b<2;b++){ //TWO BATCHES: ONE BEING PARSED WHILE THE OTHER IS READ OR VISITED
+		batches[b].buffer = malloc(batchRecords*ntfs->mftRecordSize);
+		batches[b].records = malloc(batchRecords*sizeof(struct MftRecord));
+		batches[b].valid = malloc(batchRecords*sizeof(int));
+		batches[b].recordSize = ntfs->mftRecordSize;
+		tasks[b] = malloc(taskCount*sizeof(struct MftTask));
+		pthread_mutex_init(&batches[b].lock, NULL);
+		pthread_cond_init(&batches[b].done, NULL);
+		if(batches[b].buffer == NULL || batches[b].records == NULL || batches[b].valid == NULL || tasks[b] == NULL){
+			status = -1;
+		}
+	}
+	for(r=0;r<ntfs->mftMap.count;r++){ //EVERY RUN OF THE $MFT IS ABOUT TO BE READ IN ORDER
+		if(ntfs->mftMap.runs[r].lcn != NTFS_SPARSE_LCN){
+			adviseImageRange(image, fetchNtfsClusterOffset(ntfs, ntfs->mftMap.runs[r].lcn), ntfs->mftMap.runs[r].length*ntfs->clusterSize);
+		}
+	}
+	if(status == 0 && nextNumber < totalRecords){ //READ AND START PARSING THE FIRST BATCH
+		status = fillMftBatch(image, ntfs, &batches[current], nextNumber, (size_t)(totalRecords - nextNumber < batchRecords ? totalRecords - nextNumber : batchRecords));
+		nextNumber += batches[current].count;
+		if(status == 0){
+			status = submitMftBatch(pool, &batches[current], tasks[current]);
+			pending[current] = (status == 0);
+		}
+	}
+	while(status == 0 && pending[current]){
+		if(nextNumber < totalRecords){ //READ THE NEXT BATCH WHILE THIS ONE IS PARSED
+			status = fillMftBatch(image, ntfs, &batches[!current], nextNumber, (size_t)(totalRecords - nextNumber < batchRecords ? totalRecords - nextNumber : batchRecords));
+			nextNumber += batches[!current].count;
+			if(status == 0){
+				status = submitMftBatch(pool, &batches[!current], tasks[!current]);
+				pending[!current] = (status == 0);
+			}
+		}
+		waitMftBatch(&batches[current]);
+		pending[current] = 0;
+		for(i=0;i<batches[current].count && status == 0;i++){ //VISIT IN RECORD NUMBER ORDER
+			if(batches[current].valid[i]){
+				status = visit(&batches[current].records[i], context);
+			}
+		}
+		current = !current;
+	}
+	destroyWorkPool(pool); //WAITS FOR A BATCH STILL BEING PARSED IF THE SCAN STOPPED EARLY
+	for(b=0;b<2;b++){
+		pthread_mutex_destroy(&batches[b].lock);
+		pthread_cond_destroy(&batches[b].done);
+		free(batches[b].buffer);
+		free(batches[b].records);
+		free(batches[b].valid);
+		free(tasks[b]);
+	}
+	return status;
+}
+
+
+/*
+ * Function:  findMftAttribute 
+ * --------------------
+ * Finds the first attribute of a type (and optionally name) in a decoded record
+ * 
+ * record: The decoded record
+ * type: Attribute type code (0x80 for $DATA...)
+ * name: ASCII attribute name such as "$I30", NULL for the unnamed attribute
+ * const struct MftAttribute*: The attribute, NULL if the record has none
+ */
+const struct MftAttribute *findMftAttribute(const struct MftRecord *record, unsigned int type, const char *name){
+	int i;
+	for(i=0;i<record->attributeCount;i++){
+		if(record->attributes[i].type == type && isMftAttributeNamed(&record->attributes[i], name)){
+			return &record->attributes[i];
+		}
+	}
+	return NULL;
+}
+
+
+/*
+ * Function:  isMftAttributeNamed 
+ * --------------------
+ * Compares the UTF-16LE name of an attribute with an ASCII name
+ * 
+ * attribute: The decoded attribute
+ * name: ASCII attribute name, NULL for the unnamed attribute
+ * int: 1 if the names match
+ */
+static int isMftAttributeNamed(const struct MftAttribute *attribute, const char *name){
+	return isUtf16Named(attribute->name, attribute->nameLength, name);
+}
+
+
+/*
+ * Function:  isUtf16Named 
+ * --------------------
+ * Compares a UTF-16LE name with an ASCII name
+ * 
+ * utf16: The UTF-16LE name
+ * units: Length of the name in UTF-16 characters
+ * name: ASCII name, NULL for an empty name
+ * int: 1 if the names match
+ */
+static int isUtf16Named(const unsigned char *utf16, size_t units, const char *name){
+	size_t j, nameLength = (name == NULL) ? 0 : strlen(name);
+	if(units != nameLength){
+		return 0;
+	}
+	for(j=0;j<nameLength;j++){
+		if(utf16[2*j] != (unsigned char)name[j] || utf16[2*j+1] != 0){
+			return 0;
+		}
+	}
+	return 1;
+}
+
+
+/*
+ * Function:  decodeDataRuns 
+ * --------------------
+ * Decodes the runlist of a non-resident attribute into an extent map
+ * Each run starts with a header byte: the low nibble is the size of the
+ * run length field and the high nibble the size of the signed LCN offset
+ * (relative to the previous run). An offset size of 0 is a sparse run
+ * Runs are appended, so the fragments of a stream split over several
+ * attributes can be decoded into the same map
+ * 
+ * attribute: The non-resident attribute
+ * map: The extent map the runs are appended to
+ * int: 0 on success, -1 on a malformed runlist or when out of memory
+ */
+int decodeDataRuns(const struct MftAttribute *attribute, struct NtfsExtentMap *map){
+	//DATA DECLARATION
+	const unsigned char *runlist = attribute->content;
+	unsigned int position = 0, lengthSize, offsetSize, i;
+	uint64_t vcn = attribute->startVcn, length;
+	int64_t lcn = 0, delta;
+	//DATA MANIPULATION
+	if(!attribute->nonResident || runlist == NULL){
+		return -1;
+	}
+	while(position < attribute->contentLength && runlist[position] != 0){ //A ZERO HEADER ENDS THE RUNLIST
+		lengthSize = runlist[position] & 0x0F;
+		offsetSize = runlist[position] >> 4;
+		position++;
+		if(lengthSize == 0 || lengthSize > 8 || offsetSize > 8 || position + lengthSize + offsetSize > attribute->contentLength){
+			return -1;
+		}
+		length = 0;
+		for(i=0;i<lengthSize;i++){ //UNSIGNED LITTLE ENDIAN RUN LENGTH
+			length |= (uint64_t)runlist[position + i] << (8*i);
+		}
+		position += lengthSize;
+		if(offsetSize == 0){ //SPARSE RUN
+			if(appendNtfsRun(map, vcn, NTFS_SPARSE_LCN, length) != 0){
+				return -1;
+			}
+		}else{
+			delta = (runlist[position + offsetSize - 1] & 0x80) ? -1 : 0; //SIGN EXTEND THE RELATIVE OFFSET
+			for(i=0;i<offsetSize;i++){
+				delta = (int64_t)(((uint64_t)delta << 8) | runlist[position + offsetSize - 1 - i]);
+			}
+			lcn += delta;
+			if(lcn < 0 || appendNtfsRun(map, vcn, (uint64_t)lcn, length) != 0){
+				return -1;
+			}
+		}
+		position += offsetSize;
+		vcn += length;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  buildExtentMap 
+ * --------------------
+ * Builds the extent map of the unnamed $DATA stream of a record
+ * 
+ * record: The decoded record
+ * map: The map to build (released with freeExtentMap)
+ * int: 0 on success, -1 if the record has no usable $DATA stream
+ */
+int buildExtentMap(const struct MftRecord *record, struct NtfsExtentMap *map){
+	return buildStreamExtentMap(record, 0x80, NULL, map);
+}
+
+
+/*
+ * Function:  buildStreamExtentMap 
+ * --------------------
+ * Builds the extent map of any stream of a record, such as the $I30
+ * $INDEX_ALLOCATION of a directory
+ * A resident stream is copied into the map, a non-resident stream has
+ * the runlists of all its attribute fragments decoded and sorted by VCN
+ * 
+ * record: The decoded record
+ * type: Attribute type code of the stream
+ * name: ASCII stream name, NULL for the unnamed stream
+ * map: The map to build (released with freeExtentMap)
+ * int: 0 on success, -1 if the record has no usable stream of that type and name
+ */
+int buildStreamExtentMap(const struct MftRecord *record, unsigned int type, const char *name, struct NtfsExtentMap *map){
+	//DATA DECLARATION
+	const struct MftAttribute *attribute;
+	int i, found = 0;
+	//DATA MANIPULATION
+	memset(map, 0, sizeof(*map));
+	map->recordNumber = record->number;
+	for(i=0;i<record->attributeCount;i++){
+		attribute = &record->attributes[i];
+		if(attribute->type != type || !isMftAttributeNamed(attribute, name)){
+			continue;
+		}
+		if(!attribute->nonResident){
+			map->resident = malloc(attribute->contentLength ? attribute->contentLength : 1);
+			if(map->resident == NULL || attribute->content == NULL){
+				freeExtentMap(map);
+				return -1;
+			}
+			memcpy(map->resident, attribute->content, attribute->contentLength);
+			map->dataSize = map->initializedSize = attribute->contentLength;
+			map->loaded = 1;
+			return 0;
+		}
+		if(decodeDataRuns(attribute, map) != 0){
+			freeExtentMap(map);
+			return -1;
+		}
+		if(attribute->startVcn == 0){ //THE FIRST FRAGMENT HOLDS THE SIZES
+			map->dataSize = attribute->realSize;
+			map->initializedSize = attribute->initializedSize;
+		}
+		found = 1;
+	}
+	if(!found){
+		return -1;
+	}
+	qsort(map->runs, map->count, sizeof(struct NtfsRun), compareNtfsRuns); //FRAGMENTS MAY BE STORED OUT OF ORDER
+	map->loaded = 1;
+	return 0;
+}
+
+
+/*
+ * Function:  buildListedExtentMap 
+ * --------------------
+ * Builds the extent map of a stream whose runlist may continue in
+ * extension records, as the $MFT of a heavily fragmented volume does
+ * The fragments in the record itself are decoded first, then every
+ * $ATTRIBUTE_LIST entry of the stream naming another record has that
+ * record read and its fragments merged in by starting VCN
+ * Extension records are read through the $MFT map, or through the map
+ * being built when it is the $MFT's own (its first fragment always
+ * holds the extension records). A record that cannot be read or no
+ * longer belongs to this file is skipped and its clusters stay a hole
+ * 
+ * image: The open disk image
+ * ntfs: The NTFS volume of the volume model
+ * record: The decoded base record
+ * type: Attribute type code of the stream
+ * name: ASCII stream name, NULL for the unnamed stream
+ * map: The map to build (released with freeExtentMap)
+ * int: 0 on success, -1 if the stream is missing, malformed or when out of memory
+ */
+int buildListedExtentMap(struct DiskImage *image, struct NtfsVolume *ntfs, const struct MftRecord *record, unsigned int type, const char *name, struct NtfsExtentMap *map){
+	//DATA DECLARATION
+	const struct NtfsExtentMap *records = map; //MAP THE EXTENSION RECORDS ARE READ THROUGH
+	const struct MftAttribute *attribute;
+	const unsigned char *entry;
+	unsigned char *list, *buffer;
+	struct MftRecord *extension;
+	uint64_t *merged = NULL, *grown, number;
+	size_t listLength = 0, position, entryLength, mergedCount = 0, m;
+	unsigned int nameOffset, nameUnits;
+	int a, found, status;
+	//DATA MANIPULATION
+	status = buildStreamExtentMap(record, type, name, map);
+	if(findMftAttribute(record, 0x20, NULL) == NULL || (status == 0 && map->resident != NULL)){ //EVERY FRAGMENT IS IN THIS RECORD
+		return status;
+	}
+	found = (status == 0);
+	if(!found){ //THE STREAM MAY LIVE ENTIRELY IN EXTENSION RECORDS
+		memset(map, 0, sizeof(*map));
+		map->recordNumber = record->number;
+	}
+	if(!(record->number == 0 && type == 0x80 && name == NULL)){
+		if(loadMftExtentMap(image, ntfs) != 0){
+			freeExtentMap(map);
+			return -1;
+		}
+		records = &ntfs->mftMap;
+	}
+	list = loadAttributeList(image, ntfs, record, &listLength);
+	buffer = malloc((size_t)ntfs->mftRecordSize);
+	extension = malloc(sizeof(*extension));
+	status = (list != NULL && buffer != NULL && extension != NULL) ? 0 : -1;
+	for(position = 0;status == 0 && position + ATTRLIST_MIN <= listLength;position += entryLength){
+		entry = list + position;
+		entryLength = readLe16(entry + ATTRLIST_LENGTH);
+		if(entryLength < ATTRLIST_MIN || position + entryLength > listLength){ //CORRUPT ENTRY, THE REST OF THE LIST CANNOT BE FOUND
+			break;
+		}
+		number = NTFS_REFERENCE_RECORD(readLe64(entry + ATTRLIST_REFERENCE));
+		nameOffset = entry[ATTRLIST_NAME_OFFSET];
+		nameUnits = entry[ATTRLIST_NAME_LENGTH];
+		if(readLe32(entry + ATTRLIST_TYPE) != type || number == record->number || nameOffset + nameUnits*2 > entryLength || !isUtf16Named(entry + nameOffset, nameUnits, name)){
+			continue;
+		}
+		for(m=0;m<mergedCount;m++){ //A RECORD HOLDING SEVERAL FRAGMENTS HAD THEM ALL MERGED THE FIRST TIME
+			if(merged[m] == number){
+				break;
+			}
+		}
+		if(m < mergedCount){
+			continue;
+		}
+		grown = realloc(merged, (mergedCount + 1)*sizeof(uint64_t));
+		if(grown == NULL){
+			status = -1;
+			break;
+		}
+		merged = grown;
+		merged[mergedCount++] = number;
+		if(readNtfsData(image, ntfs, records, number*ntfs->mftRecordSize, buffer, (size_t)ntfs->mftRecordSize) != ntfs->mftRecordSize
+			|| parseMftRecord(buffer, ntfs->mftRecordSize, number, extension) != 0 || extension->baseRecord != record->number){ //UNREADABLE OR REUSED BY ANOTHER FILE
+			continue;
+		}
+		for(a=0;a<extension->attributeCount && status == 0;a++){
+			attribute = &extension->attributes[a];
+			if(attribute->type != type || !attribute->nonResident || !isMftAttributeNamed(attribute, name)){
+				continue;
+			}
+			status = decodeDataRuns(attribute, map);
+			if(attribute->startVcn == 0){ //THE FIRST FRAGMENT HOLDS THE SIZES
+				map->dataSize = attribute->realSize;
+				map->initializedSize = attribute->initializedSize;
+			}
+			found = 1;
+		}
+		if(map->count > 1){
+			qsort(map->runs, map->count, sizeof(struct NtfsRun), compareNtfsRuns); //THE NEXT EXTENSION RECORD MAY BE READ THROUGH THIS MAP
+		}
+	}
+	free(list);
+	free(buffer);
+	free(extension);
+	free(merged);
+	if(status != 0 || !found){
+		freeExtentMap(map);
+		return -1;
+	}
+	map->loaded = 1;
+	return 0;
+}
+
+
+/*
+ * Function:  loadAttributeList 
+ * --------------------
+ * Copies the content of the $ATTRIBUTE_LIST of a record, which is
+ * resident in the record or, for a long list, stored in clusters
+ * 
+ * image: The open disk image
+ * ntfs: The NTFS volume of the volume model
+ * record: The decoded base record
+ * length: Set to the length of the list in bytes
+ * unsigned char*: The list (released with free), NULL if it could not be read
+ */
+static unsigned char *loadAttributeList(struct DiskImage *image, struct NtfsVolume *ntfs, const struct MftRecord *record, size_t *length){
+	//DATA DECLARATION
+	struct NtfsExtentMap map;
+	unsigned char *list;
+	//DATA MANIPULATION
+	if(buildStreamExtentMap(record, 0x20, NULL, &map) != 0 || map.dataSize > MFT_ATTRIBUTE_LIST_MAX){
+		freeExtentMap(&map);
+		return NULL;
+	}
+	*length = (size_t)map.dataSize;
+	if(map.resident != NULL){ //THE COPY ALREADY MADE FOR THE MAP IS KEPT
+		list = map.resident;
+		map.resident = NULL;
+	}else{
+		list = malloc(*length ? *length : 1);
+		if(list != NULL && readNtfsData(image, ntfs, &map, 0, list, *length) != (long long int)*length){
+			free(list);
+			list = NULL;
+		}
+	}
+	freeExtentMap(&map);
+	return list;
+}
+
+
+/*
+ * Function:  freeExtentMap 
+ * --------------------
+ * Releases the runs and resident content held by an extent map
+ * 
+ * map: The map to release
+ */
+void freeExtentMap(struct NtfsExtentMap *map){
+	free(map->runs);
+	free(map->resident);
+	memset(map, 0, sizeof(*map));
+}
+
+
+/*
+ * Function:  findNtfsRun 
+ * --------------------
+ * Binary search for the run holding a virtual cluster
+ * 
+ * map: The extent map
+ * vcn: Virtual cluster number within the stream
+ * const struct NtfsRun*: The run, NULL if the VCN is not mapped
+ */
+const struct NtfsRun *findNtfsRun(const struct NtfsExtentMap *map, uint64_t vcn){
+	size_t low = 0, high = map->count, middle;
+	while(low < high){
+		middle = low + (high - low)/2;
+		if(vcn < map->runs[middle].vcn){
+			high = middle;
+		}else if(vcn >= map->runs[middle].vcn + map->runs[middle].length){
+			low = middle + 1;
+		}else{
+			return &map->runs[middle];
+		}
+	}
+	return NULL;
+}
+
+
+/*
+ * Function:  fetchExtentMap 
+ * --------------------
+ * Returns the extent map of the unnamed $DATA stream of a record
+ * Maps are built on first use and kept in a direct mapped cache indexed
+ * by record number, so repeated reads of a file do not parse its record
+ * or decode its runlist again. Runlists continued in extension records
+ * are followed through the $ATTRIBUTE_LIST. Not thread safe: call from one thread
+ * 
+ * image: The open disk image
+ * ntfs: The NTFS volume of the volume model
+ * number: Record number of the file
+ * const struct NtfsExtentMap*: The map (valid until the slot is reused), NULL on failure
+ */
+const struct NtfsExtentMap *fetchExtentMap(struct DiskImage *image, struct NtfsVolume *ntfs, uint64_t number){
+	//DATA DECLARATION
+	struct NtfsExtentMap *slot;
+	unsigned char *buffer;
+	struct MftRecord *record;
+	int status = -1;
+	//DATA MANIPULATION
+	if(!ntfs->present){
+		return NULL;
+	}
+	if(ntfs->extentCache == NULL){
+		ntfs->extentCache = calloc(NTFS_EXTENT_CACHE_SLOTS, sizeof(struct NtfsExtentMap));
+		if(ntfs->extentCache == NULL){
+			return NULL;
+		}
+	}
+	slot = &ntfs->extentCache[number % NTFS_EXTENT_CACHE_SLOTS];
+	if(slot->loaded && slot->recordNumber == number){ //CACHE HIT
+		return slot;
+	}
+	freeExtentMap(slot); //EVICT WHATEVER MAP HELD THIS SLOT
+	buffer = malloc((size_t)ntfs->mftRecordSize);
+	record = malloc(sizeof(*record));
+	if(buffer != NULL && record != NULL && fetchMftRecord(image, ntfs, number, buffer, record) == 0){
+		status = buildListedExtentMap(image, ntfs, record, 0x80, NULL, slot);
+	}
+	free(buffer);
+	free(record);
+	return (status == 0) ? slot : NULL;
+}
+
+
+/*
+ * Function:  readNtfsData 
+ * --------------------
+ * Reads part of a stream through its extent map
+ * The run holding the offset is found by binary search, then each run
+ * is read with one ranged view. Sparse runs and the bytes between the
+ * initialized size and the end of the stream read as zeros
+ * 
+ * image: The open disk image
+ * ntfs: The NTFS volume of the volume model
+ * map: Extent map of the stream
+ * offset: Byte offset within the stream
+ * buffer: Buffer the bytes are copied into
+ * length: Number of bytes to read
+ * long long int: Bytes read (less than length at the end of the stream), -1 on failure
+ */
+long long int readNtfsData(struct DiskImage *image, struct NtfsVolume *ntfs, const struct NtfsExtentMap *map, uint64_t offset, unsigned char *buffer, size_t length){
+	//DATA DECLARATION
+	const struct NtfsRun *run;
+	const unsigned char *view;
+	uint64_t clusterSize = (uint64_t)ntfs->clusterSize, runOffset, chunk, vcn;
+	size_t done = 0, initialized = 0;
+	//DATA MANIPULATION
+	if(offset >= map->dataSize){
+		return 0;
+	}
+	if(length > map->dataSize - offset){ //CLIP TO THE END OF THE STREAM
+		length = (size_t)(map->dataSize - offset);
+	}
+	if(map->resident != NULL){
+		memcpy(buffer, map->resident + offset, length);
+		return (long long int)length;
+	}
+	if(offset < map->initializedSize){ //ONLY THE INITIALIZED PART IS READ FROM THE RUNS
+		initialized = (map->initializedSize - offset < length) ? (size_t)(map->initializedSize - offset) : length;
+	}
+	run = NULL;
+	while(done < initialized){
+		vcn = (offset + done)/clusterSize;
+		if(run == NULL || vcn < run->vcn || vcn >= run->vcn + run->length){ //RUNS MAY OVERLAP OR LEAVE GAPS, SO THE NEXT ONE IS LOOKED UP
+			run = findNtfsRun(map, vcn);
+			if(run == NULL){ //HOLE IN THE MAP
+				return -1;
+			}
+		}
+		runOffset = offset + done - run->vcn*clusterSize; //OFFSET WITHIN THE RUN, LESS THAN ITS LENGTH
+		chunk = run->length*clusterSize - runOffset;
+		if(chunk > initialized - done){
+			chunk = initialized - done;
+		}
+		if(run->lcn == NTFS_SPARSE_LCN){
+			memset(buffer + done, 0, (size_t)chunk);
+		}else{
+			view = fetchImageView(image, fetchNtfsClusterOffset(ntfs, run->lcn) + runOffset, (size_t)chunk, buffer + done);
+			if(view == NULL){
+				return -1;
+			}
+			if(view != buffer + done){
+				memcpy(buffer + done, view, (size_t)chunk);
+			}
+		}
+		done += (size_t)chunk;
+		run++; //USUALLY THE NEXT BYTES ARE IN THE NEXT RUN
+		if(run >= map->runs + map->count){
+			run = NULL;
+		}
+	}
+	memset(buffer + done, 0, length - done); //PAST THE INITIALIZED SIZE
+	return (long long int)length;
+}
+
+
+/*
+ * Function:  copyNtfsData 
+ * --------------------
+ * Writes a whole stream to an open file
+ * Allocated runs are copied in the kernel with copyImageExtents,
+ * sparse runs and the bytes past the initialized size are written as zeros
+ * 
+ * image: The open disk image
+ * ntfs: The NTFS volume of the volume model
+ * map: Extent map of the stream
+ * outFd: Descriptor of the output file
+ * int: 0 on success, -1 on failure (errno is set)
+ */
+int copyNtfsData(struct DiskImage *image, struct NtfsVolume *ntfs, const struct NtfsExtentMap *map, int outFd){
+	//DATA DECLARATION
+	static const unsigned char zeros[65536];
+	struct ImageExtent extent;
+	uint64_t clusterSize = (uint64_t)ntfs->clusterSize, remaining = map->dataSize, initialized = map->initializedSize, length, chunk;
+	size_t r;
+	ssize_t written;
+	//DATA MANIPULATION
+	if(map->resident != NULL){
+		return (write(outFd, map->resident, (size_t)map->dataSize) == (ssize_t)map->dataSize) ? 0 : -1;
+	}
+	for(r=0;r<map->count && remaining > 0;r++){
+		if(r > 0 && map->runs[r].vcn != map->runs[r-1].vcn + map->runs[r-1].length){ //HOLE IN THE MAP
+			errno = EINVAL;
+			return -1;
+		}
+		length = map->runs[r].length*clusterSize;
+		if(length > remaining){ //THE LAST CLUSTER IS ONLY PARTLY USED
+			length = remaining;
+		}
+		remaining -= length;
+		extent.length = (length < initialized) ? length : initialized;
+		initialized -= extent.length;
+		if(map->runs[r].lcn != NTFS_SPARSE_LCN && extent.length > 0){
+			extent.offset = fetchNtfsClusterOffset(ntfs, map->runs[r].lcn);
+			if(copyImageExtents(image, &extent, 1, outFd) != 0){
+				return -1;
+			}
+			length -= extent.length;
+		}
+		while(length > 0){ //SPARSE RUN OR PAST THE INITIALIZED SIZE
+			chunk = length < sizeof(zeros) ? length : sizeof(zeros);
+			written = write(outFd, zeros, (size_t)chunk);
+			if(written < 0 && errno == EINTR){
+				continue;
+			}
+			if(written <= 0){
+				return -1;
+			}
+			length -= (uint64_t)written;
+		}
+	}
+	if(remaining > 0){ //RUNLIST ENDS BEFORE THE STREAM DOES
+		errno = EINVAL;
+		return -1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  fetchMFTData 
+ * --------------------
+ * Function navigates to $MFT sector and 
+ * retrieves various $MFT attributes such as length and type.
+ * Loops for the attributeCount duration or until the end marker (0xFFFFFFFF).
+ * 
+ * attributeCount: The number of attributes data should be acquired for
+ * image: The open disk image with $MFT Data in it
+ * ntfs: The NTFS volume of the volume model
+ * attributes: Array of at least attributeCount entries to store the attributes in
+ * int: The number of attributes read
+ */
+int fetchMFTData(int attributeCount, struct DiskImage *image, struct NtfsVolume *ntfs, struct MftAttribute *attributes){
+	//DATA DECLARATION
+	unsigned char *buffer;
+	struct MftRecord *record;
+	int h = 0;
+	if(!ntfs->present){
+		return 0;
+	}
+	//DATA MANIPULATION
+	buffer = malloc((size_t)ntfs->mftRecordSize);
+	record = malloc(sizeof(*record));
+	if(buffer != NULL && record != NULL && fetchMftRecord(image, ntfs, 0, buffer, record) == 0){ //RECORD 0 IS THE $MFT ITSELF
+		for(h = 0;h<attributeCount && h<record->attributeCount;h++){ //LOOPS FOR THE VALUE OF THE PARAMETER
+			attributes[h] = record->attributes[h];
+			attributes[h].name = NULL; //POINTERS INTO THE RECORD BUFFER DO NOT OUTLIVE THIS CALL
+			attributes[h].content = NULL;
+		}
+	}
+	free(buffer);
+	free(record);
+	return h;
+}
+
+
+/*
+ * Function:  formatFileTime 
+ * --------------------
+ * Formats a Windows FILETIME (100ns intervals since 1601-01-01 UTC)
+ * as an ISO 8601 UTC timestamp keeping the full 100ns precision
+ * 
+ * fileTime: The FILETIME value
+ * buffer: Output buffer (at least 29 bytes)
+ * size: Size of the output buffer
+ */
+void formatFileTime(uint64_t fileTime, char *buffer, size_t size){
+	//DATA DECLARATION
+	const uint64_t epochDifference = 116444736000000000ULL; //100ns INTERVALS BETWEEN 1601 AND 1970
+	time_t seconds;
+	struct tm utc;
+	long long int signedTime = (long long int)(fileTime - epochDifference);
+	long long int fraction;
+	//DATA MANIPULATION
+	fraction = signedTime % 10000000;
+	if(fraction < 0){
+		fraction += 10000000;
+	}
+	seconds = (time_t)((signedTime - fraction)/10000000);
+	if(gmtime_r(&seconds, &utc) == NULL){
+		snprintf(buffer, size, "invalid");
+		return;
+	}
+	snprintf(buffer, size, "%04d-%02d-%02dT%02d:%02d:%02d.%07lldZ", utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, fraction);
+}
+
+
+/*
+ * Function:  applyMftFixups 
+ * --------------------
+ * Applies the update sequence array of a record (an MFT record or an INDX block)
+ * The last two bytes of every 512 byte stride were replaced on disk with
+ * the update sequence number, the original bytes are kept in the array
+ * The stride stays 512 bytes on volumes with larger sectors
+ * 
+ * buffer: The record
+ * recordSize: Size of the record in bytes
+ * int: 0 if every sector matched the update sequence number, -1 otherwise
+ */
+int applyMftFixups(unsigned char *buffer, int recordSize){
+	//DATA DECLARATION
+	unsigned int usaOffset = readLe16(buffer + MFT_RECORD_USA_OFFSET); //OFFSET OF THE UPDATE SEQUENCE ARRAY
+	unsigned int usaCount = readLe16(buffer + MFT_RECORD_USA_COUNT); //NUMBER OF ENTRIES (SEQUENCE NUMBER + 1 PER SECTOR)
+	unsigned int i, status = 0;
+	unsigned char *sectorEnd;
+	//DATA MANIPULATION
+	if(usaCount < 2 || usaOffset + usaCount*2 > (unsigned int)recordSize || (usaCount - 1)*MFT_FIXUP_STRIDE > (unsigned int)recordSize){
+		return -1;
+	}
+	for(i=1;i<usaCount;i++){
+		sectorEnd = buffer + i*MFT_FIXUP_STRIDE - 2;
+		if(sectorEnd[0] != buffer[usaOffset] || sectorEnd[1] != buffer[usaOffset+1]){ //SECTOR WAS NOT WRITTEN WITH THE REST OF THE RECORD
+			status = -1;
+		}
+		sectorEnd[0] = buffer[usaOffset + 2*i];
+		sectorEnd[1] = buffer[usaOffset + 2*i + 1];
+	}
+	return (int)status;
+}
+
+
+/*
+ * Function:  decodeMftAttribute 
+ * --------------------
+ * Decodes the common, resident and non-resident attribute header fields
+ * 
+ * header: Start of the attribute in the record
+ * length: Length of the attribute in bytes (already checked against the record)
+ * attribute: Filled in with the decoded header
+ */
+static void decodeMftAttribute(const unsigned char *header, unsigned int length, struct MftAttribute *attribute){
+	unsigned int nameOffset, contentOffset;
+	attribute->type = readLe32(header + MFT_ATTR_TYPE); //MFT ATTRIBUTE TYPE
+	attribute->length = length; //MFT ATTRIBUTE LENGTH
+	attribute->nonResident = header[MFT_ATTR_NON_RESIDENT];
+	attribute->nameLength = header[MFT_ATTR_NAME_LENGTH];
+	nameOffset = readLe16(header + MFT_ATTR_NAME_OFFSET);
+	attribute->flags = readLe16(header + MFT_ATTR_FLAGS);
+	attribute->id = readLe16(header + MFT_ATTR_ID);
+	attribute->name = (nameOffset + attribute->nameLength*2u <= length) ? header + nameOffset : NULL;
+	if(attribute->name == NULL){
+		attribute->nameLength = 0;
+	}
+	attribute->content = NULL;
+	attribute->contentLength = 0;
+	attribute->startVcn = attribute->lastVcn = 0;
+	attribute->allocatedSize = attribute->realSize = attribute->initializedSize = 0;
+	if(!attribute->nonResident){ //RESIDENT: CONTENT IS INSIDE THE RECORD
+		attribute->contentLength = readLe32(header + MFT_ATTR_CONTENT_LENGTH);
+		contentOffset = readLe16(header + MFT_ATTR_CONTENT_OFFSET);
+		if(contentOffset + attribute->contentLength <= length){
+			attribute->content = header + contentOffset;
+		}else{
+			attribute->contentLength = 0;
+		}
+		attribute->realSize = attribute->allocatedSize = attribute->initializedSize = attribute->contentLength;
+	}else if(length >= MFT_ATTR_NON_RESIDENT_MIN){ //NON-RESIDENT: CONTENT IS DESCRIBED BY A RUNLIST
+		attribute->startVcn = readLe64(header + MFT_ATTR_START_VCN);
+		attribute->lastVcn = readLe64(header + MFT_ATTR_LAST_VCN);
+		contentOffset = readLe16(header + MFT_ATTR_RUNLIST_OFFSET);
+		attribute->allocatedSize = readLe64(header + MFT_ATTR_ALLOCATED_SIZE);
+		attribute->realSize = readLe64(header + MFT_ATTR_REAL_SIZE);
+		attribute->initializedSize = readLe64(header + MFT_ATTR_INITIALIZED_SIZE);
+		if(contentOffset < length){
+			attribute->content = header + contentOffset;
+			attribute->contentLength = length - contentOffset;
+		}
+	}
+}
+
+
+/*
+ * Function:  decodeStandardInfo 
+ * --------------------
+ * Decodes the timestamps and file attribute flags of $STANDARD_INFORMATION
+ * 
+ * attribute: The resident $STANDARD_INFORMATION attribute
+ * record: Record the decoded values are stored in
+ */
+static void decodeStandardInfo(const struct MftAttribute *attribute, struct MftRecord *record){
+	const unsigned char *content = attribute->content;
+	if(content == NULL || attribute->contentLength < STDINFO_MIN){
+		return;
+	}
+	record->standardInfo.created = readLe64(content + STDINFO_CREATED);
+	record->standardInfo.modified = readLe64(content + STDINFO_MODIFIED);
+	record->standardInfo.mftModified = readLe64(content + STDINFO_MFT_MODIFIED);
+	record->standardInfo.accessed = readLe64(content + STDINFO_ACCESSED);
+	record->standardInfo.fileAttributes = readLe32(content + STDINFO_FILE_ATTRIBUTES);
+	record->hasStandardInfo = 1;
+}
+
+
+/*
+ * Function:  decodeFileName 
+ * --------------------
+ * Decodes a $FILE_NAME attribute into the record
+ * A record can hold several names (a DOS 8.3 name next to the long name,
+ * or hard links), the first non-DOS name is kept
+ * 
+ * attribute: The resident $FILE_NAME attribute
+ * record: Record the decoded values are stored in
+ */
+static void decodeFileName(const struct MftAttribute *attribute, struct MftRecord *record){
+	if(attribute->content == NULL || attribute->contentLength < FILENAME_NAME){
+		return;
+	}
+	if(record->hasFileName && (attribute->content[FILENAME_NAME_SPACE] == 2 || record->fileName.nameSpace != 2)){ //ONLY REPLACE A DOS NAME ALREADY KEPT
+		return;
+	}
+	if(decodeFileNameKey(attribute->content, attribute->contentLength, &record->fileName) == 0){
+		record->hasFileName = 1;
+	}
+}
+
+
+/*
+ * Function:  decodeFileNameKey 
+ * --------------------
+ * Decodes the content of a $FILE_NAME attribute, which is also the key
+ * of every entry of a directory's $I30 index
+ * 
+ * content: The $FILE_NAME content
+ * length: Bytes at content
+ * fileName: Filled in with the decoded values
+ * int: 0 on success, -1 if the content is too short for its name
+ */
+int decodeFileNameKey(const unsigned char *content, unsigned int length, struct MftFileName *fileName){
+	unsigned int nameUnits;
+	if(length < FILENAME_NAME){
+		return -1;
+	}
+	nameUnits = content[FILENAME_NAME_LENGTH];
+	if(FILENAME_NAME + nameUnits*2 > length){
+		return -1;
+	}
+	fileName->parentRecord = NTFS_REFERENCE_RECORD(readLe64(content + FILENAME_PARENT)); //PARENT REFERENCE: 48 BIT RECORD NUMBER
+	fileName->parentSequence = NTFS_REFERENCE_SEQUENCE(readLe64(content + FILENAME_PARENT)); //AND 16 BIT SEQUENCE NUMBER
+	fileName->created = readLe64(content + FILENAME_CREATED);
+	fileName->modified = readLe64(content + FILENAME_MODIFIED);
+	fileName->mftModified = readLe64(content + FILENAME_MFT_MODIFIED);
+	fileName->accessed = readLe64(content + FILENAME_ACCESSED);
+	fileName->allocatedSize = readLe64(content + FILENAME_ALLOCATED_SIZE);
+	fileName->realSize = readLe64(content + FILENAME_REAL_SIZE);
+	fileName->flags = readLe32(content + FILENAME_FLAGS);
+	fileName->nameSpace = content[FILENAME_NAME_SPACE];
+	convertUtf16Name(content + FILENAME_NAME, nameUnits, fileName->name, sizeof(fileName->name));
+	return 0;
+}
+
+
+/*
+ * Function:  fillMftBatch 
+ * --------------------
+ * Copies a batch of consecutive records into the batch buffer
+ * (fixups are applied in place so the mapped records cannot be used directly)
+ * 
+ * image: The open disk image
+ * ntfs: The NTFS volume with its $MFT extent map loaded
+ * batch: The batch to fill
+ * firstNumber: Number of the first record of the batch
+ * count: Number of records in the batch
+ * int: 0 on success, -1 if the records could not be read
+ */
+static int fillMftBatch(struct DiskImage *image, struct NtfsVolume *ntfs, struct MftBatch *batch, uint64_t firstNumber, size_t count){
+	size_t length = count*(size_t)batch->recordSize;
+	if(readNtfsData(image, ntfs, &ntfs->mftMap, firstNumber*batch->recordSize, batch->buffer, length) != (long long int)length){
+		return -1;
+	}
+	batch->firstNumber = firstNumber;
+	batch->count = count;
+	return 0;
+}
+
+
+/*
+ * Function:  submitMftBatch 
+ * --------------------
+ * Splits a batch into MFT_TASK_RECORDS sized tasks and submits them to the pool
+ * 
+ * pool: The work pool
+ * batch: The batch to parse
+ * tasks: Task array with room for every task of a batch
+ * int: 0 on success, -1 if a task could not be submitted
+ */
+static int submitMftBatch(struct WorkPool *pool, struct MftBatch *batch, struct MftTask *tasks){
+	size_t first, taskIndex = 0;
+	pthread_mutex_lock(&batch->lock);
+	batch->tasksLeft = (batch->count + MFT_TASK_RECORDS - 1)/MFT_TASK_RECORDS;
+	pthread_mutex_unlock(&batch->lock);
+	for(first = 0;first < batch->count;first += MFT_TASK_RECORDS){
+		tasks[taskIndex].batch = batch;
+		tasks[taskIndex].first = first;
+		tasks[taskIndex].count = (batch->count - first < MFT_TASK_RECORDS) ? batch->count - first : MFT_TASK_RECORDS;
+		if(submitWork(pool, parseMftTask, &tasks[taskIndex]) != 0){
+			waitWorkPool(pool);
+			return -1;
+		}
+		taskIndex++;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  waitMftBatch 
+ * --------------------
+ * Blocks until every task of a batch has finished
+ * 
+ * batch: The batch
+ */
+static void waitMftBatch(struct MftBatch *batch){
+	pthread_mutex_lock(&batch->lock);
+	while(batch->tasksLeft > 0){
+		pthread_cond_wait(&batch->done, &batch->lock);
+	}
+	pthread_mutex_unlock(&batch->lock);
+}
+
+
+/*
+ * Function:  parseMftTask 
+ * --------------------
+ * Pool task parsing a range of records of a batch
+ * 
+ * arg: The MftTask
+ */
+static void parseMftTask(void *arg){
+	struct MftTask *task = arg;
+	struct MftBatch *batch = task->batch;
+	size_t i;
+	for(i=task->first;i<task->first + task->count;i++){
+		batch->valid[i] = (parseMftRecord(batch->buffer + i*batch->recordSize, batch->recordSize, batch->firstNumber + i, &batch->records[i]) == 0);
+	}
+	pthread_mutex_lock(&batch->lock);
+	if(--batch->tasksLeft == 0){
+		pthread_cond_signal(&batch->done);
+	}
+	pthread_mutex_unlock(&batch->lock);
+}
+
+
+/*
+ * Function:  loadMftExtentMap 
+ * --------------------
+ * Builds the extent map of the $MFT on first use
+ * Record 0 (the $MFT itself) always lies in the first run, at the cluster
+ * given by the boot sector, so it is read directly to find the others
+ * Runlist fragments kept in extension records through its $ATTRIBUTE_LIST
+ * are merged in. If its runlist cannot be decoded the $MFT is treated as contiguous
+ * 
+ * image: The open disk image
+ * ntfs: The NTFS volume of the volume model
+ * int: 0 when the map is available, -1 on failure
+ */
+int loadMftExtentMap(struct DiskImage *image, struct NtfsVolume *ntfs){
+	//DATA DECLARATION
+	const unsigned char *view;
+	unsigned char *buffer;
+	struct MftRecord *record;
+	uint64_t recordSize = (uint64_t)ntfs->mftRecordSize, clusterSize = (uint64_t)ntfs->clusterSize;
+	//DATA MANIPULATION
+	if(ntfs->mftMap.loaded){
+		return 0;
+	}
+	if(clusterSize == 0){
+		return -1;
+	}
+	buffer = malloc((size_t)recordSize);
+	record = malloc(sizeof(*record));
+	if(buffer == NULL || record == NULL){
+		free(buffer);
+		free(record);
+		return -1;
+	}
+	view = fetchImageView(image, fetchNtfsClusterOffset(ntfs, (uint64_t)ntfs->mftCluster), (size_t)recordSize, buffer);
+	if(view != NULL && view != buffer){ //FIXUPS ARE APPLIED IN PLACE SO THE MAPPED RECORD IS COPIED
+		memcpy(buffer, view, (size_t)recordSize);
+	}
+	if(view == NULL || parseMftRecord(buffer, (int)recordSize, 0, record) != 0 || buildListedExtentMap(image, ntfs, record, 0x80, NULL, &ntfs->mftMap) != 0 || ntfs->mftMap.resident != NULL || ntfs->mftMap.dataSize < recordSize){
+		freeExtentMap(&ntfs->mftMap); //FALL BACK TO A CONTIGUOUS $MFT HOLDING RECORD 0 ONLY
+		if(appendNtfsRun(&ntfs->mftMap, 0, (uint64_t)ntfs->mftCluster, (recordSize + clusterSize - 1)/clusterSize) != 0){
+			free(buffer);
+			free(record);
+			return -1;
+		}
+		ntfs->mftMap.dataSize = ntfs->mftMap.initializedSize = recordSize;
+		ntfs->mftMap.loaded = 1;
+	}
+	free(buffer);
+	free(record);
+	return 0;
+}
+
+
+/*
+ * Function:  appendNtfsRun 
+ * --------------------
+ * Appends a run to an extent map, growing its array when full
+ * 
+ * map: The extent map
+ * vcn: First virtual cluster of the run
+ * lcn: First logical cluster of the run, NTFS_SPARSE_LCN if sparse
+ * length: Length of the run in clusters
+ * int: 0 on success, -1 when out of memory
+ */
+static int appendNtfsRun(struct NtfsExtentMap *map, uint64_t vcn, uint64_t lcn, uint64_t length){
+	struct NtfsRun *runs;
+	size_t capacity;
+	if(map->count == map->capacity){
+		capacity = map->capacity ? map->capacity*2 : 8;
+		runs = realloc(map->runs, capacity*sizeof(struct NtfsRun));
+		if(runs == NULL){
+			return -1;
+		}
+		map->runs = runs;
+		map->capacity = capacity;
+	}
+	map->runs[map->count].vcn = vcn;
+	map->runs[map->count].lcn = lcn;
+	map->runs[map->count].length = length;
+	map->count++;
+	return 0;
+}
+
+
+/*
+ * Function:  compareNtfsRuns 
+ * --------------------
+ * qsort comparison ordering runs by VCN
+ */
+static int compareNtfsRuns(const void *a, const void *b){
+	uint64_t first = ((const struct NtfsRun*)a)->vcn, second = ((const struct NtfsRun*)b)->vcn;
+	return (first > second) - (first < second);
+}
+
+
+/*
+ * Function:  fetchNtfsClusterOffset 
+ * --------------------
+ * Byte offset in the image of a logical cluster of the NTFS volume
+ * 
+ * ntfs: The NTFS volume
+ * lcn: Logical cluster number
+ * uint64_t: Byte offset of the cluster in the image
+ */
+static uint64_t fetchNtfsClusterOffset(struct NtfsVolume *ntfs, uint64_t lcn){
+	return (uint64_t)ntfs->sectorStart*SECTOR_SIZE + lcn*(uint64_t)ntfs->clusterSize;
+}
+
+
+/*
+ * Function:  fetchMFTAttribute 
+ * --------------------
+ * Names an attribute type with a constant lookup table indexed by the
+ * type code divided by 0x10, so no string is copied per attribute
+ *	
+ *	Key Code Descriptions for Attribute Types:
+ *	0x10 : STANDARD_INFORMATION
+ *	0x20 : ATTRIBUTE_LIST
+ *	0x30 : FILE_NAME
+ *	0x40 : OBJECT_ID
+ *	0x60 : VOLUME_NAME
+ *	0x70 : VOLUME_INFORMATION
+ *	0x80 : DATA
+ *	0x90 : INDEX_ROOT
+ *	0xA0 : INDEX_ALLOCATION
+ *	0xB0 : BITMAP
+ *	0xC0 : REPARSE_POINT
+ *
+ *  attributeType: The bytecode of the attribute type
+ *  const char*: The name of the attribute type (static storage)
+ * 	Source: https://docs.microsoft.com/en-us/windows/win32/devnotes/attribute-list-entry
+ */
+const char *fetchMFTAttribute(unsigned int attributeType){
+	static const char *const attributeTypes[] = { //INDEXED BY TYPE CODE / 0x10, UNLISTED TYPES ARE NULL
+		[0x1] = "$STANDARD_INFORMATION",
+		[0x2] = "$ATTRIBUTE_LIST",
+		[0x3] = "$FILE_NAME",
+		[0x4] = "$OBJECT_ID",
+		[0x6] = "$VOLUME_NAME",
+		[0x7] = "$VOLUME_INFORMATION",
+		[0x8] = "$DATA",
+		[0x9] = "$INDEX_ROOT",
+		[0xA] = "$INDEX_ALLOCATION",
+		[0xB] = "$BITMAP",
+		[0xC] = "$REPARSE_POINT",
+	};
+	const char *name = NULL;
+	if((attributeType & 0x0F) == 0 && (attributeType >> 4) < sizeof(attributeTypes)/sizeof(attributeTypes[0])){
+		name = attributeTypes[attributeType >> 4];
+	}
+	return (name != NULL) ? name : "NOT-RECOGNISED";
+}
@@ -0,0 +1,100 @@
+/*
+ * ntfsVolume.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: NTFS $MFT record parsing
+ * Decodes MFT file records (fixups, attribute headers, $STANDARD_INFORMATION
+ * and $FILE_NAME) and scans the whole $MFT in parallel.
+ * Runlists are decoded into extent maps that are built lazily per file,
+ * cached, and searched to read any offset of a stream.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef NTFSVOLUME_H
+#define NTFSVOLUME_H
+
+//IMPORTED LIBRARIES
+#include <stddef.h>
+#include <stdint.h>
+#include "diskImage.h"
+#include "volumeModel.h"
+
+#define MFT_MAX_ATTRIBUTES 24 //ATTRIBUTES DECODED PER RECORD (A 1 KiB RECORD RARELY HOLDS MORE)
+#define MFT_NAME_MAX 768 //255 UTF-16 CHARACTERS AS UTF-8
+#define MFT_ATTRIBUTE_LIST_MAX (256*1024) //LARGEST $ATTRIBUTE_LIST READ (REAL ONES ARE A FEW KiB)
+#define MFT_FIXUP_STRIDE 512 //UPDATE SEQUENCE STRIDE, 512 BYTES WHATEVER THE SECTOR SIZE (4Kn INCLUDED)
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct MftAttribute{
+	unsigned int type; //ATTRIBUTE TYPE CODE (0x10, 0x30, 0x80...)
+	unsigned int length; //LENGTH OF THE ATTRIBUTE IN BYTES
+	unsigned char nonResident; //1 IF THE CONTENT IS STORED IN CLUSTERS OUTSIDE THE RECORD
+	unsigned char nameLength; //LENGTH OF THE ATTRIBUTE NAME IN UTF-16 CHARACTERS
+	unsigned short flags; //COMPRESSED 0x0001, ENCRYPTED 0x4000, SPARSE 0x8000
+	unsigned short id;
+	const unsigned char *name; //UTF-16LE ATTRIBUTE NAME INSIDE THE RECORD (SUCH AS $I30)
+	const unsigned char *content; //RESIDENT CONTENT, OR THE RUNLIST OF A NON-RESIDENT ATTRIBUTE
+	unsigned int contentLength; //BYTES AT content
+	uint64_t startVcn, lastVcn; //VIRTUAL CLUSTERS COVERED (NON-RESIDENT ONLY)
+	uint64_t allocatedSize, realSize, initializedSize; //realSize IS THE CONTENT LENGTH WHEN RESIDENT
+};
+
+struct MftStandardInfo{
+	uint64_t created, modified, mftModified, accessed; //WINDOWS FILETIMES (100ns SINCE 1601)
+	unsigned int fileAttributes; //READ ONLY 0x01, HIDDEN 0x02, SYSTEM 0x04, ARCHIVE 0x20...
+};
+
+struct MftFileName{
+	uint64_t parentRecord; //MFT RECORD NUMBER OF THE PARENT DIRECTORY
+	unsigned short parentSequence; //SEQUENCE NUMBER THE PARENT HAD WHEN THE NAME WAS WRITTEN
+	uint64_t created, modified, mftModified, accessed; //WINDOWS FILETIMES (100ns SINCE 1601)
+	uint64_t allocatedSize, realSize;
+	unsigned int flags;
+	unsigned char nameSpace; //0 POSIX, 1 WIN32, 2 DOS, 3 WIN32 & DOS
+	char name[MFT_NAME_MAX]; //UTF-8 FILE NAME
+};
+
+struct MftRecord{
+	uint64_t number; //MFT RECORD NUMBER
+	unsigned short sequence; //SEQUENCE NUMBER (INCREMENTED EACH TIME THE RECORD IS REUSED)
+	unsigned short linkCount; //NUMBER OF HARD LINKS
+	unsigned short flags; //IN USE 0x01, DIRECTORY 0x02
+	int inUse, isDirectory;
+	uint64_t baseRecord; //BASE RECORD NUMBER OF AN EXTENSION RECORD (0 FOR A BASE RECORD)
+	unsigned int usedSize; //BYTES OF THE RECORD IN USE
+	int fixupError; //1 IF A SECTOR'S UPDATE SEQUENCE NUMBER DID NOT MATCH (TORN WRITE)
+	const unsigned char *data; //THE RECORD WITH FIXUPS APPLIED (ONLY VALID DURING A VISIT)
+	int attributeCount;
+	int attributesTruncated; //1 IF THE RECORD HELD MORE THAN MFT_MAX_ATTRIBUTES
+	struct MftAttribute attributes[MFT_MAX_ATTRIBUTES];
+	int hasStandardInfo;
+	struct MftStandardInfo standardInfo;
+	int hasFileName; //THE WIN32 (OR POSIX) NAME IS PREFERRED OVER THE DOS 8.3 NAME
+	struct MftFileName fileName;
+	uint64_t dataSize; //SIZE OF THE UNNAMED $DATA STREAM
+};
+
+int parseMftRecord(unsigned char *buffer, int recordSize, uint64_t number, struct MftRecord *record);
+int decodeMftRecord(unsigned char *buffer, int recordSize, uint64_t number, struct MftRecord *record);
+int applyMftFixups(unsigned char *buffer, int recordSize);
+int decodeFileNameKey(const unsigned char *content, unsigned int length, struct MftFileName *fileName);
+int fetchMftRecord(struct DiskImage *image, struct NtfsVolume *ntfs, uint64_t number, unsigned char *buffer, struct MftRecord *record);
+int scanMftRecords(struct DiskImage *image, struct NtfsVolume *ntfs, int threadCount, int (*visit)(const struct MftRecord *record, void *context), void *context);
+const struct MftAttribute *findMftAttribute(const struct MftRecord *record, unsigned int type, const char *name);
+int fetchMFTData(int attributeCount, struct DiskImage *image, struct NtfsVolume *ntfs, struct MftAttribute *attributes);
+const char *fetchMFTAttribute(unsigned int attributeType);
+void formatFileTime(uint64_t fileTime, char *buffer, size_t size);
+int decodeDataRuns(const struct MftAttribute *attribute, struct NtfsExtentMap *map);
+int buildExtentMap(const struct MftRecord *record, struct NtfsExtentMap *map);
+int buildStreamExtentMap(const struct MftRecord *record, unsigned int type, const char *name, struct NtfsExtentMap *map);
+int buildListedExtentMap(struct DiskImage *image, struct NtfsVolume *ntfs, const struct MftRecord *record, unsigned int type, const char *name, struct NtfsExtentMap *map);
+void freeExtentMap(struct NtfsExtentMap *map);
+const struct NtfsRun *findNtfsRun(const struct NtfsExtentMap *map, uint64_t vcn);
+int loadMftExtentMap(struct DiskImage *image, struct NtfsVolume *ntfs);
+const struct NtfsExtentMap *fetchExtentMap(struct DiskImage *image, struct NtfsVolume *ntfs, uint64_t number);
+long long int readNtfsData(struct DiskImage *image, struct NtfsVolume *ntfs, const struct NtfsExtentMap *map, uint64_t offset, unsigned char *buffer, size_t length);
+int copyNtfsData(struct DiskImage *image, struct NtfsVolume *ntfs, const struct NtfsExtentMap *map, int outFd);
+
+#endif
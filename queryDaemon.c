@@ -0,0 +1,606 @@
+/*
+ * queryDaemon.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Local query daemon
+ * The main thread accepts connections on the Unix socket and hands each one
+ * to the work pool, where a worker answers its requests in turn.
+ * Each image is opened and its volume model built by the first query naming it,
+ * then shared by every later query under a read-write lock: queries hold it
+ * shared, and the query that finds the image file changed (new size or
+ * modification time) takes it exclusively to reload the image.
+ * The lazily built parts of the model (the FAT, the $MFT and $Bitmap extent
+ * maps) are built at load time so the shared model is only read afterwards.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "queryDaemon.h"
+#include "scanCommands.h"
+#include "diskImage.h"
+#include "volumeModel.h"
+#include "fatVolume.h"
+#include "ntfsVolume.h"
+#include "metadataIndex.h"
+#include "jsonOutput.h"
+#include "scanStats.h"
+#include "workPool.h"
+
+struct ServedImage{
+	char path[INDEX_PATH_MAX]; //CANONICAL PATH THE IMAGE IS KNOWN BY
+	pthread_rwlock_t lock; //HELD SHARED BY QUERIES, EXCLUSIVE WHILE THE IMAGE IS (RE)LOADED
+	int loaded; //1 WHILE THE IMAGE AND ITS MODEL BELOW ARE OPEN
+	int shared; //1 IF THE PARTS OF THE MODEL BUILT ON FIRST USE WERE PRELOADED, 0 MAKES QUERIES TAKE THE LOCK EXCLUSIVELY
+	off_t size; //SIZE AND MODIFICATION TIME OF THE IMAGE FILE WHEN IT WAS OPENED
+	struct timespec modified;
+	struct DiskImage image;
+	struct VolumeModel model; //BUILT FROM THE IMAGE
+	int indexed; //1 IF THE METADATA INDEX BELOW IS OPEN
+	struct MetadataIndex index;
+	struct VolumeModel indexModel; //LOADED FROM THE INDEX, ANSWERS THE COMMANDS THAT READ THE INDEX
+	struct ServedImage *next;
+};
+
+struct QueryDaemon{
+	int useIndex; //0 WHEN STARTED WITH --no-index
+	pthread_mutex_t lock; //PROTECTS THE IMAGE LIST (NOT THE IMAGES)
+	struct ServedImage *images;
+};
+
+struct DaemonConnection{
+	struct QueryDaemon *daemon;
+	int socket; //ACCEPTED CONNECTION, CLOSED BY serveConnection
+};
+
+static volatile sig_atomic_t daemonStopping;
+
+static int openDaemonSocket(const char *socketPath);
+static void stopQueryDaemon(int signalNumber);
+static void serveConnection(void *arg);
+static int serveQuery(struct QueryDaemon *daemon, char *args[], int count, FILE *out);
+static struct ServedImage *fetchServedImage(struct QueryDaemon *daemon, const char *path);
+static int loadServedImage(struct QueryDaemon *daemon, struct ServedImage *served);
+static void unloadServedImage(struct ServedImage *served);
+static int isSameImageFile(const struct ServedImage *served, const struct stat *info);
+static void writeDaemonError(FILE *out, const char *message);
+static int writeSocket(int descriptor, const char *buffer, size_t length);
+
+
+/*
+ * Function:  runQueryDaemon 
+ * --------------------
+ * Listens on the socket and answers queries until SIGINT or SIGTERM
+ * The socket is only accessible to the user running the daemon
+ * 
+ * socketPath: Path of the Unix socket to create (an old socket there is replaced)
+ * threadCount: Connections answered at once, 0 for one per processor
+ * useIndex: 1 to answer the commands that support it from the image's metadata index
+ * int: Process exit status (0 once stopped, 1 if the socket could not be set up)
+ */
+int runQueryDaemon(const char *socketPath, int threadCount, int useIndex){
+	//DATA DECLARATION
+	struct QueryDaemon daemon;
+	struct DaemonConnection *connection;
+	struct ServedImage *served;
+	struct WorkPool *pool;
+	struct sigaction action;
+	int listener, client;
+	//DATA MANIPULATION
+	statsMode = STATS_OFF; //COUNTERS WOULD MIX THE QUERIES RUNNING AT ONCE
+	listener = openDaemonSocket(socketPath);
+	if(listener < 0){
+		return 1;
+	}
+	pool = createWorkPool(threadCount);
+	if(pool == NULL){
+		fprintf(stderr, "Unable to start the query threads\n");
+		close(listener);
+		unlink(socketPath);
+		return 1;
+	}
+	memset(&daemon, 0, sizeof(daemon));
+	daemon.useIndex = useIndex;
+	pthread_mutex_init(&daemon.lock, NULL);
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stopQueryDaemon; //NO SA_RESTART SO accept RETURNS EINTR
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	signal(SIGPIPE, SIG_IGN); //A CLIENT GOING AWAY SHOWS UP AS A WRITE ERROR INSTEAD
+	fprintf(stderr, "Serving queries on %s with %d threads\n", socketPath, fetchWorkPoolSize(pool));
+	while(!daemonStopping){
+		client = accept(listener, NULL, NULL);
+		if(client < 0){
+			if(errno != EINTR && errno != ECONNABORTED){
+				perror("accept");
+				break;
+			}
+			continue;
+		}
+		connection = malloc(sizeof(*connection));
+		if(connection == NULL){
+			close(client);
+			continue;
+		}
+		connection->daemon = &daemon;
+		connection->socket = client;
+		if(submitWork(pool, serveConnection, connection) != 0){
+			close(client);
+			free(connection);
+		}
+	}
+	close(listener);
+	unlink(socketPath);
+	destroyWorkPool(pool); //WAITS FOR THE OPEN CONNECTIONS, WHICH TIME OUT WHEN IDLE
+	while(daemon.images != NULL){
+		served = daemon.images;
+		daemon.images = served->next;
+		if(served->loaded){
+			unloadServedImage(served);
+		}
+		pthread_rwlock_destroy(&served->lock);
+		free(served);
+	}
+	pthread_mutex_destroy(&daemon.lock);
+	return 0;
+}
+
+
+/*
+ * Function:  sendDaemonQuery 
+ * --------------------
+ * Sends one command to a running daemon and copies its records to out
+ * The image path is made absolute first, the daemon may run in another directory
+ * 
+ * socketPath: Path of the daemon's Unix socket
+ * argc: Number of arguments (at least the command and the image path)
+ * argv: The command, the image path and the command's own arguments
+ * out: Stream the reply records are copied to
+ * int: The command's exit status, 1 if the daemon could not be reached, 2 on a usage error
+ */
+int sendDaemonQuery(const char *socketPath, int argc, char *argv[], FILE *out){
+	//DATA DECLARATION
+	struct sockaddr_un address;
+	char request[DAEMON_LINE_MAX], imagePath[PATH_MAX], *line = NULL;
+	const char *field;
+	size_t length = 0, lineSize = 0;
+	int i, status = -1, server;
+	FILE *in;
+	//DATA MANIPULATION
+	for(i=0;i<argc;i++){
+		field = (i == 1 && realpath(argv[i], imagePath) != NULL) ? imagePath : argv[i];
+		if(strpbrk(field, "\t\r\n") != NULL || length + strlen(field) + 1 >= sizeof(request)){
+			fprintf(stderr, "Argument cannot be sent to the daemon: %s\n", argv[i]);
+			return 2;
+		}
+		length += (size_t)sprintf(request + length, "%s%c", field, (i == argc - 1) ? '\n' : '\t');
+	}
+	if(strlen(socketPath) >= sizeof(address.sun_path)){
+		fprintf(stderr, "Socket path too long: %s\n", socketPath);
+		return 2;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, socketPath);
+	server = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(server < 0 || connect(server, (struct sockaddr*)&address, sizeof(address)) != 0){
+		perror(socketPath);
+		if(server >= 0){
+			close(server);
+		}
+		return 1;
+	}
+	signal(SIGPIPE, SIG_IGN);
+	if(writeSocket(server, request, length) != 0 || shutdown(server, SHUT_WR) != 0 || (in = fdopen(server, "r")) == NULL){ //ONE REQUEST, SO THE DAEMON CLOSES ONCE IT REPLIED
+		perror(socketPath);
+		close(server);
+		return 1;
+	}
+	while(getline(&line, &lineSize, in) > 0){
+		if(sscanf(line, "{\"record\":\"end\",\"status\":%d}", &status) == 1){
+			break;
+		}
+		fputs(line, out);
+	}
+	free(line);
+	fclose(in);
+	fflush(out);
+	if(status < 0){
+		fprintf(stderr, "The daemon closed the connection before the reply ended\n");
+		return 1;
+	}
+	return status;
+}
+
+
+/*
+ * Function:  openDaemonSocket 
+ * --------------------
+ * Creates the listening socket, readable and writable by its owner only
+ * A socket left behind by a daemon that did not stop cleanly is replaced,
+ * any other kind of file at the path is left alone
+ * 
+ * socketPath: Path of the socket
+ * int: The listening socket, -1 on failure (reported on stderr)
+ */
+static int openDaemonSocket(const char *socketPath){
+	//DATA DECLARATION
+	struct sockaddr_un address;
+	struct stat info;
+	mode_t mask;
+	int listener, status;
+	//DATA MANIPULATION
+	if(strlen(socketPath) >= sizeof(address.sun_path)){
+		fprintf(stderr, "Socket path too long: %s\n", socketPath);
+		return -1;
+	}
+	if(lstat(socketPath, &info) == 0){
+		if(!S_ISSOCK(info.st_mode)){
+			fprintf(stderr, "%s exists and is not a socket\n", socketPath);
+			return -1;
+		}
+		unlink(socketPath);
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, socketPath);
+	listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(listener < 0){
+		perror("socket");
+		return -1;
+	}
+	mask = umask(0177); //THE SOCKET IS CREATED rw-------
+	status = bind(listener, (struct sockaddr*)&address, sizeof(address));
+	umask(mask);
+	if(status != 0 || listen(listener, DAEMON_BACKLOG) != 0){
+		perror(socketPath);
+		close(listener);
+		return -1;
+	}
+	return listener;
+}
+
+
+/*
+ * Function:  stopQueryDaemon 
+ * --------------------
+ * SIGINT and SIGTERM handler, stops accepting connections
+ * 
+ * signalNumber: Unused
+ */
+static void stopQueryDaemon(int signalNumber){
+	(void)signalNumber;
+	daemonStopping = 1;
+}
+
+
+/*
+ * Function:  serveConnection 
+ * --------------------
+ * Work pool task answering the requests of one connection in order
+ * until the client closes it, stays idle too long or a reply cannot be sent
+ * 
+ * arg: The DaemonConnection, freed here
+ */
+static void serveConnection(void *arg){
+	//DATA DECLARATION
+	struct DaemonConnection *connection = arg;
+	struct JsonRecord record;
+	struct timeval idle = {DAEMON_IDLE_SECONDS, 0};
+	char line[DAEMON_LINE_MAX], *args[DAEMON_MAX_ARGUMENTS + 1], *field;
+	FILE *in = NULL, *out = NULL;
+	size_t length;
+	int count, status, outSocket;
+	//DATA MANIPULATION
+	setsockopt(connection->socket, SOL_SOCKET, SO_RCVTIMEO, &idle, sizeof(idle));
+	outSocket = dup(connection->socket); //SEPARATE STREAMS FOR READING AND WRITING, EACH CLOSES ITS OWN DESCRIPTOR
+	in = fdopen(connection->socket, "r");
+	if(in == NULL){
+		close(connection->socket);
+	}
+	out = (outSocket >= 0) ? fdopen(outSocket, "w") : NULL;
+	if(out == NULL && outSocket >= 0){
+		close(outSocket);
+	}
+	while(in != NULL && out != NULL && fgets(line, sizeof(line), in) != NULL){
+		length = strlen(line);
+		if(line[length - 1] != '\n' && !feof(in)){
+			writeDaemonError(out, "Request line too long");
+			fflush(out);
+			break;
+		}
+		while(length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')){
+			line[--length] = '\0';
+		}
+		if(length == 0){
+			continue;
+		}
+		count = 0;
+		for(field = line;count <= DAEMON_MAX_ARGUMENTS;count++){
+			args[count] = field;
+			field = strchr(field, '\t');
+			if(field == NULL){
+				count++;
+				break;
+			}
+			*field++ = '\0';
+		}
+		if(count > DAEMON_MAX_ARGUMENTS){
+			writeDaemonError(out, "Too many fields in the request");
+			status = 2;
+		}else{
+			status = serveQuery(connection->daemon, args, count, out);
+		}
+		beginJsonRecord(&record, out, "end");
+		addJsonInt(&record, "status", status);
+		endJsonRecord(&record);
+		if(fflush(out) != 0){
+			break;
+		}
+	}
+	if(in != NULL){
+		fclose(in);
+	}
+	if(out != NULL){
+		fclose(out);
+	}
+	free(connection);
+}
+
+
+/*
+ * Function:  serveQuery 
+ * --------------------
+ * Runs one request against the shared model of its image
+ * Commands that read the metadata index get the model loaded from it
+ * when the image has an index, the others the model built from the image
+ * 
+ * daemon: The daemon
+ * args: Fields of the request, the command, the image path and the command's arguments
+ * count: Number of fields
+ * out: Stream the reply records are written to
+ * int: The command's exit status (1 if the image could not be opened, 2 on a bad request)
+ */
+static int serveQuery(struct QueryDaemon *daemon, char *args[], int count, FILE *out){
+	//DATA DECLARATION
+	const struct ScanCommand *command = (count >= 2) ? findScanCommand(args[0], count - 2) : NULL;
+	struct ServedImage *served;
+	char message[INDEX_PATH_MAX + 128];
+	int status;
+	//DATA MANIPULATION
+	if(command == NULL){
+		snprintf(message, sizeof(message), "Unknown command or wrong arguments: %s", args[0]);
+		writeDaemonError(out, message);
+		return 2;
+	}
+	if(!(command->flags & COMMAND_SERVED)){
+		snprintf(message, sizeof(message), "%s writes files and is not served, run it directly", command->name);
+		writeDaemonError(out, message);
+		return 2;
+	}
+	served = fetchServedImage(daemon, args[1]);
+	if(served == NULL){
+		snprintf(message, sizeof(message), "%s: %s", args[1], strerror(errno));
+		writeDaemonError(out, message);
+		return 1;
+	}
+	if(served->indexed && (command->flags & COMMAND_INDEX_READ)){
+		status = command->run(&served->indexModel, args + 2, out);
+	}else{
+		status = command->run(&served->model, args + 2, out);
+	}
+	pthread_rwlock_unlock(&served->lock);
+	return status;
+}
+
+
+/*
+ * Function:  fetchServedImage 
+ * --------------------
+ * Finds the loaded image named by a request, opening it on first use
+ * and reloading it when the file changed since it was opened
+ * 
+ * daemon: The daemon
+ * path: Image path given in the request
+ * struct ServedImage*: The loaded image with its lock held (the caller unlocks it), shared unless
+ *                      its model could not be preloaded, NULL with errno set if it could not be opened
+ */
+static struct ServedImage *fetchServedImage(struct QueryDaemon *daemon, const char *path){
+	//DATA DECLARATION
+	struct ServedImage *served;
+	struct stat info;
+	char canonical[PATH_MAX];
+	int attempt, status = 0;
+	//DATA MANIPULATION
+	if(realpath(path, canonical) == NULL){
+		return NULL;
+	}
+	if(strlen(canonical) >= INDEX_PATH_MAX){
+		errno = ENAMETOOLONG;
+		return NULL;
+	}
+	pthread_mutex_lock(&daemon->lock);
+	for(served = daemon->images;served != NULL && strcmp(served->path, canonical) != 0;served = served->next);
+	if(served == NULL){
+		served = calloc(1, sizeof(*served));
+		if(served == NULL || pthread_rwlock_init(&served->lock, NULL) != 0){
+			pthread_mutex_unlock(&daemon->lock);
+			free(served);
+			errno = ENOMEM;
+			return NULL;
+		}
+		strcpy(served->path, canonical);
+		served->next = daemon->images;
+		daemon->images = served;
+	}
+	pthread_mutex_unlock(&daemon->lock);
+	for(attempt=0;attempt<DAEMON_RELOAD_ATTEMPTS;attempt++){
+		if(stat(served->path, &info) != 0){
+			return NULL;
+		}
+		pthread_rwlock_rdlock(&served->lock);
+		if(served->loaded && isSameImageFile(served, &info) && served->shared){
+			return served;
+		}
+		pthread_rwlock_unlock(&served->lock);
+		pthread_rwlock_wrlock(&served->lock);
+		if(!served->loaded || !isSameImageFile(served, &info)){ //ANOTHER QUERY MAY HAVE RELOADED IT WHILE THIS ONE WAITED
+			if(served->loaded){
+				unloadServedImage(served);
+			}
+			status = loadServedImage(daemon, served);
+		}
+		if(status == 0 && !served->shared){ //QUERIES WOULD FILL IN THE MODEL, RUN THEM ONE AT A TIME
+			return served;
+		}
+		pthread_rwlock_unlock(&served->lock);
+		if(status != 0){
+			return NULL;
+		}
+	}
+	errno = EAGAIN; //THE FILE KEPT CHANGING
+	return NULL;
+}
+
+
+/*
+ * Function:  loadServedImage 
+ * --------------------
+ * Opens the image, builds its volume model and loads the parts of it that
+ * are otherwise built on first use; opens the metadata index when there is
+ * one, rewriting it first if it is stale
+ * If any of those parts could not be loaded the image is not shared
+ * between queries, which would otherwise build them concurrently
+ * Called with the image's lock held exclusively
+ * 
+ * daemon: The daemon
+ * served: The image to load
+ * int: 0 on success, -1 with errno set if the image could not be opened
+ */
+static int loadServedImage(struct QueryDaemon *daemon, struct ServedImage *served){
+	//DATA DECLARATION
+	struct stat info;
+	int indexStatus;
+	//DATA MANIPULATION
+	if(stat(served->path, &info) != 0 || openDiskImage(served->path, &served->image) != 0){
+		return -1;
+	}
+	served->size = info.st_size;
+	served->modified = info.st_mtim;
+	buildVolumeModel(&served->image, &served->model);
+	served->shared = 1;
+	if(served->model.fat.present && served->model.fat.table == NULL && loadFatTable(&served->image, &served->model.fat) != 0){
+		served->shared = 0;
+	}
+	if(served->model.ntfs.present && (loadMftExtentMap(&served->image, &served->model.ntfs) != 0
+		|| fetchExtentMap(&served->image, &served->model.ntfs, 6) == NULL)){ //$Bitmap, KEPT IN ITS CACHE SLOT FOR THE FREE SPACE MAP
+		served->shared = 0;
+	}
+	served->indexed = 0;
+	if(daemon->useIndex){
+		indexStatus = openMetadataIndex(served->path, &served->index);
+		if(indexStatus == INDEX_STALE){
+			if(writeMetadataIndex(&served->model, served->path) != 0){
+				fprintf(stderr, "Unable to write the metadata index of %s: %s\n", served->path, strerror(errno));
+			}else{
+				indexStatus = openMetadataIndex(served->path, &served->index);
+			}
+		}
+		if(indexStatus == INDEX_OPENED){
+			loadIndexedModel(&served->index, &served->indexModel);
+			served->indexed = 1;
+		}
+	}
+	served->loaded = 1;
+	return 0;
+}
+
+
+/*
+ * Function:  unloadServedImage 
+ * --------------------
+ * Frees the models and closes the index and the image
+ * Called with the image's lock held exclusively
+ * 
+ * served: The loaded image
+ */
+static void unloadServedImage(struct ServedImage *served){
+	if(served->indexed){
+		freeVolumeModel(&served->indexModel);
+		closeMetadataIndex(&served->index);
+		served->indexed = 0;
+	}
+	freeVolumeModel(&served->model);
+	closeDiskImage(&served->image);
+	served->loaded = 0;
+}
+
+
+/*
+ * Function:  isSameImageFile 
+ * --------------------
+ * Compares the image file with the one that was loaded
+ * 
+ * served: The loaded image
+ * info: Current status of the image file
+ * int: 1 if its size and modification time are unchanged
+ */
+static int isSameImageFile(const struct ServedImage *served, const struct stat *info){
+	return served->size == info->st_size && served->modified.tv_sec == info->st_mtim.tv_sec && served->modified.tv_nsec == info->st_mtim.tv_nsec;
+}
+
+
+/*
+ * Function:  writeDaemonError 
+ * --------------------
+ * Writes an "error" record in place of a command's records
+ * 
+ * out: Stream the record is written to
+ * message: Description of the error
+ */
+static void writeDaemonError(FILE *out, const char *message){
+	struct JsonRecord record;
+	beginJsonRecord(&record, out, "error");
+	addJsonString(&record, "message", message);
+	endJsonRecord(&record);
+}
+
+
+/*
+ * Function:  writeSocket 
+ * --------------------
+ * Writes the whole buffer to a socket
+ * 
+ * descriptor: Connected socket
+ * buffer: Bytes to write
+ * length: Number of bytes
+ * int: 0 on success, -1 on a write error
+ */
+static int writeSocket(int descriptor, const char *buffer, size_t length){
+	ssize_t written;
+	while(length > 0){
+		written = write(descriptor, buffer, length);
+		if(written < 0 && errno == EINTR){
+			continue;
+		}
+		if(written <= 0){
+			return -1;
+		}
+		buffer += written;
+		length -= (size_t)written;
+	}
+	return 0;
+}
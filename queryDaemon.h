@@ -0,0 +1,34 @@
+/*
+ * queryDaemon.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Local query daemon
+ * Keeps disk images open with their volume models (and metadata indexes)
+ * loaded and answers the read-only scan commands sent over a Unix domain
+ * socket, so repeated queries skip opening the image and parsing its tables.
+ * Requests are one line each: the command, the image path and the command's
+ * arguments separated by tabs. The reply is the command's JSON records
+ * followed by an "end" record holding its exit status.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef QUERYDAEMON_H
+#define QUERYDAEMON_H
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+
+#define DAEMON_BACKLOG 64 //CONNECTIONS WAITING TO BE ACCEPTED
+#define DAEMON_MAX_ARGUMENTS 8 //FIELDS OF A REQUEST: COMMAND, IMAGE AND THE COMMAND'S ARGUMENTS
+#define DAEMON_LINE_MAX 8192 //LONGEST REQUEST LINE
+#define DAEMON_IDLE_SECONDS 30 //A CONNECTION SENDING NO REQUEST FOR THIS LONG IS CLOSED
+#define DAEMON_OUTPUT_BUFFER (64*1024) //REPLY BYTES BUFFERED BEFORE A WRITE TO THE SOCKET
+#define DAEMON_RELOAD_ATTEMPTS 3 //TIMES AN IMAGE CHANGING UNDER A QUERY IS RELOADED BEFORE GIVING UP
+
+//FUNCTION & STRUCT DECLARATIONS:
+int runQueryDaemon(const char *socketPath, int threadCount, int useIndex);
+int sendDaemonQuery(const char *socketPath, int argc, char *argv[], FILE *out);
+
+#endif
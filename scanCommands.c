@@ -0,0 +1,1462 @@
+/*
+ * scanCommands.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Non-interactive command line interface
+ * Subcommands (partitions, fat, ntfs, deleted, mft, recover, extract, freespace, carve, hash, timeline, children, index, paths, i30, search) take the image path
+ * as an argument and write one JSON record per line to stdout
+ * as each result is produced. Metadata queries are answered from the
+ * image's metadata index instead of the image when it has an up to date one.
+ * The same commands can be sent to a running query daemon (serve / query),
+ * or run over a whole directory of images at once (fleet).
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "scanCommands.h"
+#include "diskImage.h"
+#include "volumeModel.h"
+#include "fatVolume.h"
+#include "ntfsVolume.h"
+#include "jsonOutput.h"
+#include "allocationMap.h"
+#include "fileCarver.h"
+#include "imageHash.h"
+#include "scanStats.h"
+#include "timeline.h"
+#include "metadataIndex.h"
+#include "queryDaemon.h"
+#include "ntfsTree.h"
+#include "fleetScan.h"
+#include "fileMap.h"
+#include "keywordSearch.h"
+
+#define SEARCH_PREVIEW_BYTES 64 //BYTES OF A MATCH COPIED INTO ITS RECORD
+
+struct DeletedRecordContext{
+	struct VolumeModel *model;
+	FILE *out;
+};
+
+struct ChildrenContext{
+	const char *parentPath; //FAT DIRECTORY WHOSE ENTRIES ARE LISTED ("" FOR THE ROOT), NULL FOR AN NTFS DIRECTORY
+	uint64_t parentRecord; //NTFS DIRECTORY RECORD WHOSE FILES ARE LISTED
+	FILE *out;
+};
+
+struct SearchContext{
+	struct FileMap map; //REVERSE MAP PLACING EACH HIT IN ITS FILE
+	char *pathBuffer; //NTFS_PATH_MAX BYTES FOR RESOLVED NTFS PATHS
+	FILE *out;
+	uint64_t hits;
+};
+
+struct RecoverContext{
+	struct VolumeModel *model;
+	const char *outDir; //DIRECTORY THE FILES ARE RECOVERED INTO
+	FILE *out;
+	int failures; //NUMBER OF FILES THAT COULD NOT BE WRITTEN
+};
+
+static int writePartitionRecords(struct VolumeModel *model, char *args[], FILE *out);
+static int writeFatRecord(struct VolumeModel *model, char *args[], FILE *out);
+static int writeNtfsRecord(struct VolumeModel *model, char *args[], FILE *out);
+static int writeDeletedRecords(struct VolumeModel *model, char *args[], FILE *out);
+static int writeDeletedRecord(const struct FatDirEntry *entry, void *context);
+static int writeMftRecords(struct VolumeModel *model, char *args[], FILE *out);
+static int writeMftRecord(const struct MftRecord *mftRecord, void *context);
+static int recoverFatFiles(struct VolumeModel *model, char *args[], FILE *out);
+static int recoverFatFile(const struct FatDirEntry *entry, void *context);
+static int extractNtfsFile(struct VolumeModel *model, char *args[], FILE *out);
+static int writeFreeSpace(struct VolumeModel *model, char *args[], FILE *out);
+static int fetchScopeExtents(struct VolumeModel *model, const char *scope, struct ExtentList *regions);
+static int carveFiles(struct VolumeModel *model, char *args[], FILE *out);
+static int writeCarveHit(const struct CarveHit *hit, void *context);
+static int hashImageFile(struct VolumeModel *model, char *args[], FILE *out);
+static int writeBlockHash(const struct HashBlock *block, void *context);
+static int writeTimeline(struct VolumeModel *model, char *args[], FILE *out);
+static int writeTimelineEvent(const struct TimelineEvent *event, void *context);
+static int writeChildRecords(struct VolumeModel *model, char *args[], FILE *out);
+static int writeFatChild(const struct FatDirEntry *entry, void *context);
+static int writeMftChild(const struct MftRecord *mftRecord, void *context);
+static int writeIndexRecord(struct VolumeModel *model, char *args[], FILE *out);
+static int writePathRecords(struct VolumeModel *model, char *args[], FILE *out);
+static int writeIndexEntries(struct VolumeModel *model, char *args[], FILE *out);
+static int writeIndexEntry(const struct NtfsIndexEntry *entry, void *context);
+static int writeSearchHits(struct VolumeModel *model, char *args[], FILE *out);
+static int writeSearchHit(const struct SearchHit *hit, void *context);
+static void addJsonDigests(struct JsonRecord *record, const struct ImageDigest *digest);
+static int createOutputFile(const char *outDir, const char *path, uint64_t entryOffset, char *outPath, size_t outPathSize);
+
+static const struct ScanCommand scanCommands[] = {
+	{"partitions", "", 0, "partition table entries", STATS_PARTITION, COMMAND_INDEX_READ | COMMAND_SERVED, writePartitionRecords},
+	{"fat", "", 0, "FAT volume information", STATS_FAT, COMMAND_INDEX_READ | COMMAND_SERVED, writeFatRecord},
+	{"ntfs", "", 0, "NTFS volume information", STATS_NTFS, COMMAND_INDEX_READ | COMMAND_SERVED, writeNtfsRecord},
+	{"deleted", "", 0, "deleted entries in all FAT directories", STATS_DELETED, COMMAND_INDEX_READ | COMMAND_SERVED, writeDeletedRecords},
+	{"mft", "", 0, "every $MFT file record with its attributes", STATS_MFT, COMMAND_INDEX_READ | COMMAND_SERVED, writeMftRecords},
+	{"recover", "<outdir>", 1, "recover every live and deleted FAT file into outdir", STATS_RECOVER, 0, recoverFatFiles},
+	{"extract", "<record> <outfile>", 2, "write the $DATA stream of an NTFS file record to outfile", STATS_EXTRACT, 0, extractNtfsFile},
+	{"freespace", "<scope> <outfile>", 2, "write unallocated space and/or file slack (unallocated, slack, unallocated+slack) to outfile", STATS_FREESPACE, 0, writeFreeSpace},
+	{"carve", "<scope>", 1, "carve files by header and footer signatures (all, unallocated, slack, unallocated+slack)", STATS_CARVE, COMMAND_SERVED, carveFiles},
+	{"hash", "<blockKiB>", 1, "MD5/SHA-1/SHA-256 of the image and partitions, SHA-256 per block (0 for none)", STATS_HASH, COMMAND_SERVED, hashImageFile},
+	{"timeline", "<memoryMiB>", 1, "every FAT and NTFS timestamp of all partitions sorted by time, sorting in at most memoryMiB", STATS_TIMELINE, COMMAND_SERVED, writeTimeline},
+	{"children", "<directory>", 1, "entries of a FAT directory (/path) or files of an NTFS directory (record number)", STATS_CHILDREN, COMMAND_INDEX_READ | COMMAND_SERVED, writeChildRecords},
+	{"index", "", 0, "write the metadata index next to the image (rebuilt only when the image changes)", STATS_INDEX, COMMAND_INDEX_CREATE, writeIndexRecord},
+	{"paths", "", 0, "full path of every NTFS file record, deleted and orphaned records included", STATS_PATHS, COMMAND_INDEX_READ | COMMAND_SERVED, writePathRecords},
+	{"i30", "<record>", 1, "entries of the $I30 index of an NTFS directory record, in name order", STATS_I30, COMMAND_SERVED, writeIndexEntries},
+	{"search", "<keyword|regex> <pattern>", 2, "keyword (ASCII and UTF-16LE) or extended regular expression hits, each with the partition and file holding it", STATS_SEARCH, COMMAND_SERVED, writeSearchHits}
+};
+
+
+/*
+ * Function:  runScanCommand 
+ * --------------------
+ * Looks up the subcommand, opens the image named after it,
+ * builds the volume model and streams the command's records to stdout
+ * Options before the subcommand: --stats prints where the time and I/O
+ * went to stderr once the command finishes, --stats=json writes the same
+ * figures as "stats" records after the command's own records
+ * Commands that support it are answered from the metadata index next to the
+ * image without reading the image; an index left stale by a changed image
+ * is rewritten first. --no-index reads the image and leaves the index alone
+ * "serve" starts the query daemon and "query" sends a command to it instead
+ * 
+ * argc: Number of arguments (starting at the first option or the subcommand)
+ * argv: Arguments, the options, then the subcommand, the image path and the command's own arguments
+ * int: Process exit status (0 success, 1 failure, 2 usage error)
+ */
+int runScanCommand(int argc, char *argv[]){
+	//DATA DECLARATION
+	const struct ScanCommand *command;
+	int status, useIndex = 1, imageOpen = 0, indexStatus = INDEX_MISSING;
+	struct DiskImage image;
+	struct VolumeModel model;
+	struct MetadataIndex index;
+	//DATA MANIPULATION
+	for(;argc > 0 && strncmp(argv[0], "--", 2) == 0;argc--, argv++){ //OPTIONS COME BEFORE THE SUBCOMMAND
+		if(strcmp(argv[0], "--stats") == 0){
+			statsMode = STATS_TEXT;
+		}else if(strcmp(argv[0], "--stats=json") == 0){
+			statsMode = STATS_JSON;
+		}else if(strcmp(argv[0], "--no-index") == 0){
+			useIndex = 0;
+		}else{
+			fprintf(stderr, "Unknown option: %s\n", argv[0]);
+			return 2;
+		}
+	}
+	if((argc == 2 || argc == 3) && strcmp(argv[0], "serve") == 0){
+		return runQueryDaemon(argv[1], (argc == 3) ? atoi(argv[2]) : 0, useIndex);
+	}
+	if(argc >= 3 && argc <= 5 && strcmp(argv[0], "fleet") == 0){
+		return runFleetScan(argv[1], argv[2], (argc >= 4) ? atoi(argv[3]) : 0, (argc == 5) ? atoi(argv[4]) : 0);
+	}
+	if(argc >= 4 && strcmp(argv[0], "query") == 0){
+		return sendDaemonQuery(argv[1], argc - 2, argv + 2, stdout);
+	}
+	command = (argc > 0) ? findScanCommand(argv[0], argc - 2) : NULL;
+	if(command == NULL){
+		fprintf(stderr, "Unknown command or wrong arguments: %s\n", (argc > 0) ? argv[0] : "");
+		return 2;
+	}
+	if(useIndex && (command->flags & (COMMAND_INDEX_READ | COMMAND_INDEX_CREATE))){
+		indexStatus = openMetadataIndex(argv[1], &index);
+	}
+	if(indexStatus != INDEX_OPENED){ //THE IMAGE HAS TO BE READ
+		if(openDiskImage(argv[1], &image) != 0){
+			perror(argv[1]);
+			return 1;
+		}
+		imageOpen = 1;
+		buildVolumeModel(&image, &model);
+	}
+	if(indexStatus == INDEX_STALE || (indexStatus == INDEX_MISSING && useIndex && (command->flags & COMMAND_INDEX_CREATE))){
+		beginStatsStage(STATS_INDEX);
+		if(writeMetadataIndex(&model, argv[1]) != 0){
+			fprintf(stderr, "Unable to write the metadata index of %s: %s\n", argv[1], strerror(errno));
+		}else if((indexStatus = openMetadataIndex(argv[1], &index)) == INDEX_OPENED){
+			index.rebuilt = 1;
+			freeVolumeModel(&model); //ANSWERED FROM THE NEW INDEX, AS LATER RUNS WILL BE
+		}
+		endStatsStage(STATS_INDEX);
+	}
+	if(indexStatus == INDEX_OPENED){
+		loadIndexedModel(&index, &model);
+	}
+	beginStatsStage(command->stage);
+	status = command->run(&model, argv + 2, stdout);
+	endStatsStage(command->stage);
+	freeVolumeModel(&model);
+	if(indexStatus == INDEX_OPENED){
+		closeMetadataIndex(&index);
+	}
+	if(imageOpen){
+		closeDiskImage(&image);
+	}
+	writeStatsReport(stdout);
+	fflush(stdout);
+	return status;
+}
+
+
+/*
+ * Function:  findScanCommand 
+ * --------------------
+ * Looks up a subcommand by name
+ * 
+ * name: Subcommand name
+ * argumentCount: Number of arguments given after the image path
+ * const struct ScanCommand*: The command, NULL if unknown or given the wrong number of arguments
+ */
+const struct ScanCommand *findScanCommand(const char *name, int argumentCount){
+	size_t i;
+	for(i=0;i<sizeof(scanCommands)/sizeof(scanCommands[0]);i++){
+		if(strcmp(name, scanCommands[i].name) == 0){
+			return (argumentCount == scanCommands[i].argumentCount) ? &scanCommands[i] : NULL;
+		}
+	}
+	return NULL;
+}
+
+
+/*
+ * Function:  printScanUsage 
+ * --------------------
+ * Prints the list of subcommands to stderr
+ * 
+ * programName: Name the program was run as (argv[0])
+ */
+void printScanUsage(const char *programName){
+	size_t i;
+	int width = 0;
+	fprintf(stderr, "Usage: %s [--stats[=json]] [--no-index] [<command> <image> [arguments]]\n", programName);
+	fprintf(stderr, "       %s [--no-index] serve <socket> [threads]\n", programName);
+	fprintf(stderr, "       %s query <socket> <command> <image> [arguments]\n", programName);
+	fprintf(stderr, "       %s fleet <directory|manifest> <outdir> [threads] [ioLimit]\n", programName);
+	fprintf(stderr, "Without arguments the interactive menu is started.\n");
+	fprintf(stderr, "--stats reports time, reads, seeks and cache hits per stage on stderr (--stats=json as records on stdout).\n");
+	fprintf(stderr, "Once the index command has indexed an image, partitions, fat, ntfs, deleted, mft, children and paths read <image>.idx\n");
+	fprintf(stderr, "instead of the image (--no-index reads the image).\n");
+	fprintf(stderr, "serve keeps images open with their volume models loaded and answers the commands marked * sent by query\n");
+	fprintf(stderr, "over the Unix socket.\n");
+	fprintf(stderr, "fleet scans every image of a directory or manifest at once, ioLimit of them reading at a time, and writes\n");
+	fprintf(stderr, "the partitions, fat, deleted, ntfs and paths records of each to <outdir>/<image>.json.\n\nCommands:\n");
+	for(i=0;i<sizeof(scanCommands)/sizeof(scanCommands[0]);i++){
+		if((int)strlen(scanCommands[i].arguments) > width){
+			width = (int)strlen(scanCommands[i].arguments);
+		}
+	}
+	for(i=0;i<sizeof(scanCommands)/sizeof(scanCommands[0]);i++){
+		fprintf(stderr, "  %-12s%-*s %s%s\n", scanCommands[i].name, width, scanCommands[i].arguments, (scanCommands[i].flags & COMMAND_SERVED) ? "* " : "  ", scanCommands[i].summary);
+	}
+}
+
+
+/*
+ * Function:  writePartitionRecords 
+ * --------------------
+ * Writes one "partition" record per partition of the model, in the order
+ * the partition tables were enumerated (MBR primaries, EBR logical partitions or GPT entries)
+ * 
+ * model: The volume model of the open disk image
+ * args: Unused
+ * out: Stream the records are written to
+ * int: 0 on success
+ */
+static int writePartitionRecords(struct VolumeModel *model, char *args[], FILE *out){
+	static const char *schemes[] = {"mbr", "ebr", "gpt"};
+	char guid[40];
+	const unsigned char *g;
+	const struct Partition *partition;
+	struct JsonRecord record;
+	size_t i;
+	for(i=0;i<model->partitionCount;i++){
+		partition = &model->partitions[i];
+		beginJsonRecord(&record, out, "partition");
+		addJsonInt(&record, "index", partition->index);
+		addJsonString(&record, "scheme", schemes[partition->scheme]);
+		if(partition->scheme == PARTITION_GPT){
+			g = partition->typeGuid; //FIRST THREE FIELDS ARE STORED LITTLE ENDIAN
+			snprintf(guid, sizeof(guid), "%02X%02X%02X%02X-%02X%02X-%02X%02X-%02X%02X-%02X%02X%02X%02X%02X%02X", g[3], g[2], g[1], g[0], g[5], g[4], g[7], g[6], g[8], g[9], g[10], g[11], g[12], g[13], g[14], g[15]);
+			addJsonString(&record, "typeGuid", guid);
+			addJsonString(&record, "name", partition->name);
+		}else{
+			addJsonInt(&record, "typeCode", (unsigned char)partition->type);
+		}
+		addJsonString(&record, "type", describePartition(partition));
+		addJsonInt(&record, "sectorStart", (long long int)partition->sectorStart);
+		addJsonInt(&record, "sectorCount", (long long int)partition->sectorCount);
+		addJsonInt(&record, "sizeKiB", (long long int)partition->size);
+		endJsonRecord(&record);
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  writeFatRecord 
+ * --------------------
+ * Writes the "fatVolume" record for the FAT volume of the model
+ * 
+ * model: The volume model of the open disk image
+ * args: Unused
+ * out: Stream the record is written to
+ * int: 0 on success, 1 if the image holds no FAT volume
+ */
+static int writeFatRecord(struct VolumeModel *model, char *args[], FILE *out){
+	struct FatVolume *fat = &model->fat;
+	struct JsonRecord record;
+	if(!fat->present){
+		fprintf(stderr, "No FAT Volume found on this disk image\n");
+		return 1;
+	}
+	beginJsonRecord(&record, out, "fatVolume");
+	addJsonInt(&record, "sectorStart", fat->sectorStart);
+	addJsonInt(&record, "fatBits", fat->fatBits);
+	addJsonInt(&record, "bytesPerSector", fat->bytesPerSector);
+	addJsonInt(&record, "sectorsPerCluster", fat->sectorsPerCluster);
+	addJsonInt(&record, "reservedSectors", fat->reserved);
+	addJsonInt(&record, "fatCopies", fat->fatCopy);
+	addJsonInt(&record, "fatAreaSize", fat->fatSize);
+	addJsonInt(&record, "rootDirSize", fat->rootDirSize);
+	addJsonInt(&record, "rootDirSector", fat->dataSectorAddr);
+	addJsonInt(&record, "cluster2Sector", fat->secondClusterAddr);
+	addJsonInt(&record, "clusterCount", fat->clusterCount);
+	if(fat->fatBits == 32){
+		addJsonInt(&record, "rootCluster", fat->rootCluster);
+	}
+	endJsonRecord(&record);
+	return 0;
+}
+
+
+/*
+ * Function:  writeNtfsRecord 
+ * --------------------
+ * Writes the "ntfsVolume" record for the NTFS volume of the model
+ * 
+ * model: The volume model of the open disk image
+ * args: Unused
+ * out: Stream the record is written to
+ * int: 0 on success, 1 if the image holds no NTFS volume
+ */
+static int writeNtfsRecord(struct VolumeModel *model, char *args[], FILE *out){
+	struct NtfsVolume *ntfs = &model->ntfs;
+	struct JsonRecord record;
+	if(!ntfs->present){
+		fprintf(stderr, "No NTFS Volume found on this disk image\n");
+		return 1;
+	}
+	beginJsonRecord(&record, out, "ntfsVolume");
+	addJsonInt(&record, "sectorStart", ntfs->sectorStart);
+	addJsonInt(&record, "bytesPerSector", ntfs->bytesPerSector);
+	addJsonInt(&record, "sectorsPerCluster", ntfs->sectorsPerCluster);
+	addJsonInt(&record, "mftCluster", ntfs->mftCluster);
+	addJsonInt(&record, "mftSector", ntfs->mftSectorAddr);
+	endJsonRecord(&record);
+	return 0;
+}
+
+
+/*
+ * Function:  writeDeletedRecords 
+ * --------------------
+ * Writes a "deletedFile" record for every deleted entry in the root directory
+ * and all subdirectories (including entries inside deleted directories)
+ * Each record is written as soon as its entry is found
+ * 
+ * model: The volume model of the open disk image
+ * args: Unused
+ * out: Stream the records are written to
+ * int: 0 on success, 1 if the image holds no FAT volume or the walk failed
+ */
+static int writeDeletedRecords(struct VolumeModel *model, char *args[], FILE *out){
+	struct DeletedRecordContext context = {model, out};
+	if(!model->fat.present){
+		fprintf(stderr, "No FAT Volume found on this disk image\n");
+		return 1;
+	}
+	if(model->index != NULL){
+		return (walkIndexedFatEntries(model->index, NULL, 0, writeDeletedRecord, &context) < 0) ? 1 : 0;
+	}
+	return (walkFatDirectories(model->image, &model->fat, writeDeletedRecord, &context) < 0) ? 1 : 0;
+}
+
+
+/*
+ * Function:  writeDeletedRecord 
+ * --------------------
+ * Directory walk visitor writing one "deletedFile" record
+ * 
+ * entry: The directory entry being visited
+ * context: The DeletedRecordContext of the command
+ * int: 0 to continue the walk
+ */
+static int writeDeletedRecord(const struct FatDirEntry *entry, void *context){
+	struct DeletedRecordContext *deleted = context;
+	struct FatVolume *fat = &deleted->model->fat;
+	struct JsonRecord record;
+	char preview[16];
+	size_t previewLength;
+	if(!entry->deleted && !entry->parentDeleted){
+		return 0;
+	}
+	if(deleted->model->index != NULL){
+		previewLength = fetchIndexedPreview(entry, preview, sizeof(preview));
+	}else{
+		previewLength = fetchFilePreview(deleted->model->image, fat, entry, preview, sizeof(preview));
+	}
+	beginJsonRecord(&record, deleted->out, "deletedFile");
+	addJsonString(&record, "path", entry->path);
+	addJsonBytes(&record, "shortName", entry->shortName, strlen(entry->shortName));
+	addJsonString(&record, "longName", entry->longName);
+	addJsonBool(&record, "directory", (entry->attributes & 0x10) != 0);
+	addJsonBool(&record, "inDeletedDirectory", entry->parentDeleted);
+	addJsonInt(&record, "attributes", entry->attributes);
+	addJsonInt(&record, "startCluster", entry->startCluster);
+	addJsonInt(&record, "size", entry->fileSize);
+	addJsonInt(&record, "entryOffset", (long long int)entry->entryOffset);
+	if(entry->startCluster >= 2){
+		addJsonInt(&record, "clusterSector", (long long int)(fetchClusterOffset(fat, entry->startCluster)/SECTOR_SIZE));
+	}
+	addJsonBytes(&record, "preview", preview, previewLength);
+	endJsonRecord(&record);
+	return 0;
+}
+
+
+/*
+ * Function:  writeMftRecords 
+ * --------------------
+ * Streams an "mftRecord" record for every file record of the $MFT
+ * Records are parsed in parallel and written in record number order
+ * 
+ * model: The volume model of the open disk image
+ * args: Unused
+ * out: Stream the records are written to
+ * int: 0 on success, 1 if the image holds no NTFS volume or the $MFT could not be read
+ */
+static int writeMftRecords(struct VolumeModel *model, char *args[], FILE *out){
+	int status;
+	if(!model->ntfs.present){
+		fprintf(stderr, "No NTFS Volume found on this disk image\n");
+		return 1;
+	}
+	if(model->index != NULL){
+		status = scanIndexedMftRecords(model->index, NULL, 0, writeMftRecord, out);
+	}else{
+		status = scanMftRecords(model->image, &model->ntfs, 0, writeMftRecord, out);
+	}
+	if(status != 0){
+		fprintf(stderr, "Unable to read the $MFT\n");
+		return 1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  writeMftRecord 
+ * --------------------
+ * Visitor writing one "mftRecord" record with the record header,
+ * $STANDARD_INFORMATION times, the preferred $FILE_NAME and every attribute header
+ * 
+ * mftRecord: The decoded MFT record
+ * context: The stream the record is written to
+ * int: 0 to continue the scan
+ */
+static int writeMftRecord(const struct MftRecord *mftRecord, void *context){
+	//DATA DECLARATION
+	struct JsonRecord record;
+	char text[32];
+	const struct MftAttribute *attribute;
+	int i;
+	//DATA MANIPULATION
+	beginJsonRecord(&record, context, "mftRecord");
+	addJsonInt(&record, "number", (long long int)mftRecord->number);
+	addJsonInt(&record, "sequence", mftRecord->sequence);
+	addJsonBool(&record, "inUse", mftRecord->inUse);
+	addJsonBool(&record, "directory", mftRecord->isDirectory);
+	addJsonInt(&record, "baseRecord", (long long int)mftRecord->baseRecord);
+	addJsonInt(&record, "linkCount", mftRecord->linkCount);
+	addJsonBool(&record, "fixupError", mftRecord->fixupError);
+	if(mftRecord->hasFileName){
+		addJsonString(&record, "name", mftRecord->fileName.name);
+		addJsonInt(&record, "parentRecord", (long long int)mftRecord->fileName.parentRecord);
+		addJsonInt(&record, "parentSequence", mftRecord->fileName.parentSequence);
+	}
+	addJsonInt(&record, "size", (long long int)mftRecord->dataSize);
+	if(mftRecord->hasStandardInfo){
+		openJsonObject(&record, "standardInformation");
+		formatFileTime(mftRecord->standardInfo.created, text, sizeof(text));
+		addJsonString(&record, "created", text);
+		formatFileTime(mftRecord->standardInfo.modified, text, sizeof(text));
+		addJsonString(&record, "modified", text);
+		formatFileTime(mftRecord->standardInfo.mftModified, text, sizeof(text));
+		addJsonString(&record, "mftModified", text);
+		formatFileTime(mftRecord->standardInfo.accessed, text, sizeof(text));
+		addJsonString(&record, "accessed", text);
+		addJsonInt(&record, "fileAttributes", mftRecord->standardInfo.fileAttributes);
+		closeJsonObject(&record);
+	}
+	openJsonArray(&record, "attributes");
+	for(i=0;i<mftRecord->attributeCount;i++){
+		attribute = &mftRecord->attributes[i];
+		openJsonObject(&record, NULL);
+		addJsonInt(&record, "typeCode", attribute->type);
+		addJsonString(&record, "type", fetchMFTAttribute(attribute->type));
+		addJsonInt(&record, "length", attribute->length);
+		addJsonBool(&record, "nonResident", attribute->nonResident);
+		if(attribute->nonResident){
+			addJsonInt(&record, "startVcn", (long long int)attribute->startVcn);
+			addJsonInt(&record, "lastVcn", (long long int)attribute->lastVcn);
+			addJsonInt(&record, "allocatedSize", (long long int)attribute->allocatedSize);
+		}
+		addJsonInt(&record, "realSize", (long long int)attribute->realSize);
+		closeJsonObject(&record);
+	}
+	closeJsonArray(&record);
+	if(mftRecord->attributesTruncated){
+		addJsonBool(&record, "attributesTruncated", 1);
+	}
+	endJsonRecord(&record);
+	return 0;
+}
+
+
+/*
+ * Function:  recoverFatFiles 
+ * --------------------
+ * Recovers every live and deleted file of the FAT volume into a directory
+ * The directory tree of the volume is recreated below outdir and a
+ * "recoveredFile" record is written for each file
+ * 
+ * model: The volume model of the open disk image
+ * args: args[0] is the output directory
+ * out: Stream the records are written to
+ * int: 0 on success, 1 if any file could not be recovered
+ */
+static int recoverFatFiles(struct VolumeModel *model, char *args[], FILE *out){
+	struct RecoverContext context = {model, args[0], out, 0};
+	if(!model->fat.present){
+		fprintf(stderr, "No FAT Volume found on this disk image\n");
+		return 1;
+	}
+	if(mkdir(args[0], 0755) != 0 && errno != EEXIST){
+		perror(args[0]);
+		return 1;
+	}
+	if(walkFatDirectories(model->image, &model->fat, recoverFatFile, &context) < 0){
+		return 1;
+	}
+	return context.failures ? 1 : 0;
+}
+
+
+/*
+ * Function:  recoverFatFile 
+ * --------------------
+ * Directory walk visitor recovering one file
+ * The file's clusters are coalesced into extents and copied to the
+ * output file by the kernel with copyImageExtents
+ * 
+ * entry: The directory entry being visited
+ * context: The RecoverContext of the command
+ * int: 0 to continue the walk
+ */
+static int recoverFatFile(const struct FatDirEntry *entry, void *context){
+	//DATA DECLARATION
+	struct RecoverContext *recover = context;
+	struct FileExtents extents;
+	struct JsonRecord record;
+	char outPath[FAT_PATH_MAX + 512];
+	int outFd, status;
+	//DATA MANIPULATION
+	if(entry->attributes & 0x10){ //DIRECTORIES ARE CREATED AS THE FILES BELOW THEM ARE WRITTEN
+		return 0;
+	}
+	if(fetchFileExtents(recover->model->image, &recover->model->fat, entry, &extents) != 0){
+		return -1;
+	}
+	outFd = createOutputFile(recover->outDir, entry->path, entry->entryOffset, outPath, sizeof(outPath));
+	status = (outFd < 0) ? -1 : copyImageExtents(recover->model->image, extents.extents, extents.count, outFd);
+	if(status != 0){
+		fprintf(stderr, "%s: %s\n", outPath, strerror(errno));
+		recover->failures++;
+	}
+	if(outFd >= 0){
+		close(outFd);
+	}
+	beginJsonRecord(&record, recover->out, "recoveredFile");
+	addJsonString(&record, "path", entry->path);
+	addJsonString(&record, "output", outPath);
+	addJsonBool(&record, "deleted", entry->deleted || entry->parentDeleted);
+	addJsonInt(&record, "size", entry->fileSize);
+	addJsonInt(&record, "recovered", (status == 0) ? (long long int)extents.length : 0);
+	addJsonInt(&record, "extents", (long long int)extents.count);
+	addJsonBool(&record, "truncated", extents.truncated);
+	addJsonBool(&record, "overwritten", extents.overwritten);
+	endJsonRecord(&record);
+	freeFileExtents(&extents);
+	return 0;
+}
+
+
+/*
+ * Function:  extractNtfsFile 
+ * --------------------
+ * Writes the unnamed $DATA stream of an NTFS file record to a file
+ * The stream is read through its extent map, so fragmented and sparse
+ * files are extracted without reading the rest of the $MFT
+ * An "extractedFile" record is written once the copy finishes
+ * 
+ * model: The volume model of the open disk image
+ * args: args[0] is the MFT record number, args[1] the output file
+ * out: Stream the record is written to
+ * int: 0 on success, 1 on failure
+ */
+static int extractNtfsFile(struct VolumeModel *model, char *args[], FILE *out){
+	//DATA DECLARATION
+	const struct NtfsExtentMap *map;
+	struct JsonRecord record;
+	char *end;
+	unsigned long long int number;
+	int outFd, status;
+	//DATA MANIPULATION
+	if(!model->ntfs.present){
+		fprintf(stderr, "No NTFS Volume found on this disk image\n");
+		return 1;
+	}
+	number = strtoull(args[0], &end, 0);
+	if(*args[0] == '\0' || *end != '\0'){
+		fprintf(stderr, "Invalid MFT record number: %s\n", args[0]);
+		return 1;
+	}
+	map = fetchExtentMap(model->image, &model->ntfs, number);
+	if(map == NULL){
+		fprintf(stderr, "MFT record %llu has no readable $DATA stream\n", number);
+		return 1;
+	}
+	outFd = open(args[1], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(outFd < 0){
+		perror(args[1]);
+		return 1;
+	}
+	status = copyNtfsData(model->image, &model->ntfs, map, outFd);
+	if(status != 0){
+		fprintf(stderr, "%s: %s\n", args[1], strerror(errno));
+	}
+	close(outFd);
+	beginJsonRecord(&record, out, "extractedFile");
+	addJsonInt(&record, "mftRecord", (long long int)number);
+	addJsonString(&record, "output", args[1]);
+	addJsonInt(&record, "size", (long long int)map->dataSize);
+	addJsonBool(&record, "resident", map->resident != NULL);
+	addJsonInt(&record, "runs", (long long int)map->count);
+	addJsonBool(&record, "extracted", status == 0);
+	endJsonRecord(&record);
+	return (status == 0) ? 0 : 1;
+}
+
+
+/*
+ * Function:  writeFreeSpace 
+ * --------------------
+ * Writes the unallocated space and/or the file slack of the image to one file,
+ * extent after extent in image order, so it can be searched without the rest
+ * of the image. A "freeExtent" record maps each extent to its place in the
+ * output file and a "freeSpace" record gives the totals
+ * 
+ * model: The volume model of the open disk image
+ * args: args[0] is the scope (unallocated, slack or unallocated+slack), args[1] the output file
+ * out: Stream the records are written to
+ * int: 0 on success, 1 on failure or an unknown scope
+ */
+static int writeFreeSpace(struct VolumeModel *model, char *args[], FILE *out){
+	//DATA DECLARATION
+	struct ExtentList regions = {NULL, 0, 0, 0};
+	struct JsonRecord record;
+	uint64_t outputOffset = 0;
+	size_t i;
+	int outFd, status;
+	//DATA MANIPULATION
+	if(strcmp(args[0], "all") == 0 || (status = fetchScopeExtents(model, args[0], &regions)) > 0){
+		fprintf(stderr, "Unknown scope: %s (use unallocated, slack or unallocated+slack)\n", args[0]);
+		return 1;
+	}
+	if(status != 0){
+		fprintf(stderr, "Unable to read the allocation data\n");
+		freeExtentList(&regions);
+		return 1;
+	}
+	outFd = open(args[1], O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(outFd < 0){
+		perror(args[1]);
+		freeExtentList(&regions);
+		return 1;
+	}
+	for(i=0;i<regions.count && status == 0;i++){
+		status = copyImageExtents(model->image, &regions.extents[i], 1, outFd);
+		beginJsonRecord(&record, out, "freeExtent");
+		addJsonInt(&record, "offset", (long long int)regions.extents[i].offset);
+		addJsonInt(&record, "sector", (long long int)(regions.extents[i].offset/SECTOR_SIZE));
+		addJsonInt(&record, "length", (long long int)regions.extents[i].length);
+		addJsonInt(&record, "outputOffset", (long long int)outputOffset);
+		endJsonRecord(&record);
+		outputOffset += regions.extents[i].length;
+	}
+	if(status != 0){
+		fprintf(stderr, "%s: %s\n", args[1], strerror(errno));
+	}
+	close(outFd);
+	beginJsonRecord(&record, out, "freeSpace");
+	addJsonString(&record, "scope", args[0]);
+	addJsonString(&record, "output", args[1]);
+	addJsonInt(&record, "extents", (long long int)regions.count);
+	addJsonInt(&record, "length", (long long int)regions.length);
+	addJsonInt(&record, "imageSize", (long long int)model->image->size);
+	addJsonBool(&record, "written", status == 0);
+	endJsonRecord(&record);
+	freeExtentList(&regions);
+	return (status == 0) ? 0 : 1;
+}
+
+
+/*
+ * Function:  fetchScopeExtents 
+ * --------------------
+ * Builds the regions of the image a command works on
+ * 
+ * model: The volume model of the open disk image
+ * scope: "all", "unallocated", "slack" or "unallocated+slack"
+ * regions: Extent list the regions are appended to (zero initialised)
+ * int: 0 on success, -1 on failure, 1 for an unknown scope
+ */
+static int fetchScopeExtents(struct VolumeModel *model, const char *scope, struct ExtentList *regions){
+	if(strcmp(scope, "all") == 0){
+		return appendImageExtent(regions, 0, model->image->size);
+	}else if(strcmp(scope, "unallocated") == 0){
+		return fetchFreeSpaceExtents(model, FREE_UNALLOCATED, regions);
+	}else if(strcmp(scope, "slack") == 0){
+		return fetchFreeSpaceExtents(model, FREE_SLACK, regions);
+	}else if(strcmp(scope, "unallocated+slack") == 0){
+		return fetchFreeSpaceExtents(model, FREE_UNALLOCATED | FREE_SLACK, regions);
+	}
+	return 1;
+}
+
+
+/*
+ * Function:  carveFiles 
+ * --------------------
+ * Carves files by signature across the whole image or only its
+ * unallocated space and/or file slack, writing a "carvedFile" record
+ * as each hit is found
+ * 
+ * model: The volume model of the open disk image
+ * args: args[0] is the scope (all, unallocated, slack or unallocated+slack)
+ * out: Stream the records are written to
+ * int: 0 on success, 1 on failure or an unknown scope
+ */
+static int carveFiles(struct VolumeModel *model, char *args[], FILE *out){
+	//DATA DECLARATION
+	struct ExtentList regions = {NULL, 0, 0, 0};
+	int status;
+	//DATA MANIPULATION
+	status = fetchScopeExtents(model, args[0], &regions);
+	if(status > 0){
+		fprintf(stderr, "Unknown carving scope: %s (use all, unallocated, slack or unallocated+slack)\n", args[0]);
+		return 1;
+	}
+	if(status == 0){
+		status = carveImage(model->image, regions.extents, regions.count, 0, writeCarveHit, out);
+	}
+	if(status != 0){
+		fprintf(stderr, "Carving failed\n");
+	}
+	freeExtentList(&regions);
+	return (status == 0) ? 0 : 1;
+}
+
+
+/*
+ * Function:  writeCarveHit 
+ * --------------------
+ * Carving visitor writing one "carvedFile" record
+ * 
+ * hit: The carved file
+ * context: The stream the record is written to
+ * int: 0 to continue carving
+ */
+static int writeCarveHit(const struct CarveHit *hit, void *context){
+	struct JsonRecord record;
+	beginJsonRecord(&record, context, "carvedFile");
+	addJsonString(&record, "type", hit->signature->name);
+	addJsonString(&record, "extension", hit->signature->extension);
+	addJsonInt(&record, "offset", (long long int)hit->offset);
+	addJsonInt(&record, "sector", (long long int)(hit->offset/SECTOR_SIZE));
+	addJsonInt(&record, "length", (long long int)hit->length);
+	addJsonBool(&record, "complete", hit->complete);
+	endJsonRecord(&record);
+	return 0;
+}
+
+
+/*
+ * Function:  hashImageFile 
+ * --------------------
+ * Hashes the image in one pass for chain of custody
+ * Writes a "blockHash" record per block (when a block size is given)
+ * as the image is read, then a "partitionHash" record per partition
+ * and finally the "imageHash" record
+ * 
+ * model: The volume model of the open disk image
+ * args: args[0] is the per-block hash size in KiB (a multiple of 4, 0 for none)
+ * out: Stream the records are written to
+ * int: 0 on success, 1 on failure
+ */
+static int hashImageFile(struct VolumeModel *model, char *args[], FILE *out){
+	//DATA DECLARATION
+	struct ImageExtent *ranges;
+	struct ImageDigest imageDigest, *partitionDigests;
+	struct JsonRecord record;
+	const struct Partition **hashed;
+	const struct Partition *partition;
+	unsigned long long int blockKiB;
+	uint64_t start, length;
+	size_t i, count = 0;
+	char *end;
+	int status;
+	//DATA MANIPULATION
+	blockKiB = strtoull(args[0], &end, 10);
+	if(*args[0] == '\0' || *end != '\0' || (blockKiB*1024) % HASH_ALIGN != 0){
+		fprintf(stderr, "Invalid block size: %s (KiB, a multiple of %d)\n", args[0], HASH_ALIGN/1024);
+		return 1;
+	}
+	ranges = calloc(model->partitionCount + 1, sizeof(struct ImageExtent));
+	partitionDigests = calloc(model->partitionCount + 1, sizeof(struct ImageDigest));
+	hashed = calloc(model->partitionCount + 1, sizeof(*hashed));
+	if(ranges == NULL || partitionDigests == NULL || hashed == NULL){
+		free(ranges);
+		free(partitionDigests);
+		free(hashed);
+		return 1;
+	}
+	for(i=0;i<model->partitionCount;i++){ //PARTITIONS HOLDING DATA, CLIPPED TO THE IMAGE
+		partition = &model->partitions[i];
+		if(partition->sectorCount == 0 || (partition->scheme != PARTITION_GPT && (partition->type == 0 || isExtendedPartitionType(partition->type) || (unsigned char)partition->type == 0xEE))){
+			continue;
+		}
+		start = partition->sectorStart*SECTOR_SIZE;
+		length = partition->sectorCount*SECTOR_SIZE;
+		start = (start < model->image->size) ? start : model->image->size;
+		length = (length < model->image->size - start) ? length : model->image->size - start;
+		ranges[count].offset = start;
+		ranges[count].length = length;
+		hashed[count++] = partition;
+	}
+	status = hashImage(model->image, ranges, count, blockKiB*1024, 0, writeBlockHash, out, &imageDigest, partitionDigests);
+	if(status != 0){
+		perror("Hashing failed");
+	}
+	for(i=0;i<count && status == 0;i++){
+		beginJsonRecord(&record, out, "partitionHash");
+		addJsonInt(&record, "index", hashed[i]->index);
+		addJsonInt(&record, "sectorStart", (long long int)hashed[i]->sectorStart);
+		addJsonInt(&record, "length", (long long int)ranges[i].length);
+		addJsonBool(&record, "truncated", ranges[i].length < hashed[i]->sectorCount*SECTOR_SIZE);
+		addJsonDigests(&record, &partitionDigests[i]);
+		endJsonRecord(&record);
+	}
+	if(status == 0){
+		beginJsonRecord(&record, out, "imageHash");
+		addJsonString(&record, "image", model->image->name);
+		addJsonString(&record, "format", model->image->backend->name); //DIGESTS ARE OF THE MEDIA, NOT THE SPLIT OR E01 CONTAINER FILES
+		addJsonInt(&record, "size", (long long int)model->image->size);
+		addJsonDigests(&record, &imageDigest);
+		endJsonRecord(&record);
+	}
+	free(ranges);
+	free(partitionDigests);
+	free(hashed);
+	return (status == 0) ? 0 : 1;
+}
+
+
+/*
+ * Function:  writeBlockHash 
+ * --------------------
+ * Hashing visitor writing one "blockHash" record
+ * 
+ * block: The hashed block
+ * context: The stream the record is written to
+ * int: 0 to continue hashing
+ */
+static int writeBlockHash(const struct HashBlock *block, void *context){
+	struct JsonRecord record;
+	char hex[65];
+	formatDigest(block->sha256, sizeof(block->sha256), hex);
+	beginJsonRecord(&record, context, "blockHash");
+	addJsonInt(&record, "index", (long long int)block->index);
+	addJsonInt(&record, "offset", (long long int)block->offset);
+	addJsonInt(&record, "length", (long long int)block->length);
+	addJsonString(&record, "sha256", hex);
+	endJsonRecord(&record);
+	return 0;
+}
+
+
+/*
+ * Function:  writeTimeline 
+ * --------------------
+ * Writes a "timelineEvent" record for every FAT directory entry time and
+ * NTFS $STANDARD_INFORMATION and $FILE_NAME time of every partition, oldest first
+ * The events are sorted within the memory budget, spilling sorted runs to
+ * temporary files and merging them when there are more than fit
+ * A "timeline" record with the totals follows the events
+ * 
+ * model: The volume model of the open disk image
+ * args: args[0] is the memory budget in MiB (at least 1)
+ * out: Stream the records are written to
+ * int: 0 on success, 1 on failure
+ */
+static int writeTimeline(struct VolumeModel *model, char *args[], FILE *out){
+	//DATA DECLARATION
+	struct TimelineSorter sorter;
+	struct JsonRecord record;
+	char *end;
+	unsigned long long int budget = strtoull(args[0], &end, 10);
+	size_t runs;
+	int status;
+	//DATA MANIPULATION
+	if(*end != '\0' || end == args[0] || budget == 0 || budget > SIZE_MAX/(1024*1024)){
+		fprintf(stderr, "Invalid memory budget: %s (MiB)\n", args[0]);
+		return 1;
+	}
+	if(beginTimeline(&sorter, (size_t)budget*1024*1024) != 0){
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+	errno = 0;
+	status = collectTimeline(model, &sorter);
+	runs = sorter.runCount + (sorter.runCount > 0 && sorter.keyCount > 0); //THE LAST RUN IS ONLY SPILLED IF OTHERS WERE
+	if(status == 0){
+		status = finishTimeline(&sorter, writeTimelineEvent, out);
+	}
+	if(status != 0){
+		fprintf(stderr, "Unable to build the timeline: %s\n", (errno != 0) ? strerror(errno) : "volume could not be read");
+	}
+	beginJsonRecord(&record, out, "timeline");
+	addJsonInt(&record, "events", (long long int)sorter.events);
+	addJsonInt(&record, "spilledRuns", (long long int)runs);
+	addJsonInt(&record, "memoryBudget", (long long int)sorter.budget);
+	addJsonBool(&record, "complete", status == 0);
+	endJsonRecord(&record);
+	freeTimeline(&sorter);
+	return (status == 0) ? 0 : 1;
+}
+
+
+/*
+ * Function:  writeTimelineEvent 
+ * --------------------
+ * Timeline visitor writing one "timelineEvent" record
+ * FAT times are local times, so they are written without the UTC 'Z'
+ * 
+ * event: The event
+ * context: The stream the record is written to
+ * int: 0 to continue the timeline
+ */
+static int writeTimelineEvent(const struct TimelineEvent *event, void *context){
+	static const char *sources[] = {"fat", "$SI", "$FN"};
+	struct JsonRecord record;
+	char text[40];
+	formatFileTime(event->time, text, sizeof(text));
+	if(event->source == TIMELINE_FAT && text[0] != '\0' && text[strlen(text) - 1] == 'Z'){
+		text[strlen(text) - 1] = '\0';
+	}
+	beginJsonRecord(&record, context, "timelineEvent");
+	addJsonString(&record, "time", text);
+	addJsonInt(&record, "fileTime", (long long int)event->time);
+	addJsonString(&record, "macb", event->macb);
+	addJsonString(&record, "source", sources[event->source]);
+	addJsonInt(&record, "partition", event->partition);
+	addJsonBool(&record, "deleted", event->deleted);
+	addJsonInt(&record, (event->source == TIMELINE_FAT) ? "entryOffset" : "mftRecord", (long long int)event->id);
+	addJsonString(&record, (event->source == TIMELINE_FAT) ? "path" : "name", event->name);
+	endJsonRecord(&record);
+	return 0;
+}
+
+
+/*
+ * Function:  writeChildRecords 
+ * --------------------
+ * Lists a directory: a "fatEntry" record for every entry of a FAT directory
+ * (given by its path, "/" for the root) or an "ntfsEntry" record for every
+ * file whose $FILE_NAME names an NTFS directory record as its parent
+ * From the image the whole FAT volume is walked or the whole $MFT scanned,
+ * from the metadata index only the directory's children are read
+ * 
+ * model: The volume model of the open disk image
+ * args: args[0] is the FAT directory path or the NTFS record number
+ * out: Stream the records are written to
+ * int: 0 on success, 1 if there is no such volume or it could not be read
+ */
+static int writeChildRecords(struct VolumeModel *model, char *args[], FILE *out){
+	//DATA DECLARATION
+	struct ChildrenContext context = {NULL, 0, out};
+	const struct MetadataIndex *index = model->index;
+	const struct IndexChild *children;
+	char *end;
+	size_t count, i;
+	int status = 0;
+	//DATA MANIPULATION
+	if(args[0][0] == '/'){ //FAT DIRECTORY PATH
+		if(!model->fat.present){
+			fprintf(stderr, "No FAT Volume found on this disk image\n");
+			return 1;
+		}
+		context.parentPath = (strcmp(args[0], "/") == 0) ? "" : args[0]; //ENTRY PATHS OF THE ROOT ARE "/NAME"
+		if(index == NULL){
+			status = walkFatDirectories(model->image, &model->fat, writeFatChild, &context);
+		}else if(context.parentPath[0] == '\0'){
+			children = findIndexedChildren(index->fatChildren, index->fatChildCount, INDEX_ROOT, &count);
+			status = walkIndexedFatEntries(index, children, count, writeFatChild, &context);
+		}else{
+			for(i=0;i<index->fatEntryCount && status == 0;i++){ //A DELETED DIRECTORY MAY SHARE ITS PATH WITH A LIVE ONE
+				if((index->fatEntries[i].attributes & 0x10) && strcmp(fetchIndexString(index, index->fatEntries[i].path), context.parentPath) == 0){
+					children = findIndexedChildren(index->fatChildren, index->fatChildCount, i + 1, &count);
+					status = walkIndexedFatEntries(index, children, count, writeFatChild, &context);
+				}
+			}
+		}
+	}else{ //NTFS DIRECTORY RECORD NUMBER
+		context.parentRecord = strtoull(args[0], &end, 10);
+		if(*end != '\0' || end == args[0]){
+			fprintf(stderr, "Invalid directory: %s (use a FAT path starting with / or an MFT record number)\n", args[0]);
+			return 1;
+		}
+		if(!model->ntfs.present){
+			fprintf(stderr, "No NTFS Volume found on this disk image\n");
+			return 1;
+		}
+		if(index == NULL){
+			status = scanMftRecords(model->image, &model->ntfs, 0, writeMftChild, &context);
+		}else{
+			children = findIndexedChildren(index->mftChildren, index->mftChildCount, context.parentRecord, &count);
+			status = scanIndexedMftRecords(index, children, count, writeMftChild, &context);
+		}
+	}
+	if(status != 0){
+		fprintf(stderr, "Unable to read the directory\n");
+	}
+	return (status == 0) ? 0 : 1;
+}
+
+
+/*
+ * Function:  writeFatChild 
+ * --------------------
+ * Directory walk visitor writing a "fatEntry" record for an entry of the listed directory
+ * 
+ * entry: The directory entry being visited
+ * context: The ChildrenContext of the command
+ * int: 0 to continue the walk
+ */
+static int writeFatChild(const struct FatDirEntry *entry, void *context){
+	struct ChildrenContext *children = context;
+	struct JsonRecord record;
+	size_t length = (size_t)(strrchr(entry->path, '/') - entry->path); //PATH OF THE DIRECTORY THE ENTRY IS IN
+	if(length != strlen(children->parentPath) || strncmp(entry->path, children->parentPath, length) != 0){
+		return 0;
+	}
+	beginJsonRecord(&record, children->out, "fatEntry");
+	addJsonString(&record, "path", entry->path);
+	addJsonBytes(&record, "shortName", entry->shortName, strlen(entry->shortName));
+	addJsonString(&record, "longName", entry->longName);
+	addJsonBool(&record, "directory", (entry->attributes & 0x10) != 0);
+	addJsonBool(&record, "deleted", entry->deleted);
+	addJsonBool(&record, "inDeletedDirectory", entry->parentDeleted);
+	addJsonInt(&record, "attributes", entry->attributes);
+	addJsonInt(&record, "startCluster", entry->startCluster);
+	addJsonInt(&record, "size", entry->fileSize);
+	addJsonInt(&record, "entryOffset", (long long int)entry->entryOffset);
+	endJsonRecord(&record);
+	return 0;
+}
+
+
+/*
+ * Function:  writeMftChild 
+ * --------------------
+ * MFT visitor writing an "ntfsEntry" record for a base record whose
+ * $FILE_NAME parent is the listed directory
+ * 
+ * mftRecord: The decoded MFT record
+ * context: The ChildrenContext of the command
+ * int: 0 to continue the scan
+ */
+static int writeMftChild(const struct MftRecord *mftRecord, void *context){
+	struct ChildrenContext *children = context;
+	struct JsonRecord record;
+	if(mftRecord->baseRecord != 0 || !mftRecord->hasFileName || mftRecord->fileName.parentRecord != children->parentRecord){
+		return 0;
+	}
+	beginJsonRecord(&record, children->out, "ntfsEntry");
+	addJsonInt(&record, "number", (long long int)mftRecord->number);
+	addJsonInt(&record, "sequence", mftRecord->sequence);
+	addJsonString(&record, "name", mftRecord->fileName.name);
+	addJsonBool(&record, "directory", mftRecord->isDirectory);
+	addJsonBool(&record, "inUse", mftRecord->inUse);
+	addJsonInt(&record, "parentSequence", mftRecord->fileName.parentSequence);
+	addJsonInt(&record, "size", (long long int)mftRecord->dataSize);
+	endJsonRecord(&record);
+	return 0;
+}
+
+
+/*
+ * Function:  writeIndexRecord 
+ * --------------------
+ * Writes a "metadataIndex" record describing the index of the image
+ * (runScanCommand has already written it if there was none or the image changed)
+ * 
+ * model: The volume model, loaded from the index
+ * args: Unused
+ * out: Stream the record is written to
+ * int: 0 on success, 1 if the index could not be written
+ */
+static int writeIndexRecord(struct VolumeModel *model, char *args[], FILE *out){
+	const struct MetadataIndex *index = model->index;
+	struct JsonRecord record;
+	if(index == NULL){
+		fprintf(stderr, "No metadata index (it could not be written, or --no-index was given)\n");
+		return 1;
+	}
+	beginJsonRecord(&record, out, "metadataIndex");
+	addJsonString(&record, "path", index->path);
+	addJsonBool(&record, "rebuilt", index->rebuilt);
+	addJsonInt(&record, "size", (long long int)index->size);
+	addJsonInt(&record, "partitions", (long long int)index->partitionCount);
+	addJsonInt(&record, "fatEntries", (long long int)index->fatEntryCount);
+	addJsonInt(&record, "fatExtents", (long long int)index->fatExtentCount);
+	addJsonInt(&record, "mftRecords", (long long int)index->mftRecordCount);
+	addJsonInt(&record, "mftRuns", (long long int)index->mftRunCount);
+	addJsonInt(&record, "mftBytes", (long long int)index->mftDataSize);
+	endJsonRecord(&record);
+	return 0;
+}
+
+
+/*
+ * Function:  writePathRecords 
+ * --------------------
+ * Rebuilds the NTFS directory tree and writes one "ntfsPath" record per
+ * named base record in record order, then an "ntfsTree" summary record
+ * 
+ * model: The volume model of the open disk image
+ * args: Unused
+ * out: Stream the records are written to
+ * int: 0 on success, 1 on failure
+ */
+static int writePathRecords(struct VolumeModel *model, char *args[], FILE *out){
+	//DATA DECLARATION
+	struct NtfsTree tree;
+	struct JsonRecord record;
+	const char *path;
+	char *buffer;
+	uint64_t number, paths = 0;
+	int orphan;
+	//DATA MANIPULATION
+	if(!model->ntfs.present){
+		fprintf(stderr, "No NTFS Volume found on this disk image\n");
+		return 1;
+	}
+	buffer = malloc(NTFS_PATH_MAX);
+	if(buffer == NULL || buildNtfsTree(model, &tree) != 0){
+		fprintf(stderr, "Unable to read the $MFT\n");
+		free(buffer);
+		return 1;
+	}
+	for(number=0;number<tree.count;number++){
+		path = resolveNtfsPath(&tree, number, buffer, NTFS_PATH_MAX, &orphan);
+		if(path == NULL){
+			continue;
+		}
+		beginJsonRecord(&record, out, "ntfsPath");
+		addJsonInt(&record, "number", (long long int)number);
+		addJsonInt(&record, "sequence", tree.nodes[number].sequence);
+		addJsonBool(&record, "inUse", (tree.nodes[number].flags & NTFS_NODE_IN_USE) != 0);
+		addJsonBool(&record, "directory", (tree.nodes[number].flags & NTFS_NODE_DIRECTORY) != 0);
+		addJsonBool(&record, "orphan", orphan);
+		addJsonString(&record, "path", path);
+		endJsonRecord(&record);
+		paths++;
+	}
+	beginJsonRecord(&record, out, "ntfsTree");
+	addJsonInt(&record, "paths", (long long int)paths);
+	addJsonInt(&record, "orphans", (long long int)tree.orphans);
+	addJsonInt(&record, "distinctNames", (long long int)tree.names.count);
+	addJsonInt(&record, "nameBytes", (long long int)tree.names.used);
+	endJsonRecord(&record);
+	freeNtfsTree(&tree);
+	free(buffer);
+	return 0;
+}
+
+
+/*
+ * Function:  writeIndexEntries 
+ * --------------------
+ * Writes one "indexEntry" record per entry of an NTFS directory's $I30 index
+ * 
+ * model: The volume model of the open disk image
+ * args: The directory's MFT record number
+ * out: Stream the records are written to
+ * int: 0 on success, 1 on failure
+ */
+static int writeIndexEntries(struct VolumeModel *model, char *args[], FILE *out){
+	char *end;
+	uint64_t number = strtoull(args[0], &end, 10);
+	if(*end != '\0' || end == args[0]){
+		fprintf(stderr, "Invalid record number: %s\n", args[0]);
+		return 1;
+	}
+	if(!model->ntfs.present){
+		fprintf(stderr, "No NTFS Volume found on this disk image\n");
+		return 1;
+	}
+	if(walkNtfsIndex(model->image, &model->ntfs, number, writeIndexEntry, out) != 0){
+		fprintf(stderr, "Unable to read the $I30 index of record %s\n", args[0]);
+		return 1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  writeIndexEntry 
+ * --------------------
+ * walkNtfsIndex visitor writing one "indexEntry" record
+ * The times and sizes are those of the entry's copy of the $FILE_NAME,
+ * which may be older than the ones in the file's own record
+ * 
+ * entry: The index entry
+ * context: Output stream
+ * int: 0 to continue
+ */
+static int writeIndexEntry(const struct NtfsIndexEntry *entry, void *context){
+	struct JsonRecord record;
+	char text[32];
+	beginJsonRecord(&record, context, "indexEntry");
+	addJsonInt(&record, "number", (long long int)entry->record);
+	addJsonInt(&record, "sequence", entry->sequence);
+	addJsonString(&record, "name", entry->fileName.name);
+	addJsonInt(&record, "nameSpace", entry->fileName.nameSpace);
+	addJsonBool(&record, "directory", (entry->fileName.flags & 0x10000000) != 0); //DUPLICATED FILE_NAME_INDEX_PRESENT FLAG
+	addJsonInt(&record, "parentRecord", (long long int)entry->fileName.parentRecord);
+	addJsonInt(&record, "size", (long long int)entry->fileName.realSize);
+	formatFileTime(entry->fileName.modified, text, sizeof(text));
+	addJsonString(&record, "modified", text);
+	addJsonString(&record, "location", entry->inAllocation ? "allocation" : "root");
+	if(entry->inAllocation){
+		addJsonInt(&record, "vcn", (long long int)entry->vcn);
+	}
+	endJsonRecord(&record);
+	return 0;
+}
+
+
+/*
+ * Function:  writeSearchHits 
+ * --------------------
+ * Searches the whole image and writes one "searchHit" record per match,
+ * placed in its partition and file through a reverse map built first,
+ * then a "searchSummary" record
+ * 
+ * model: The volume model of the open disk image
+ * args: args[0] is the mode (keyword or regex), args[1] the pattern
+ * out: Stream the records are written to
+ * int: 0 on success, 1 on failure
+ */
+static int writeSearchHits(struct VolumeModel *model, char *args[], FILE *out){
+	//DATA DECLARATION
+	struct SearchContext context;
+	struct ImageExtent whole;
+	struct JsonRecord record;
+	int mode, status;
+	//DATA MANIPULATION
+	if(strcmp(args[0], "keyword") == 0){
+		mode = SEARCH_KEYWORD;
+	}else if(strcmp(args[0], "regex") == 0){
+		mode = SEARCH_REGEX;
+	}else{
+		fprintf(stderr, "Unknown search mode: %s (use keyword or regex)\n", args[0]);
+		return 1;
+	}
+	memset(&context, 0, sizeof(context));
+	context.out = out;
+	context.pathBuffer = malloc(NTFS_PATH_MAX);
+	if(context.pathBuffer == NULL || buildFileMap(model, &context.map) != 0){
+		fprintf(stderr, "Unable to map the files of the image\n");
+		free(context.pathBuffer);
+		return 1;
+	}
+	whole.offset = 0;
+	whole.length = model->image->size;
+	status = searchImage(model->image, &whole, 1, mode, args[1], 0, writeSearchHit, &context);
+	if(status == -2){
+		fprintf(stderr, "Invalid search pattern: %s\n", args[1]);
+	}else if(status != 0){
+		fprintf(stderr, "Search failed\n");
+	}else{
+		beginJsonRecord(&record, out, "searchSummary");
+		addJsonInt(&record, "hits", (long long int)context.hits);
+		addJsonInt(&record, "mappedFiles", (long long int)context.map.fileCount);
+		addJsonInt(&record, "mappedExtents", (long long int)context.map.count);
+		endJsonRecord(&record);
+	}
+	freeFileMap(&context.map);
+	free(context.pathBuffer);
+	return (status == 0) ? 0 : 1;
+}
+
+
+/*
+ * Function:  writeSearchHit 
+ * --------------------
+ * Search visitor writing one "searchHit" record with what holds the match:
+ * a file's content or slack, unallocated space, space outside the
+ * partitions, or file system metadata. A hit in the $MFT also names
+ * the file record it falls in
+ * 
+ * hit: The match
+ * context: The SearchContext
+ * int: 0 to continue searching
+ */
+static int writeSearchHit(const struct SearchHit *hit, void *context){
+	//DATA DECLARATION
+	static const char *const locationNames[] = {"file", "slack", "unallocated", "metadata", "unpartitioned"};
+	struct SearchContext *search = context;
+	struct FileLocation location;
+	struct JsonRecord record;
+	char preview[SEARCH_PREVIEW_BYTES];
+	const char *path;
+	size_t i, length;
+	//DATA MANIPULATION
+	locateImageOffset(&search->map, hit->offset, &location);
+	if(hit->encoding == SEARCH_UTF16LE){ //SHOW THE KEYWORD, NOT ITS ZERO BYTES
+		for(length=0, i=0;i<hit->length && length<sizeof(preview);i+=2){
+			preview[length++] = (char)hit->data[i];
+		}
+	}else{
+		length = (hit->length < sizeof(preview)) ? hit->length : sizeof(preview);
+		memcpy(preview, hit->data, length);
+	}
+	beginJsonRecord(&record, search->out, "searchHit");
+	addJsonInt(&record, "offset", (long long int)hit->offset);
+	addJsonInt(&record, "sector", (long long int)(hit->offset/SECTOR_SIZE));
+	addJsonInt(&record, "length", (long long int)hit->length);
+	addJsonString(&record, "encoding", (hit->encoding == SEARCH_UTF16LE) ? "utf16le" : "ascii");
+	addJsonBytes(&record, "match", preview, length);
+	addJsonString(&record, "location", locationNames[location.kind]);
+	addJsonBool(&record, "allocated", location.allocated);
+	if(location.volume != NULL){
+		addJsonInt(&record, "partition", location.volume->partition);
+		addJsonString(&record, "fileSystem", (location.volume->fileSystem == FILESYSTEM_FAT) ? "FAT" : "NTFS");
+	}
+	if(location.file != NULL){
+		path = fetchFileMapPath(&search->map, location.file, search->pathBuffer, NTFS_PATH_MAX);
+		if(path != NULL){
+			addJsonString(&record, "path", path);
+		}
+		if(location.volume->fileSystem == FILESYSTEM_NTFS){
+			addJsonInt(&record, "fileRecord", (long long int)location.file->owner);
+		}else if(location.file->owner != 0){ //THE FAT12/16 ROOT DIRECTORY HAS NO ENTRY
+			addJsonInt(&record, "entryOffset", (long long int)location.file->owner);
+		}
+		addJsonInt(&record, "fileOffset", (long long int)location.fileOffset);
+		addJsonBool(&record, "deleted", (location.file->flags & FILE_MAP_DELETED) != 0);
+		addJsonBool(&record, "directory", (location.file->flags & FILE_MAP_DIRECTORY) != 0);
+		if(location.volume->fileSystem == FILESYSTEM_NTFS && location.file->owner == 0 && !(location.file->flags & FILE_MAP_DIRECTORY) && location.volume->mftRecordSize > 0){
+			addJsonInt(&record, "mftRecord", (long long int)(location.fileOffset/(uint64_t)location.volume->mftRecordSize));
+		}
+	}
+	endJsonRecord(&record);
+	search->hits++;
+	return 0;
+}
+
+
+/*
+ * Function:  addJsonDigests 
+ * --------------------
+ * Adds the md5, sha1 and sha256 fields of a digest set to a record
+ * 
+ * record: The record being written
+ * digest: The digests
+ */
+static void addJsonDigests(struct JsonRecord *record, const struct ImageDigest *digest){
+	char hex[65];
+	formatDigest(digest->md5, sizeof(digest->md5), hex);
+	addJsonString(record, "md5", hex);
+	formatDigest(digest->sha1, sizeof(digest->sha1), hex);
+	addJsonString(record, "sha1", hex);
+	formatDigest(digest->sha256, sizeof(digest->sha256), hex);
+	addJsonString(record, "sha256", hex);
+}
+
+
+/*
+ * Function:  createOutputFile 
+ * --------------------
+ * Creates the output file for a recovered file below outDir,
+ * creating the directories of its path as needed
+ * "." and ".." path components are replaced so nothing is written outside outDir
+ * If the name is already taken (a deleted and a live file sharing a name)
+ * the entry offset is added to the name
+ * 
+ * outDir: Output directory
+ * path: Path of the file on the volume (starts with '/')
+ * entryOffset: Byte offset of the file's directory entry
+ * outPath: Buffer the output path is written to
+ * outPathSize: Size of outPath
+ * int: Descriptor of the new file, -1 on failure
+ */
+static int createOutputFile(const char *outDir, const char *path, uint64_t entryOffset, char *outPath, size_t outPathSize){
+	//DATA DECLARATION
+	size_t used, start;
+	char *slash;
+	int outFd;
+	//DATA MANIPULATION
+	used = (size_t)snprintf(outPath, outPathSize, "%s", outDir);
+	start = used;
+	snprintf(outPath + used, outPathSize - used, "%s", path);
+	for(slash = outPath + start;slash != NULL && *slash != '\0';slash = strchr(slash + 1, '/')){ //MAKE EACH PARENT DIRECTORY
+		if((slash[1] == '.' && (slash[2] == '/' || slash[2] == '\0')) || (slash[1] == '.' && slash[2] == '.' && (slash[3] == '/' || slash[3] == '\0'))){
+			slash[1] = '_';
+		}
+		if(slash != outPath + start){
+			*slash = '\0';
+			mkdir(outPath, 0755);
+			*slash = '/';
+		}
+	}
+	outFd = open(outPath, O_WRONLY | O_CREAT | O_EXCL, 0644);
+	if(outFd < 0 && errno == EEXIST){
+		used = strlen(outPath);
+		snprintf(outPath + used, outPathSize - used, "~%llu", (unsigned long long)entryOffset);
+		outFd = open(outPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	}
+	return outFd;
+}
@@ -0,0 +1,40 @@
+/*
+ * scanCommands.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Non-interactive command line interface
+ * Runs a single subcommand against an image and streams
+ * the results to stdout as newline-delimited JSON.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef SCANCOMMANDS_H
+#define SCANCOMMANDS_H
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include "volumeModel.h"
+#include "scanStats.h"
+
+#define COMMAND_INDEX_READ 0x01 //ANSWERED FROM THE METADATA INDEX WHEN THE IMAGE HAS ONE (REBUILT IF THE IMAGE CHANGED)
+#define COMMAND_INDEX_CREATE 0x02 //ALSO CREATES THE INDEX WHEN THE IMAGE HAS NONE
+#define COMMAND_SERVED 0x04 //ONLY READS THE MODEL AND THE IMAGE, SO THE QUERY DAEMON MAY RUN IT
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct ScanCommand{
+	const char *name; //SUBCOMMAND TYPED ON THE COMMAND LINE
+	const char *arguments; //ARGUMENTS AFTER THE IMAGE PATH FOR THE USAGE MESSAGE
+	int argumentCount; //NUMBER OF ARGUMENTS EXPECTED AFTER THE IMAGE PATH
+	const char *summary; //ONE LINE DESCRIPTION FOR THE USAGE MESSAGE
+	enum StatsStage stage; //STAGE THE COMMAND IS TIMED AS WITH --stats
+	int flags; //COMMAND_INDEX_READ, COMMAND_INDEX_CREATE AND COMMAND_SERVED
+	int (*run)(struct VolumeModel *model, char *args[], FILE *out);
+};
+
+int runScanCommand(int argc, char *argv[]);
+const struct ScanCommand *findScanCommand(const char *name, int argumentCount);
+void printScanUsage(const char *programName);
+
+#endif
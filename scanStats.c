@@ -0,0 +1,249 @@
+/*
+ * scanStats.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Hot path instrumentation
+ * The global counters are updated with relaxed atomic adds from any thread.
+ * Stages are begun and ended on the main thread; each one keeps the
+ * change in the counters and in the process resource usage over the stage,
+ * so the report shows where the I/O and the time of a run went.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "scanStats.h"
+#include "jsonOutput.h"
+
+struct StatsSnapshot{
+	uint64_t wallNanoseconds; //MONOTONIC CLOCK
+	uint64_t userMicroseconds; //CPU TIME OF EVERY THREAD OF THE PROCESS
+	uint64_t systemMicroseconds;
+	uint64_t majorFaults; //PAGE FAULTS THAT HAD TO READ THE DISK
+	uint64_t minorFaults;
+	struct StatsCounters counters;
+};
+
+struct StatsStageTotal{
+	uint64_t runs; //TIMES THE STAGE WAS ENTERED
+	struct StatsSnapshot total; //SUM OF THE DIFFERENCES OVER EACH RUN
+	struct StatsSnapshot start; //TAKEN WHEN THE CURRENT RUN BEGAN
+};
+
+int statsMode = STATS_OFF;
+struct StatsCounters statsCounters;
+
+static const char *const statsStageNames[STATS_STAGE_COUNT] = {"partition", "fat", "ntfs", "deleted", "mft", "recover", "extract", "freespace", "carve", "hash", "timeline", "children", "index", "paths", "i30", "search"};
+static struct StatsStageTotal statsStages[STATS_STAGE_COUNT];
+static uint64_t lastReadEnd; //END OF THE PREVIOUS REQUEST, FOR THE SEEK DISTANCE
+
+static void takeStatsSnapshot(struct StatsSnapshot *snapshot);
+static void addStatsCounters(uint64_t *total, const uint64_t *end, const uint64_t *start, size_t count);
+static void writeStatsRecord(FILE *out, const char *stage, uint64_t runs, const struct StatsSnapshot *total);
+static void writeStatsRow(FILE *out, const char *stage, uint64_t runs, const struct StatsSnapshot *total);
+
+
+/*
+ * Function:  recordImageRead 
+ * --------------------
+ * Counts a view or copy of the image and the distance from the last one
+ * Called through countImageRead only while stats are enabled
+ * 
+ * offset: Byte offset of the range
+ * length: Length of the range in bytes
+ */
+void recordImageRead(uint64_t offset, uint64_t length){
+	uint64_t previous = __atomic_exchange_n(&lastReadEnd, offset + length, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&statsCounters.views, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&statsCounters.bytesRead, length, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&statsCounters.seekDistance, (offset > previous) ? offset - previous : previous - offset, __ATOMIC_RELAXED);
+}
+
+
+/*
+ * Function:  fetchStatsClock 
+ * --------------------
+ * Reads the monotonic clock
+ * 
+ * uint64_t: Nanoseconds since an arbitrary starting point
+ */
+uint64_t fetchStatsClock(void){
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec*1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+
+/*
+ * Function:  beginStatsStage 
+ * --------------------
+ * Marks the start of a stage (does nothing while stats are disabled)
+ * 
+ * stage: The stage being entered
+ */
+void beginStatsStage(enum StatsStage stage){
+	if(statsMode == STATS_OFF){
+		return;
+	}
+	takeStatsSnapshot(&statsStages[stage].start);
+}
+
+
+/*
+ * Function:  endStatsStage 
+ * --------------------
+ * Adds the time, faults and counters since beginStatsStage to the stage
+ * 
+ * stage: The stage being left
+ */
+void endStatsStage(enum StatsStage stage){
+	struct StatsStageTotal *total = &statsStages[stage];
+	struct StatsSnapshot end;
+	if(statsMode == STATS_OFF){
+		return;
+	}
+	takeStatsSnapshot(&end);
+	addStatsCounters((uint64_t*)&total->total, (const uint64_t*)&end, (const uint64_t*)&total->start, sizeof(end)/sizeof(uint64_t));
+	total->runs++;
+}
+
+
+/*
+ * Function:  writeStatsReport 
+ * --------------------
+ * Writes the stages that ran and the run totals
+ * As a table on stderr for --stats, or as one "stats" record per stage
+ * on the output stream for --stats=json
+ * 
+ * out: Stream the JSON records are written to
+ */
+void writeStatsReport(FILE *out){
+	static const struct StatsSnapshot empty;
+	struct StatsSnapshot all;
+	int i;
+	if(statsMode == STATS_OFF){
+		return;
+	}
+	memset(&all, 0, sizeof(all));
+	if(statsMode == STATS_TEXT){
+		fprintf(stderr, "%-10s %5s %10s %10s %10s %8s %8s %12s %10s %14s %10s %10s\n", "stage", "runs", "wall(s)", "user(s)", "system(s)", "majflt", "views", "MiB read", "reads", "MiB seeked", "cacheHit", "cacheMiss");
+	}
+	for(i=0;i<STATS_STAGE_COUNT;i++){
+		if(statsStages[i].runs == 0){
+			continue;
+		}
+		addStatsCounters((uint64_t*)&all, (const uint64_t*)&statsStages[i].total, (const uint64_t*)&empty, sizeof(all)/sizeof(uint64_t));
+		if(statsMode == STATS_TEXT){
+			writeStatsRow(stderr, statsStageNames[i], statsStages[i].runs, &statsStages[i].total);
+		}else{
+			writeStatsRecord(out, statsStageNames[i], statsStages[i].runs, &statsStages[i].total);
+		}
+	}
+	all.counters.outputRecords = statsCounters.outputRecords; //OUTPUT IS COUNTED FOR THE WHOLE RUN, NOT PER STAGE
+	all.counters.outputNanoseconds = statsCounters.outputNanoseconds;
+	if(statsMode == STATS_TEXT){
+		writeStatsRow(stderr, "total", 1, &all);
+		fprintf(stderr, "output: %llu records in %.3f s\n", (unsigned long long int)all.counters.outputRecords, all.counters.outputNanoseconds/1e9);
+	}else{
+		writeStatsRecord(out, "total", 1, &all);
+	}
+}
+
+
+/*
+ * Function:  takeStatsSnapshot 
+ * --------------------
+ * Reads the clock, the resource usage of the process and the counters
+ * 
+ * snapshot: Filled in with the current values
+ */
+static void takeStatsSnapshot(struct StatsSnapshot *snapshot){
+	const uint64_t *counter = (const uint64_t*)&statsCounters;
+	uint64_t *copy = (uint64_t*)&snapshot->counters;
+	struct rusage usage;
+	size_t i;
+	getrusage(RUSAGE_SELF, &usage);
+	snapshot->wallNanoseconds = fetchStatsClock();
+	snapshot->userMicroseconds = (uint64_t)usage.ru_utime.tv_sec*1000000 + (uint64_t)usage.ru_utime.tv_usec;
+	snapshot->systemMicroseconds = (uint64_t)usage.ru_stime.tv_sec*1000000 + (uint64_t)usage.ru_stime.tv_usec;
+	snapshot->majorFaults = (uint64_t)usage.ru_majflt;
+	snapshot->minorFaults = (uint64_t)usage.ru_minflt;
+	for(i=0;i<sizeof(statsCounters)/sizeof(uint64_t);i++){ //EACH COUNTER IS READ ATOMICALLY, WORKERS MAY STILL BE ADDING
+		copy[i] = __atomic_load_n(&counter[i], __ATOMIC_RELAXED);
+	}
+}
+
+
+/*
+ * Function:  addStatsCounters 
+ * --------------------
+ * Adds end - start to total field by field
+ * Snapshots are made only of uint64_t fields so they are added as arrays
+ * 
+ * total: Fields added to
+ * end: Values at the end of the run
+ * start: Values at the start of the run
+ * count: Number of uint64_t fields
+ */
+static void addStatsCounters(uint64_t *total, const uint64_t *end, const uint64_t *start, size_t count){
+	size_t i;
+	for(i=0;i<count;i++){
+		total[i] += end[i] - start[i];
+	}
+}
+
+
+/*
+ * Function:  writeStatsRecord 
+ * --------------------
+ * Writes one "stats" record
+ * 
+ * out: Stream the record is written to
+ * stage: Stage name ("total" for the whole run)
+ * runs: Times the stage was entered
+ * total: The stage totals
+ */
+static void writeStatsRecord(FILE *out, const char *stage, uint64_t runs, const struct StatsSnapshot *total){
+	struct JsonRecord record;
+	beginJsonRecord(&record, out, "stats");
+	addJsonString(&record, "stage", stage);
+	addJsonInt(&record, "runs", (long long int)runs);
+	addJsonDouble(&record, "wallSeconds", total->wallNanoseconds/1e9);
+	addJsonDouble(&record, "userSeconds", total->userMicroseconds/1e6);
+	addJsonDouble(&record, "systemSeconds", total->systemMicroseconds/1e6);
+	addJsonInt(&record, "majorFaults", (long long int)total->majorFaults);
+	addJsonInt(&record, "minorFaults", (long long int)total->minorFaults);
+	addJsonInt(&record, "views", (long long int)total->counters.views);
+	addJsonInt(&record, "bytesRead", (long long int)total->counters.bytesRead);
+	addJsonInt(&record, "readCalls", (long long int)total->counters.readCalls);
+	addJsonInt(&record, "seekDistance", (long long int)total->counters.seekDistance);
+	addJsonInt(&record, "cacheHits", (long long int)total->counters.cacheHits);
+	addJsonInt(&record, "cacheMisses", (long long int)total->counters.cacheMisses);
+	if(strcmp(stage, "total") == 0){
+		addJsonInt(&record, "outputRecords", (long long int)total->counters.outputRecords);
+		addJsonDouble(&record, "outputSeconds", total->counters.outputNanoseconds/1e9);
+	}
+	endJsonRecord(&record);
+}
+
+
+/*
+ * Function:  writeStatsRow 
+ * --------------------
+ * Writes one row of the --stats summary table
+ * 
+ * out: Stream the row is written to
+ * stage: Stage name ("total" for the whole run)
+ * runs: Times the stage was entered
+ * total: The stage totals
+ */
+static void writeStatsRow(FILE *out, const char *stage, uint64_t runs, const struct StatsSnapshot *total){
+	fprintf(out, "%-10s %5llu %10.3f %10.3f %10.3f %8llu %8llu %12.1f %10llu %14.1f %10llu %10llu\n", stage, (unsigned long long int)runs,
+		total->wallNanoseconds/1e9, total->userMicroseconds/1e6, total->systemMicroseconds/1e6, (unsigned long long int)total->majorFaults,
+		(unsigned long long int)total->counters.views, total->counters.bytesRead/1048576.0, (unsigned long long int)total->counters.readCalls,
+		total->counters.seekDistance/1048576.0, (unsigned long long int)total->counters.cacheHits, (unsigned long long int)total->counters.cacheMisses);
+}
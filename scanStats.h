@@ -0,0 +1,97 @@
+/*
+ * scanStats.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Hot path instrumentation
+ * Counts image reads, read system calls, seek distance, EWF cache hits
+ * and JSON output, and times each stage (wall, user and system time).
+ * Every counter is behind a single flag test so the instrumentation
+ * costs next to nothing unless --stats was given.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef SCANSTATS_H
+#define SCANSTATS_H
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdint.h>
+
+#define STATS_OFF 0 //statsMode VALUES
+#define STATS_TEXT 1 //SUMMARY TABLE ON STDERR
+#define STATS_JSON 2 //"stats" RECORDS ON STDOUT
+
+//FUNCTION & STRUCT DECLARATIONS:
+enum StatsStage{
+	STATS_PARTITION, //PARTITION TABLE (MBR, EBR CHAIN OR GPT)
+	STATS_FAT, //FAT BOOT SECTOR AND TABLE
+	STATS_NTFS, //NTFS BOOT SECTOR AND $MFT RUNS
+	STATS_DELETED, //DELETED ENTRY SCAN OF EVERY FAT DIRECTORY
+	STATS_MFT, //$MFT RECORD PARSING
+	STATS_RECOVER,
+	STATS_EXTRACT,
+	STATS_FREESPACE, //UNALLOCATED SPACE AND SLACK WRITTEN OUT
+	STATS_CARVE,
+	STATS_HASH,
+	STATS_TIMELINE, //TIMESTAMPS COLLECTED, SORTED AND WRITTEN
+	STATS_CHILDREN,
+	STATS_INDEX, //METADATA INDEX WRITTEN FROM THE IMAGE
+	STATS_PATHS, //NTFS DIRECTORY TREE BUILT AND EVERY PATH RESOLVED
+	STATS_I30, //$I30 INDEX OF ONE DIRECTORY WALKED
+	STATS_SEARCH, //IMAGE SEARCHED FOR A KEYWORD OR EXPRESSION AND EACH HIT PLACED IN ITS FILE
+	STATS_STAGE_COUNT
+};
+
+struct StatsCounters{
+	uint64_t views; //VIEWS AND COPIES OF THE IMAGE REQUESTED BY THE PARSERS
+	uint64_t bytesRead; //BYTES COVERED BY THOSE REQUESTS
+	uint64_t seekDistance; //BYTES BETWEEN THE END OF ONE REQUEST AND THE START OF THE NEXT
+	uint64_t readCalls; //READ SYSTEM CALLS MADE BY THE BACKENDS (NONE WHILE THE IMAGE IS MAPPED)
+	uint64_t cacheHits; //EWF CHUNKS SERVED FROM THE CHUNK CACHE
+	uint64_t cacheMisses; //EWF CHUNKS A READER HAD TO INFLATE ITSELF
+	uint64_t outputRecords; //JSON RECORDS WRITTEN
+	uint64_t outputNanoseconds; //TIME SPENT FORMATTING AND WRITING THEM
+};
+
+extern int statsMode;
+extern struct StatsCounters statsCounters;
+
+void recordImageRead(uint64_t offset, uint64_t length);
+uint64_t fetchStatsClock(void);
+void beginStatsStage(enum StatsStage stage);
+void endStatsStage(enum StatsStage stage);
+void writeStatsReport(FILE *out);
+
+
+/*
+ * Function:  countImageRead 
+ * --------------------
+ * Counts a view or copy of the image (inlined so the disabled case is one test)
+ * 
+ * offset: Byte offset of the range
+ * length: Length of the range in bytes
+ */
+static inline void countImageRead(uint64_t offset, uint64_t length){
+	if(statsMode != STATS_OFF){
+		recordImageRead(offset, length);
+	}
+}
+
+
+/*
+ * Function:  countStat 
+ * --------------------
+ * Adds to one of the global counters (safe from any thread)
+ * 
+ * counter: Field of statsCounters
+ * amount: Value added
+ */
+static inline void countStat(uint64_t *counter, uint64_t amount){
+	if(statsMode != STATS_OFF){
+		__atomic_fetch_add(counter, amount, __ATOMIC_RELAXED);
+	}
+}
+
+#endif
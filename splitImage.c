@@ -0,0 +1,280 @@
+/*
+ * splitImage.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Split raw image backend
+ * Opens every numbered segment of a split raw image and maps image
+ * offsets to a segment with a binary search over the segment starts.
+ * Reads that cross a segment boundary are served from both segments.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "splitImage.h"
+#include "scanStats.h"
+
+struct SplitSegment{
+	int fd; //DESCRIPTOR OF THE SEGMENT FILE
+	uint64_t start; //IMAGE OFFSET OF THE FIRST BYTE OF THE SEGMENT
+	uint64_t length; //SIZE OF THE SEGMENT FILE
+};
+
+struct SplitImage{
+	struct SplitSegment *segments; //SEGMENTS IN IMAGE ORDER
+	size_t count;
+};
+
+static int probeSplitImage(const char *fileName, const unsigned char *header, size_t length);
+static int openSplitImage(const char *fileName, struct DiskImage *image);
+static int readSplitImage(struct DiskImage *image, uint64_t offset, unsigned char *buffer, size_t length);
+static void adviseSplitImage(struct DiskImage *image, uint64_t offset, uint64_t length);
+static void closeSplitImage(struct DiskImage *image);
+static size_t findSplitSegment(const struct SplitImage *split, uint64_t offset);
+static size_t fetchSegmentDigits(const char *fileName);
+
+const struct ImageBackend splitImageBackend = {"split", probeSplitImage, openSplitImage, readSplitImage, adviseSplitImage, closeSplitImage};
+
+
+/*
+ * Function:  probeSplitImage 
+ * --------------------
+ * Recognises the first segment of a split image by its numbered
+ * extension (.001, or .01/.0001 for tools that pad differently)
+ * 
+ * fileName: The fileName of the disk image
+ * header: The first bytes of the file (unused, raw segments have no signature)
+ * length: Number of bytes in header
+ * int: 1 if fileName is the first segment of a split image, 0 otherwise
+ */
+static int probeSplitImage(const char *fileName, const unsigned char *header, size_t length){
+	size_t digits = fetchSegmentDigits(fileName);
+	size_t nameLength = strlen(fileName);
+	size_t i;
+	if(digits < 2){
+		return 0;
+	}
+	for(i=nameLength-digits;i<nameLength-1;i++){ //ALL ZEROS FOLLOWED BY A ONE
+		if(fileName[i] != '0'){
+			return 0;
+		}
+	}
+	return fileName[nameLength-1] == '1';
+}
+
+
+/*
+ * Function:  openSplitImage 
+ * --------------------
+ * Opens the first segment and every following segment that exists
+ * 
+ * fileName: The fileName of the first segment
+ * image: Pointer to the image struct to be filled in
+ * int: 0 on success, -1 if a segment could not be opened (errno is set)
+ */
+static int openSplitImage(const char *fileName, struct DiskImage *image){
+	//DATA DECLARATION
+	struct SplitImage *split;
+	struct SplitSegment *grown;
+	struct stat segmentStat;
+	size_t digits = fetchSegmentDigits(fileName), nameLength = strlen(fileName), capacity = 0;
+	char *segmentName;
+	unsigned int number;
+	int fd;
+	//DATA MANIPULATION
+	split = calloc(1, sizeof(*split));
+	segmentName = malloc(nameLength + 1);
+	if(split == NULL || segmentName == NULL){
+		free(split);
+		free(segmentName);
+		return -1;
+	}
+	image->state = split;
+	memcpy(segmentName, fileName, nameLength + 1);
+	for(number=1;number<=SPLIT_MAX_SEGMENTS;number++){
+		snprintf(segmentName + nameLength - digits, digits + 1, "%0*u", (int)digits, number);
+		if(strlen(segmentName) != nameLength){ //RAN OUT OF DIGITS
+			break;
+		}
+		fd = open(segmentName, O_RDONLY);
+		if(fd < 0){
+			if(number > 1 && errno == ENOENT){ //NO MORE SEGMENTS
+				break;
+			}
+			free(segmentName);
+			closeSplitImage(image);
+			return -1;
+		}
+		if(split->count == capacity){
+			capacity = capacity ? capacity*2 : 16;
+			grown = realloc(split->segments, capacity*sizeof(*grown));
+			if(grown == NULL){
+				close(fd);
+				free(segmentName);
+				closeSplitImage(image);
+				return -1;
+			}
+			split->segments = grown;
+		}
+		if(fstat(fd, &segmentStat) != 0){
+			close(fd);
+			free(segmentName);
+			closeSplitImage(image);
+			return -1;
+		}
+		split->segments[split->count].fd = fd;
+		split->segments[split->count].start = image->size;
+		split->segments[split->count].length = (uint64_t)segmentStat.st_size;
+		image->size += (uint64_t)segmentStat.st_size;
+		split->count++;
+	}
+	free(segmentName);
+	return 0;
+}
+
+
+/*
+ * Function:  readSplitImage 
+ * --------------------
+ * Fills a buffer from the segments covering a range, retrying short reads
+ * 
+ * image: The open disk image
+ * offset: Byte offset into the image
+ * buffer: Buffer to read into
+ * length: Number of bytes to read (inside the image)
+ * int: 0 on success, -1 on a read error (errno is set)
+ */
+static int readSplitImage(struct DiskImage *image, uint64_t offset, unsigned char *buffer, size_t length){
+	struct SplitImage *split = image->state;
+	struct SplitSegment *segment;
+	size_t s = findSplitSegment(split, offset), done = 0, wanted;
+	ssize_t got;
+	while(done < length && s < split->count){
+		segment = &split->segments[s];
+		if(offset + done >= segment->start + segment->length){ //CONTINUES IN THE NEXT SEGMENT
+			s++;
+			continue;
+		}
+		wanted = length - done;
+		if(wanted > segment->start + segment->length - (offset + done)){
+			wanted = (size_t)(segment->start + segment->length - (offset + done));
+		}
+		got = pread(segment->fd, buffer + done, wanted, (off_t)(offset + done - segment->start));
+		countStat(&statsCounters.readCalls, 1);
+		if(got < 0 && errno == EINTR){
+			continue;
+		}
+		if(got <= 0){
+			if(got == 0){
+				errno = EIO;
+			}
+			return -1;
+		}
+		done += (size_t)got;
+	}
+	if(done < length){
+		errno = EIO;
+		return -1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  adviseSplitImage 
+ * --------------------
+ * Passes a sequential read hint on to each segment the range covers
+ * 
+ * image: The open disk image
+ * offset: Byte offset of the range
+ * length: Length of the range in bytes (inside the image)
+ */
+static void adviseSplitImage(struct DiskImage *image, uint64_t offset, uint64_t length){
+	struct SplitImage *split = image->state;
+	struct SplitSegment *segment;
+	uint64_t start, end;
+	size_t s;
+	for(s=findSplitSegment(split, offset);s<split->count && split->segments[s].start < offset + length;s++){
+		segment = &split->segments[s];
+		start = (offset > segment->start) ? offset - segment->start : 0;
+		end = (offset + length < segment->start + segment->length) ? offset + length - segment->start : segment->length;
+		posix_fadvise(segment->fd, (off_t)start, (off_t)(end - start), POSIX_FADV_SEQUENTIAL);
+		posix_fadvise(segment->fd, (off_t)start, (off_t)(end - start), POSIX_FADV_WILLNEED);
+	}
+}
+
+
+/*
+ * Function:  closeSplitImage 
+ * --------------------
+ * Closes every segment and frees the backend state
+ * 
+ * image: Pointer to the image struct to be closed
+ */
+static void closeSplitImage(struct DiskImage *image){
+	struct SplitImage *split = image->state;
+	size_t s;
+	if(split == NULL){
+		return;
+	}
+	for(s=0;s<split->count;s++){
+		close(split->segments[s].fd);
+	}
+	free(split->segments);
+	free(split);
+	image->state = NULL;
+}
+
+
+/*
+ * Function:  findSplitSegment 
+ * --------------------
+ * Binary search for the segment holding an image offset
+ * 
+ * split: The split image state
+ * offset: Byte offset into the image
+ * size_t: Index of the last segment starting at or before offset
+ */
+static size_t findSplitSegment(const struct SplitImage *split, uint64_t offset){
+	size_t low = 0, high = split->count;
+	while(high - low > 1){
+		size_t middle = low + (high - low)/2;
+		if(split->segments[middle].start <= offset){
+			low = middle;
+		}else{
+			high = middle;
+		}
+	}
+	return low;
+}
+
+
+/*
+ * Function:  fetchSegmentDigits 
+ * --------------------
+ * Counts the digits of a numbered extension such as .001
+ * 
+ * fileName: The fileName of a segment
+ * size_t: Number of digits after the last '.', 0 if the extension is not all digits
+ */
+static size_t fetchSegmentDigits(const char *fileName){
+	const char *extension = strrchr(fileName, '.');
+	size_t digits = 0;
+	if(extension == NULL || strchr(extension, '/') != NULL){
+		return 0;
+	}
+	for(extension++;extension[digits] != '\0';digits++){
+		if(extension[digits] < '0' || extension[digits] > '9'){
+			return 0;
+		}
+	}
+	return digits;
+}
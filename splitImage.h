@@ -0,0 +1,23 @@
+/*
+ * splitImage.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Split raw image backend
+ * Reads a raw image stored as numbered segments (image.001, image.002...)
+ * as one continuous image.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef SPLITIMAGE_H
+#define SPLITIMAGE_H
+
+//IMPORTED LIBRARIES
+#include "diskImage.h"
+
+#define SPLIT_MAX_SEGMENTS 9999 //LARGEST SEGMENT NUMBER FOLLOWED
+
+extern const struct ImageBackend splitImageBackend;
+
+#endif
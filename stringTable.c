@@ -0,0 +1,145 @@
+/*
+ * stringTable.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Interned strings
+ * Strings are hashed with FNV-1a into a linear probing table that is
+ * doubled once it is three quarters full. Offsets stay valid as the
+ * buffer grows, pointers returned by fetchInternedString do not.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdlib.h>
+#include <string.h>
+#include "stringTable.h"
+
+static uint64_t hashString(const char *string, size_t length);
+static int growStringSlots(struct StringTable *table);
+
+
+/*
+ * Function:  internString 
+ * --------------------
+ * Returns the offset of a string, adding it the first time it is seen
+ * 
+ * table: The string table (zero initialised before first use)
+ * string: The string, without NUL bytes (it need not be NUL terminated)
+ * length: Bytes of the string
+ * offset: Set to the offset of the stored copy
+ * int: 0 on success, -1 when out of memory
+ */
+int internString(struct StringTable *table, const char *string, size_t length, uint64_t *offset){
+	//DATA DECLARATION
+	const char *stored;
+	char *grown;
+	size_t slot, capacity;
+	//DATA MANIPULATION
+	if((table->count + 1)*4 > table->slotCount*3 && growStringSlots(table) != 0){
+		return -1;
+	}
+	for(slot = (size_t)hashString(string, length) & (table->slotCount - 1);table->slots[slot] != 0;slot = (slot + 1) & (table->slotCount - 1)){
+		stored = table->bytes + table->slots[slot] - 1;
+		if(strncmp(stored, string, length) == 0 && stored[length] == '\0'){ //ALREADY HELD
+			*offset = table->slots[slot] - 1;
+			return 0;
+		}
+	}
+	if(table->used + length + 1 > table->capacity){
+		capacity = table->capacity ? table->capacity : 4096;
+		while(table->used + length + 1 > capacity){
+			capacity *= 2;
+		}
+		grown = realloc(table->bytes, capacity);
+		if(grown == NULL){
+			return -1;
+		}
+		table->bytes = grown;
+		table->capacity = capacity;
+	}
+	memcpy(table->bytes + table->used, string, length);
+	table->bytes[table->used + length] = '\0';
+	*offset = table->used;
+	table->slots[slot] = table->used + 1;
+	table->used += length + 1;
+	table->count++;
+	return 0;
+}
+
+
+/*
+ * Function:  fetchInternedString 
+ * --------------------
+ * Looks up a stored string
+ * 
+ * table: The string table
+ * offset: Offset returned by internString
+ * const char*: The NUL terminated string (valid until the next internString)
+ */
+const char *fetchInternedString(const struct StringTable *table, uint64_t offset){
+	return table->bytes + offset;
+}
+
+
+/*
+ * Function:  freeStringTable 
+ * --------------------
+ * Releases the strings and the hash table
+ * 
+ * table: The string table
+ */
+void freeStringTable(struct StringTable *table){
+	free(table->bytes);
+	free(table->slots);
+	memset(table, 0, sizeof(*table));
+}
+
+
+/*
+ * Function:  hashString 
+ * --------------------
+ * 64 bit FNV-1a hash
+ * 
+ * string: The bytes to hash
+ * length: Number of bytes
+ * uint64_t: The hash
+ */
+static uint64_t hashString(const char *string, size_t length){
+	uint64_t hash = 14695981039346656037ULL;
+	size_t i;
+	for(i=0;i<length;i++){
+		hash ^= (unsigned char)string[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+
+/*
+ * Function:  growStringSlots 
+ * --------------------
+ * Doubles the hash table and places every stored string again
+ * 
+ * table: The string table
+ * int: 0 on success, -1 when out of memory
+ */
+static int growStringSlots(struct StringTable *table){
+	//DATA DECLARATION
+	size_t slotCount = table->slotCount ? table->slotCount*2 : 1024, offset, length, slot;
+	uint64_t *slots = calloc(slotCount, sizeof(*slots));
+	//DATA MANIPULATION
+	if(slots == NULL){
+		return -1;
+	}
+	for(offset = 0;offset < table->used;offset += length + 1){ //THE BUFFER HOLDS EXACTLY THE STORED STRINGS, ONE AFTER THE OTHER
+		length = strlen(table->bytes + offset);
+		for(slot = (size_t)hashString(table->bytes + offset, length) & (slotCount - 1);slots[slot] != 0;slot = (slot + 1) & (slotCount - 1));
+		slots[slot] = offset + 1;
+	}
+	free(table->slots);
+	table->slots = slots;
+	table->slotCount = slotCount;
+	return 0;
+}
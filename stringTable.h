@@ -0,0 +1,33 @@
+/*
+ * stringTable.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Interned strings
+ * Keeps each distinct string once in one growing buffer and refers to it
+ * by its offset, so names repeated across millions of files (desktop.ini,
+ * Thumbs.db...) cost one copy and an 8 byte reference each.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef STRINGTABLE_H
+#define STRINGTABLE_H
+
+//IMPORTED LIBRARIES
+#include <stddef.h>
+#include <stdint.h>
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct StringTable{
+	char *bytes; //THE STRINGS, EACH NUL TERMINATED, IN THE ORDER THEY WERE FIRST ADDED
+	size_t used, capacity;
+	uint64_t *slots; //OPEN ADDRESSING HASH TABLE OF OFFSET + 1 (0 IS AN EMPTY SLOT)
+	size_t slotCount, count; //slotCount IS A POWER OF TWO, count THE DISTINCT STRINGS HELD
+};
+
+int internString(struct StringTable *table, const char *string, size_t length, uint64_t *offset);
+const char *fetchInternedString(const struct StringTable *table, uint64_t offset);
+void freeStringTable(struct StringTable *table);
+
+#endif
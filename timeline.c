@@ -0,0 +1,649 @@
+/*
+ * timeline.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: MAC timeline in bounded memory
+ * Events are packed into a record buffer with a separate array of sort keys.
+ * When either fills up (half the budget each) the keys are sorted and the
+ * run is written to a temporary file. The runs are then merged a k-way
+ * heap at a time, TIMELINE_MAX_FANIN runs per pass, back into time order.
+ * Events with equal times keep the order they were added in.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "timeline.h"
+#include "fatVolume.h"
+#include "ntfsVolume.h"
+#include "diskLayout.h"
+
+#define TIMELINE_RUN_BUFFER_MAX (1024*1024) //LARGEST STDIO BUFFER GIVEN TO ONE RUN FILE WHILE MERGING
+
+struct TimelineHeader{ //AN EVENT AS STORED IN THE RECORD BUFFER AND THE RUN FILES, FOLLOWED BY ITS NUL TERMINATED NAME
+	uint64_t time;
+	uint64_t id;
+	int32_t partition;
+	uint16_t nameLength;
+	char macb[4];
+	unsigned char source;
+	unsigned char deleted;
+};
+
+struct TimelineKey{
+	uint64_t time;
+	size_t offset; //OFFSET OF THE EVENT IN THE RECORD BUFFER, ALSO THE ORDER IT WAS ADDED IN
+};
+
+struct MergeInput{
+	FILE *file; //RUN BEING READ
+	struct TimelineHeader header; //ITS NEXT EVENT
+	char *name;
+};
+
+struct TimelineCollector{
+	struct TimelineSorter *sorter;
+	int partition; //INDEX OF THE PARTITION BEING WALKED
+	int status; //-1 ONCE AN EVENT COULD NOT BE ADDED
+};
+
+static int spillTimelineRun(struct TimelineSorter *sorter);
+static int mergeTimelineRuns(FILE **runs, size_t count, size_t budget, FILE *out, int (*visit)(const struct TimelineEvent *event, void *context), void *context);
+static int readTimelineEvent(struct MergeInput *input);
+static int writeTimelineEvent(FILE *out, const struct TimelineHeader *header, const char *name);
+static void siftMergeHeap(struct MergeInput *inputs, size_t *heap, size_t count, size_t position);
+static int isEarlierInput(const struct MergeInput *inputs, size_t first, size_t second);
+static void fillTimelineEvent(struct TimelineEvent *event, const struct TimelineHeader *header, const char *name);
+static int compareTimelineKeys(const void *a, const void *b);
+static int collectFatEvent(const struct FatDirEntry *entry, void *context);
+static int collectMftEvents(const struct MftRecord *record, void *context);
+static int addGroupedEvents(struct TimelineCollector *collector, const uint64_t times[4], int source, int deleted, uint64_t id, const char *name, size_t nameLength);
+static uint64_t convertFatTime(unsigned int date, unsigned int time, unsigned int centiseconds);
+
+
+/*
+ * Function:  beginTimeline 
+ * --------------------
+ * Prepares a sorter whose buffers stay within a memory budget
+ * 
+ * sorter: The sorter to initialise
+ * budget: Bytes of memory the sort may use (raised to TIMELINE_MIN_BUDGET)
+ * int: 0 on success, -1 when out of memory
+ */
+int beginTimeline(struct TimelineSorter *sorter, size_t budget){
+	memset(sorter, 0, sizeof(*sorter));
+	sorter->budget = (budget < TIMELINE_MIN_BUDGET) ? TIMELINE_MIN_BUDGET : budget;
+	sorter->capacity = sorter->budget/2;
+	sorter->keyCapacity = sorter->budget/2/sizeof(struct TimelineKey);
+	sorter->records = malloc(sorter->capacity);
+	sorter->keys = malloc(sorter->keyCapacity*sizeof(struct TimelineKey));
+	if(sorter->records == NULL || sorter->keys == NULL){
+		freeTimeline(sorter);
+		return -1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  addTimelineEvent 
+ * --------------------
+ * Adds an event, spilling the current run to a temporary file when the buffers are full
+ * Names longer than TIMELINE_NAME_MAX are cut
+ * 
+ * sorter: The sorter
+ * event: The event (its name is copied)
+ * int: 0 on success, -1 if a run could not be written
+ */
+int addTimelineEvent(struct TimelineSorter *sorter, const struct TimelineEvent *event){
+	//DATA DECLARATION
+	struct TimelineHeader header;
+	size_t nameLength = (event->nameLength < TIMELINE_NAME_MAX) ? event->nameLength : TIMELINE_NAME_MAX;
+	size_t size = (sizeof(header) + nameLength + 1 + 7) & ~(size_t)7; //KEEP EVERY HEADER 8 BYTE ALIGNED
+	//DATA MANIPULATION
+	if((sorter->used + size > sorter->capacity || sorter->keyCount == sorter->keyCapacity) && spillTimelineRun(sorter) != 0){
+		return -1;
+	}
+	memset(&header, 0, sizeof(header));
+	header.time = event->time;
+	header.id = event->id;
+	header.partition = event->partition;
+	header.nameLength = (uint16_t)nameLength;
+	memcpy(header.macb, event->macb, sizeof(header.macb));
+	header.source = (unsigned char)event->source;
+	header.deleted = (unsigned char)event->deleted;
+	memcpy(sorter->records + sorter->used, &header, sizeof(header));
+	memcpy(sorter->records + sorter->used + sizeof(header), event->name, nameLength);
+	sorter->records[sorter->used + sizeof(header) + nameLength] = '\0';
+	sorter->keys[sorter->keyCount].time = event->time;
+	sorter->keys[sorter->keyCount++].offset = sorter->used;
+	sorter->used += size;
+	sorter->events++;
+	return 0;
+}
+
+
+/*
+ * Function:  finishTimeline 
+ * --------------------
+ * Hands every event to the visitor in time order
+ * If everything fitted in one run it is sorted and visited from memory,
+ * otherwise the last run is spilled too and the run files are merged
+ * 
+ * sorter: The sorter (no more events may be added)
+ * visit: Called for each event, a non zero return stops the timeline
+ * context: Passed through to visit
+ * int: 0 when every event was visited, the non zero value returned by visit, -1 on failure
+ */
+int finishTimeline(struct TimelineSorter *sorter, int (*visit)(const struct TimelineEvent *event, void *context), void *context){
+	//DATA DECLARATION
+	struct TimelineHeader header;
+	struct TimelineEvent event;
+	FILE *merged;
+	size_t i, next, count;
+	int status = 0;
+	//DATA MANIPULATION
+	if(sorter->runCount == 0){ //ALL IN MEMORY, NO FILES NEEDED
+		qsort(sorter->keys, sorter->keyCount, sizeof(struct TimelineKey), compareTimelineKeys);
+		for(i=0;i<sorter->keyCount && status == 0;i++){
+			memcpy(&header, sorter->records + sorter->keys[i].offset, sizeof(header));
+			fillTimelineEvent(&event, &header, (const char*)sorter->records + sorter->keys[i].offset + sizeof(header));
+			status = visit(&event, context);
+		}
+		return status;
+	}
+	if(sorter->keyCount > 0 && spillTimelineRun(sorter) != 0){
+		return -1;
+	}
+	free(sorter->records); //THE MERGE USES THE BUDGET FOR FILE BUFFERS INSTEAD
+	free(sorter->keys);
+	sorter->records = NULL;
+	sorter->keys = NULL;
+	while(sorter->runCount > TIMELINE_MAX_FANIN){ //MERGE GROUPS OF RUNS UNTIL ONE PASS CAN FINISH
+		for(i=0, next=0;i<sorter->runCount;i+=count){
+			count = (sorter->runCount - i < TIMELINE_MAX_FANIN) ? sorter->runCount - i : TIMELINE_MAX_FANIN;
+			merged = (count > 1) ? tmpfile() : sorter->runs[i];
+			if(merged == NULL){
+				memmove(sorter->runs + next, sorter->runs + i, (sorter->runCount - i)*sizeof(FILE*)); //LEFT FOR freeTimeline TO CLOSE
+				sorter->runCount = next + sorter->runCount - i;
+				return -1;
+			}
+			if(count > 1 && mergeTimelineRuns(sorter->runs + i, count, sorter->budget, merged, NULL, NULL) != 0){ //CLOSES THE GROUP
+				memmove(sorter->runs + next + 1, sorter->runs + i + count, (sorter->runCount - i - count)*sizeof(FILE*));
+				sorter->runs[next] = merged;
+				sorter->runCount = next + 1 + sorter->runCount - i - count;
+				return -1;
+			}
+			rewind(merged);
+			sorter->runs[next++] = merged;
+		}
+		sorter->runCount = next;
+	}
+	status = mergeTimelineRuns(sorter->runs, sorter->runCount, sorter->budget, NULL, visit, context);
+	sorter->runCount = 0; //CLOSED BY THE MERGE
+	return status;
+}
+
+
+/*
+ * Function:  freeTimeline 
+ * --------------------
+ * Releases the buffers of a sorter and closes (deleting) its run files
+ * 
+ * sorter: The sorter
+ */
+void freeTimeline(struct TimelineSorter *sorter){
+	size_t i;
+	for(i=0;i<sorter->runCount;i++){
+		fclose(sorter->runs[i]);
+	}
+	free(sorter->runs);
+	free(sorter->records);
+	free(sorter->keys);
+	memset(sorter, 0, sizeof(*sorter));
+}
+
+
+/*
+ * Function:  collectTimeline 
+ * --------------------
+ * Adds the events of every FAT and NTFS partition of the image
+ * FAT volumes give the created, accessed (date only) and modified times of
+ * every directory entry, NTFS volumes the four $STANDARD_INFORMATION and
+ * the four $FILE_NAME times of every base MFT record
+ * Times shared by several of a file's timestamps become one event
+ * 
+ * model: The volume model of the open disk image
+ * sorter: The sorter the events are added to
+ * int: 0 on success, -1 if a volume could not be read or an event could not be added
+ */
+int collectTimeline(struct VolumeModel *model, struct TimelineSorter *sorter){
+	//DATA DECLARATION
+	struct TimelineCollector collector = {sorter, 0, 0};
+	struct FatVolume fat;
+	struct NtfsVolume ntfs;
+	const struct Partition *partition;
+	size_t i;
+	int status = 0;
+	//DATA MANIPULATION
+	for(i=0;i<model->partitionCount && status == 0;i++){
+		partition = &model->partitions[i];
+		collector.partition = partition->index;
+		switch(fetchPartitionFileSystem(model->image, partition)){
+			case FILESYSTEM_FAT:
+				if(model->fat.present && model->fat.sectorStart == partition->sectorStart){ //REUSE THE FAT INDEX OF THE MODEL
+					status = walkFatDirectories(model->image, &model->fat, collectFatEvent, &collector);
+					break;
+				}
+				memset(&fat, 0, sizeof(fat));
+				fat.sectorStart = partition->sectorStart;
+				fetchFatVolumeInfo(model->image, &fat);
+				if(fat.present){
+					status = walkFatDirectories(model->image, &fat, collectFatEvent, &collector);
+				}
+				freeFatVolume(&fat);
+				break;
+			case FILESYSTEM_NTFS:
+				if(model->ntfs.present && (uint64_t)model->ntfs.sectorStart == partition->sectorStart){
+					status = scanMftRecords(model->image, &model->ntfs, 0, collectMftEvents, &collector);
+					break;
+				}
+				memset(&ntfs, 0, sizeof(ntfs));
+				ntfs.sectorStart = (long long int)partition->sectorStart;
+				fetchNTFSVolumeInfo(model->image, &ntfs);
+				if(ntfs.present){
+					status = scanMftRecords(model->image, &ntfs, 0, collectMftEvents, &collector);
+				}
+				freeNtfsVolume(&ntfs);
+				break;
+			default:
+				break;
+		}
+	}
+	return (status != 0 || collector.status != 0) ? -1 : 0;
+}
+
+
+/*
+ * Function:  spillTimelineRun 
+ * --------------------
+ * Sorts the events in memory and writes them to a new temporary run file
+ * 
+ * sorter: The sorter
+ * int: 0 on success, -1 if the file could not be created or written
+ */
+static int spillTimelineRun(struct TimelineSorter *sorter){
+	//DATA DECLARATION
+	struct TimelineHeader header;
+	FILE **grown, *run;
+	size_t i, capacity;
+	//DATA MANIPULATION
+	if(sorter->runCount == sorter->runCapacity){
+		capacity = sorter->runCapacity ? sorter->runCapacity*2 : 16;
+		grown = realloc(sorter->runs, capacity*sizeof(*grown));
+		if(grown == NULL){
+			return -1;
+		}
+		sorter->runs = grown;
+		sorter->runCapacity = capacity;
+	}
+	run = tmpfile(); //UNLINKED ALREADY, REMOVED WHEN CLOSED OR THE PROCESS EXITS
+	if(run == NULL){
+		return -1;
+	}
+	qsort(sorter->keys, sorter->keyCount, sizeof(struct TimelineKey), compareTimelineKeys);
+	for(i=0;i<sorter->keyCount;i++){
+		memcpy(&header, sorter->records + sorter->keys[i].offset, sizeof(header));
+		if(writeTimelineEvent(run, &header, (const char*)sorter->records + sorter->keys[i].offset + sizeof(header)) != 0){
+			fclose(run);
+			return -1;
+		}
+	}
+	if(fflush(run) != 0){
+		fclose(run);
+		return -1;
+	}
+	rewind(run);
+	sorter->runs[sorter->runCount++] = run;
+	sorter->used = 0;
+	sorter->keyCount = 0;
+	return 0;
+}
+
+
+/*
+ * Function:  mergeTimelineRuns 
+ * --------------------
+ * Merges sorted runs with a binary heap of their next events
+ * The merged events are written to out, or handed to visit when out is NULL
+ * Every run is closed, the budget is shared out as their read buffers
+ * 
+ * runs: The run files (at their start)
+ * count: Number of runs
+ * budget: Bytes of memory the merge may use
+ * out: File the merged run is written to, NULL to visit the events
+ * visit: Called for each event when out is NULL
+ * context: Passed through to visit
+ * int: 0 on success, the non zero value returned by visit, -1 on failure
+ */
+static int mergeTimelineRuns(FILE **runs, size_t count, size_t budget, FILE *out, int (*visit)(const struct TimelineEvent *event, void *context), void *context){
+	//DATA DECLARATION
+	struct MergeInput *inputs = calloc(count, sizeof(struct MergeInput));
+	struct TimelineEvent event;
+	size_t *heap = calloc(count, sizeof(size_t));
+	size_t bufferSize = budget/(2*count), heapCount = 0, i, top;
+	int status = 0, got;
+	//DATA MANIPULATION
+	if(bufferSize > TIMELINE_RUN_BUFFER_MAX){
+		bufferSize = TIMELINE_RUN_BUFFER_MAX;
+	}
+	if(inputs == NULL || heap == NULL){
+		status = -1;
+	}
+	for(i=0;i<count && status == 0;i++){
+		inputs[i].file = runs[i];
+		inputs[i].name = malloc(TIMELINE_NAME_MAX + 1);
+		if(inputs[i].name == NULL){
+			status = -1;
+			break;
+		}
+		setvbuf(runs[i], NULL, _IOFBF, bufferSize);
+		got = readTimelineEvent(&inputs[i]);
+		if(got < 0){
+			status = -1;
+		}else if(got == 1){
+			heap[heapCount++] = i;
+		}
+	}
+	for(i=heapCount;i-- > 0 && status == 0;){ //BUILD THE HEAP
+		siftMergeHeap(inputs, heap, heapCount, i);
+	}
+	while(heapCount > 0 && status == 0){
+		top = heap[0];
+		if(out != NULL){
+			status = writeTimelineEvent(out, &inputs[top].header, inputs[top].name);
+		}else{
+			fillTimelineEvent(&event, &inputs[top].header, inputs[top].name);
+			status = visit(&event, context);
+		}
+		got = (status == 0) ? readTimelineEvent(&inputs[top]) : 0;
+		if(got < 0){
+			status = -1;
+		}else if(got == 0){ //RUN EXHAUSTED, MOVE THE LAST INPUT TO THE TOP
+			heap[0] = heap[--heapCount];
+		}
+		siftMergeHeap(inputs, heap, heapCount, 0);
+	}
+	if(out != NULL && status == 0 && fflush(out) != 0){
+		status = -1;
+	}
+	for(i=0;i<count;i++){
+		fclose(runs[i]);
+		if(inputs != NULL){
+			free(inputs[i].name);
+		}
+	}
+	free(inputs);
+	free(heap);
+	return status;
+}
+
+
+/*
+ * Function:  readTimelineEvent 
+ * --------------------
+ * Reads the next event of a run into its merge input
+ * 
+ * input: The merge input
+ * int: 1 if an event was read, 0 at the end of the run, -1 on a read error
+ */
+static int readTimelineEvent(struct MergeInput *input){
+	if(fread(&input->header, sizeof(input->header), 1, input->file) != 1){
+		return ferror(input->file) ? -1 : 0;
+	}
+	if(input->header.nameLength > TIMELINE_NAME_MAX || fread(input->name, 1, input->header.nameLength + 1, input->file) != input->header.nameLength + 1u){
+		return -1;
+	}
+	return 1;
+}
+
+
+/*
+ * Function:  writeTimelineEvent 
+ * --------------------
+ * Appends one event to a run file
+ * 
+ * out: The run file
+ * header: The event
+ * name: Its name (header->nameLength bytes and the NUL)
+ * int: 0 on success, -1 on a write error
+ */
+static int writeTimelineEvent(FILE *out, const struct TimelineHeader *header, const char *name){
+	if(fwrite(header, sizeof(*header), 1, out) != 1 || fwrite(name, 1, header->nameLength + 1, out) != header->nameLength + 1u){
+		return -1;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  siftMergeHeap 
+ * --------------------
+ * Moves a heap entry down until neither child holds an earlier event
+ * 
+ * inputs: The merge inputs
+ * heap: Input indexes, earliest event first
+ * count: Entries in the heap
+ * position: Entry to move down
+ */
+static void siftMergeHeap(struct MergeInput *inputs, size_t *heap, size_t count, size_t position){
+	size_t child, swap;
+	while((child = 2*position + 1) < count){
+		if(child + 1 < count && isEarlierInput(inputs, heap[child + 1], heap[child])){
+			child++;
+		}
+		if(!isEarlierInput(inputs, heap[child], heap[position])){
+			break;
+		}
+		swap = heap[child];
+		heap[child] = heap[position];
+		heap[position] = swap;
+		position = child;
+	}
+}
+
+
+/*
+ * Function:  isEarlierInput 
+ * --------------------
+ * Orders merge inputs by the time of their next event,
+ * then by run number so equal times keep the order they were added in
+ * 
+ * inputs: The merge inputs
+ * first: Index of the first input
+ * second: Index of the second input
+ * int: 1 if the first input comes before the second
+ */
+static int isEarlierInput(const struct MergeInput *inputs, size_t first, size_t second){
+	if(inputs[first].header.time != inputs[second].header.time){
+		return inputs[first].header.time < inputs[second].header.time;
+	}
+	return first < second;
+}
+
+
+/*
+ * Function:  fillTimelineEvent 
+ * --------------------
+ * Unpacks a stored event for the visitor
+ * 
+ * event: The event to fill in
+ * header: The stored event
+ * name: Its name
+ */
+static void fillTimelineEvent(struct TimelineEvent *event, const struct TimelineHeader *header, const char *name){
+	event->time = header->time;
+	memcpy(event->macb, header->macb, 4);
+	event->macb[4] = '\0';
+	event->source = header->source;
+	event->partition = header->partition;
+	event->deleted = header->deleted;
+	event->id = header->id;
+	event->name = name;
+	event->nameLength = header->nameLength;
+}
+
+
+/*
+ * Function:  compareTimelineKeys 
+ * --------------------
+ * qsort comparison ordering keys by time, then by the order they were added in
+ */
+static int compareTimelineKeys(const void *a, const void *b){
+	const struct TimelineKey *first = a, *second = b;
+	if(first->time != second->time){
+		return (first->time > second->time) - (first->time < second->time);
+	}
+	return (first->offset > second->offset) - (first->offset < second->offset);
+}
+
+
+/*
+ * Function:  collectFatEvent 
+ * --------------------
+ * Directory walk visitor adding the events of one FAT entry
+ * The "." and ".." entries and the volume label are skipped
+ * 
+ * entry: The directory entry being visited
+ * context: The TimelineCollector
+ * int: 0 to continue the walk, -1 if an event could not be added
+ */
+static int collectFatEvent(const struct FatDirEntry *entry, void *context){
+	struct TimelineCollector *collector = context;
+	const unsigned char *raw = entry->raw;
+	uint64_t times[4]; //MODIFIED, ACCESSED, CHANGED, BORN
+	if(strcmp(entry->shortName, ".") == 0 || strcmp(entry->shortName, "..") == 0 || (entry->attributes & 0x08)){
+		return 0;
+	}
+	times[0] = convertFatTime(readLe16(raw + FAT_DIRENT_MODIFIED_DATE), readLe16(raw + FAT_DIRENT_MODIFIED_TIME), 0);
+	times[1] = convertFatTime(readLe16(raw + FAT_DIRENT_ACCESSED_DATE), 0, 0); //LAST ACCESS IS A DATE ONLY
+	times[2] = 0; //FAT KEEPS NO METADATA CHANGE TIME
+	times[3] = convertFatTime(readLe16(raw + FAT_DIRENT_CREATED_DATE), readLe16(raw + FAT_DIRENT_CREATED_TIME), raw[FAT_DIRENT_CREATED_TENTHS]);
+	return addGroupedEvents(collector, times, TIMELINE_FAT, entry->deleted || entry->parentDeleted, entry->entryOffset, entry->path, strlen(entry->path));
+}
+
+
+/*
+ * Function:  collectMftEvents 
+ * --------------------
+ * MFT scan visitor adding the $STANDARD_INFORMATION and $FILE_NAME events
+ * of one base record (extension records hold no times of their own)
+ * 
+ * record: The decoded MFT record
+ * context: The TimelineCollector
+ * int: 0 to continue the scan, -1 if an event could not be added
+ */
+static int collectMftEvents(const struct MftRecord *record, void *context){
+	struct TimelineCollector *collector = context;
+	const char *name = record->hasFileName ? record->fileName.name : "";
+	uint64_t times[4]; //MODIFIED, ACCESSED, CHANGED, BORN
+	int status = 0;
+	if(record->baseRecord != 0){
+		return 0;
+	}
+	if(record->hasStandardInfo){
+		times[0] = record->standardInfo.modified;
+		times[1] = record->standardInfo.accessed;
+		times[2] = record->standardInfo.mftModified;
+		times[3] = record->standardInfo.created;
+		status = addGroupedEvents(collector, times, TIMELINE_STANDARD_INFO, !record->inUse, record->number, name, strlen(name));
+	}
+	if(record->hasFileName && status == 0){
+		times[0] = record->fileName.modified;
+		times[1] = record->fileName.accessed;
+		times[2] = record->fileName.mftModified;
+		times[3] = record->fileName.created;
+		status = addGroupedEvents(collector, times, TIMELINE_FILE_NAME, !record->inUse, record->number, name, strlen(name));
+	}
+	return status;
+}
+
+
+/*
+ * Function:  addGroupedEvents 
+ * --------------------
+ * Adds one event per distinct time of a file's four timestamps,
+ * with the macb flags of every timestamp sharing that time
+ * Zero times (not set) are left out
+ * 
+ * collector: The TimelineCollector
+ * times: Modified, accessed, changed and born times
+ * source: TIMELINE_FAT, TIMELINE_STANDARD_INFO OR TIMELINE_FILE_NAME
+ * deleted: 1 if the entry or record is deleted
+ * id: MFT record number or directory entry offset
+ * name: Path or file name
+ * nameLength: Bytes in name
+ * int: 0 on success, -1 if an event could not be added
+ */
+static int addGroupedEvents(struct TimelineCollector *collector, const uint64_t times[4], int source, int deleted, uint64_t id, const char *name, size_t nameLength){
+	static const char flags[4] = {'m', 'a', 'c', 'b'};
+	struct TimelineEvent event;
+	int i, j, seen;
+	event.source = source;
+	event.partition = collector->partition;
+	event.deleted = deleted;
+	event.id = id;
+	event.name = name;
+	event.nameLength = nameLength;
+	for(i=0;i<4 && collector->status == 0;i++){
+		for(seen=0, j=0;j<i;j++){ //ALREADY ADDED WITH AN EARLIER TIMESTAMP
+			seen |= (times[j] == times[i]);
+		}
+		if(times[i] == 0 || seen){
+			continue;
+		}
+		for(j=0;j<4;j++){
+			event.macb[j] = (times[j] == times[i]) ? flags[j] : '.';
+		}
+		event.macb[4] = '\0';
+		event.time = times[i];
+		collector->status = addTimelineEvent(collector->sorter, &event);
+	}
+	return collector->status;
+}
+
+
+/*
+ * Function:  convertFatTime 
+ * --------------------
+ * Converts a FAT date and time to a FILETIME of the same (local) wall clock time
+ * Date: bits 15-9 year since 1980, 8-5 month, 4-0 day
+ * Time: bits 15-11 hour, 10-5 minute, 4-0 seconds/2
+ * 
+ * date: The FAT date
+ * time: The FAT time
+ * centiseconds: Extra 10ms units (0-199) of a creation time
+ * uint64_t: The FILETIME, 0 if the date is not set or not valid
+ */
+static uint64_t convertFatTime(unsigned int date, unsigned int time, unsigned int centiseconds){
+	//DATA DECLARATION
+	int year = 1980 + (int)(date >> 9), era, yearOfEra, dayOfYear, dayOfEra;
+	unsigned int month = (date >> 5) & 0x0F, day = date & 0x1F;
+	long long int days;
+	//DATA MANIPULATION
+	if(month < 1 || month > 12 || day < 1){
+		return 0;
+	}
+	year -= (month <= 2); //DAYS SINCE 1970 OF A CIVIL DATE, WITH MARCH AS THE FIRST MONTH OF THE YEAR
+	era = year/400;
+	yearOfEra = year - era*400;
+	dayOfYear = (int)((153*(month + (month > 2 ? -3 : 9)) + 2)/5 + day - 1);
+	dayOfEra = yearOfEra*365 + yearOfEra/4 - yearOfEra/100 + dayOfYear;
+	days = (long long int)era*146097 + dayOfEra - 719468;
+	days += 134774; //DAYS FROM 1601 TO 1970
+	return ((uint64_t)days*86400 + (time >> 11)*3600 + ((time >> 5) & 0x3F)*60 + (time & 0x1F)*2)*10000000ULL + (uint64_t)centiseconds*100000ULL;
+}
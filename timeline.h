@@ -0,0 +1,60 @@
+/*
+ * timeline.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: MAC timeline in bounded memory
+ * Collects the FAT directory entry times and the NTFS $STANDARD_INFORMATION
+ * and $FILE_NAME times of every partition and returns them sorted by time.
+ * Events are sorted in memory sized runs that are spilled to temporary
+ * files and merged, so memory stays within the budget however many events there are.
+ * 
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "volumeModel.h"
+
+#define TIMELINE_FAT 0 //TimelineEvent SOURCES
+#define TIMELINE_STANDARD_INFO 1
+#define TIMELINE_FILE_NAME 2
+#define TIMELINE_NAME_MAX 4096 //LONGEST NAME KEPT WITH AN EVENT (A FULL FAT PATH)
+#define TIMELINE_MIN_BUDGET (1024*1024) //SMALLEST MEMORY BUDGET ACCEPTED
+#define TIMELINE_MAX_FANIN 64 //RUNS MERGED AT ONCE, MORE RUNS ARE MERGED IN SEVERAL PASSES
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct TimelineEvent{
+	uint64_t time; //WINDOWS FILETIME (100ns SINCE 1601), LOCAL TIME FOR FAT
+	char macb[5]; //"m.cb" STYLE: WHICH OF MODIFIED, ACCESSED, CHANGED AND BORN HAPPENED AT time
+	int source; //TIMELINE_FAT, TIMELINE_STANDARD_INFO OR TIMELINE_FILE_NAME
+	int partition; //INDEX OF THE PARTITION THE FILE IS ON
+	int deleted; //1 FOR A DELETED DIRECTORY ENTRY OR AN MFT RECORD NOT IN USE
+	uint64_t id; //MFT RECORD NUMBER, OR BYTE OFFSET OF THE FAT DIRECTORY ENTRY
+	const char *name; //FULL PATH (FAT) OR FILE NAME (NTFS), NUL TERMINATED WHEN VISITED
+	size_t nameLength;
+};
+
+struct TimelineSorter{
+	size_t budget; //BYTES OF MEMORY THE SORT MAY USE
+	unsigned char *records; //EVENTS OF THE CURRENT RUN, PACKED ONE AFTER THE OTHER
+	size_t used, capacity;
+	struct TimelineKey *keys; //SORT KEYS OF THE CURRENT RUN
+	size_t keyCount, keyCapacity;
+	FILE **runs; //SORTED RUNS SPILLED TO TEMPORARY FILES
+	size_t runCount, runCapacity;
+	uint64_t events; //EVENTS ADDED IN TOTAL
+};
+
+int beginTimeline(struct TimelineSorter *sorter, size_t budget);
+int addTimelineEvent(struct TimelineSorter *sorter, const struct TimelineEvent *event);
+int finishTimeline(struct TimelineSorter *sorter, int (*visit)(const struct TimelineEvent *event, void *context), void *context);
+void freeTimeline(struct TimelineSorter *sorter);
+int collectTimeline(struct VolumeModel *model, struct TimelineSorter *sorter);
+
+#endif
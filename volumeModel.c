@@ -0,0 +1,580 @@
+/*
+ * volumeModel.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Parse-once in-memory volume model
+ * Reads the MBR partition table, FAT boot sector and NTFS boot sector
+ * a single time when the image is opened. Every later query is
+ * answered from the model without touching the image again.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "volumeModel.h"
+#include "diskLayout.h"
+#include "nameConvert.h"
+#include "scanStats.h"
+
+
+/*
+ * Function:  buildVolumeModel 
+ * --------------------
+ * Builds the whole volume model for an open image
+ * Parses the partition table first as it locates the FAT and NTFS volumes
+ * 
+ * image: The open disk image
+ * model: Pointer to the model to be filled in
+ */
+void buildVolumeModel(struct DiskImage *image, struct VolumeModel *model){
+	memset(model, 0, sizeof(*model));
+	model->image = image;
+	beginStatsStage(STATS_PARTITION);
+	fetchPartitionInfo(image, model);
+	endStatsStage(STATS_PARTITION);
+	if(model->fat.sectorStart != 0){
+		beginStatsStage(STATS_FAT);
+		fetchFatVolumeInfo(image, &model->fat);
+		endStatsStage(STATS_FAT);
+	}
+	if(model->ntfs.sectorStart != 0){
+		beginStatsStage(STATS_NTFS);
+		fetchNTFSVolumeInfo(image, &model->ntfs);
+		endStatsStage(STATS_NTFS);
+	}
+}
+
+
+/*
+ * Function:  freeVolumeModel 
+ * --------------------
+ * Releases memory held by the model (such as a loaded FAT index
+ * or the cached NTFS extent maps)
+ * The image itself is closed separately with closeDiskImage
+ * 
+ * model: The volume model to release
+ */
+void freeVolumeModel(struct VolumeModel *model){
+	free(model->partitions);
+	model->partitions = NULL;
+	model->partitionCount = model->partitionCapacity = 0;
+	freeFatVolume(&model->fat);
+	freeNtfsVolume(&model->ntfs);
+}
+
+
+/*
+ * Function:  freeFatVolume 
+ * --------------------
+ * Releases the FAT index loaded for a FAT volume
+ * 
+ * fat: The FAT volume
+ */
+void freeFatVolume(struct FatVolume *fat){
+	free(fat->tableBuffer);
+	fat->tableBuffer = NULL;
+	fat->table = NULL;
+}
+
+
+/*
+ * Function:  freeNtfsVolume 
+ * --------------------
+ * Releases the $MFT runs and the cached extent maps of an NTFS volume
+ * 
+ * ntfs: The NTFS volume
+ */
+void freeNtfsVolume(struct NtfsVolume *ntfs){
+	int i;
+	free(ntfs->mftMap.runs);
+	free(ntfs->mftMap.resident);
+	memset(&ntfs->mftMap, 0, sizeof(ntfs->mftMap));
+	if(ntfs->extentCache != NULL){
+		for(i=0;i<NTFS_EXTENT_CACHE_SLOTS;i++){
+			free(ntfs->extentCache[i].runs);
+			free(ntfs->extentCache[i].resident);
+		}
+		free(ntfs->extentCache);
+		ntfs->extentCache = NULL;
+	}
+}
+
+
+/*
+ * Function:  fetchPartitionInfo 
+ * --------------------
+ * Enumerates every partition of the image into the model
+ * (MBR primary entries, logical partitions of an extended partition,
+ * or the entries of a GPT partition array)
+ * It also records the start sectors of the first FAT and NTFS volumes,
+ * GPT basic data partitions are told apart by their boot sector
+ * 
+ * image: The open disk image to assess Partition Info
+ * model: The volume model the partitions are stored in
+ */
+void fetchPartitionInfo(struct DiskImage *image, struct VolumeModel *model){
+	//DATA DECLARATION
+	struct PartitionScan scan;
+	struct Partition partition, *partitions;
+	size_t capacity;
+	int fileSystem;
+	//DATA MANIPULATION
+	beginPartitionScan(image, &scan);
+	while(nextPartition(&scan, &partition) == 1){
+		if(model->partitionCount == model->partitionCapacity){ //GROW THE PARTITION LIST
+			capacity = model->partitionCapacity ? model->partitionCapacity*2 : 8;
+			partitions = realloc(model->partitions, capacity*sizeof(struct Partition));
+			if(partitions == NULL){
+				break;
+			}
+			model->partitions = partitions;
+			model->partitionCapacity = capacity;
+		}
+		model->partitions[model->partitionCount++] = partition;
+		if(partition.scheme == PARTITION_GPT){
+			model->partitionScheme = PARTITION_GPT;
+		}else if(partition.type == 0){ //IF THE TYPE IDENTIFIER IS 0x00 IT IS AN UNKNOWN OR EMPTY PARTITION
+			model->partitionBlank++;
+			continue;
+		}
+		fileSystem = fetchPartitionFileSystem(image, &partition);
+		if(fileSystem == FILESYSTEM_FAT && model->fat.sectorStart == 0){ //SETS FAT VOLUME START SECTOR (FIRST FAT PARTITION ONLY)
+			model->fat.sectorStart = partition.sectorStart;
+		}
+		if(fileSystem == FILESYSTEM_NTFS && model->ntfs.sectorStart == 0){ //SETS NTFS VOLUME START SECTOR (FIRST NTFS PARTITION ONLY)
+			model->ntfs.sectorStart = (long long int)partition.sectorStart;
+		}
+	}
+}
+
+
+/*
+ * Function:  beginPartitionScan 
+ * --------------------
+ * Starts a streaming enumeration of the partitions of an image
+ * Partitions are then returned one at a time by nextPartition, so the
+ * tables are read as they are walked and never held in memory as a whole
+ * 
+ * image: The open disk image
+ * scan: The enumeration state to initialise
+ */
+void beginPartitionScan(struct DiskImage *image, struct PartitionScan *scan){
+	memset(scan, 0, sizeof(*scan));
+	scan->image = image;
+	scan->state = PARTITION_MBR;
+}
+
+
+/*
+ * Function:  nextPartition 
+ * --------------------
+ * Returns the next partition of the enumeration
+ * The four primary entries of the MBR are returned first (empty ones
+ * included). A protective MBR (type EEh) switches to the GPT header at
+ * LBA 1 and its partition array instead, and an extended partition has
+ * its chain of extended boot records followed once the primaries are done
+ * All sector values are 64 bit, in 512 byte sectors
+ * 
+ * scan: The enumeration state
+ * partition: Filled in with the next partition
+ * int: 1 if a partition was returned, 0 at the end of the tables
+ */
+int nextPartition(struct PartitionScan *scan, struct Partition *partition){
+	//DATA DECLARATION
+	const unsigned char *view, *entry;
+	unsigned char scratch[512], blank[16] = {0};
+	uint64_t lba, lastLba, ebr;
+	unsigned int blockSize;
+	//DATA MANIPULATION
+	memset(partition, 0, sizeof(*partition));
+	while(scan->state == PARTITION_MBR && scan->primary < 4){ //PRIMARY ENTRIES OF THE MBR
+		view = fetchImageView(scan->image, MBR_TABLE_OFFSET, 4*MBR_ENTRY_SIZE, scratch); //VIEW OF THE PARTITION TABLE AT 0x1BE
+		if(view == NULL){ //IMAGE TOO SMALL TO HOLD AN MBR
+			scan->state = -1;
+			break;
+		}
+		entry = view + MBR_ENTRY_SIZE*scan->primary++; //USING THE OFFSET OF 16 CYCLES ACROSS THE PARTITION DATA FROM 0x1BE (START OF PARTITION TABLE ENTRY)
+		if(entry[MBR_ENTRY_TYPE] == 0xEE){ //PROTECTIVE MBR OF A GPT DISK
+			for(blockSize=512;blockSize<=4096;blockSize*=8){ //GPT HEADER AT LBA 1 (512 BYTE OR 4Kn BLOCKS)
+				view = fetchImageView(scan->image, blockSize, GPT_HEADER_MIN, scratch);
+				if(view != NULL && memcmp(view, "EFI PART", 8) == 0){
+					break;
+				}
+			}
+			if(blockSize > 4096){ //NO VALID HEADER, REPORT THE PROTECTIVE ENTRY ITSELF
+				scan->primary = 4;
+				partition->type = entry[MBR_ENTRY_TYPE];
+				partition->sectorStart = readLe32(entry + MBR_ENTRY_LBA);
+				partition->sectorCount = readLe32(entry + MBR_ENTRY_SECTORS);
+				partition->size = partition->sectorCount*SECTOR_SIZE/1024;
+				partition->index = scan->index++;
+				return 1;
+			}
+			scan->lbaFactor = blockSize/SECTOR_SIZE;
+			scan->gptEntryOffset = readLe64(view + GPT_HEADER_ENTRY_LBA)*blockSize; //LBA OF THE PARTITION ENTRY ARRAY
+			scan->gptEntryCount = readLe32(view + GPT_HEADER_ENTRY_COUNT); //NUMBER OF ENTRIES
+			scan->gptEntrySize = readLe32(view + GPT_HEADER_ENTRY_SIZE); //SIZE OF EACH ENTRY (128 BYTES OR A LARGER POWER OF 2)
+			if(scan->gptEntrySize < 128 || scan->gptEntrySize > sizeof(scratch)){
+				scan->gptEntryCount = 0;
+			}
+			scan->state = PARTITION_GPT;
+			break;
+		}
+		partition->scheme = PARTITION_MBR;
+		partition->type = entry[MBR_ENTRY_TYPE];
+		partition->sectorStart = readLe32(entry + MBR_ENTRY_LBA); //READS THE START SECTOR VALUE (LB ADDRESS)
+		partition->sectorCount = readLe32(entry + MBR_ENTRY_SECTORS); //READS THE PARTITION SIZE VALUE (NUM OF SECTORS)
+		partition->size = partition->sectorCount*SECTOR_SIZE/1024; //CONVERSION OF SECTOR COUNT * 512 BYTES/1024 TO GET PARTITION SIZE IN KiB
+		if(isExtendedPartitionType(partition->type) && scan->extendedStart == 0 && partition->sectorStart != 0){ //FOLLOWED ONCE THE PRIMARIES ARE DONE
+			scan->extendedStart = scan->nextEbr = partition->sectorStart;
+		}
+		partition->index = scan->index++;
+		return 1;
+	}
+	if(scan->state == PARTITION_MBR){
+		scan->state = (scan->extendedStart != 0) ? PARTITION_EBR : -1;
+	}
+	while(scan->state == PARTITION_EBR && scan->nextEbr != 0 && scan->ebrCount < 4096){ //CHAIN OF EXTENDED BOOT RECORDS
+		ebr = scan->nextEbr;
+		scan->ebrCount++;
+		view = fetchImageView(scan->image, ebr*SECTOR_SIZE, 512, scratch);
+		if(view == NULL || readLe16(view + MBR_SIGNATURE) != 0xAA55){ //BROKEN CHAIN
+			break;
+		}
+		entry = view + MBR_TABLE_OFFSET + MBR_ENTRY_SIZE; //SECOND ENTRY LINKS TO THE NEXT EBR, RELATIVE TO THE EXTENDED PARTITION
+		scan->nextEbr = isExtendedPartitionType(entry[MBR_ENTRY_TYPE]) ? scan->extendedStart + readLe32(entry + MBR_ENTRY_LBA) : 0;
+		if(scan->nextEbr <= ebr){ //THE CHAIN ONLY MOVES FORWARD, ANYTHING ELSE IS A LOOP
+			scan->nextEbr = 0;
+		}
+		entry = view + MBR_TABLE_OFFSET; //FIRST ENTRY IS THE LOGICAL PARTITION, RELATIVE TO THIS EBR
+		if(entry[MBR_ENTRY_TYPE] == 0){
+			continue;
+		}
+		partition->scheme = PARTITION_EBR;
+		partition->type = entry[MBR_ENTRY_TYPE];
+		partition->sectorStart = ebr + readLe32(entry + MBR_ENTRY_LBA);
+		partition->sectorCount = readLe32(entry + MBR_ENTRY_SECTORS);
+		partition->size = partition->sectorCount*SECTOR_SIZE/1024;
+		partition->index = scan->index++;
+		return 1;
+	}
+	while(scan->state == PARTITION_GPT && scan->gptEntry < scan->gptEntryCount){ //GPT PARTITION ARRAY, ONE ENTRY AT A TIME
+		entry = fetchImageView(scan->image, scan->gptEntryOffset + (uint64_t)scan->gptEntry*scan->gptEntrySize, scan->gptEntrySize, scratch);
+		scan->gptEntry++;
+		if(entry == NULL){
+			break;
+		}
+		if(memcmp(entry, blank, 16) == 0){ //UNUSED ENTRY
+			continue;
+		}
+		lba = readLe64(entry + GPT_ENTRY_FIRST_LBA); //FIRST LBA
+		lastLba = readLe64(entry + GPT_ENTRY_LAST_LBA); //LAST LBA (INCLUSIVE)
+		if(lastLba < lba){
+			continue;
+		}
+		partition->scheme = PARTITION_GPT;
+		memcpy(partition->typeGuid, entry + GPT_ENTRY_TYPE_GUID, 16);
+		partition->sectorStart = lba*scan->lbaFactor;
+		partition->sectorCount = (lastLba - lba + 1)*scan->lbaFactor;
+		partition->size = partition->sectorCount*SECTOR_SIZE/1024;
+		convertUtf16Name(entry + GPT_ENTRY_NAME, GPT_ENTRY_NAME_UNITS, partition->name, sizeof(partition->name));
+		partition->index = scan->index++;
+		return 1;
+	}
+	scan->state = -1;
+	return 0;
+}
+
+
+/*
+ * Function:  fetchPartitionType 
+ * --------------------
+ * Names a partition type from its bytecode with a constant lookup table
+ * indexed by the type byte, so no string is copied per partition
+ *	
+ *	Key Code Descriptions for Partition Types:
+ *	00h : Unknown or empty
+ *	01h : 12-bit FAT
+ *	04h : 16-bit FAT (< 32MB)
+ *	05h : Extended MS-DOS Partition
+ *	06h : FAT-16 (32MB to 2GB)
+ *	07h : NTFS
+ *	0Bh : FAT-32 (CHS)
+ *	0Ch : FAT-32 (LBA)
+ *	0Eh : FAT-16 (LBA)
+ *	0Fh : Extended (LBA)
+ *	EEh : GPT protective MBR
+ *
+ *  partitionType: The bytecode of the partition type
+ *  const char*: The name of the partition type (static storage)
+ */
+const char *fetchPartitionType(char partitionType){
+	static const char *const partitionTypes[256] = { //UNLISTED TYPES ARE NULL
+		[0x00] = "UNKNOWN/EMPTY",
+		[0x01] = "12-BIT FAT",
+		[0x04] = "16-BIT FAT",
+		[0x05] = "EXT. MS-DOS",
+		[0x06] = "FAT-16",
+		[0x07] = "NTFS",
+		[0x0B] = "FAT-32(CHS)",
+		[0x0C] = "FAT-32(LBA)",
+		[0x0E] = "FAT-16(LBA)",
+		[0x0F] = "EXT. LBA",
+		[0xEE] = "GPT PROTECT",
+	};
+	const char *name = partitionTypes[(unsigned char)partitionType];
+	return (name != NULL) ? name : "NOT-RECOGNISED";
+}
+
+
+/*
+ * Function:  fetchGptPartitionType 
+ * --------------------
+ * Looks up the name of a GPT partition type GUID
+ * GUIDs are compared in their on-disk byte order
+ * (the first three fields are little endian)
+ * 
+ * typeGuid: The 16 byte partition type GUID
+ * const char*: The name of the partition type (static storage)
+ */
+const char *fetchGptPartitionType(const unsigned char *typeGuid){
+	static const struct{
+		unsigned char guid[16];
+		const char *name;
+	} gptTypes[] = {
+		{{0x28,0x73,0x2A,0xC1,0x1F,0xF8,0xD2,0x11,0xBA,0x4B,0x00,0xA0,0xC9,0x3E,0xC9,0x3B}, "EFI SYSTEM"}, //C12A7328-F81F-11D2-BA4B-00A0C93EC93B
+		{{0xA2,0xA0,0xD0,0xEB,0xE5,0xB9,0x33,0x44,0x87,0xC0,0x68,0xB6,0xB7,0x26,0x99,0xC7}, "BASIC DATA"}, //EBD0A0A2-B9E5-4433-87C0-68B6B72699C7
+		{{0x16,0xE3,0xC9,0xE3,0x5C,0x0B,0xB8,0x4D,0x81,0x7D,0xF9,0x2D,0xF0,0x02,0x15,0xAE}, "MS RESERVED"}, //E3C9E316-0B5C-4DB8-817D-F92DF00215AE
+		{{0xA4,0xBB,0x94,0xDE,0xD1,0x06,0x40,0x4D,0xA1,0x6A,0xBF,0xD5,0x01,0x79,0xD6,0xAC}, "MS RECOVERY"}, //DE94BBA4-06D1-4D40-A16A-BFD50179D6AC
+		{{0xAF,0x3D,0xC6,0x0F,0x83,0x84,0x72,0x47,0x8E,0x79,0x3D,0x69,0xD8,0x47,0x7D,0xE4}, "LINUX FS"}, //0FC63DAF-8483-4772-8E79-3D69D8477DE4
+		{{0x6D,0xFD,0x57,0x06,0xAB,0xA4,0xC4,0x43,0x84,0xE5,0x09,0x33,0xC8,0x4B,0x4F,0x4F}, "LINUX SWAP"}, //0657FD6D-A4AB-43C4-84E5-0933C84B4F4F
+		{{0x79,0xD3,0xD6,0xE6,0x07,0xF5,0xC2,0x44,0xA2,0x3C,0x23,0x8F,0x2A,0x3D,0xF9,0x28}, "LINUX LVM"}, //E6D6D379-F507-44C2-A23C-238F2A3DF928
+		{{0x00,0x53,0x46,0x48,0x00,0x00,0xAA,0x11,0xAA,0x11,0x00,0x30,0x65,0x43,0xEC,0xAC}, "APPLE HFS+"}, //48465300-0000-11AA-AA11-00306543ECAC
+	};
+	size_t i;
+	for(i=0;i<sizeof(gptTypes)/sizeof(gptTypes[0]);i++){
+		if(memcmp(typeGuid, gptTypes[i].guid, 16) == 0){
+			return gptTypes[i].name;
+		}
+	}
+	return "NOT-RECOGNISED";
+}
+
+
+/*
+ * Function:  describePartition 
+ * --------------------
+ * Names the type of any enumerated partition, MBR type byte or GPT type GUID
+ * 
+ * partition: The partition
+ * const char*: The name of the partition type (static storage)
+ */
+const char *describePartition(const struct Partition *partition){
+	if(partition->scheme == PARTITION_GPT){
+		return fetchGptPartitionType(partition->typeGuid);
+	}
+	return fetchPartitionType(partition->type);
+}
+
+
+/*
+ * Function:  isFatPartitionType 
+ * --------------------
+ * Checks if a partition type bytecode is one of the FAT file system types
+ * (01h, 04h, 06h, 0Bh, 0Ch, 0Eh)
+ * 
+ * partitionType: The bytecode of the partition type
+ * int: 1 if the partition holds a FAT volume, 0 otherwise
+ */
+int isFatPartitionType(char partitionType){
+	switch(partitionType){
+		case 0x01: case 0x04: case 0x06: case 0x0B: case 0x0C: case 0x0E:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+
+/*
+ * Function:  isExtendedPartitionType 
+ * --------------------
+ * Checks if a partition type bytecode is an extended partition
+ * holding a chain of extended boot records (05h, 0Fh, 85h)
+ * 
+ * partitionType: The bytecode of the partition type
+ * int: 1 for an extended partition, 0 otherwise
+ */
+int isExtendedPartitionType(char partitionType){
+	switch((unsigned char)partitionType){
+		case 0x05: case 0x0F: case 0x85:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+
+/*
+ * Function:  fetchPartitionFileSystem 
+ * --------------------
+ * Decides which file system a partition holds
+ * MBR entries are trusted by their type byte, GPT entries are probed
+ * 
+ * image: The open disk image
+ * partition: The partition
+ * int: FILESYSTEM_FAT, FILESYSTEM_NTFS or 0 if neither
+ */
+int fetchPartitionFileSystem(struct DiskImage *image, const struct Partition *partition){
+	if(partition->scheme == PARTITION_GPT){
+		return probeFileSystem(image, partition->sectorStart); //GPT TYPE GUIDS DO NOT TELL FAT AND NTFS APART
+	}
+	return isFatPartitionType(partition->type) ? FILESYSTEM_FAT : (partition->type == 07) ? FILESYSTEM_NTFS : 0;
+}
+
+
+/*
+ * Function:  probeFileSystem 
+ * --------------------
+ * Identifies the file system of a partition from its boot sector
+ * Used for GPT partitions, whose type GUID is shared by FAT and NTFS
+ * 
+ * image: The open disk image
+ * sectorStart: First sector of the partition
+ * int: FILESYSTEM_FAT, FILESYSTEM_NTFS or 0 if neither
+ */
+int probeFileSystem(struct DiskImage *image, uint64_t sectorStart){
+	const unsigned char *view;
+	unsigned char scratch[512];
+	unsigned int bytesPerSector, sectorsPerCluster;
+	view = fetchImageView(image, sectorStart*SECTOR_SIZE, 512, scratch);
+	if(view == NULL || readLe16(view + MBR_SIGNATURE) != 0xAA55){
+		return 0;
+	}
+	if(memcmp(view + NTFS_BOOT_OEM_ID, "NTFS    ", 8) == 0){ //OEM ID OF AN NTFS BOOT SECTOR
+		return FILESYSTEM_NTFS;
+	}
+	bytesPerSector = readLe16(view + FAT_BPB_BYTES_PER_SECTOR);
+	sectorsPerCluster = view[FAT_BPB_SECTORS_PER_CLUSTER];
+	if((bytesPerSector == 512 || bytesPerSector == 1024 || bytesPerSector == 2048 || bytesPerSector == 4096)
+		&& sectorsPerCluster != 0 && (sectorsPerCluster & (sectorsPerCluster - 1)) == 0
+		&& readLe16(view + FAT_BPB_RESERVED_SECTORS) != 0 && (view[FAT_BPB_FAT_COUNT] == 1 || view[FAT_BPB_FAT_COUNT] == 2) && view[FAT_BPB_MEDIA] >= 0xF0){ //PLAUSIBLE BPB (THE "FAT" TYPE STRING IS OPTIONAL)
+		return FILESYSTEM_FAT;
+	}
+	return 0;
+}
+
+
+/*
+ * Function:  fetchFatVolumeInfo 
+ * --------------------
+ * Retrieves FAT Volume Information such as
+ * Sectors per Cluster, FAT Area Size, Root Directory Size, and
+ * the Sector address of #2 Cluster.
+ * The FAT type (12, 16 or 32) is decided by the number of data clusters
+ * FAT32 volumes have no fixed root directory, it starts at rootCluster instead
+ * 
+ * image: The open disk image to assess FAT Volume Info
+ * fat: The FAT volume of the model, sectorStart must already be set
+ */
+void fetchFatVolumeInfo(struct DiskImage *image, struct FatVolume *fat){
+	//DATA DECLARATION
+	const unsigned char *volumeDataBuffer;
+	unsigned char scratch[FAT_BPB_BYTES];
+    //DATA MANIPULATION			
+	volumeDataBuffer = fetchImageView(image, (uint64_t)fat->sectorStart*512, FAT_BPB_BYTES, scratch); //VIEW OF THE FIRST 64 BYTES OF THE VOLUME BOOT SECTOR
+	if(volumeDataBuffer == NULL){
+		return;
+	}
+	fat->bytesPerSector = readLe16(volumeDataBuffer + FAT_BPB_BYTES_PER_SECTOR); //BYTES PER SECTOR
+	fat->reserved = readLe16(volumeDataBuffer + FAT_BPB_RESERVED_SECTORS); //RESERVED AREA SIZE IN SECTORS
+	fat->sectorsPerCluster = volumeDataBuffer[FAT_BPB_SECTORS_PER_CLUSTER];
+	fat->fatCopy = volumeDataBuffer[FAT_BPB_FAT_COUNT]; //NUMBER OF COPIES OF FAT
+	fat->sizeOfFat = readLe16(volumeDataBuffer + FAT_BPB_FAT_SIZE16); //SIZE OF EACH FAT IN SECTORS
+	if(fat->sizeOfFat == 0){ //FAT32 KEEPS A 32 BIT FAT SIZE AT 0x24
+		fat->sizeOfFat = readLe32(volumeDataBuffer + FAT_BPB_FAT_SIZE32);
+	}
+	fat->totalSectors = readLe16(volumeDataBuffer + FAT_BPB_TOTAL_SECTORS16); //16 BIT TOTAL SECTOR COUNT
+	if(fat->totalSectors == 0){ //LARGER VOLUMES KEEP A 32 BIT COUNT AT 0x20
+		fat->totalSectors = readLe32(volumeDataBuffer + FAT_BPB_TOTAL_SECTORS32);
+	}
+	if(fat->bytesPerSector == 0 || fat->sectorsPerCluster == 0){ //NOT A VALID BOOT SECTOR
+		return;
+	}
+	fat->fatSize = fat->sizeOfFat*fat->fatCopy; //FAT TOTAL SIZE = (SIZE OF EACH FAT IN SECTORS)*(NUMBER OF COPIES OF FAT)
+	fat->maxRootDir = readLe16(volumeDataBuffer + FAT_BPB_ROOT_ENTRIES); //MAXIMUM NUMBER OF ROOT DIRECTORIES
+	fat->rootDirSize = (fat->maxRootDir*FAT_DIRENT_SIZE)/fat->bytesPerSector;//ROOT DIR SIZE = ( MAX. NUM. OF DIR ENTRIES)*(DIR ENTRY SIZE IN BYTES)/SECTOR SIZE
+	//NOTE: DIRECTORY ENTRY SIZE FOR FAT VOLUME IS ALWAYS 32 BYTES
+	//NOTE: sectorStart IS A 512 BYTE LBA WHILE THE BPB AREAS ARE IN bytesPerSector UNITS, SO BOTH ADDRESSES ARE WORKED OUT IN BYTES
+	fat->dataSectorAddr = (fat->sectorStart*SECTOR_SIZE + (uint64_t)(fat->reserved + fat->fatSize)*fat->bytesPerSector)/SECTOR_SIZE;//(FIRST SECTOR OF VOLUME) + (SIZE OF RESERVED) + (FAT AREA SIZE);
+	fat->secondClusterAddr = (fat->sectorStart*SECTOR_SIZE + (uint64_t)(fat->reserved + fat->fatSize + fat->rootDirSize)*fat->bytesPerSector)/SECTOR_SIZE; //ROOT DIRECTORY SECTOR + THE ROOT DIRECTORY TOTAL SIZE
+	if(fat->totalSectors > (unsigned int)(fat->reserved + fat->fatSize + fat->rootDirSize)){
+		fat->clusterCount = (fat->totalSectors - fat->reserved - fat->fatSize - fat->rootDirSize)/fat->sectorsPerCluster;
+	}
+	if(fat->clusterCount < 4085){ //CLUSTER COUNT DECIDES THE FAT TYPE (MICROSOFT FAT SPECIFICATION)
+		fat->fatBits = 12;
+	}else if(fat->clusterCount < 65525){
+		fat->fatBits = 16;
+	}else{
+		fat->fatBits = 32;
+		fat->rootCluster = readLe32(volumeDataBuffer + FAT_BPB_ROOT_CLUSTER); //FIRST CLUSTER OF THE FAT32 ROOT DIRECTORY
+	}
+	fat->present = 1;
+}
+
+
+/*
+ * Function:  fetchNTFSVolumeInfo 
+ * --------------------
+ * Fetches relevant NTFS Boot Sector details such as the
+ * bytes per Sector, sectors per Cluster, and $MFTOffset
+ * It also reads the offset of the first attribute of the $MFT record
+ * 
+ * image: The open disk image to assess NTFS Volume Info
+ * ntfs: The NTFS volume of the model, sectorStart must already be set
+ */
+void fetchNTFSVolumeInfo(struct DiskImage *image, struct NtfsVolume *ntfs){
+	//DATA DECLARATION
+	int recordSize, clusterField;
+	const unsigned char *ntfsDataBuffer;
+	unsigned char scratch[512];
+    //DATA MANIPULATION			
+	ntfsDataBuffer = fetchImageView(image, (uint64_t)ntfs->sectorStart*512, 512, scratch); //VIEW OF THE NTFS BOOT SECTOR
+	if(ntfsDataBuffer == NULL){
+		return;
+	}
+	ntfs->bytesPerSector = readLe16(ntfsDataBuffer + NTFS_BOOT_BYTES_PER_SECTOR); //BYTES PER SECTOR FOR NTFS VOLUME (16 BIT AT 0x0B)
+	clusterField = ntfsDataBuffer[NTFS_BOOT_SECTORS_PER_CLUSTER]; //SECTORS PER CLUSTER, ABOVE 80h THE CLUSTER IS 2^(256-VALUE) BYTES
+	if(clusterField > 0x80 && ntfs->bytesPerSector > 0){
+		ntfs->sectorsPerCluster = (256 - clusterField < 31) ? (1 << (256 - clusterField))/ntfs->bytesPerSector : 0;
+	}else{
+		ntfs->sectorsPerCluster = clusterField;
+	}
+	ntfs->clusterSize = ntfs->bytesPerSector*ntfs->sectorsPerCluster; //BYTES PER CLUSTER
+	ntfs->mftCluster = (long long int)readLe64(ntfsDataBuffer + NTFS_BOOT_MFT_CLUSTER); //64 BIT LOGICAL CLUSTER NUMBER FOR MASTER FILE TABLE
+	ntfs->mftSectorAddr = ntfs->sectorStart+(ntfs->mftCluster*ntfs->clusterSize/SECTOR_SIZE); //MFT SECTOR ADDRESS = NTFS TABLE ADDRESS + (LOGICAL CLUSTER NUMBER * CLUSTER SIZE IN SECTORS)
+	ntfs->totalSectors = (long long int)readLe64(ntfsDataBuffer + NTFS_BOOT_TOTAL_SECTORS); //TOTAL SECTORS IN THE VOLUME
+	recordSize = (signed char)ntfsDataBuffer[NTFS_BOOT_RECORD_SIZE]; //CLUSTERS PER FILE RECORD, NEGATIVE MEANS 2^(-VALUE) BYTES
+	if(recordSize > 0){
+		ntfs->mftRecordSize = recordSize*ntfs->sectorsPerCluster*ntfs->bytesPerSector;
+	}else if(recordSize < 0 && recordSize > -31){
+		ntfs->mftRecordSize = 1 << -recordSize;
+	}
+	if(ntfs->mftRecordSize < 512){ //FALL BACK TO THE USUAL SIZE ON A DAMAGED BOOT SECTOR
+		ntfs->mftRecordSize = 1024;
+	}
+	if(ntfs->clusterSize <= 0){ //NOT A USABLE BOOT SECTOR
+		return;
+	}
+	ntfsDataBuffer = fetchImageView(image, (uint64_t)ntfs->mftSectorAddr*512, MFT_RECORD_HEADER_MIN, scratch); //VIEW OF THE FIRST 32 BYTES OF THE $MFT RECORD
+	if(ntfsDataBuffer == NULL){
+		return;
+	}
+	ntfs->mftAttrOffset = readLe16(ntfsDataBuffer + MFT_RECORD_ATTRIBUTE_OFFSET); //$MFT ATTRIBUTE OFFSET
+	ntfs->present = 1;
+}
+
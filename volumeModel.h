@@ -0,0 +1,138 @@
+/*
+ * volumeModel.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Parse-once in-memory volume model
+ * Holds the partitions (MBR primary, EBR logical or GPT), FAT boot sector (BPB) fields,
+ * NTFS boot sector fields and the $MFT location of an image.
+ * Built a single time per image and reused by every query.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef VOLUMEMODEL_H
+#define VOLUMEMODEL_H
+
+//IMPORTED LIBRARIES
+#include "diskImage.h"
+
+#define PARTITION_MBR 0 //PRIMARY ENTRY OF THE MBR PARTITION TABLE
+#define PARTITION_EBR 1 //LOGICAL PARTITION FOUND THROUGH AN EXTENDED BOOT RECORD CHAIN
+#define PARTITION_GPT 2 //ENTRY OF THE GPT PARTITION ARRAY
+#define PARTITION_NAME_MAX 112 //36 UTF-16 CHARACTERS AS UTF-8
+#define FILESYSTEM_FAT 1 //probeFileSystem RESULTS
+#define FILESYSTEM_NTFS 2
+#define NTFS_SPARSE_LCN UINT64_MAX //LCN OF A SPARSE RUN (NO CLUSTERS ALLOCATED, READS AS ZEROS)
+#define NTFS_EXTENT_CACHE_SLOTS 64 //FILE EXTENT MAPS KEPT IN THE DIRECT MAPPED CACHE
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct MetadataIndex;
+
+struct Partition{ 
+	int index; //POSITION IN THE ENUMERATION (0-3 PRIMARY, THEN LOGICAL PARTITIONS OR GPT ENTRIES)
+	int scheme; //PARTITION_MBR, PARTITION_EBR OR PARTITION_GPT
+	char type; //MBR TYPE BYTE (0 FOR GPT ENTRIES)
+	unsigned char typeGuid[16]; //GPT PARTITION TYPE GUID (ZERO FOR MBR ENTRIES)
+	uint64_t sectorStart; //FIRST SECTOR (512 BYTE LBA) OF THE PARTITION
+	uint64_t sectorCount; //LENGTH OF THE PARTITION IN 512 BYTE SECTORS
+	uint64_t size; //SIZE IN KiB
+	char name[PARTITION_NAME_MAX]; //GPT PARTITION NAME (EMPTY FOR MBR ENTRIES)
+};
+
+struct PartitionScan{
+	struct DiskImage *image;
+	int state; //WHICH TABLE IS BEING READ (PRIMARY, EBR CHAIN, GPT ARRAY OR DONE)
+	int index; //NUMBER OF PARTITIONS RETURNED SO FAR
+	int primary; //NEXT PRIMARY ENTRY OF THE MBR
+	uint64_t extendedStart; //FIRST SECTOR OF THE EXTENDED PARTITION (0 IF NONE)
+	uint64_t nextEbr; //SECTOR OF THE NEXT EXTENDED BOOT RECORD IN THE CHAIN
+	int ebrCount; //EXTENDED BOOT RECORDS FOLLOWED (GUARDS AGAINST A LOOPING CHAIN)
+	uint64_t gptEntryOffset; //BYTE OFFSET OF THE GPT PARTITION ARRAY
+	unsigned int gptEntryCount, gptEntrySize, gptEntry; //SIZE OF THE ARRAY AND NEXT ENTRY TO READ
+	unsigned int lbaFactor; //512 BYTE SECTORS PER GPT LOGICAL BLOCK (1, OR 8 ON 4Kn DISKS)
+};
+
+struct FatVolume{
+	int present; //1 IF A FAT PARTITION WAS FOUND AND ITS BOOT SECTOR READ
+	uint64_t sectorStart; //FIRST SECTOR OF THE VOLUME
+	int bytesPerSector;
+	int sectorsPerCluster;
+	int reserved; //RESERVED AREA SIZE IN SECTORS
+	int fatCopy; //NUMBER OF COPIES OF FAT
+	int sizeOfFat; //SIZE OF EACH FAT IN SECTORS
+	int fatSize; //FAT AREA SIZE IN SECTORS
+	int maxRootDir; //MAXIMUM NUMBER OF ROOT DIRECTORY ENTRIES (0 ON FAT32)
+	int rootDirSize; //ROOT DIRECTORY SIZE IN SECTORS (0 ON FAT32)
+	uint64_t dataSectorAddr; //IMAGE SECTOR (512 BYTE) ADDRESS OF THE ROOT DIRECTORY
+	uint64_t secondClusterAddr; //IMAGE SECTOR (512 BYTE) ADDRESS OF CLUSTER #2
+	unsigned int totalSectors; //SIZE OF THE VOLUME IN SECTORS
+	unsigned int clusterCount; //NUMBER OF DATA CLUSTERS (CLUSTERS 2 TO clusterCount+1)
+	unsigned int rootCluster; //FIRST CLUSTER OF THE ROOT DIRECTORY (FAT32 ONLY)
+	int fatBits; //12, 16 OR 32 DEPENDING ON THE FAT TYPE
+	const void *table; //IN-MEMORY FAT INDEX (16 BIT ENTRIES FOR FAT12/16, 32 BIT FOR FAT32, LITTLE ENDIAN), NULL UNTIL LOADED
+	void *tableBuffer; //OWNED COPY BACKING table WHEN IT IS NOT A VIEW OF THE MAPPED IMAGE
+	unsigned int tableEntries; //NUMBER OF ENTRIES IN table
+};
+
+struct NtfsRun{
+	uint64_t vcn; //FIRST VIRTUAL CLUSTER OF THE RUN WITHIN THE STREAM
+	uint64_t lcn; //FIRST LOGICAL CLUSTER OF THE RUN ON THE VOLUME (NTFS_SPARSE_LCN IF SPARSE)
+	uint64_t length; //LENGTH OF THE RUN IN CLUSTERS
+};
+
+struct NtfsExtentMap{
+	int loaded; //1 ONCE THE MAP HAS BEEN BUILT
+	uint64_t recordNumber; //MFT RECORD THE STREAM BELONGS TO
+	struct NtfsRun *runs; //RUNS SORTED BY vcn
+	size_t count, capacity;
+	uint64_t dataSize; //REAL SIZE OF THE STREAM IN BYTES
+	uint64_t initializedSize; //BYTES OF THE STREAM WRITTEN, THE REST UP TO dataSize READS AS ZEROS
+	unsigned char *resident; //COPY OF THE CONTENT OF A RESIDENT STREAM (NULL IF NON-RESIDENT)
+};
+
+struct NtfsVolume{
+	int present; //1 IF AN NTFS PARTITION WAS FOUND AND ITS BOOT SECTOR READ
+	long long int sectorStart; //SECTOR ADDRESS OF THE NTFS BOOT SECTOR
+	int bytesPerSector;
+	int sectorsPerCluster;
+	long long int mftCluster; //LOGICAL CLUSTER NUMBER OF THE $MFT
+	long long int mftSectorAddr; //SECTOR ADDRESS OF THE $MFT FILE RECORD
+	int mftAttrOffset; //OFFSET OF THE FIRST ATTRIBUTE IN THE $MFT RECORD
+	int mftRecordSize; //SIZE OF ONE MFT FILE RECORD IN BYTES (USUALLY 1024)
+	long long int totalSectors; //SIZE OF THE VOLUME IN SECTORS
+	int clusterSize; //BYTES PER CLUSTER
+	struct NtfsExtentMap mftMap; //RUNS OF THE $MFT ITSELF, BUILT ON FIRST USE
+	struct NtfsExtentMap *extentCache; //EXTENT MAPS OF FILES BY RECORD NUMBER, NULL UNTIL FIRST USE
+	int scanThreads; //PARSER THREADS OF scanMftRecords WHEN THE CALLER ASKS FOR 0, 0 FOR ONE PER PROCESSOR
+};
+
+struct VolumeModel{
+	struct DiskImage *image; //IMAGE THE MODEL WAS BUILT FROM
+	struct Partition *partitions; //EVERY PARTITION FOUND, IN ENUMERATION ORDER
+	size_t partitionCount, partitionCapacity;
+	int partitionBlank; //NUMBER OF EMPTY PRIMARY ENTRIES
+	int partitionScheme; //PARTITION_GPT FOR A GPT DISK, PARTITION_MBR OTHERWISE
+	struct FatVolume fat;
+	struct NtfsVolume ntfs;
+	const struct MetadataIndex *index; //INDEX THE MODEL WAS LOADED FROM (image IS NULL), NULL WHEN BUILT FROM THE IMAGE
+};
+
+void buildVolumeModel(struct DiskImage *image, struct VolumeModel *model);
+void freeVolumeModel(struct VolumeModel *model);
+void freeFatVolume(struct FatVolume *fat);
+void freeNtfsVolume(struct NtfsVolume *ntfs);
+void fetchPartitionInfo(struct DiskImage *image, struct VolumeModel *model);
+void beginPartitionScan(struct DiskImage *image, struct PartitionScan *scan);
+int nextPartition(struct PartitionScan *scan, struct Partition *partition);
+const char *fetchPartitionType(char partitionType);
+const char *fetchGptPartitionType(const unsigned char *typeGuid);
+const char *describePartition(const struct Partition *partition);
+int isFatPartitionType(char partitionType);
+int isExtendedPartitionType(char partitionType);
+int fetchPartitionFileSystem(struct DiskImage *image, const struct Partition *partition);
+int probeFileSystem(struct DiskImage *image, uint64_t sectorStart);
+void fetchFatVolumeInfo(struct DiskImage *image, struct FatVolume *fat);
+void fetchNTFSVolumeInfo(struct DiskImage *image, struct NtfsVolume *ntfs);
+
+#endif
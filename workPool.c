@@ -0,0 +1,341 @@
+/*
+ * workPool.c
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Work-stealing thread pool
+ * Tasks submitted from outside the pool are spread round robin over the
+ * worker queues, tasks submitted by a worker go on its own queue.
+ * A worker runs its own newest task first (LIFO, still warm in cache)
+ * and steals the oldest task of another worker (FIFO) when its queue is empty.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+//IMPORTED LIBRARIES
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "workPool.h"
+
+struct WorkItem{
+	void (*task)(void *arg);
+	void *arg;
+};
+
+struct WorkQueue{ //DOUBLE ENDED QUEUE OWNED BY ONE WORKER
+	pthread_mutex_t lock;
+	struct WorkItem *items; //RING BUFFER
+	size_t head, count, capacity; //head IS THE OLDEST ITEM
+};
+
+struct WorkPool{
+	int threadCount;
+	pthread_t *threads;
+	struct WorkQueue *queues;
+	pthread_mutex_t lock; //PROTECTS THE COUNTERS AND CONDITION VARIABLES BELOW
+	pthread_cond_t workReady; //SIGNALLED WHEN A TASK IS SUBMITTED OR THE POOL STOPS
+	pthread_cond_t workDone; //SIGNALLED WHEN THE LAST OUTSTANDING TASK FINISHES
+	size_t queued; //TASKS SITTING IN QUEUES
+	size_t outstanding; //TASKS SUBMITTED BUT NOT YET FINISHED
+	unsigned int nextQueue; //ROUND ROBIN QUEUE FOR EXTERNAL SUBMISSIONS
+	int stopping;
+};
+
+struct WorkerStart{
+	struct WorkPool *pool;
+	int index;
+};
+
+static __thread struct WorkPool *currentPool = NULL; //POOL OF THE CALLING WORKER THREAD
+static __thread int currentWorker = -1; //INDEX OF THE CALLING WORKER THREAD
+
+static void *runWorker(void *arg);
+static int takeWork(struct WorkPool *pool, int index, struct WorkItem *item);
+static int pushWork(struct WorkQueue *queue, struct WorkItem item);
+
+
+/*
+ * Function:  createWorkPool
+ * --------------------
+ * Starts a pool of worker threads
+ *
+ * threadCount: Number of workers, 0 or less uses one per online processor
+ * struct WorkPool*: The new pool, NULL on failure
+ */
+struct WorkPool *createWorkPool(int threadCount){
+	//DATA DECLARATION
+	struct WorkPool *pool;
+	struct WorkerStart *start;
+	int i;
+	//DATA MANIPULATION
+	if(threadCount <= 0){
+		threadCount = fetchProcessorCount();
+	}
+	pool = calloc(1, sizeof(*pool));
+	if(pool == NULL){
+		return NULL;
+	}
+	pool->threadCount = threadCount;
+	pool->threads = calloc((size_t)threadCount, sizeof(pthread_t));
+	pool->queues = calloc((size_t)threadCount, sizeof(struct WorkQueue));
+	if(pool->threads == NULL || pool->queues == NULL){
+		free(pool->threads);
+		free(pool->queues);
+		free(pool);
+		return NULL;
+	}
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->workReady, NULL);
+	pthread_cond_init(&pool->workDone, NULL);
+	for(i=0;i<threadCount;i++){
+		pthread_mutex_init(&pool->queues[i].lock, NULL);
+	}
+	for(i=0;i<threadCount;i++){
+		start = malloc(sizeof(*start));
+		if(start != NULL){
+			start->pool = pool;
+			start->index = i;
+		}
+		if(start == NULL || pthread_create(&pool->threads[i], NULL, runWorker, start) != 0){ //RUN WITH THE WORKERS STARTED SO FAR
+			free(start);
+			pool->threadCount = i;
+			break;
+		}
+	}
+	if(pool->threadCount == 0){
+		destroyWorkPool(pool);
+		return NULL;
+	}
+	return pool;
+}
+
+
+/*
+ * Function:  submitWork
+ * --------------------
+ * Queues a task to be run by the pool
+ *
+ * pool: The pool
+ * task: Function to run
+ * arg: Argument passed to task
+ * int: 0 on success, -1 on allocation failure
+ */
+int submitWork(struct WorkPool *pool, void (*task)(void *arg), void *arg){
+	//DATA DECLARATION
+	struct WorkItem item = {task, arg};
+	int index;
+	//DATA MANIPULATION
+	pthread_mutex_lock(&pool->lock);
+	if(currentPool == pool && currentWorker >= 0){ //NESTED TASKS STAY WITH THE WORKER THAT MADE THEM
+		index = currentWorker;
+	}else{
+		index = (int)(pool->nextQueue++ % (unsigned int)pool->threadCount);
+	}
+	pool->outstanding++;
+	pool->queued++;
+	pthread_mutex_unlock(&pool->lock);
+	if(pushWork(&pool->queues[index], item) != 0){
+		pthread_mutex_lock(&pool->lock);
+		pool->outstanding--;
+		pool->queued--;
+		pthread_mutex_unlock(&pool->lock);
+		return -1;
+	}
+	pthread_mutex_lock(&pool->lock);
+	pthread_cond_signal(&pool->workReady);
+	pthread_mutex_unlock(&pool->lock);
+	return 0;
+}
+
+
+/*
+ * Function:  waitWorkPool
+ * --------------------
+ * Blocks until every submitted task has finished
+ * Must not be called from a worker thread of the same pool
+ *
+ * pool: The pool
+ */
+void waitWorkPool(struct WorkPool *pool){
+	pthread_mutex_lock(&pool->lock);
+	while(pool->outstanding > 0){
+		pthread_cond_wait(&pool->workDone, &pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
+
+/*
+ * Function:  destroyWorkPool
+ * --------------------
+ * Waits for outstanding tasks, stops the workers and frees the pool
+ *
+ * pool: The pool (may be NULL)
+ */
+void destroyWorkPool(struct WorkPool *pool){
+	int i;
+	if(pool == NULL){
+		return;
+	}
+	waitWorkPool(pool);
+	pthread_mutex_lock(&pool->lock);
+	pool->stopping = 1;
+	pthread_cond_broadcast(&pool->workReady);
+	pthread_mutex_unlock(&pool->lock);
+	for(i=0;i<pool->threadCount;i++){
+		pthread_join(pool->threads[i], NULL);
+	}
+	for(i=0;i<pool->threadCount;i++){
+		pthread_mutex_destroy(&pool->queues[i].lock);
+		free(pool->queues[i].items);
+	}
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->workReady);
+	pthread_cond_destroy(&pool->workDone);
+	free(pool->threads);
+	free(pool->queues);
+	free(pool);
+}
+
+
+/*
+ * Function:  fetchWorkPoolSize
+ * --------------------
+ * pool: The pool
+ * int: Number of worker threads running in the pool
+ */
+int fetchWorkPoolSize(struct WorkPool *pool){
+	return pool->threadCount;
+}
+
+
+/*
+ * Function:  fetchProcessorCount
+ * --------------------
+ * int: Number of online processors (at least 1)
+ */
+int fetchProcessorCount(void){
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count < 1) ? 1 : (int)count;
+}
+
+
+/*
+ * Function:  runWorker
+ * --------------------
+ * Main loop of a worker thread
+ * Runs tasks while there are any and sleeps on workReady otherwise
+ *
+ * arg: The WorkerStart of this worker (freed here)
+ * void*: Unused
+ */
+static void *runWorker(void *arg){
+	//DATA DECLARATION
+	struct WorkerStart *start = arg;
+	struct WorkPool *pool = start->pool;
+	int index = start->index;
+	struct WorkItem item;
+	//DATA MANIPULATION
+	free(start);
+	currentPool = pool;
+	currentWorker = index;
+	for(;;){
+		if(takeWork(pool, index, &item)){
+			item.task(item.arg);
+			pthread_mutex_lock(&pool->lock);
+			if(--pool->outstanding == 0){
+				pthread_cond_broadcast(&pool->workDone);
+			}
+			pthread_mutex_unlock(&pool->lock);
+			continue;
+		}
+		pthread_mutex_lock(&pool->lock);
+		while(pool->queued == 0 && !pool->stopping){
+			pthread_cond_wait(&pool->workReady, &pool->lock);
+		}
+		if(pool->stopping && pool->queued == 0){
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+		pthread_mutex_unlock(&pool->lock);
+	}
+	return NULL;
+}
+
+
+/*
+ * Function:  takeWork
+ * --------------------
+ * Takes the newest task of the worker's own queue,
+ * or steals the oldest task from the other queues in turn
+ *
+ * pool: The pool
+ * index: Index of the calling worker
+ * item: Filled in with the task taken
+ * int: 1 if a task was taken, 0 if every queue was empty
+ */
+static int takeWork(struct WorkPool *pool, int index, struct WorkItem *item){
+	//DATA DECLARATION
+	struct WorkQueue *queue;
+	int i, found = 0;
+	//DATA MANIPULATION
+	for(i=0;i<pool->threadCount && !found;i++){
+		queue = &pool->queues[(index + i) % pool->threadCount];
+		pthread_mutex_lock(&queue->lock);
+		if(queue->count > 0){
+			if(i == 0){ //OWN QUEUE: NEWEST FIRST
+				*item = queue->items[(queue->head + queue->count - 1) % queue->capacity];
+			}else{ //STEAL: OLDEST FIRST
+				*item = queue->items[queue->head];
+				queue->head = (queue->head + 1) % queue->capacity;
+			}
+			queue->count--;
+			found = 1;
+		}
+		pthread_mutex_unlock(&queue->lock);
+	}
+	if(found){
+		pthread_mutex_lock(&pool->lock);
+		pool->queued--;
+		pthread_mutex_unlock(&pool->lock);
+	}
+	return found;
+}
+
+
+/*
+ * Function:  pushWork
+ * --------------------
+ * Adds a task to the newest end of a queue, growing the ring buffer if full
+ *
+ * queue: The queue
+ * item: The task
+ * int: 0 on success, -1 on allocation failure
+ */
+static int pushWork(struct WorkQueue *queue, struct WorkItem item){
+	//DATA DECLARATION
+	struct WorkItem *items;
+	size_t i, capacity;
+	//DATA MANIPULATION
+	pthread_mutex_lock(&queue->lock);
+	if(queue->count == queue->capacity){
+		capacity = queue->capacity ? queue->capacity*2 : 64;
+		items = malloc(capacity*sizeof(*items));
+		if(items == NULL){
+			pthread_mutex_unlock(&queue->lock);
+			return -1;
+		}
+		for(i=0;i<queue->count;i++){ //UNWRAP THE RING INTO THE NEW BUFFER
+			items[i] = queue->items[(queue->head + i) % queue->capacity];
+		}
+		free(queue->items);
+		queue->items = items;
+		queue->capacity = capacity;
+		queue->head = 0;
+	}
+	queue->items[(queue->head + queue->count) % queue->capacity] = item;
+	queue->count++;
+	pthread_mutex_unlock(&queue->lock);
+	return 0;
+}
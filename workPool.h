@@ -0,0 +1,26 @@
+/*
+ * workPool.h
+ * Module: ET4027 - Computer Forensics Tool
+ * Summary: Work-stealing thread pool
+ * Each worker thread owns a queue of tasks. Workers take their own newest
+ * task first and steal the oldest task of another worker when idle.
+ *
+ * Authors: Luke O'Sullivan Griffin - 17184614
+ *	    	Mike Vriesema - 17212359
+ * Date: 21/02/2021
+ */
+
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+//FUNCTION & STRUCT DECLARATIONS:
+struct WorkPool;
+
+struct WorkPool *createWorkPool(int threadCount);
+int submitWork(struct WorkPool *pool, void (*task)(void *arg), void *arg);
+void waitWorkPool(struct WorkPool *pool);
+void destroyWorkPool(struct WorkPool *pool);
+int fetchWorkPoolSize(struct WorkPool *pool);
+int fetchProcessorCount(void);
+
+#endif